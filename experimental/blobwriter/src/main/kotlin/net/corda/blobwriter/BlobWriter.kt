@@ -146,6 +146,27 @@ fun main (args: Array<String>) {
 
     )
 
+    // compressed variants of a few of the above
+    listOf (
+            "_Mis_" to _Mis_(mapOf (1 to "two", 3 to "four", 5 to "six")),
+            "__i_LMis_l__" to __i_LMis_l__ (
+                    _i_ (666),
+                    listOf (
+                            mapOf (1 to "two", 3 to "four", 5 to "six"),
+                            mapOf (7 to "eight", 9 to "ten")
+                    ),
+                    _l_ (1000000L)),
+            "_ALd_" to _ALd_ (arrayOf(
+                    listOf (10.1, 11.2, 12.3),
+                    listOf (),
+                    listOf (13.4)))
+    ).forEach { (name, obj) ->
+        File ("$path/$name.deflate").writeBytes (obj.serialize (
+                context = BLOB_WRITER_CONTEXT.withEncoding (CordaSerializationEncoding.DEFLATE)).bytes)
+        File ("$path/$name.snappy").writeBytes (obj.serialize (
+                context = BLOB_WRITER_CONTEXT.withEncoding (CordaSerializationEncoding.SNAPPY)).bytes)
+    }
+
 
 }
 
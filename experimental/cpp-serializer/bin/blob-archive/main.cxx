@@ -0,0 +1,193 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <string.h>
+#include <getopt.h>
+
+#include "amqp/stream/Archive.h"
+#include "amqp/stream/JSONWriter.h"
+
+/******************************************************************************/
+
+namespace {
+
+    void
+    usage (const char * name_) {
+        std::cerr << "usage: " << name_ << " --create <archive> <blob>..." << std::endl
+            << "       " << name_ << " --list <archive>" << std::endl
+            << "       " << name_ << " [--refs] <archive> [<record>...]" << std::endl
+            << "  -c, --create  archive every blob named, or every blob named by"
+            << " a line of stdin given -" << std::endl
+            << "  -l, --list    list every record of an archive and its type"
+            << std::endl
+            << "  -r, --refs    leave back references unexpanded" << std::endl
+            << "  with neither every record, or those numbered, is decoded"
+            << std::endl;
+    }
+
+    /**
+     * Blobs that can't be read are reported and left out, the records of
+     * those that can are numbered in the order they're given
+     */
+    int
+    create (const char * out_, const std::vector<std::string> & blobs_) {
+        std::ofstream out { out_, std::ios::out | std::ios::binary };
+
+        if (!out) {
+            std::cerr << "Can't write to " << out_ << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        amqp::internal::stream::ArchiveWriter writer (out);
+
+        bool failed { false };
+        uint64_t bytes { 0 };
+
+        for (const auto & blob : blobs_) {
+            try {
+                std::ifstream in { blob, std::ios::in | std::ios::binary };
+
+                if (!in) {
+                    throw std::runtime_error ("Not a file");
+                }
+
+                std::vector<char> data {
+                    std::istreambuf_iterator<char> (in),
+                    std::istreambuf_iterator<char>() };
+
+                writer.add (data.data(), data.size());
+
+                bytes += data.size();
+            } catch (const std::exception & e) {
+                std::cerr << blob << ": " << e.what() << std::endl;
+                failed = true;
+            }
+        }
+
+        writer.close();
+
+        std::cerr << writer.records() << " blobs, " << writer.schemas()
+            << " schemas, " << bytes << " bytes archived into "
+            << out.tellp() << std::endl;
+
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    int
+    list (const char * archive_) {
+        amqp::internal::stream::Archive archive (archive_);
+
+        for (size_t i { 0 } ; i < archive.records() ; ++i) {
+            std::cout << i << " " << archive.descriptor (i) << " "
+                << archive.data (i).size() << std::endl;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    int
+    dump (
+        const char * archive_,
+        const std::vector<size_t> & records_,
+        amqp::internal::stream::ObjectTable::refs_t refs_
+    ) {
+        amqp::internal::stream::Archive archive (archive_);
+        amqp::internal::stream::JSONWriter writer (std::cout);
+
+        auto one = [&](size_t record_) {
+            if (record_ >= archive.records()) {
+                throw std::out_of_range ("No record " + std::to_string (record_));
+            }
+
+            std::cout << "{ Parsed : ";
+            archive.visit (record_, writer, refs_);
+            std::cout << " }" << std::endl;
+        };
+
+        if (records_.empty()) {
+            for (size_t i { 0 } ; i < archive.records() ; ++i) {
+                one (i);
+            }
+        } else {
+            for (auto record : records_) {
+                one (record);
+            }
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+}
+
+/******************************************************************************/
+
+int
+main (int argc, char **argv) {
+    const struct option options[] = {
+        { "create", required_argument, nullptr, 'c' },
+        { "list",   no_argument,       nullptr, 'l' },
+        { "refs",   no_argument,       nullptr, 'r' },
+        { nullptr,  0,                 nullptr, 0   }
+    };
+
+    const char * create_ { nullptr };
+    bool listing { false };
+    auto refs { amqp::internal::stream::ObjectTable::expand_r };
+
+    int opt;
+    while ((opt = getopt_long (argc, argv, "c:lr", options, nullptr)) != -1) {
+        switch (opt) {
+            case 'c' : create_ = optarg; break;
+            case 'l' : listing = true; break;
+            case 'r' : refs = amqp::internal::stream::ObjectTable::reference_r; break;
+            default :
+                usage (argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        if (create_) {
+            std::vector<std::string> files;
+
+            for (int i { optind } ; i < argc ; ++i) {
+                if (strcmp (argv[i], "-") == 0) {
+                    for (std::string line ; std::getline (std::cin, line) ; ) {
+                        if (!line.empty()) {
+                            files.push_back (line);
+                        }
+                    }
+                } else {
+                    files.emplace_back (argv[i]);
+                }
+            }
+
+            return create (create_, files);
+        }
+
+        if (optind >= argc || (listing && optind + 1 != argc)) {
+            usage (argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        if (listing) {
+            return list (argv[optind]);
+        }
+
+        std::vector<size_t> records;
+
+        for (int i { optind + 1 } ; i < argc ; ++i) {
+            records.push_back (std::stoul (argv[i]));
+        }
+
+        return dump (argv[optind], records, refs);
+    } catch (const std::exception & e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+/******************************************************************************/
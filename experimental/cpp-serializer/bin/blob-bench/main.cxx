@@ -0,0 +1,238 @@
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iterator>
+
+#include "CordaBytes.h"
+#include "BlobInspector.h"
+#include "DecodeContext.h"
+
+#include "amqp/reader/Format.h"
+#include "amqp/stream/JSONWriter.h"
+#include "amqp/stream/BlobDecoder.h"
+#include "amqp/stream/BlobEncoder.h"
+#include "amqp/stream/SchemaScanner.h"
+
+/******************************************************************************
+ *
+ * Rendering benchmarks, run against a blob heavy in whatever is being
+ * measured, for numbers bin/test-files/_ALd_ (an array of lists of doubles).
+ *
+ * Each is run a fixed number of times and reported as the mean time, and
+ * number of heap allocations, per iteration. The results are written
+ * somewhere the optimiser can't see through so none of the work is
+ * skipped.
+ *
+ ******************************************************************************/
+
+namespace {
+
+    std::atomic<size_t> allocations { 0 };
+
+}
+
+/******************************************************************************/
+
+void *
+operator new (size_t size_) {
+    ++allocations;
+
+    if (auto * p = std::malloc (size_ ? size_ : 1)) {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+/******************************************************************************/
+
+void
+operator delete (void * p_) noexcept {
+    std::free (p_);
+}
+
+/******************************************************************************/
+
+void
+operator delete (void * p_, size_t) noexcept {
+    std::free (p_);
+}
+
+/******************************************************************************/
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    size_t sink { 0 };
+
+    template<class F>
+    void
+    bench (const std::string & name_, size_t iterations_, F f_) {
+        // once to warm up, and fill any caches involved
+        f_();
+
+        auto start = Clock::now();
+        size_t allocated = allocations;
+
+        for (size_t i { 0 } ; i < iterations_ ; ++i) {
+            f_();
+        }
+
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds> (
+                Clock::now() - start).count();
+
+        std::cout << name_ << " : "
+            << static_cast<double> (ns) / iterations_ << " ns, "
+            << static_cast<double> (allocations - allocated) / iterations_
+            << " allocations" << std::endl;
+    }
+
+}
+
+/******************************************************************************/
+
+int
+main (int argc, char ** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <blob> [iterations]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string path { argv[1] };
+    const size_t iterations = argc > 2 ? std::stoul (argv[2]) : 10000;
+
+    std::ifstream file { path, std::ios::in | std::ios::binary };
+    std::string blob {
+        std::istreambuf_iterator<char> (file),
+        std::istreambuf_iterator<char>() };
+
+    /*
+     * The whole blob, read into a tree and then rendered
+     */
+    bench ("tree render      ", iterations, [&] {
+        CordaBytes cb (path);
+        sink += BlobInspector (cb).dump().size();
+    });
+
+    /*
+     * The same but with the blob's buffers, its tree and the output kept
+     * from one pass to the next, what a worker in a batch does
+     */
+    DecodeContext context;
+    std::string out;
+
+    bench ("context render   ", iterations, [&] {
+        out.clear();
+        auto & cb = context.corda (blob);
+        BlobInspector (context.data (cb.size()), cb).dump (context.out (out));
+        sink += out.size();
+        context.recycle();
+    });
+
+    /*
+     * The whole blob, rendered as it's decoded. The schema is only
+     * loaded on the first pass, after that this is decode and render
+     * alone.
+     */
+    std::stringstream ss;
+    amqp::internal::stream::JSONWriter writer (ss);
+    amqp::internal::stream::BlobDecoder decoder (writer);
+
+    bench ("stream render    ", iterations, [&] {
+        ss.str ("");
+        decoder.reset();
+        decoder.feed (blob.data(), blob.size());
+        sink += ss.tellp();
+    });
+
+    /*
+     * The whole blob decoded straight into an encoder, the schema section
+     * being written from its cache after the first pass. The difference
+     * from rendering is what encoding costs over decoding.
+     */
+    amqp::internal::stream::SchemaScanner scanner;
+    file.clear();
+    file.seekg (0);
+    scanner.scan (file);
+
+    auto schema = scanner.load();
+    auto type = schema->fromDescriptor (scanner.descriptor())->second.get()->name();
+
+    amqp::internal::stream::BlobEncoder encoder (std::move (schema));
+    amqp::internal::stream::BlobDecoder reencoder (encoder);
+
+    bench ("stream re-encode ", iterations, [&] {
+        encoder.begin (type);
+        reencoder.reset();
+        reencoder.feed (blob.data(), blob.size());
+        sink += encoder.end().size();
+    });
+
+    /*
+     * Just the numbers, before and after
+     */
+    std::vector<double> doubles (1000);
+    std::mt19937_64 gen (42);
+    std::uniform_real_distribution<double> dist (-1e6, 1e6);
+
+    for (auto & d : doubles) {
+        d = dist (gen);
+    }
+
+    bench ("1000 to_string   ", iterations / 10, [&] {
+        for (auto d : doubles) {
+            sink += std::to_string (d).size();
+        }
+    });
+
+    bench ("1000 format      ", iterations / 10, [&] {
+        char buffer[amqp::internal::reader::FORMAT_MAX];
+
+        for (auto d : doubles) {
+            sink += amqp::internal::reader::format (buffer, d) - buffer;
+        }
+    });
+
+    /*
+     * Strings, just wrapping them in quotes as we used to against
+     * properly escaping them. Mostly free text with the odd character
+     * needing escaping.
+     */
+    std::vector<std::string> strings (1000);
+    std::uniform_int_distribution<int> chars (0, 99);
+
+    for (auto & str : strings) {
+        for (int i { 0 } ; i < 80 ; ++i) {
+            auto c = chars (gen);
+            str.push_back (c == 99 ? '"' : c < 15 ? ' ' : static_cast<char> ('a' + c % 26));
+        }
+    }
+
+    bench ("1000 quoted      ", iterations / 10, [&] {
+        for (const auto & str : strings) {
+            sink += ("\"" + str + "\"").size();
+        }
+    });
+
+    bench ("1000 escaped     ", iterations / 10, [&] {
+        std::string out;
+
+        for (const auto & str : strings) {
+            out.clear();
+            amqp::internal::reader::quote (out, str);
+            sink += out.size();
+        }
+    });
+
+    return sink ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/******************************************************************************/
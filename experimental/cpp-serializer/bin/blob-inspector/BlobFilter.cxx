@@ -0,0 +1,173 @@
+#include "BlobFilter.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "amqp/AMQPHeader.h"
+#include "amqp/AMQPSectionId.h"
+
+#include "amqp/stream/Tokeniser.h"
+#include "amqp/stream/Decompressor.h"
+#include "amqp/stream/StreamDecoder.h"
+#include "amqp/stream/SchemaScanner.h"
+#include "amqp/stream/EnvelopeScanner.h"
+
+/******************************************************************************/
+
+namespace stream = amqp::internal::stream;
+
+/******************************************************************************/
+
+BlobFilter::BlobFilter (
+    const std::string & expression_,
+    stream::ObjectTable::refs_t refs_,
+    const amqp::internal::Limits & limits_
+) : m_predicate (expression_)
+  , m_refs (refs_)
+  , m_limits (limits_)
+  , m_tokeniser (m_scanner)
+  , m_highWater (0)
+{
+}
+
+/******************************************************************************/
+
+/**
+ * The schema of a type we've not seen before, and the predicate compiled
+ * against it
+ */
+BlobFilter::Cached &
+BlobFilter::load (
+    const std::string & descriptor_,
+    const char * schema_,
+    size_t size_,
+    size_t offset_
+) {
+    auto it = m_cache.find (descriptor_);
+
+    if (it != m_cache.end()) {
+        return it->second;
+    }
+
+    Cached cached;
+
+    cached.schema = amqp::internal::stream::SchemaScanner::load (
+            schema_, size_, offset_);
+
+    cached.path = m_predicate.compile (*cached.schema, descriptor_);
+
+    return m_cache[descriptor_] = std::move (cached);
+}
+
+/******************************************************************************/
+
+bool
+BlobFilter::filter (
+    const char * blob_,
+    size_t size_,
+    amqp::reader::IVisitor & visitor_
+) {
+    amqp::internal::Budget budget (m_limits);
+    amqp::internal::Budget::Scope scope (budget);
+
+    auto headerSize = amqp::AMQP_HEADER.size();
+
+    if (size_ <= headerSize
+        || std::memcmp (blob_, amqp::AMQP_HEADER.data(), headerSize) != 0)
+    {
+        throw std::runtime_error ("Not a Corda stream");
+    }
+
+    char section = blob_[headerSize];
+
+    blob_ += headerSize + 1;
+    size_ -= headerSize + 1;
+
+    if (section == amqp::ENCODING) {
+        if (!size_) {
+            throw std::runtime_error ("Missing encoding");
+        }
+
+        m_inflated = stream::Decompressor::inflate (blob_ + 1, size_ - 1, *blob_);
+
+        if (m_inflated.empty()) {
+            throw std::runtime_error ("Empty compressed blob");
+        }
+
+        section = m_inflated.front();
+        blob_ = m_inflated.data() + 1;
+        size_ = m_inflated.size() - 1;
+    }
+
+    if (section != amqp::DATA_AND_STOP && section != amqp::ALT_DATA_AND_STOP) {
+        throw std::runtime_error ("Unsupported encoding");
+    }
+
+    auto & scanner = m_scanner;
+
+    scanner.reset();
+    m_tokeniser.reset();
+
+    if (m_tokeniser.feed (blob_, size_) != size_) {
+        throw std::runtime_error ("Data after the end of the blob");
+    }
+
+    if (!scanner.complete()) {
+        throw std::runtime_error ("Truncated envelope");
+    }
+
+    auto & cached = load (
+            scanner.descriptor(),
+            blob_ + scanner.schema().begin,
+            scanner.schema().size(),
+            scanner.schema().begin);
+
+    if (!cached.path) {
+        return false;
+    }
+
+    const char * data = blob_ + scanner.data().begin;
+
+    if (!m_predicate.matches (data, scanner.data().size(), *cached.path)) {
+        return false;
+    }
+
+    if (!cached.reader) {
+        cached.factory = std::make_unique<amqp::internal::CompositeFactory>();
+        cached.factory->process (*cached.schema);
+
+        cached.reader = std::dynamic_pointer_cast<amqp::internal::reader::Reader> (
+                cached.factory->byDescriptor (scanner.descriptor()));
+
+        if (!cached.reader) {
+            throw std::runtime_error ("No reader for " + scanner.descriptor());
+        }
+    }
+
+    if (!cached.decoder || cached.visitor != &visitor_) {
+        cached.visitor = &visitor_;
+        cached.decoder = std::make_unique<stream::StreamDecoder> (
+                *cached.reader, *cached.schema, visitor_, m_refs);
+        cached.tokeniser = std::make_unique<stream::Tokeniser> (*cached.decoder);
+    } else {
+        cached.decoder->reset (*cached.reader);
+    }
+
+    cached.tokeniser->reset (scanner.data().begin);
+    cached.tokeniser->feed (data, scanner.data().size());
+
+    bool done = cached.decoder->done();
+
+    if (m_highWater && size_ > m_highWater) {
+        cached.decoder.reset();
+        cached.tokeniser.reset();
+    }
+
+    if (!done) {
+        throw std::runtime_error ("Truncated data");
+    }
+
+    return true;
+}
+
+/******************************************************************************/
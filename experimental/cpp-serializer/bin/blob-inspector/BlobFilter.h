@@ -0,0 +1,92 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+
+#include "types.h"
+
+#include "amqp/Limits.h"
+#include "amqp/CompositeFactory.h"
+#include "amqp/reader/IVisitor.h"
+#include "amqp/stream/Predicate.h"
+#include "amqp/stream/Tokeniser.h"
+#include "amqp/stream/ObjectTable.h"
+#include "amqp/stream/StreamDecoder.h"
+#include "amqp/stream/EnvelopeScanner.h"
+
+/******************************************************************************/
+
+/**
+ * Picks out the blobs matching a [Predicate], decoding only those. The
+ * envelope of each blob is scanned to find its sections and the schema
+ * loaded, but that's all that's done before the predicate is compiled
+ * against it. A blob whose type can't match, because it doesn't have
+ * the property or it's of the wrong type, is rejected there and then
+ * without looking at its data at all. Otherwise only the property is
+ * read, everything else being stepped over, and the blob is decoded in
+ * full only if it matches.
+ *
+ * As with the [BlobValidator] everything learnt about a type, its schema,
+ * compiled predicate and readers, is remembered so each is only worked
+ * out once. Readers are only built for types that have had a blob match.
+ */
+class BlobFilter {
+    private :
+        struct Cached {
+            uPtr<amqp::internal::schema::Schema> schema;
+            std::optional<amqp::internal::stream::Predicate::Path> path;
+            uPtr<amqp::internal::CompositeFactory> factory;
+            std::shared_ptr<amqp::internal::reader::Reader> reader;
+
+            /**
+             * Kept between the blobs that match, and only remade should
+             * they be for a different visitor
+             */
+            amqp::reader::IVisitor * visitor { nullptr };
+            uPtr<amqp::internal::stream::StreamDecoder> decoder;
+            uPtr<amqp::internal::stream::Tokeniser> tokeniser;
+        };
+
+        amqp::internal::stream::Predicate m_predicate;
+        amqp::internal::stream::ObjectTable::refs_t m_refs;
+        amqp::internal::Limits m_limits;
+
+        std::map<std::string, Cached> m_cache;
+
+        std::vector<char> m_inflated;
+
+        amqp::internal::stream::EnvelopeScanner m_scanner;
+        amqp::internal::stream::Tokeniser m_tokeniser;
+
+        size_t m_highWater;
+
+        Cached & load (const std::string &, const char *, size_t, size_t offset_);
+
+    public :
+        /**
+         * Throws if the expression isn't a valid predicate
+         */
+        explicit BlobFilter (
+            const std::string &,
+            amqp::internal::stream::ObjectTable::refs_t =
+                amqp::internal::stream::ObjectTable::expand_r,
+            const amqp::internal::Limits & = amqp::internal::Limits());
+
+        /**
+         * Given an entire blob, header and all, tell the visitor about its
+         * values if, and only if, it matches. Throws if the blob can't be
+         * read, which for one that doesn't match might not be noticed.
+         */
+        bool filter (const char *, size_t, amqp::reader::IVisitor &);
+
+        /**
+         * Once a blob larger than this is done with the memory decoding it
+         * took is given back rather than kept for the next, 0 for never
+         */
+        void highWater (size_t bytes_) { m_highWater = bytes_; }
+};
+
+/******************************************************************************/
@@ -9,35 +9,131 @@
 
 #include "amqp/schema/descriptors/AMQPDescriptorRegistory.h"
 
+#include "amqp/AMQPHeader.h"
+#include "amqp/DecodeError.h"
 #include "amqp/CompositeFactory.h"
+#include "amqp/reader/Reader.h"
+#include "amqp/stream/JSONWriter.h"
+#include "amqp/stream/BlobDecoder.h"
 #include "amqp/schema/described-types/Envelope.h"
 
 /******************************************************************************/
 
-BlobInspector::BlobInspector (CordaBytes & cb_)
-    : m_data { pn_data (cb_.size()) }
+BlobInspector::BlobInspector (
+    CordaBytes & cb_,
+    const amqp::internal::Limits & limits_
+) : m_data { pn_data (cb_.size()) }
+  , m_owned (true)
+  , m_limits (limits_)
+  , m_blob (cb_)
 {
-    // returns how many bytes we processed which right now we don't care
-    // about but I assume there is a case where it doesn't process the
-    // entire file
+    try {
+        decode (cb_);
+    } catch (...) {
+        pn_data_free (m_data);
+        throw;
+    }
+}
+
+/******************************************************************************/
+
+BlobInspector::BlobInspector (
+    pn_data_t * data_,
+    CordaBytes & cb_,
+    const amqp::internal::Limits & limits_
+) : m_data { data_ }
+  , m_owned (false)
+  , m_limits (limits_)
+  , m_blob (cb_)
+{
+    pn_data_clear (m_data);
+
+    decode (cb_);
+}
+
+/******************************************************************************/
+
+BlobInspector::~BlobInspector() {
+    if (m_owned) {
+        pn_data_free (m_data);
+    }
+}
+
+/******************************************************************************/
+
+void
+BlobInspector::decode (CordaBytes & cb_) {
+    using amqp::internal::DecodeError;
+
+    // returns how many bytes we processed, anything less than the whole
+    // blob meaning it's either truncated or has something tacked onto it
     auto rtn = pn_data_decode (m_data, cb_.bytes(), cb_.size());
-    assert (rtn == cb_.size());
+
+    if (rtn < 0) {
+        throw DecodeError ("Malformed blob, proton error " + std::to_string (rtn));
+    }
+
+    if (static_cast<size_t>(rtn) != cb_.size()) {
+        throw DecodeError ("Unexpected data after the end of the envelope", rtn);
+    }
 }
 
 /******************************************************************************/
 
 std::string
 BlobInspector::dump() {
+    std::stringstream ss;
+
+    dump (ss);
+
+    return ss.str();
+}
+
+/******************************************************************************/
+
+/**
+ * Nothing's written until the whole tree's been read, so finding a
+ * reference part way through leaves nothing to take back
+ */
+void
+BlobInspector::dump (std::ostream & out_) {
+    try {
+        tree (out_);
+    } catch (const amqp::internal::reader::Referenced &) {
+        stream (out_);
+    }
+}
+
+/******************************************************************************/
+
+void
+BlobInspector::tree (std::ostream & out_) {
+    amqp::internal::Budget budget (m_limits);
+    amqp::internal::Budget::Scope scope (budget);
+
+    using amqp::internal::DecodeError;
+
     std::unique_ptr<amqp::internal::schema::Envelope> envelope;
 
-    if (pn_data_is_described (m_data)) {
+    if (!pn_data_is_described (m_data)) {
+        throw DecodeError ("Expected a described envelope", 0);
+    }
+
+    {
         proton::auto_enter p (m_data);
 
         auto a = pn_data_get_ulong(m_data);
+        auto it = amqp::internal::AMQPDescriptorRegistory.find (a);
 
-        envelope.reset (
-                dynamic_cast<amqp::internal::schema::Envelope *> (
-                        amqp::internal::AMQPDescriptorRegistory[a]->build(m_data).release()));
+        if (it != amqp::internal::AMQPDescriptorRegistory.end()) {
+            envelope.reset (
+                    dynamic_cast<amqp::internal::schema::Envelope *> (
+                            it->second->build(m_data).release()));
+        }
+    }
+
+    if (!envelope) {
+        throw DecodeError ("Expected a described envelope", 0);
     }
 
     amqp::internal::CompositeFactory cf;
@@ -45,7 +141,10 @@ BlobInspector::dump() {
     cf.process (envelope->schema());
 
     auto reader = cf.byDescriptor (envelope->descriptor());
-    assert (reader);
+
+    if (!reader) {
+        throw DecodeError ("No reader for the blob's descriptor " + envelope->descriptor());
+    }
 
     {
         // move to the actual blob entry in the tree - ideally we'd have
@@ -54,20 +153,46 @@ BlobInspector::dump() {
         proton::auto_enter p (m_data);
         pn_data_next (m_data);
         proton::is_list (m_data);
-        assert (pn_data_get_list (m_data) == 3);
+        if (pn_data_get_list (m_data) != 3) {
+            throw DecodeError ("Expected an envelope of three elements");
+        }
         {
             proton::auto_enter p (m_data);
 
-            std::stringstream ss;
-
             // We wrap our output like this to make sure it's valid JSON to
             // facilitate easy pretty printing
-            ss << reader->dump ("{ Parsed", m_data, envelope->schema())->dump()
+            out_ << reader->dump ("{ Parsed", m_data, envelope->schema())->dump()
                << " }";
-
-            return ss.str();
         }
     }
 }
 
 /******************************************************************************/
+
+void
+BlobInspector::stream (std::ostream & out_) {
+    amqp::internal::stream::JSONWriter writer (out_);
+    amqp::internal::stream::BlobDecoder decoder (
+        writer, amqp::internal::stream::ObjectTable::expand_r, m_limits);
+
+    /*
+     * What we hold has already lost its header, and been inflated, so
+     * the decoder's handed a header, and section, of its own first
+     */
+    char section = static_cast<char>(m_blob.encoding());
+
+    decoder.feed (amqp::AMQP_HEADER.data(), amqp::AMQP_HEADER.size());
+    decoder.feed (&section, 1);
+
+    out_ << "{ Parsed : ";
+
+    if (decoder.feed (m_blob.bytes(), m_blob.size()) != m_blob.size()
+        || !decoder.done())
+    {
+        throw amqp::internal::DecodeError ("Blob didn't end with its envelope");
+    }
+
+    out_ << " }";
+}
+
+/******************************************************************************/
@@ -3,20 +3,57 @@
 #include <iosfwd>
 #include "CordaBytes.h"
 
+#include "amqp/Limits.h"
+
 /******************************************************************************/
 
 struct pn_data_t;
 
 /******************************************************************************/
 
+/**
+ * Decodes a blob into a proton tree and walks it with the readers. Those
+ * can't follow a reference back to an object earlier in the blob, so a
+ * blob holding any is instead rendered by the streaming decoder, which
+ * can, with each reference expanded as the tree would have had it.
+ */
 class BlobInspector {
     private :
         pn_data_t * m_data;
+        bool m_owned;
+        amqp::internal::Limits m_limits;
+
+        /**
+         * must outlive us
+         */
+        const CordaBytes & m_blob;
+
+        void decode (CordaBytes &);
+
+        void tree (std::ostream &);
+        void stream (std::ostream &);
 
     public :
-        BlobInspector (CordaBytes &);
+        explicit BlobInspector (
+            CordaBytes &,
+            const amqp::internal::Limits & = amqp::internal::Limits());
+
+        /**
+         * Decode into [data_], cleared first, rather than a tree of our
+         * own, so one can be reused for blob after blob
+         */
+        BlobInspector (
+            pn_data_t * data_,
+            CordaBytes &,
+            const amqp::internal::Limits & = amqp::internal::Limits());
+
+        ~BlobInspector();
+
+        BlobInspector (const BlobInspector &) = delete;
+        BlobInspector & operator = (const BlobInspector &) = delete;
 
         std::string dump();
+        void dump (std::ostream &);
 
 };
 
@@ -0,0 +1,857 @@
+#include "BlobStreamer.h"
+
+#include <array>
+#include <limits>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "amqp/DecodeError.h"
+#include "amqp/AMQPHeader.h"
+#include "amqp/AMQPSectionId.h"
+
+#include "amqp/CompositeFactory.h"
+#include "amqp/schema/described-types/Schema.h"
+
+#include "amqp/stream/Tokeniser.h"
+#include "amqp/stream/OffsetIndex.h"
+#include "amqp/stream/JSONWriter.h"
+#include "amqp/stream/Decompressor.h"
+#include "amqp/stream/ListSplitter.h"
+#include "amqp/stream/SchemaScanner.h"
+#include "amqp/stream/StreamDecoder.h"
+#include "amqp/stream/EnvelopeScanner.h"
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * Somewhere to read an envelope from, offsets are from its start
+     */
+    class Source {
+        public :
+            virtual ~Source() = default;
+
+            /**
+             * @return how many bytes were read, 0 at the end of the blob
+             */
+            virtual size_t read (char *, size_t) = 0;
+
+            virtual void seek (size_t) = 0;
+
+            virtual size_t position() const = 0;
+    };
+
+    /**
+     * An uncompressed blob, the envelope immediately follows the Corda
+     * header so we can read and seek within it directly
+     */
+    class FileSource : public Source {
+        private :
+            std::ifstream & m_file;
+            size_t m_base;
+            size_t m_position;
+
+        public :
+            explicit FileSource (std::ifstream & file_)
+                : m_file (file_)
+                , m_base (file_.tellg())
+                , m_position (0)
+            { }
+
+            size_t read (char * data_, size_t size_) override {
+                auto got = static_cast<size_t>(m_file.read (data_, size_).gcount());
+                m_position += got;
+                return got;
+            }
+
+            void seek (size_t offset_) override {
+                m_file.clear();
+                m_file.seekg (m_base + offset_);
+                m_position = offset_;
+            }
+
+            size_t position() const override {
+                return m_position;
+            }
+    };
+
+    /**
+     * A compressed blob. There's no seeking within a compressed stream so
+     * going forwards we inflate and throw away what we're not interested
+     * in, going backwards we have to start again.
+     */
+    class InflatingSource : public Source {
+        private :
+            std::ifstream & m_file;
+            std::streampos m_start;
+            int m_encoding;
+
+            uPtr<amqp::internal::stream::Decompressor> m_decompressor;
+            std::vector<char> m_raw;
+            size_t m_position;
+
+            void restart() {
+                m_file.clear();
+                m_file.seekg (m_start);
+                m_decompressor = amqp::internal::stream::Decompressor::make (
+                        m_encoding);
+                m_position = 0;
+
+                char section { };
+                if (inflate (&section, 1) != 1
+                    || (section != amqp::DATA_AND_STOP
+                        && section != amqp::ALT_DATA_AND_STOP))
+                {
+                    throw std::runtime_error ("Unsupported encoding");
+                }
+            }
+
+            size_t inflate (char * data_, size_t size_) {
+                for ( ; ; ) {
+                    if (auto n = m_decompressor->output (data_, size_)) {
+                        return n;
+                    }
+
+                    if (m_decompressor->finished()) {
+                        return 0;
+                    }
+
+                    auto got = m_file.read (m_raw.data(), m_raw.size()).gcount();
+
+                    if (!got) {
+                        return 0;
+                    }
+
+                    m_decompressor->input (m_raw.data(), got);
+                }
+            }
+
+        public :
+            InflatingSource (std::ifstream & file_, int encoding_)
+                : m_file (file_)
+                , m_start (file_.tellg())
+                , m_encoding (encoding_)
+                , m_raw (64 * 1024)
+                , m_position (0)
+            {
+                restart();
+            }
+
+            size_t read (char * data_, size_t size_) override {
+                auto n = inflate (data_, size_);
+                m_position += n;
+                return n;
+            }
+
+            void seek (size_t offset_) override {
+                if (offset_ < m_position) {
+                    restart();
+                }
+
+                std::array<char, 4096> scratch { };
+
+                while (m_position < offset_) {
+                    if (!read (scratch.data(), std::min (
+                            scratch.size(), offset_ - m_position)))
+                    {
+                        throw std::runtime_error ("Truncated blob");
+                    }
+                }
+            }
+
+            size_t position() const override {
+                return m_position;
+            }
+    };
+
+    /**
+     * Hands a [ListSplitter] the bytes of a list as it asks for them. Most
+     * lists sit within the block the tokeniser's being fed, the rest of
+     * one that doesn't is read ahead of where the tokeniser's got to. We
+     * carry on as if it hadn't been, the tokeniser expecting to step over
+     * the list, and should it read on instead go back for what it missed.
+     */
+    class ListSource
+        : public Source
+        , public amqp::internal::stream::IListSource
+    {
+        private :
+            Source & m_source;
+
+            /**
+             * the last block read, and where it was read from
+             */
+            const char * m_block;
+            size_t m_at;
+            size_t m_size;
+
+            /**
+             * set once [m_source] has been read beyond the block
+             */
+            bool m_ahead;
+
+            std::vector<char> m_list;
+
+        public :
+            explicit ListSource (Source & source_)
+                : m_source (source_)
+                , m_block (nullptr)
+                , m_at (source_.position())
+                , m_size (0)
+                , m_ahead (false)
+            { }
+
+            size_t read (char * data_, size_t size_) override {
+                if (m_ahead) {
+                    seek (m_at + m_size);
+                }
+
+                m_at = m_source.position();
+                m_size = m_source.read (data_, size_);
+                m_block = data_;
+
+                return m_size;
+            }
+
+            void seek (size_t offset_) override {
+                m_source.seek (offset_);
+
+                m_block = nullptr;
+                m_at = offset_;
+                m_size = 0;
+                m_ahead = false;
+            }
+
+            size_t position() const override {
+                return m_ahead ? m_at + m_size : m_source.position();
+            }
+
+            std::string_view list (size_t begin_, size_t size_) override {
+                auto within = m_block && begin_ >= m_at && begin_ <= m_at + m_size;
+
+                if (within && size_ <= m_at + m_size - begin_) {
+                    return { m_block + (begin_ - m_at), size_ };
+                }
+
+                m_list.resize (size_);
+
+                size_t got { 0 };
+
+                if (within) {
+                    got = m_at + m_size - begin_;
+                    std::copy_n (m_block + (begin_ - m_at), got, m_list.data());
+                }
+
+                m_ahead = true;
+
+                if (m_source.position() != begin_ + got) {
+                    m_source.seek (begin_ + got);
+                }
+
+                while (got < size_) {
+                    auto n = m_source.read (m_list.data() + got, size_ - got);
+                    if (!n) {
+                        throw std::runtime_error ("Truncated blob");
+                    }
+                    got += n;
+                }
+
+                return { m_list.data(), size_ };
+            }
+    };
+
+    /**
+     * Push everything up until [end_] through the tokeniser. Whenever the
+     * tokeniser is asked to skip something larger than what we've got
+     * buffered we seek past it rather than reading it in.
+     *
+     * Anything going wrong along the way is reported as having happened
+     * wherever the tokeniser had got to, unless it already knew better.
+     */
+    void
+    tokenise (
+        Source & source_,
+        amqp::internal::stream::Tokeniser & tokeniser_,
+        std::vector<char> & buffer_,
+        size_t end_
+    ) try {
+        while (tokeniser_.offset() < end_) {
+            if (auto skip = tokeniser_.skipping()) {
+                source_.seek (source_.position() + skip);
+                tokeniser_.skipped (skip);
+                continue;
+            }
+
+            auto want = std::min (buffer_.size(), end_ - source_.position());
+            auto got = want ? source_.read (buffer_.data(), want) : 0;
+
+            if (!got) {
+                throw std::runtime_error ("Truncated blob");
+            }
+
+            tokeniser_.feed (buffer_.data(), got);
+
+            if (tokeniser_.stopped()) {
+                return;
+            }
+        }
+    } catch (amqp::internal::DecodeError & e) {
+        e.at (tokeniser_.offset());
+        throw;
+    } catch (const std::exception & e) {
+        throw amqp::internal::DecodeError (e.what(), tokeniser_.offset());
+    }
+
+    /**
+     * Passes on only the part of a value a path leads to, the rest of it
+     * is decoded but goes nowhere
+     */
+    class Focus : public amqp::reader::IVisitor {
+        private :
+            enum level_t { composite_l, list_l, map_l };
+
+            struct Step {
+                std::string property;
+                size_t      element;
+            };
+
+            struct Level {
+                level_t     type;
+
+                /**
+                 * the path leads to, or through, this level
+                 */
+                bool        on;
+
+                size_t      idx;
+                std::string property;
+            };
+
+            amqp::reader::IVisitor & m_visitor;
+            std::vector<Step> m_path;
+            std::vector<Level> m_levels;
+            bool m_found;
+
+            /**
+             * Does the path lead to, or through, the value about to begin
+             */
+            bool on() const {
+                auto depth = m_levels.size();
+
+                if (!depth) {
+                    return true;
+                }
+
+                const auto & parent = m_levels.back();
+
+                if (!parent.on || depth > m_path.size()) {
+                    return parent.on;
+                }
+
+                const auto & step = m_path[depth - 1];
+
+                switch (parent.type) {
+                    case composite_l :
+                        return !step.property.empty()
+                            && step.property == parent.property;
+                    case list_l :
+                        return step.property.empty() && step.element == parent.idx;
+                    default :
+                        return false;
+                }
+            }
+
+            /**
+             * Is the value about to begin, or the level just ending, part
+             * of what the path leads to
+             */
+            bool within (bool on_, size_t depth_) {
+                if (on_ && depth_ == m_path.size()) {
+                    m_found = true;
+                }
+
+                return on_ && depth_ >= m_path.size();
+            }
+
+            void advance() {
+                if (!m_levels.empty()) {
+                    ++m_levels.back().idx;
+                }
+            }
+
+            bool leaf() {
+                bool rtn = within (on(), m_levels.size());
+                advance();
+                return rtn;
+            }
+
+            bool begin (level_t type_) {
+                auto o = on();
+                bool rtn = within (o, m_levels.size());
+                m_levels.push_back ({ type_, o, 0, { } });
+                return rtn;
+            }
+
+            bool end() {
+                auto & level = m_levels.back();
+                bool rtn = level.on && m_levels.size() - 1 >= m_path.size();
+                m_levels.pop_back();
+                advance();
+                return rtn;
+            }
+
+        public :
+            /**
+             * The path is whatever of the one asked for is within the
+             * value being decoded, so starts with . or [
+             */
+            Focus (amqp::reader::IVisitor & visitor_, std::string_view path_)
+                : m_visitor (visitor_)
+                , m_found (false)
+            {
+                for (size_t i { 0 } ; i < path_.size() ; ) {
+                    auto end = std::min (path_.find_first_of (".[", i + 1), path_.size());
+
+                    if (path_[i] == '[') {
+                        m_path.push_back ({ { }, std::stoul (std::string (path_.substr (i + 1))) });
+                    } else {
+                        m_path.push_back ({ std::string (path_.substr (i + 1, end - i - 1)), 0 });
+                    }
+
+                    i = end;
+                }
+            }
+
+            bool found() const { return m_found; }
+
+            void property (const std::string & name_) override {
+                auto & level = m_levels.back();
+                level.property = name_;
+
+                if (level.on && m_levels.size() - 1 >= m_path.size()) {
+                    m_visitor.property (name_);
+                }
+            }
+
+            void beginComposite (const std::string & name_, size_t fields_) override {
+                if (begin (composite_l)) {
+                    m_visitor.beginComposite (name_, fields_);
+                }
+            }
+
+            void endComposite() override {
+                if (end()) {
+                    m_visitor.endComposite();
+                }
+            }
+
+            void beginList (size_t entries_) override {
+                if (begin (list_l)) {
+                    m_visitor.beginList (entries_);
+                }
+            }
+
+            void endList() override {
+                if (end()) {
+                    m_visitor.endList();
+                }
+            }
+
+            void beginMap (size_t entries_) override {
+                if (begin (map_l)) {
+                    m_visitor.beginMap (entries_);
+                }
+            }
+
+            void endMap() override {
+                if (end()) {
+                    m_visitor.endMap();
+                }
+            }
+
+            void value (bool value_) override {
+                if (leaf()) {
+                    m_visitor.value (value_);
+                }
+            }
+
+            void value (int32_t value_) override {
+                if (leaf()) {
+                    m_visitor.value (value_);
+                }
+            }
+
+            void value (int64_t value_) override {
+                if (leaf()) {
+                    m_visitor.value (value_);
+                }
+            }
+
+            void value (double value_) override {
+                if (leaf()) {
+                    m_visitor.value (value_);
+                }
+            }
+
+            void value (std::string_view value_) override {
+                if (leaf()) {
+                    m_visitor.value (value_);
+                }
+            }
+
+            void enumeration (std::string_view value_) override {
+                if (leaf()) {
+                    m_visitor.enumeration (value_);
+                }
+            }
+
+            void null() override {
+                if (leaf()) {
+                    m_visitor.null();
+                }
+            }
+
+            void reference (size_t index_) override {
+                if (leaf()) {
+                    m_visitor.reference (index_);
+                }
+            }
+    };
+
+    /**
+     * A blob opened for reading, its envelope behind a [Source]
+     */
+    class Blob {
+        private :
+            std::ifstream m_file;
+            uint64_t m_size;
+            uPtr<Source> m_source;
+
+        public :
+            explicit Blob (const std::string & file_)
+                : m_file (file_, std::ios::in | std::ios::binary)
+                , m_size (0)
+            {
+                if (!m_file) {
+                    throw std::runtime_error ("Not a file");
+                }
+
+                m_file.seekg (0, std::ios::end);
+                m_size = m_file.tellg();
+                m_file.seekg (0);
+
+                std::array<char, 7> header { };
+                m_file.read (header.data(), header.size());
+
+                if (!m_file || header != amqp::AMQP_HEADER) {
+                    throw std::runtime_error ("Not a Corda stream");
+                }
+
+                char section { };
+                m_file.read (&section, 1);
+
+                switch (section) {
+                    case amqp::DATA_AND_STOP :
+                    case amqp::ALT_DATA_AND_STOP :
+                        m_source = std::make_unique<FileSource> (m_file);
+                        break;
+                    case amqp::ENCODING : {
+                        char encoding { };
+                        m_file.read (&encoding, 1);
+                        m_source = std::make_unique<InflatingSource> (m_file, encoding);
+                        break;
+                    }
+                    default :
+                        throw std::runtime_error ("Unsupported encoding");
+                }
+            }
+
+            uint64_t size() const {
+                return m_size;
+            }
+
+            Source & source() {
+                return *m_source;
+            }
+
+            uPtr<amqp::internal::schema::Schema> schema (size_t begin_, size_t end_) {
+                using namespace amqp::internal;
+
+                if (end_ < begin_) {
+                    throw std::runtime_error ("Truncated schema");
+                }
+
+                std::vector<char> bytes (end_ - begin_);
+
+                m_source->seek (begin_);
+
+                for (size_t got { 0 } ; got < bytes.size() ; ) {
+                    auto n = m_source->read (bytes.data() + got, bytes.size() - got);
+                    if (!n) {
+                        throw std::runtime_error ("Truncated schema");
+                    }
+                    got += n;
+                }
+
+                return stream::SchemaScanner::load (
+                        bytes.data(), bytes.size(), begin_);
+            }
+    };
+
+}
+
+/******************************************************************************/
+
+BlobStreamer::BlobStreamer (
+    std::string file_,
+    size_t chunk_,
+    amqp::internal::stream::ObjectTable::refs_t refs_,
+    const amqp::internal::Limits & limits_
+) : m_file (std::move (file_))
+  , m_chunk (chunk_)
+  , m_refs (refs_)
+  , m_limits (limits_)
+  , m_workers (1)
+  , m_threshold (amqp::internal::stream::ListSplitter::THRESHOLD)
+  , m_splits (0)
+{
+}
+
+/******************************************************************************/
+
+void
+BlobStreamer::split (unsigned workers_, size_t threshold_) {
+    m_workers = workers_;
+    m_threshold = threshold_;
+}
+
+/******************************************************************************/
+
+void
+BlobStreamer::visit (amqp::reader::IVisitor & visitor_) const {
+    decode (visitor_, nullptr);
+}
+
+/******************************************************************************/
+
+void
+BlobStreamer::index (
+    const std::string & index_,
+    amqp::reader::IVisitor & visitor_
+) const {
+    decode (visitor_, &index_);
+}
+
+/******************************************************************************/
+
+void
+BlobStreamer::decode (
+    amqp::reader::IVisitor & visitor_,
+    const std::string * index_,
+    std::ostream * json_
+) const {
+    using namespace amqp::internal;
+
+    Budget budget (m_limits);
+    Budget::Scope scope (budget);
+
+    Blob blob (m_file);
+
+    std::vector<char> buffer (m_chunk);
+
+    /*
+     * First pass, find out where everything is without decoding any of it
+     */
+    stream::EnvelopeScanner scanner;
+    {
+        stream::Tokeniser tokeniser (scanner);
+        tokenise (blob.source(), tokeniser, buffer, std::numeric_limits<size_t>::max());
+    }
+
+    if (!scanner.complete()) {
+        throw std::runtime_error ("Truncated envelope");
+    }
+
+    /*
+     * Load the schema and build our readers from it
+     */
+    auto schema = blob.schema (scanner.schema().begin, scanner.schema().end);
+
+    CompositeFactory cf;
+
+    cf.process (*schema);
+
+    auto reader = std::dynamic_pointer_cast<reader::Reader> (
+            cf.byDescriptor (scanner.descriptor()));
+
+    if (!reader) {
+        throw std::runtime_error (
+                "No reader for " + scanner.descriptor());
+    }
+
+    /*
+     * Second pass, actually decode the data, noting where each value is
+     * as we go if we've been asked to
+     */
+    stream::OffsetIndexBuilder builder (visitor_);
+
+    stream::StreamDecoder decoder (
+            *reader,
+            *schema,
+            index_ ? static_cast<amqp::reader::IVisitor &>(builder) : visitor_,
+            m_refs);
+
+    builder.attach (decoder);
+
+    stream::Tokeniser tokeniser (
+            index_ ? static_cast<stream::ITokenHandler &>(builder) : decoder,
+            scanner.data().begin);
+
+    blob.source().seek (scanner.data().begin);
+
+    /*
+     * Everything's read a block at a time, a list worth splitting being
+     * fetched whole only once the splitter's found it
+     */
+    ListSource source (blob.source());
+
+    std::optional<stream::ListSplitter> splitter;
+
+    if (json_ && !index_ && m_workers > 1) {
+        splitter.emplace (
+                source, tokeniser, *schema, m_refs, *json_, m_workers, m_threshold);
+
+        decoder.splitter (&*splitter);
+    }
+
+    tokenise (source, tokeniser, buffer, scanner.data().end);
+
+    m_splits = splitter ? splitter->lists() : 0;
+
+    if (!decoder.done()) {
+        throw std::runtime_error ("Truncated data");
+    }
+
+    if (index_) {
+        std::ofstream out { *index_, std::ios::out | std::ios::binary };
+
+        if (!out) {
+            throw std::runtime_error ("Can't write to " + *index_);
+        }
+
+        builder.write (out, scanner, blob.size());
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * Neither the envelope nor anything before the value asked for is read,
+ * for a compressed blob that's still inflated but not decoded. A value
+ * within one that was indexed, the element of a list say, means decoding
+ * all of that one.
+ */
+void
+BlobStreamer::visit (
+    const amqp::internal::stream::OffsetIndex & index_,
+    const std::string & path_,
+    amqp::reader::IVisitor & visitor_
+) const {
+    using namespace amqp::internal;
+
+    Budget budget (m_limits);
+    Budget::Scope scope (budget);
+
+    Blob blob (m_file);
+
+    const auto & header = index_.header();
+
+    if (header.blobSize != blob.size()) {
+        throw std::runtime_error ("The index doesn't match " + m_file);
+    }
+
+    auto found = index_.find (path_);
+
+    if (!found) {
+        throw std::runtime_error ("Nothing indexed at \"" + path_ + "\"");
+    }
+
+    auto value = found->value;
+
+    auto schema = blob.schema (header.schemaBegin, header.schemaEnd);
+
+    CompositeFactory cf;
+
+    cf.process (*schema);
+
+    auto descriptor = std::string (index_.descriptor());
+
+    auto root = std::dynamic_pointer_cast<reader::Reader> (
+            cf.byDescriptor (descriptor));
+
+    if (!root) {
+        throw std::runtime_error ("No reader for " + descriptor);
+    }
+
+    /*
+     * Check the path makes sense before going anywhere, the index would
+     * have it that nothing's there either way
+     */
+    stream::OffsetIndex::resolve (*root, *schema, path_);
+
+    Focus focus (visitor_, std::string_view (path_).substr (found->prefix));
+
+    stream::StreamDecoder decoder (
+            stream::OffsetIndex::resolve (
+                *root, *schema, std::string_view (path_).substr (0, found->prefix)),
+            *schema,
+            focus,
+            m_refs,
+            value.objects);
+
+    stream::Tokeniser tokeniser (decoder, value.offset);
+
+    std::vector<char> buffer (m_chunk);
+
+    blob.source().seek (value.offset);
+
+    tokenise (blob.source(), tokeniser, buffer, header.dataEnd);
+
+    if (!decoder.done()) {
+        throw std::runtime_error ("Truncated data");
+    }
+
+    if (!focus.found()) {
+        throw std::runtime_error ("Nothing at \"" + path_ + "\"");
+    }
+}
+
+/******************************************************************************/
+
+void
+BlobStreamer::dump (std::ostream & out_) const {
+    amqp::internal::stream::JSONWriter writer (out_);
+
+    out_ << "{ Parsed : ";
+    decode (writer, nullptr, &out_);
+    out_ << " }";
+}
+
+/******************************************************************************/
+
+std::string
+BlobStreamer::dump() const {
+    std::stringstream ss;
+
+    dump (ss);
+
+    return ss.str();
+}
+
+/******************************************************************************/
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <iosfwd>
+
+#include "amqp/Limits.h"
+#include "amqp/reader/IVisitor.h"
+#include "amqp/stream/ObjectTable.h"
+
+namespace amqp::internal::stream {
+
+    class OffsetIndex;
+
+}
+
+/******************************************************************************/
+
+/**
+ * Where the [BlobInspector] loads an entire blob into memory, decodes it
+ * into a proton tree and then builds a second tree of values from that
+ * before producing any output, this reads the blob from disk a chunk at a
+ * time and writes each value out as soon as it's been decoded.
+ *
+ * The schema still has to be loaded in its entirety, we can't build the
+ * readers without it, but that's normally a tiny fraction of the blob.
+ * Since it follows the data the file is read twice, once to find the
+ * sections and load the schema and then again to decode the data.
+ */
+class BlobStreamer {
+    private :
+        std::string m_file;
+        size_t m_chunk;
+        amqp::internal::stream::ObjectTable::refs_t m_refs;
+        amqp::internal::Limits m_limits;
+
+        unsigned m_workers;
+        size_t m_threshold;
+
+        /**
+         * how many lists the last blob decoded had split
+         */
+        mutable size_t m_splits;
+
+        void decode (
+            amqp::reader::IVisitor &,
+            const std::string * index_,
+            std::ostream * json_ = nullptr) const;
+
+    public :
+        explicit BlobStreamer (
+            std::string,
+            size_t chunk_ = 64 * 1024,
+            amqp::internal::stream::ObjectTable::refs_t =
+                amqp::internal::stream::ObjectTable::expand_r,
+            const amqp::internal::Limits & = amqp::internal::Limits());
+
+        /**
+         * Tell the visitor about each value as it's decoded
+         */
+        void visit (amqp::reader::IVisitor &) const;
+
+        /**
+         * As [visit], noting where each value begins in an index written
+         * to the file named once we're done
+         */
+        void index (const std::string & index_, amqp::reader::IVisitor &) const;
+
+        /**
+         * Tell the visitor about the value at a path, and only that, by
+         * seeking to wherever the index says it begins
+         */
+        void visit (
+            const amqp::internal::stream::OffsetIndex &,
+            const std::string & path_,
+            amqp::reader::IVisitor &) const;
+
+        /**
+         * When dumping, decode the elements of any list or array of at
+         * least [threshold_] bytes on [workers_] threads at once. Each
+         * list that's split is read into memory whole to do it.
+         */
+        void split (unsigned workers_, size_t threshold_);
+
+        /**
+         * How many lists the last blob dumped had split
+         */
+        size_t splits() const { return m_splits; }
+
+        void dump (std::ostream &) const;
+
+        std::string dump() const;
+};
+
+/******************************************************************************/
@@ -0,0 +1,113 @@
+#include "BlobValidator.h"
+
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "amqp/AMQPHeader.h"
+
+#include "TextDecoder.h"
+
+/******************************************************************************/
+
+BlobValidator::BlobValidator (const amqp::internal::Limits & limits_)
+    : m_decoder (
+        m_visitor,
+        amqp::internal::stream::ObjectTable::reference_r,
+        limits_)
+    , m_buffer (64 * 1024)
+    , m_error ("")
+{
+}
+
+/******************************************************************************/
+
+void
+BlobValidator::check (const char * blob_, size_t size_) {
+    if (m_decoder.feed (blob_, size_) != size_) {
+        throw std::runtime_error ("Data after the end of the blob");
+    }
+}
+
+/******************************************************************************/
+
+void
+BlobValidator::finish() {
+    if (!m_decoder.done()) {
+        throw std::runtime_error ("Truncated blob");
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * The reason is just why, where being left to [error]
+ */
+bool
+BlobValidator::fail (const std::exception & e_, std::string & reason_) {
+    m_error = amqp::internal::DecodeError::of (e_, "");
+    reason_ = m_error.reason();
+
+    return false;
+}
+
+/******************************************************************************/
+
+bool
+BlobValidator::validate (const std::string & file_, std::string & reason_) {
+    try {
+        std::ifstream file { file_, std::ios::in | std::ios::binary };
+
+        if (!file) {
+            throw std::runtime_error ("Not a file");
+        }
+
+        m_decoder.reset();
+
+        std::array<char, 7> header { };
+        file.read (header.data(), header.size());
+
+        if (header != amqp::AMQP_HEADER) {
+            std::string text { header.data(), static_cast<size_t>(file.gcount()) };
+            text.append (
+                std::istreambuf_iterator<char> (file),
+                std::istreambuf_iterator<char>());
+
+            std::vector<char> bytes;
+            text::decode (text.data(), text.size(), bytes);
+
+            return validate (bytes.data(), bytes.size(), reason_);
+        }
+
+        check (header.data(), header.size());
+
+        while (file.read (m_buffer.data(), m_buffer.size()).gcount()) {
+            check (m_buffer.data(), file.gcount());
+        }
+
+        finish();
+    } catch (const std::exception & e) {
+        return fail (e, reason_);
+    }
+
+    return true;
+}
+
+/******************************************************************************/
+
+bool
+BlobValidator::validate (const char * blob_, size_t size_, std::string & reason_) {
+    try {
+        m_decoder.reset();
+
+        check (blob_, size_);
+        finish();
+    } catch (const std::exception & e) {
+        return fail (e, reason_);
+    }
+
+    return true;
+}
+
+/******************************************************************************/
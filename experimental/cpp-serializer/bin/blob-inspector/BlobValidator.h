@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "amqp/DecodeError.h"
+#include "amqp/stream/NullVisitor.h"
+#include "amqp/stream/BlobDecoder.h"
+
+/******************************************************************************/
+
+/**
+ * Checks a blob would decode without decoding it into anything. The
+ * header, section and encoding bytes, the envelope, the schema and every
+ * value in the data are checked as they would be had we rendered them:
+ * each described value must name a type in the schema and that type must
+ * be the one expected where it was found, composites must have as many
+ * fields as their schema says, and so on. Finally nothing but the blob
+ * may be in the file.
+ *
+ * References back to earlier objects are checked to refer to one that's
+ * been read but aren't expanded, there's no need to keep anything around
+ * to do so.
+ *
+ * A validator remembers the schema of every type it's seen so checking
+ * many blobs of the same few types only builds their readers once. The
+ * schema of each is still tokenised, and so checked to be well formed
+ * AMQP, but is only loaded the first time its type is seen.
+ */
+class BlobValidator {
+    private :
+        amqp::internal::stream::NullVisitor m_visitor;
+        amqp::internal::stream::BlobDecoder m_decoder;
+
+        std::vector<char> m_buffer;
+
+        amqp::internal::DecodeError m_error;
+
+        void check (const char *, size_t);
+        void finish();
+        bool fail (const std::exception &, std::string & reason_);
+
+    public :
+        explicit BlobValidator (
+            const amqp::internal::Limits & = amqp::internal::Limits());
+
+        /**
+         * @return true if the blob is valid, if not [reason_] says why
+         */
+        bool validate (const std::string & file_, std::string & reason_);
+        bool validate (const char *, size_t, std::string & reason_);
+
+        /**
+         * Why, and where, the last blob that wasn't valid wasn't
+         */
+        const amqp::internal::DecodeError & error() const { return m_error; }
+
+        /**
+         * see [BlobDecoder::highWater]
+         */
+        void highWater (size_t bytes_) { m_decoder.highWater (bytes_); }
+};
+
+/******************************************************************************/
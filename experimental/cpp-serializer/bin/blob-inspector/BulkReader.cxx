@@ -0,0 +1,517 @@
+#include "BulkReader.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+
+#if __has_include (<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define BULK_READER_URING
+#endif
+
+#include "Queue.h"
+
+/******************************************************************************/
+
+/**
+ * One block of memory carved into equally sized buffers. Which are free
+ * is kept on a [Queue] as they're given back by whichever thread
+ * finished with them.
+ */
+class BulkReader::Pool : public std::enable_shared_from_this<Pool> {
+    private :
+        std::unique_ptr<char, decltype (&free)> m_memory;
+        size_t m_size;
+        size_t m_count;
+
+        Queue<size_t> m_free;
+
+    public :
+        Pool (size_t count_, size_t size_)
+            : m_memory (
+                static_cast<char *> (aligned_alloc (4096, (count_ * size_ + 4095) & ~size_t { 4095 })),
+                &free)
+            , m_size (size_)
+            , m_count (count_)
+            , m_free (count_)
+        {
+            if (!m_memory) {
+                throw std::runtime_error ("Can't allocate the read buffers");
+            }
+
+            for (size_t i { 0 } ; i < count_ ; ++i) {
+                m_free.push (i);
+            }
+        }
+
+        size_t size() const { return m_size; }
+        size_t count() const { return m_count; }
+
+        char * buffer (size_t i_) { return m_memory.get() + i_ * m_size; }
+
+        bool tryTake (size_t & i_) { return m_free.tryPop (i_); }
+
+        size_t take() {
+            size_t i;
+            m_free.pop (i);
+            return i;
+        }
+
+        void give (size_t i_) { m_free.push (i_); }
+
+        /**
+         * The buffer as the caller sees it, it coming back to us once
+         * they're done
+         */
+        std::shared_ptr<const char> hold (size_t i_) {
+            return std::shared_ptr<const char> (
+                buffer (i_),
+                [pool = shared_from_this(), i_](const char *) { pool->give (i_); });
+        }
+};
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * Open, read and close one file after another. A read that comes back
+     * short is taken to be the whole file, as it is for any regular one,
+     * so a small file costs the three calls and no more.
+     */
+    class PreadReader : public BulkReader {
+        public :
+            explicit PreadReader (sPtr<Pool> pool_)
+                : BulkReader (std::move (pool_))
+            { }
+
+            void read (const std::vector<const char *> & files_, const Done & done_) override {
+                for (size_t i { 0 } ; i < files_.size() ; ++i) {
+                    auto buffer = m_pool->take();
+                    int fd = open (files_[i], O_RDONLY | O_CLOEXEC);
+
+                    if (fd < 0) {
+                        auto error = errno;
+                        m_pool->give (buffer);
+                        done_ ({ i, nullptr, 0, error, false });
+                        continue;
+                    }
+
+                    ssize_t got;
+
+                    while ((got = pread (fd, m_pool->buffer (buffer), m_pool->size(), 0)) < 0
+                        && errno == EINTR)
+                    { }
+
+                    auto error = got < 0 ? errno : 0;
+
+                    close (fd);
+
+                    if (got < 0 || static_cast<size_t>(got) == m_pool->size()) {
+                        m_pool->give (buffer);
+                        done_ ({ i, nullptr, 0, error, false });
+                    } else {
+                        done_ ({ i, m_pool->hold (buffer), static_cast<size_t>(got), 0, true });
+                    }
+                }
+            }
+
+            const char * name() const override { return "pread"; }
+    };
+
+}
+
+/******************************************************************************/
+
+#ifdef BULK_READER_URING
+
+namespace {
+
+    int
+    enter (int ring_, unsigned submit_, unsigned wait_) {
+        return static_cast<int> (syscall (
+            __NR_io_uring_enter, ring_, submit_, wait_, IORING_ENTER_GETEVENTS, nullptr, 0));
+    }
+
+    int
+    reg (int ring_, unsigned op_, const void * arg_, unsigned count_) {
+        return static_cast<int> (syscall (
+            __NR_io_uring_register, ring_, op_, arg_, count_));
+    }
+
+    /**
+     * Each file in flight has a single operation queued at any one time,
+     * its open, then its read, then its close. Which of those a
+     * completion is for is in the bottom bits of its user data, the slot
+     * saying which file in the rest.
+     */
+    enum Kind : uint64_t { open_k, read_k, close_k };
+
+    class UringReader : public BulkReader {
+        private :
+            struct Slot {
+                size_t index;
+                size_t buffer;
+                int fd;
+            };
+
+            int m_ring;
+            unsigned m_entries;
+            bool m_fixed;
+
+            void * m_sq;
+            size_t m_sqSize;
+            void * m_cq;
+            size_t m_cqSize;
+
+            io_uring_sqe * m_sqes;
+            size_t m_sqesSize;
+
+            unsigned * m_sqTail;
+            unsigned m_sqMask;
+            unsigned * m_sqArray;
+
+            unsigned * m_cqHead;
+            unsigned * m_cqTail;
+            unsigned m_cqMask;
+            io_uring_cqe * m_cqes;
+
+            std::vector<Slot> m_slots;
+            std::vector<size_t> m_freeSlots;
+
+            /**
+             * operations queued but not yet completed, never more than
+             * the ring holds so there's always room for the next
+             */
+            unsigned m_pending;
+            unsigned m_queued;
+
+            io_uring_sqe * sqe (uint64_t slot_, Kind kind_) {
+                auto tail = *m_sqTail;
+                auto * sqe = &m_sqes[tail & m_sqMask];
+
+                memset (sqe, 0, sizeof (*sqe));
+                sqe->user_data = slot_ << 2U | kind_;
+
+                m_sqArray[tail & m_sqMask] = tail & m_sqMask;
+                __atomic_store_n (m_sqTail, tail + 1, __ATOMIC_RELEASE);
+
+                ++m_queued;
+
+                return sqe;
+            }
+
+            void queueOpen (size_t slot_, const char * file_) {
+                auto * s = sqe (slot_, open_k);
+
+                s->opcode = IORING_OP_OPENAT;
+                s->fd = AT_FDCWD;
+                s->addr = reinterpret_cast<uint64_t> (file_);
+                s->open_flags = O_RDONLY | O_CLOEXEC;
+            }
+
+            void queueRead (size_t slot_) {
+                auto & slot = m_slots[slot_];
+                auto * s = sqe (slot_, read_k);
+
+                s->opcode = m_fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+                s->fd = slot.fd;
+                s->addr = reinterpret_cast<uint64_t> (m_pool->buffer (slot.buffer));
+                s->len = static_cast<uint32_t> (m_pool->size());
+                s->off = 0;
+                s->buf_index = static_cast<uint16_t> (slot.buffer);
+            }
+
+            void queueClose (int fd_) {
+                auto * s = sqe (0, close_k);
+
+                s->opcode = IORING_OP_CLOSE;
+                s->fd = fd_;
+            }
+
+            void submit() {
+                int rtn;
+
+                while ((rtn = enter (m_ring, m_queued, m_pending ? 1 : 0)) < 0) {
+                    if (errno != EINTR) {
+                        throw std::runtime_error (
+                            std::string ("io_uring_enter failed, ") + strerror (errno));
+                    }
+                }
+
+                m_queued = 0;
+            }
+
+            void complete (const io_uring_cqe & cqe_, const Done & done_) {
+                auto kind = static_cast<Kind> (cqe_.user_data & 3U);
+                auto index = static_cast<size_t> (cqe_.user_data >> 2U);
+
+                if (kind == close_k) {
+                    --m_pending;
+                    return;
+                }
+
+                auto & slot = m_slots[index];
+
+                if (kind == open_k && cqe_.res >= 0) {
+                    slot.fd = cqe_.res;
+                    queueRead (index);
+                    return;
+                }
+
+                if (kind == read_k) {
+                    queueClose (slot.fd);
+                } else {
+                    --m_pending;
+                }
+
+                auto got = cqe_.res;
+                m_freeSlots.push_back (index);
+
+                if (got < 0 || static_cast<size_t>(got) == m_pool->size()) {
+                    m_pool->give (slot.buffer);
+                    done_ ({ slot.index, nullptr, 0, got < 0 ? -got : 0, false });
+                } else {
+                    done_ ({
+                        slot.index,
+                        m_pool->hold (slot.buffer),
+                        static_cast<size_t>(got),
+                        0,
+                        true });
+                }
+            }
+
+            /**
+             * Map the ring's queues and set up everything that points
+             * into them
+             */
+            void map (const io_uring_params & params_) {
+                bool single = params_.features & IORING_FEAT_SINGLE_MMAP;
+
+                if (single) {
+                    m_sqSize = m_cqSize = std::max (m_sqSize, m_cqSize);
+                }
+
+                m_sq = mmap (nullptr, m_sqSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+
+                if (m_sq == MAP_FAILED) {
+                    throw std::runtime_error ("Can't map the io_uring");
+                }
+
+                if (single) {
+                    m_cq = m_sq;
+                } else if ((m_cq = mmap (nullptr, m_cqSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_CQ_RING)) == MAP_FAILED)
+                {
+                    throw std::runtime_error ("Can't map the io_uring");
+                }
+
+                auto sqes = mmap (nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES);
+
+                if (sqes == MAP_FAILED) {
+                    throw std::runtime_error ("Can't map the io_uring");
+                }
+
+                m_sqes = static_cast<io_uring_sqe *> (sqes);
+
+                auto * sq = static_cast<char *> (m_sq);
+                auto * cq = static_cast<char *> (m_cq);
+
+                m_sqTail = reinterpret_cast<unsigned *> (sq + params_.sq_off.tail);
+                m_sqMask = *reinterpret_cast<unsigned *> (sq + params_.sq_off.ring_mask);
+                m_sqArray = reinterpret_cast<unsigned *> (sq + params_.sq_off.array);
+
+                m_cqHead = reinterpret_cast<unsigned *> (cq + params_.cq_off.head);
+                m_cqTail = reinterpret_cast<unsigned *> (cq + params_.cq_off.tail);
+                m_cqMask = *reinterpret_cast<unsigned *> (cq + params_.cq_off.ring_mask);
+                m_cqes = reinterpret_cast<io_uring_cqe *> (cq + params_.cq_off.cqes);
+
+                m_slots.resize (m_entries);
+
+                for (size_t i { m_entries } ; i > 0 ; --i) {
+                    m_freeSlots.push_back (i - 1);
+                }
+
+                /*
+                 * Registering the buffers saves the kernel mapping each
+                 * one on every read, but it's locked memory and may be
+                 * refused, in which case they're read into unregistered
+                 */
+                std::vector<iovec> iovecs (m_pool->count());
+
+                for (size_t i { 0 } ; i < iovecs.size() ; ++i) {
+                    iovecs[i] = { m_pool->buffer (i), m_pool->size() };
+                }
+
+                m_fixed = iovecs.size() <= UINT16_MAX
+                    && reg (m_ring, IORING_REGISTER_BUFFERS,
+                            iovecs.data(), static_cast<unsigned> (iovecs.size())) == 0;
+            }
+
+            /**
+             * Unmap whatever of the ring was mapped, and close it
+             */
+            void release() {
+                if (m_sqes != MAP_FAILED) {
+                    munmap (m_sqes, m_sqesSize);
+                }
+
+                if (m_cq != MAP_FAILED && m_cq != m_sq) {
+                    munmap (m_cq, m_cqSize);
+                }
+
+                if (m_sq != MAP_FAILED) {
+                    munmap (m_sq, m_sqSize);
+                }
+
+                ::close (m_ring);
+            }
+
+            UringReader (sPtr<Pool> pool_, int ring_, const io_uring_params & params_)
+                : BulkReader (std::move (pool_))
+                , m_ring (ring_)
+                , m_entries (params_.sq_entries)
+                , m_fixed (false)
+                , m_sq (MAP_FAILED)
+                , m_sqSize (params_.sq_off.array + params_.sq_entries * sizeof (unsigned))
+                , m_cq (MAP_FAILED)
+                , m_cqSize (params_.cq_off.cqes + params_.cq_entries * sizeof (io_uring_cqe))
+                , m_sqes (static_cast<io_uring_sqe *> (MAP_FAILED))
+                , m_sqesSize (params_.sq_entries * sizeof (io_uring_sqe))
+                , m_pending (0)
+                , m_queued (0)
+            {
+                try {
+                    map (params_);
+                } catch (...) {
+                    release();
+                    throw;
+                }
+            }
+
+        public :
+            /**
+             * @return null if there's no io_uring, or it can't do what we
+             * need of it
+             */
+            static uPtr<UringReader> make (sPtr<Pool> pool_, unsigned entries_) {
+                io_uring_params params { };
+
+                int ring = static_cast<int> (syscall (__NR_io_uring_setup, entries_, &params));
+
+                if (ring < 0) {
+                    return nullptr;
+                }
+
+                /*
+                 * Opening and closing through the ring need 5.6 or
+                 * later, ask rather than find out from every file failing
+                 */
+                std::vector<char> memory (
+                    sizeof (io_uring_probe) + 256 * sizeof (io_uring_probe_op), 0);
+                auto * probe = reinterpret_cast<io_uring_probe *> (memory.data());
+
+                if (reg (ring, IORING_REGISTER_PROBE, probe, 256) != 0) {
+                    ::close (ring);
+                    return nullptr;
+                }
+
+                for (auto op : { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_READ_FIXED, IORING_OP_CLOSE }) {
+                    if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                        ::close (ring);
+                        return nullptr;
+                    }
+                }
+
+                try {
+                    return uPtr<UringReader> (new UringReader (std::move (pool_), ring, params));
+                } catch (const std::exception &) {
+                    return nullptr;
+                }
+            }
+
+            ~UringReader() override {
+                release();
+            }
+
+            void read (const std::vector<const char *> & files_, const Done & done_) override {
+                size_t next { 0 };
+
+                while (next < files_.size() || m_pending) {
+                    while (next < files_.size() && m_pending < m_entries && !m_freeSlots.empty()) {
+                        size_t buffer;
+
+                        if (!m_pool->tryTake (buffer)) {
+                            if (m_pending) {
+                                break;
+                            }
+
+                            buffer = m_pool->take();
+                        }
+
+                        auto slot = m_freeSlots.back();
+                        m_freeSlots.pop_back();
+
+                        m_slots[slot] = { next, buffer, -1 };
+                        queueOpen (slot, files_[next++]);
+                        ++m_pending;
+                    }
+
+                    submit();
+
+                    auto head = *m_cqHead;
+                    auto tail = __atomic_load_n (m_cqTail, __ATOMIC_ACQUIRE);
+
+                    for ( ; head != tail ; ++head) {
+                        auto cqe = m_cqes[head & m_cqMask];
+                        __atomic_store_n (m_cqHead, head + 1, __ATOMIC_RELEASE);
+
+                        complete (cqe, done_);
+                    }
+                }
+            }
+
+            const char * name() const override { return "io_uring"; }
+    };
+
+}
+
+#endif
+
+/******************************************************************************/
+
+BulkReader::BulkReader (sPtr<Pool> pool_) : m_pool (std::move (pool_)) { }
+
+/******************************************************************************/
+
+BulkReader::~BulkReader() = default;
+
+/******************************************************************************/
+
+uPtr<BulkReader>
+BulkReader::make (size_t buffers_, size_t size_, bool uring_) {
+    auto pool = std::make_shared<Pool> (buffers_, size_);
+
+#ifdef BULK_READER_URING
+    if (uring_) {
+        if (auto reader = UringReader::make (pool, 64)) {
+            return reader;
+        }
+    }
+#endif
+
+    return std::make_unique<PreadReader> (std::move (pool));
+}
+
+/******************************************************************************/
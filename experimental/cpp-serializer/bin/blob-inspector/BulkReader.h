@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <functional>
+
+#include "types.h"
+
+/******************************************************************************/
+
+/**
+ * Reads whole files, lots of them, into buffers taken from a fixed pool,
+ * for when a batch is many thousands of small blobs and opening, reading
+ * and closing each in turn would leave us waiting on the system calls
+ * rather than decoding.
+ *
+ * Where the kernel has io_uring the opens, reads and closes of many files
+ * are queued on a ring at once, the buffers registered with it up front,
+ * and each file handed back as its read completes, so in whatever order
+ * the kernel gets to them. Without it each file is opened and read in
+ * turn, epoll being no help with regular files.
+ *
+ * Nothing is stat'ed, a file is simply read into a buffer and if it fills
+ * the buffer it's left for the caller to read some other way.
+ */
+class BulkReader {
+    public :
+        struct Read {
+            /**
+             * where the file was in those given to [read]
+             */
+            size_t index;
+
+            /**
+             * the file's contents, the buffer going back to the pool once
+             * the last copy of this is gone. Null should the file not have
+             * been read or not fitted.
+             */
+            std::shared_ptr<const char> bytes;
+            size_t size;
+
+            /**
+             * errno for a file that couldn't be opened or read
+             */
+            int error;
+
+            /**
+             * false when the file filled the buffer and may go on past it
+             */
+            bool whole;
+        };
+
+        using Done = std::function<void (Read &&)>;
+
+    protected :
+        class Pool;
+
+        sPtr<Pool> m_pool;
+
+        explicit BulkReader (sPtr<Pool>);
+
+    public :
+        /**
+         * @param buffers_ how many buffers are in the pool, and so how
+         * many files may be held at once, read but not yet finished with
+         * @param size_ of each buffer, the largest file read this way
+         * @param uring_ false to read each file in turn even if io_uring
+         * is available
+         */
+        static uPtr<BulkReader> make (size_t buffers_, size_t size_, bool uring_ = true);
+
+        virtual ~BulkReader();
+
+        BulkReader (const BulkReader &) = delete;
+        BulkReader & operator = (const BulkReader &) = delete;
+
+        /**
+         * Read every file, calling [done_] on this thread as each is. Should
+         * every buffer be in use this waits for one to be given back.
+         */
+        virtual void read (const std::vector<const char *> & files_, const Done & done_) = 0;
+
+        /**
+         * "io_uring" or "pread", for reporting
+         */
+        virtual const char * name() const = 0;
+};
+
+/******************************************************************************/
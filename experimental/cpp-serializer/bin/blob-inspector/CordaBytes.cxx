@@ -1,38 +1,131 @@
 #include "CordaBytes.h"
 
 #include <array>
-#include <sys/stat.h>
+#include <cstring>
+#include <iterator>
 #include "amqp/AMQPHeader.h"
+#include "amqp/stream/Decompressor.h"
+
+#include "TextDecoder.h"
 
 /******************************************************************************/
 
-CordaBytes::CordaBytes (const std::string & file_)
-    : m_blob { nullptr }
-{
+CordaBytes::CordaBytes (const std::string & file_) {
     std::ifstream file { file_, std::ios::in | std::ios::binary };
-    struct stat results { };
 
-    if (::stat(file_.c_str(), &results) != 0) {
+    if (!file) {
         throw std::runtime_error ("Not a file");
     }
 
-    // Disregard the Corda header
-    m_size = results.st_size - (amqp::AMQP_HEADER.size() + 1);
-
     std::array<char, 7> header { };
     file.read (header.data(), 7);
 
     if (header != amqp::AMQP_HEADER) {
-        throw std::runtime_error ("Not a Corda stream");
+        /*
+         * Not a raw blob, see if it's one that's been written out as text
+         */
+        std::string text { header.data(), static_cast<size_t>(file.gcount()) };
+        text.append (
+            std::istreambuf_iterator<char> (file),
+            std::istreambuf_iterator<char>());
+
+        std::vector<char> bytes;
+        text::decode (text.data(), text.size(), bytes);
+
+        parse (bytes.data(), bytes.size());
+
+        return;
+    }
+
+    char section { };
+    file.read (&section, 1);
+
+    if (section == amqp::ENCODING) {
+        char encoding { };
+        file.read (&encoding, 1);
+
+        m_blob = amqp::internal::stream::Decompressor::inflate (file, encoding);
+
+        if (m_blob.empty()) {
+            throw std::runtime_error ("Empty compressed blob");
+        }
+
+        // the real section lives at the start of the compressed stream
+        section = m_blob.front();
+        m_blob.erase (m_blob.begin());
+    } else {
+        // Disregard the Corda header, what's left is read as it comes
+        // rather than stat'ing the file for its size
+        std::array<char, 64 * 1024> chunk { };
+
+        while (file.read (chunk.data(), chunk.size()).gcount()) {
+            m_blob.insert (m_blob.end(), chunk.data(), chunk.data() + file.gcount());
+        }
     }
 
-    file.read (reinterpret_cast<char *>(&m_encoding), 1);
+    m_encoding = static_cast<amqp::amqp_section_id_t>(section);
+}
+
+/******************************************************************************/
+
+CordaBytes::CordaBytes (const char * blob_, size_t size_) {
+    parse (blob_, size_);
+}
+
+/******************************************************************************/
+
+CordaBytes::CordaBytes() : m_encoding (amqp::DATA_AND_STOP) { }
+
+/******************************************************************************/
+
+void
+CordaBytes::assign (const char * blob_, size_t size_) {
+    parse (blob_, size_);
+}
 
-    m_blob = new char[m_size];
+/******************************************************************************/
 
-    memset (m_blob, 0, m_size);
-    file.read (m_blob, m_size);
+void
+CordaBytes::release() {
+    std::vector<char>().swap (m_blob);
 }
 
 /******************************************************************************/
 
+void
+CordaBytes::parse (const char * blob_, size_t size_) {
+    const auto headerSize { amqp::AMQP_HEADER.size() };
+
+    if (size_ < headerSize + 1
+        || std::memcmp (blob_, amqp::AMQP_HEADER.data(), headerSize) != 0)
+    {
+        throw std::runtime_error ("Not a Corda stream");
+    }
+
+    char section = blob_[headerSize];
+
+    blob_ += headerSize + 1;
+    size_ -= headerSize + 1;
+
+    if (section == amqp::ENCODING) {
+        if (!size_) {
+            throw std::runtime_error ("Missing encoding");
+        }
+
+        m_blob = amqp::internal::stream::Decompressor::inflate (
+                blob_ + 1, size_ - 1, *blob_);
+
+        if (m_blob.empty()) {
+            throw std::runtime_error ("Empty compressed blob");
+        }
+
+        section = m_blob.front();
+        m_blob.erase (m_blob.begin());
+    } else {
+        m_blob.assign (blob_, blob_ + size_);
+    }
+
+    m_encoding = static_cast<amqp::amqp_section_id_t>(section);
+}
+
+/******************************************************************************/
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "string"
+#include <vector>
 #include <fstream>
 #include "amqp/AMQPSectionId.h"
 
@@ -9,23 +10,46 @@
 class CordaBytes {
     private :
         amqp::amqp_section_id_t m_encoding;
-        size_t m_size;
-        char * m_blob;
+        std::vector<char> m_blob;
+
+        void parse (const char *, size_t);
 
     public :
+        /**
+         * If the blob is compressed it is inflated, [encoding] then being
+         * the section found at the start of the inflated stream. A file
+         * holding the blob as hex or base64 text is decoded first.
+         */
         explicit CordaBytes (const std::string &);
 
-        ~CordaBytes() {
-            delete [] m_blob;
-        }
+        /**
+         * A blob, header and all, we already have in memory
+         */
+        CordaBytes (const char *, size_t);
+
+        /**
+         * Nothing, until [assign]ed a blob
+         */
+        CordaBytes();
+
+        /**
+         * Replace whatever we held with another blob in memory, reusing
+         * the space the last one took
+         */
+        void assign (const char *, size_t);
+
+        /**
+         * Give up the space we're holding
+         */
+        void release();
 
         const decltype (m_encoding) & encoding() const {
             return m_encoding;
         }
 
-        decltype (m_size) size() const { return m_size; }
+        size_t size() const { return m_blob.size(); }
 
-        const char * const bytes() const { return m_blob; }
+        const char * const bytes() const { return m_blob.data(); }
 };
 
 /******************************************************************************/
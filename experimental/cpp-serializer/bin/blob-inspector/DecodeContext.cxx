@@ -0,0 +1,102 @@
+#include "DecodeContext.h"
+
+#include <algorithm>
+
+#include "proton/codec.h"
+
+/******************************************************************************/
+
+DecodeContext::Sink::int_type
+DecodeContext::Sink::overflow (int_type c_) {
+    if (!m_target) {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type (c_, traits_type::eof())) {
+        m_target->push_back (traits_type::to_char_type (c_));
+    }
+
+    return traits_type::not_eof (c_);
+}
+
+/******************************************************************************/
+
+std::streamsize
+DecodeContext::Sink::xsputn (const char * s_, std::streamsize n_) {
+    if (!m_target) {
+        return 0;
+    }
+
+    m_target->append (s_, static_cast<size_t>(n_));
+
+    return n_;
+}
+
+/******************************************************************************/
+
+DecodeContext::DecodeContext (size_t highWater_)
+    : m_highWater (highWater_)
+    , m_data (pn_data (0))
+    , m_decoded (0)
+    , m_out (&m_sink)
+{
+}
+
+/******************************************************************************/
+
+DecodeContext::~DecodeContext() {
+    pn_data_free (m_data);
+}
+
+/******************************************************************************/
+
+CordaBytes &
+DecodeContext::corda (std::string_view blob_) {
+    m_corda.assign (blob_.data(), blob_.size());
+
+    return m_corda;
+}
+
+/******************************************************************************/
+
+pn_data_t *
+DecodeContext::data (size_t size_) {
+    m_decoded = std::max (m_decoded, size_);
+
+    pn_data_clear (m_data);
+
+    return m_data;
+}
+
+/******************************************************************************/
+
+std::ostream &
+DecodeContext::out (std::string & target_) {
+    m_sink.target (target_);
+    m_out.clear();
+
+    return m_out;
+}
+
+/******************************************************************************/
+
+/**
+ * proton won't say how large its tree has grown so how large a blob went
+ * into it stands in for that
+ */
+void
+DecodeContext::recycle() {
+    recycle (m_bytes);
+
+    if (m_highWater && m_corda.size() > m_highWater) {
+        m_corda.release();
+    }
+
+    if (m_highWater && m_decoded > m_highWater) {
+        pn_data_free (m_data);
+        m_data = pn_data (0);
+        m_decoded = 0;
+    }
+}
+
+/******************************************************************************/
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <streambuf>
+#include <string_view>
+
+#include "CordaBytes.h"
+
+/******************************************************************************/
+
+struct pn_data_t;
+
+/******************************************************************************/
+
+/**
+ * Everything one thread needs to decode blob after blob, kept from one to
+ * the next rather than allocated afresh for each: the bytes of a blob we
+ * were given as text, the blob once its header's been stripped or it's
+ * been inflated, the proton tree it's decoded into and a stream writing
+ * straight into whatever string its output is wanted in.
+ *
+ * Once the largest of the blobs has been seen none of these need to grow
+ * again, so in a long batch decoding allocates next to nothing. The price
+ * is holding onto the memory the largest blob needed, so anything left
+ * larger than the high water mark is given back by [recycle] instead.
+ */
+class DecodeContext {
+    private :
+        /**
+         * Appends whatever's written to it to a string
+         */
+        class Sink : public std::streambuf {
+            private :
+                std::string * m_target { nullptr };
+
+            protected :
+                int_type overflow (int_type) override;
+                std::streamsize xsputn (const char *, std::streamsize) override;
+
+            public :
+                void target (std::string & target_) { m_target = &target_; }
+        };
+
+        size_t m_highWater;
+
+        std::vector<char> m_bytes;
+        CordaBytes m_corda;
+
+        pn_data_t * m_data;
+
+        /**
+         * the largest blob decoded into [m_data] since it was made
+         */
+        size_t m_decoded;
+
+        Sink m_sink;
+        std::ostream m_out;
+
+    public :
+        static constexpr size_t HIGH_WATER = 16U << 20U;
+
+        /**
+         * @param highWater_ in bytes, 0 for a context that never gives
+         * anything back
+         */
+        explicit DecodeContext (size_t highWater_ = HIGH_WATER);
+        ~DecodeContext();
+
+        DecodeContext (const DecodeContext &) = delete;
+        DecodeContext & operator = (const DecodeContext &) = delete;
+
+        size_t highWater() const { return m_highWater; }
+
+        /**
+         * Somewhere to decode a blob given to us as text
+         */
+        std::vector<char> & bytes() { return m_bytes; }
+
+        /**
+         * The blob, header stripped and inflated if need be
+         */
+        CordaBytes & corda (std::string_view);
+
+        /**
+         * An empty tree to decode a blob of this size into
+         */
+        pn_data_t * data (size_t);
+
+        /**
+         * A stream appending to [target_] until asked for again
+         */
+        std::ostream & out (std::string & target_);
+
+        /**
+         * The same stream, for writers that hold onto it, writing to
+         * whatever it was last pointed at
+         */
+        std::ostream & out() { return m_out; }
+
+        /**
+         * The blob's done with, give up anything it left too large
+         */
+        void recycle();
+
+        /**
+         * As [recycle] for a buffer of the caller's
+         */
+        template<typename T>
+        void recycle (T & buffer_) const {
+            if (m_highWater && buffer_.capacity() > m_highWater) {
+                T().swap (buffer_);
+            }
+        }
+};
+
+/******************************************************************************/
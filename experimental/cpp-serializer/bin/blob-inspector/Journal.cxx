@@ -0,0 +1,190 @@
+#include "Journal.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/******************************************************************************
+ *
+ * journal
+ *
+ ******************************************************************************/
+
+/**
+ * FNV-1a over the other fields, enough to tell a whole entry from one
+ * that was only partly written
+ */
+uint64_t
+journal::
+check (const Entry & entry_) {
+    uint64_t hash { 0xcbf29ce484222325ULL };
+
+    for (auto field : { entry_.inputs, entry_.output, entry_.rejects, entry_.failures }) {
+        for (int i { 0 } ; i < 8 ; ++i) {
+            hash ^= (field >> (i * 8)) & 0xff;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+
+    return hash;
+}
+
+/******************************************************************************/
+
+namespace {
+
+    void
+    writeAll (int fd_, const void * data_, size_t size_) {
+        auto p = static_cast<const char *>(data_);
+
+        while (size_) {
+            auto n = write (fd_, p, size_);
+
+            if (n < 0) {
+                throw std::runtime_error ("Failed to write the journal");
+            }
+
+            p += n;
+            size_ -= n;
+        }
+    }
+
+    bool
+    readAll (int fd_, void * data_, size_t size_) {
+        auto p = static_cast<char *>(data_);
+
+        while (size_) {
+            auto n = read (fd_, p, size_);
+
+            if (n <= 0) {
+                return false;
+            }
+
+            p += n;
+            size_ -= n;
+        }
+
+        return true;
+    }
+
+}
+
+/******************************************************************************/
+
+Journal::Journal (const std::string & file_)
+    : m_fd (open (file_.c_str(), O_RDWR | O_CREAT, 0644))
+    , m_last { }
+{
+    if (m_fd < 0) {
+        throw std::runtime_error ("Can't open " + file_);
+    }
+
+    try {
+        struct stat results { };
+
+        if (fstat (m_fd, &results) != 0) {
+            throw std::runtime_error ("Can't open " + file_);
+        }
+
+        auto size = static_cast<size_t>(results.st_size);
+
+        if (size == 0) {
+            journal::Header header { };
+            std::memcpy (header.magic, journal::MAGIC, sizeof (journal::MAGIC));
+            header.version = journal::VERSION;
+            header.orderMark = journal::ORDER_MARK;
+
+            writeAll (m_fd, &header, sizeof (header));
+
+            if (fsync (m_fd) != 0) {
+                throw std::runtime_error ("Failed to sync the journal");
+            }
+
+            return;
+        }
+
+        journal::Header header { };
+
+        if (size < sizeof (header)
+            || !readAll (m_fd, &header, sizeof (header))
+            || std::memcmp (header.magic, journal::MAGIC, sizeof (journal::MAGIC)) != 0)
+        {
+            throw std::runtime_error ("Not a journal: " + file_);
+        }
+
+        if (header.version != journal::VERSION
+            || header.orderMark != journal::ORDER_MARK)
+        {
+            throw std::runtime_error ("Unsupported journal: " + file_);
+        }
+
+        /*
+         * Only the last whole entry matters, unless it was torn in which
+         * case it's the one before
+         */
+        auto entries = (size - sizeof (header)) / sizeof (journal::Entry);
+
+        for (; entries ; --entries) {
+            auto at = sizeof (header) + (entries - 1) * sizeof (journal::Entry);
+            journal::Entry entry { };
+
+            if (lseek (m_fd, static_cast<off_t>(at), SEEK_SET) < 0
+                || !readAll (m_fd, &entry, sizeof (entry)))
+            {
+                throw std::runtime_error ("Can't read " + file_);
+            }
+
+            if (entry.check == journal::check (entry)) {
+                m_last = entry;
+                break;
+            }
+        }
+
+        auto end = static_cast<off_t>(sizeof (header) + entries * sizeof (journal::Entry));
+
+        if (static_cast<size_t>(end) != size) {
+            if (ftruncate (m_fd, end) != 0 || fsync (m_fd) != 0) {
+                throw std::runtime_error ("Can't truncate " + file_);
+            }
+        }
+
+        if (lseek (m_fd, end, SEEK_SET) < 0) {
+            throw std::runtime_error ("Can't read " + file_);
+        }
+    } catch (...) {
+        close (m_fd);
+        throw;
+    }
+}
+
+/******************************************************************************/
+
+Journal::~Journal() {
+    close (m_fd);
+}
+
+/******************************************************************************/
+
+void
+Journal::record (
+    uint64_t inputs_,
+    uint64_t output_,
+    uint64_t rejects_,
+    uint64_t failures_
+) {
+    journal::Entry entry { inputs_, output_, rejects_, failures_, 0 };
+    entry.check = journal::check (entry);
+
+    writeAll (m_fd, &entry, sizeof (entry));
+
+    if (fdatasync (m_fd) != 0) {
+        throw std::runtime_error ("Failed to sync the journal");
+    }
+
+    m_last = entry;
+}
+
+/******************************************************************************/
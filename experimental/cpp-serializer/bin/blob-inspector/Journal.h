@@ -0,0 +1,107 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <cstdint>
+
+/******************************************************************************
+ *
+ * journal
+ *
+ ******************************************************************************/
+
+/**
+ * The layout of a journal, an append-only record of how far a batch has
+ * got through its input. Each entry says how many inputs had been dealt
+ * with in full and how large each of the batch's outputs were when they
+ * had been, so a run that's killed can be resumed by skipping that many
+ * inputs and cutting its outputs back to those sizes. Whatever was
+ * written after the last entry is thrown away and done again, nothing is
+ * missed and nothing is written twice.
+ *
+ *      Header
+ *      Entry[]
+ *
+ * An entry is only appended once the outputs it describes are on disk,
+ * and is itself synced before the batch carries on. An entry torn by a
+ * crash part way through writing it is noticed by its check and ignored,
+ * the one before it being where to resume from.
+ */
+namespace journal {
+
+    constexpr char MAGIC[8] = { 'C', 'O', 'R', 'D', 'A', 'J', 'N', 'L' };
+    constexpr uint64_t VERSION = 1;
+    constexpr uint64_t ORDER_MARK = 0x0102030405060708ULL;
+
+    struct Header {
+        char     magic[8];
+        uint64_t version;
+        uint64_t orderMark;
+    };
+
+    struct Entry {
+        /**
+         * how many inputs, in the order they're read, have been dealt with
+         */
+        uint64_t inputs;
+
+        /**
+         * the size of the main output
+         */
+        uint64_t output;
+
+        /**
+         * the size of where the inputs that failed are written
+         */
+        uint64_t rejects;
+
+        /**
+         * how many inputs failed
+         */
+        uint64_t failures;
+
+        uint64_t check;
+    };
+
+    uint64_t check (const Entry &);
+
+}
+
+/******************************************************************************/
+
+class Journal {
+    private :
+        int m_fd;
+
+        journal::Entry m_last;
+
+    public :
+        /**
+         * Opens the journal, creating it if there isn't one. Anything
+         * following its last good entry is truncated away.
+         */
+        explicit Journal (const std::string &);
+        ~Journal();
+
+        Journal (const Journal &) = delete;
+        Journal & operator = (const Journal &) = delete;
+
+        /**
+         * Where the last run got to, all zero for a new journal
+         */
+        const journal::Entry & last() const { return m_last; }
+
+        /**
+         * Nothing's been recorded yet
+         */
+        bool empty() const { return m_last.check == 0; }
+
+        /**
+         * Append an entry and wait for it to reach the disk. The
+         * outputs it describes are expected to be there already.
+         */
+        void record (uint64_t inputs_, uint64_t output_, uint64_t rejects_, uint64_t failures_);
+};
+
+/******************************************************************************/
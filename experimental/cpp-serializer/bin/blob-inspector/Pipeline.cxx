@@ -0,0 +1,412 @@
+#include "Pipeline.h"
+
+#include <map>
+#include <cerrno>
+#include <thread>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "BulkReader.h"
+#include "TextDecoder.h"
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * Output is gathered up and written in pieces at least this large
+     */
+    constexpr size_t WRITE = 1U << 20U;
+
+    /**
+     * The size of each of the [Pipeline::BUFFERS] files are read into
+     */
+    constexpr size_t BUFFER = 64U << 10U;
+
+}
+
+/******************************************************************************/
+
+/**
+ * A file mapped into memory, the kernel having been asked to read it in
+ * ahead of us needing it
+ */
+struct Pipeline::Mapping {
+    const char * data { nullptr };
+    size_t size { 0 };
+
+    explicit Mapping (const std::string & file_) {
+        int fd = open (file_.c_str(), O_RDONLY);
+
+        if (fd < 0) {
+            throw std::runtime_error ("Not a file");
+        }
+
+        struct stat results { };
+
+        if (fstat (fd, &results) != 0 || !S_ISREG (results.st_mode)) {
+            close (fd);
+            throw std::runtime_error ("Not a file");
+        }
+
+        size = static_cast<size_t>(results.st_size);
+
+        if (size) {
+            posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            posix_fadvise (fd, 0, 0, POSIX_FADV_WILLNEED);
+
+            auto base = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (base == MAP_FAILED) {
+                close (fd);
+                throw std::runtime_error ("Can't map " + file_);
+            }
+
+            madvise (base, size, MADV_WILLNEED);
+
+            data = static_cast<const char *>(base);
+        }
+
+        close (fd);
+    }
+
+    ~Mapping() {
+        if (size) {
+            munmap (const_cast<char *>(data), size);
+        }
+    }
+
+    Mapping (const Mapping &) = delete;
+    Mapping & operator = (const Mapping &) = delete;
+};
+
+/******************************************************************************/
+
+struct Pipeline::Result {
+    uint64_t seq { 0 };
+
+    std::string name;
+    std::string input;
+
+    bool skip { false };
+    bool rejected { false };
+
+    std::string output;
+    std::optional<amqp::internal::DecodeError> error;
+};
+
+/******************************************************************************/
+
+std::string_view
+Pipeline::Job::blob (std::vector<char> & scratch_) const {
+    if (!m_error.empty()) {
+        throw std::runtime_error (m_error);
+    }
+
+    std::string_view raw;
+
+    if (m_line) {
+        raw = m_input;
+    } else if (m_buffer) {
+        raw = { m_buffer.get(), m_size };
+    } else if (m_mapping) {
+        raw = { m_mapping->data, m_mapping->size };
+    } else {
+        raw = { m_bytes.data(), m_bytes.size() };
+    }
+
+    if (text::detect (raw.data(), raw.size()) == text::binary_t) {
+        return raw;
+    }
+
+    scratch_.clear();
+    text::decode (raw.data(), raw.size(), scratch_);
+
+    return { scratch_.data(), scratch_.size() };
+}
+
+/******************************************************************************/
+
+Pipeline::Pipeline (
+    Progress & progress_,
+    unsigned workers_,
+    size_t depth_,
+    size_t highWater_
+) : m_progress (progress_)
+  , m_workers (std::max (1U, workers_))
+  , m_depth (std::max (size_t { 2 }, depth_))
+  , m_highWater (highWater_)
+  , m_metrics { }
+{
+}
+
+/******************************************************************************/
+
+int
+Pipeline::run (
+    std::istream * lines_,
+    char ** files_,
+    int count_,
+    const Worker & worker_,
+    std::ostream & out_
+) {
+    Queue<Job> jobs (m_depth);
+    Queue<Result> results (m_depth);
+
+    /*
+     * Strings done with, their memory still held, for the lines read and
+     * the output decoded. Should it be empty a new one's as good, should
+     * it be full whatever doesn't fit is simply freed.
+     */
+    Queue<std::string> spares (2 * m_depth);
+
+    auto spare = [&](std::string & into_) {
+        spares.tryPop (into_);
+        into_.clear();
+    };
+
+    auto recycle = [&](std::string & string_) {
+        if (string_.capacity() && (!m_highWater || string_.capacity() <= m_highWater)) {
+            spares.tryPush (string_);
+        }
+    };
+
+    /*
+     * How many results have been written, the reader waiting whenever
+     * it gets this far ahead so one slow blob can't leave everything read
+     * since waiting in memory for it
+     */
+    std::atomic<uint64_t> written { 0 };
+    const uint64_t window { 4 * m_depth + m_workers };
+
+    auto resumeAt = m_progress.resumeAt();
+
+    auto files = count_ ? BulkReader::make (Pipeline::BUFFERS, BUFFER) : nullptr;
+
+    std::thread reader ([&] {
+        uint64_t seq { 0 };
+
+        /*
+         * Wait until everything up to [seq_] may be read
+         */
+        auto admit = [&](uint64_t seq_) {
+            for (unsigned attempt { 0 } ; seq_ >= written.load() + window ; ++attempt) {
+                std::this_thread::sleep_for (std::chrono::microseconds (
+                    std::min (1000U, 10U << std::min (attempt, 7U))));
+            }
+        };
+
+        auto push = [&](Job & job_) {
+            job_.m_skip = job_.m_skip || job_.m_seq < resumeAt;
+
+            jobs.push (std::move (job_));
+        };
+
+        if (lines_) {
+            std::string line;
+
+            for (size_t n { 1 } ; spare (line), std::getline (*lines_, line) ; ++n) {
+                Job job;
+                job.m_seq = seq++;
+                job.m_name = "line " + std::to_string (n);
+                job.m_line = true;
+                job.m_skip = line.find_first_not_of (" \t\r") == std::string::npos;
+                job.m_input = std::move (line);
+
+                admit (job.m_seq);
+                push (job);
+            }
+        }
+
+        /*
+         * The files are handed to the bulk reader a window's worth at a
+         * time, they come back in whatever order they were read but
+         * nothing in them can be further ahead of the writer than that
+         */
+        std::vector<const char *> reads;
+        std::vector<uint64_t> seqs;
+
+        for (int i { 0 } ; i < count_ ; ) {
+            auto chunk = std::min (static_cast<uint64_t> (count_ - i), m_depth);
+            admit (seq + chunk - 1);
+
+            reads.clear();
+            seqs.clear();
+
+            for (auto end = i + static_cast<int> (chunk) ; i < end ; ++i) {
+                Job job;
+                job.m_seq = seq++;
+                job.m_name = files_[i];
+                job.m_input = files_[i];
+
+                if (job.m_seq < resumeAt) {
+                    push (job);
+                } else if (strcmp (files_[i], "-") == 0) {
+                    job.m_bytes.assign (
+                        std::istreambuf_iterator<char> (std::cin),
+                        std::istreambuf_iterator<char>());
+
+                    push (job);
+                } else {
+                    reads.push_back (files_[i]);
+                    seqs.push_back (job.m_seq);
+                }
+            }
+
+            files->read (reads, [&](BulkReader::Read && read_) {
+                Job job;
+                job.m_seq = seqs[read_.index];
+                job.m_name = reads[read_.index];
+                job.m_input = reads[read_.index];
+
+                if (read_.whole) {
+                    job.m_buffer = std::move (read_.bytes);
+                    job.m_size = read_.size;
+                } else if (read_.error == ENOENT || read_.error == EISDIR) {
+                    job.m_error = "Not a file";
+                } else if (read_.error) {
+                    job.m_error = std::string ("Can't read, ") + strerror (read_.error);
+                } else {
+                    try {
+                        job.m_mapping = std::make_shared<Mapping> (job.m_input);
+                    } catch (const std::exception & e) {
+                        job.m_error = e.what();
+                    }
+                }
+
+                push (job);
+            });
+        }
+
+        jobs.close();
+    });
+
+    std::atomic<unsigned> working { m_workers };
+    std::vector<std::thread> workers;
+
+    for (unsigned i { 0 } ; i < m_workers ; ++i) {
+        workers.emplace_back ([&] {
+            auto decode = worker_();
+
+            for (Job job ; jobs.pop (job) ; ) {
+                Result result;
+                result.seq = job.m_seq;
+                result.skip = job.m_skip;
+
+                if (!job.m_skip) {
+                    spare (result.output);
+
+                    try {
+                        result.rejected = !decode (job, result.output);
+                    } catch (const std::exception & e) {
+                        result.output.clear();
+                        result.error = amqp::internal::DecodeError::of (e, "");
+                    }
+
+                    result.name = std::move (job.m_name);
+                    result.input = std::move (job.m_input);
+                }
+
+                /*
+                 * Give the job's buffer back before waiting on anything,
+                 * were there more of us than buffers those we held would
+                 * leave the reader waiting on a buffer forever
+                 */
+                job = Job();
+
+                results.push (std::move (result));
+            }
+
+            if (--working == 0) {
+                results.close();
+            }
+        });
+    }
+
+    /*
+     * Results come back in whatever order the workers finish them so any
+     * that are ahead of the next one to write wait here
+     */
+    std::map<uint64_t, Result> pending;
+    std::string buffer;
+    uint64_t next { 0 };
+
+    auto flush = [&] {
+        if (!buffer.empty()) {
+            out_.write (buffer.data(), buffer.size());
+            out_.flush();
+
+            m_metrics.writes++;
+            m_metrics.bytes += buffer.size();
+
+            buffer.clear();
+        }
+    };
+
+    auto write = [&](Result & result_) {
+        if (!m_progress.next (flush) || result_.skip) {
+            return;
+        }
+
+        if (result_.error) {
+            m_progress.quarantine().failed (*result_.error, result_.name, result_.input);
+        } else {
+            buffer += result_.output;
+
+            if (result_.rejected) {
+                m_progress.quarantine().add (result_.input);
+            }
+        }
+
+        if (buffer.size() >= WRITE) {
+            flush();
+        }
+    };
+
+    for (Result result ; results.pop (result) ; ) {
+        pending.emplace (result.seq, std::move (result));
+
+        for (auto it = pending.begin() ;
+             it != pending.end() && it->first == next ;
+             it = pending.erase (it))
+        {
+            write (it->second);
+            written = ++next;
+
+            recycle (it->second.output);
+            recycle (it->second.input);
+        }
+
+        /*
+         * Nothing more is ready, rather than sit on what we have let
+         * whoever's reading it see it
+         */
+        if (results.size() == 0) {
+            flush();
+        }
+    }
+
+    reader.join();
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+
+    flush();
+
+    m_metrics.jobs = jobs.metrics();
+    m_metrics.results = results.metrics();
+    m_metrics.inputs = next;
+    m_metrics.reader = files ? files->name() : nullptr;
+
+    return m_progress.finish();
+}
+
+/******************************************************************************/
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <iosfwd>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include <string_view>
+
+#include "Queue.h"
+#include "Progress.h"
+
+#include "amqp/DecodeError.h"
+
+/******************************************************************************/
+
+/**
+ * Runs a batch as three stages, each on its own threads, so reading the
+ * next blobs, decoding those already read and writing out those decoded
+ * all happen at once rather than each waiting on the others.
+ *
+ *  - a reader takes each input in turn, a line of stdin or a file. Files
+ *    are read many at a time by a [BulkReader], those too large for its
+ *    buffers being mapped and read ahead instead. Having only the one
+ *    reader keeps the disk read close to the order the inputs were given.
+ *  - as many workers as asked for each decode whichever input is next,
+ *    each with its own decoder so each keeps its own schema cache, into
+ *    a buffer of their own. Those buffers, and the lines read, go back
+ *    to a pool once written so in a long batch they stop being allocated.
+ *  - the writer, the thread calling [run], puts the results back into
+ *    the order their inputs were in and writes them out in large writes.
+ *    Failures are reported, and progress recorded, from here too, so
+ *    everything the batch says is in the same order it would have been
+ *    had the blobs been decoded one at a time.
+ *
+ * The stages are joined by bounded [Queue]s, and the reader is never
+ * allowed too far ahead of the writer, so however slow one blob is to
+ * decode the rest of the batch can't pile up in memory behind it.
+ */
+class Pipeline {
+    public :
+        class Job;
+
+        /**
+         * What a worker does with a blob, appending whatever is to be
+         * written out for it to [out_]. Failing to decode it is thrown.
+         *
+         * @return false if the blob was rejected, it having said as much
+         * in its output, the writer then only quarantining it
+         */
+        using Decode = std::function<bool (const Job &, std::string & out_)>;
+
+        /**
+         * Called on each worker's thread to make the decode it'll use for
+         * everything it's given, so anything it keeps between blobs is its
+         * own
+         */
+        using Worker = std::function<Decode()>;
+
+        struct Metrics {
+            QueueMetrics jobs;
+            QueueMetrics results;
+
+            /**
+             * how files were read, null if there weren't any
+             */
+            const char * reader;
+
+            size_t inputs;
+            size_t writes;
+            size_t bytes;
+        };
+
+    private :
+        struct Mapping;
+        struct Result;
+
+        Progress & m_progress;
+        unsigned m_workers;
+        size_t m_depth;
+        size_t m_highWater;
+
+        Metrics m_metrics;
+
+    public :
+        static constexpr size_t DEPTH = 256;
+
+        /**
+         * Files are read into this many buffers, those too large for one
+         * being mapped
+         */
+        static constexpr size_t BUFFERS = 128;
+
+        /**
+         * @param depth_ how many inputs may be queued between each stage
+         * @param highWater_ the lines read and the output decoded from
+         * them are kept once written for the inputs after them to reuse,
+         * other than any larger than this many bytes. 0 keeps them all.
+         */
+        Pipeline (
+            Progress &,
+            unsigned workers_,
+            size_t depth_ = DEPTH,
+            size_t highWater_ = 0);
+
+        /**
+         * Decode every line of [lines_], if there is one, and then every
+         * file named, writing the results to [out_]
+         *
+         * @return how the batch as a whole should exit
+         */
+        int run (
+            std::istream * lines_,
+            char ** files_,
+            int count_,
+            const Worker &,
+            std::ostream & out_);
+
+        const Metrics & metrics() const { return m_metrics; }
+
+        size_t highWater() const { return m_highWater; }
+};
+
+/******************************************************************************/
+
+/**
+ * One input, as the reader found it
+ */
+class Pipeline::Job {
+    private :
+        friend class Pipeline;
+
+        uint64_t m_seq { 0 };
+
+        std::string m_name;
+        std::string m_input;
+
+        bool m_skip { false };
+        bool m_line { false };
+
+        std::shared_ptr<Mapping> m_mapping;
+        std::shared_ptr<const char> m_buffer;
+        size_t m_size { 0 };
+        std::vector<char> m_bytes;
+
+        std::string m_error;
+
+    public :
+        /**
+         * e.g. "line 12", or the file name
+         */
+        const std::string & name() const { return m_name; }
+
+        /**
+         * The line or file name, what's quarantined should it fail
+         */
+        const std::string & input() const { return m_input; }
+
+        /**
+         * The blob's bytes, decoding them into [scratch_] if they were
+         * given to us as text. Throws if the input couldn't be read.
+         */
+        std::string_view blob (std::vector<char> & scratch_) const;
+};
+
+/******************************************************************************/
@@ -0,0 +1,196 @@
+#include "Progress.h"
+
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/******************************************************************************/
+
+namespace {
+
+    uint64_t
+    size (int fd_, const char * what_) {
+        struct stat results { };
+
+        if (fstat (fd_, &results) != 0) {
+            throw std::runtime_error (std::string ("Can't stat ") + what_);
+        }
+
+        return static_cast<uint64_t>(results.st_size);
+    }
+
+    void
+    sync (int fd_, const char * what_) {
+        if (fdatasync (fd_) != 0) {
+            throw std::runtime_error (std::string ("Failed to sync ") + what_);
+        }
+    }
+
+}
+
+/******************************************************************************/
+
+Progress::Progress (
+    std::ostream & log_,
+    const char * journal_,
+    const char * quarantine_,
+    std::chrono::milliseconds interval_
+) : m_journal (journal_
+        ? std::make_unique<Journal> (journal_)
+        : nullptr)
+  , m_rejectsFd (-1)
+  , m_quarantine (
+        log_,
+        quarantine_ ? &m_rejects : nullptr,
+        m_journal ? m_journal->last().failures : 0)
+  , m_inputs (0)
+  , m_resumeAt (m_journal ? m_journal->last().inputs : 0)
+  , m_recorded (m_resumeAt)
+  , m_interval (interval_)
+  , m_recordedAt (std::chrono::steady_clock::now())
+{
+    bool resuming = m_journal && !m_journal->empty();
+
+    if (m_journal) {
+        struct stat results { };
+
+        if (fstat (STDOUT_FILENO, &results) != 0 || !S_ISREG (results.st_mode)) {
+            throw std::runtime_error (
+                "A journaled batch has to write to a file, stdout isn't one");
+        }
+
+        auto output = m_journal->last().output;
+
+        if (resuming) {
+            if (static_cast<uint64_t>(results.st_size) < output) {
+                throw std::runtime_error (
+                    "stdout is shorter than the journal says it should be,"
+                    " to resume it has to be appended to with >>");
+            }
+
+            if (ftruncate (STDOUT_FILENO, static_cast<off_t>(output)) != 0
+                || lseek (STDOUT_FILENO, 0, SEEK_END) < 0)
+            {
+                throw std::runtime_error ("Can't truncate stdout");
+            }
+        }
+    }
+
+    if (quarantine_) {
+        if (resuming) {
+            if (truncate (quarantine_, static_cast<off_t>(m_journal->last().rejects)) != 0
+                && m_journal->last().rejects)
+            {
+                throw std::runtime_error (
+                    std::string ("Can't truncate the quarantine ") + quarantine_);
+            }
+
+            m_rejects.open (quarantine_, std::ios::out | std::ios::app);
+        } else {
+            m_rejects.open (quarantine_, std::ios::out);
+        }
+
+        if (!m_rejects) {
+            throw std::runtime_error (std::string ("Can't write to ") + quarantine_);
+        }
+
+        if (m_journal && (m_rejectsFd = open (quarantine_, O_WRONLY)) < 0) {
+            throw std::runtime_error (std::string ("Can't open ") + quarantine_);
+        }
+    }
+
+    /*
+     * Whatever stdout already holds, if it's being appended to, isn't
+     * ours and needs to survive a resume
+     */
+    if (m_journal && !resuming) {
+        record (nullptr);
+    }
+}
+
+/******************************************************************************/
+
+Progress::~Progress() {
+    if (m_rejectsFd >= 0) {
+        close (m_rejectsFd);
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * Everything we've written, [flush_] writing whatever's been held back of
+ * it, has to be on disk before the journal says it is, so it's synced first
+ */
+void
+Progress::record (const std::function<void()> & flush_) {
+    if (flush_) {
+        flush_();
+    }
+
+    std::cout.flush();
+    sync (STDOUT_FILENO, "stdout");
+
+    uint64_t rejects { 0 };
+
+    if (m_rejectsFd >= 0) {
+        m_rejects.flush();
+        sync (m_rejectsFd, "the quarantine");
+
+        rejects = size (m_rejectsFd, "the quarantine");
+    }
+
+    m_journal->record (
+        m_inputs,
+        size (STDOUT_FILENO, "stdout"),
+        rejects,
+        m_quarantine.failures());
+
+    m_recorded = m_inputs;
+    m_recordedAt = std::chrono::steady_clock::now();
+}
+
+/******************************************************************************/
+
+bool
+Progress::due() const {
+    return m_journal
+        && m_inputs >= m_resumeAt
+        && m_inputs != m_recorded
+        && (m_inputs - m_recorded >= INPUTS
+            || std::chrono::steady_clock::now() - m_recordedAt >= m_interval);
+}
+
+/******************************************************************************/
+
+bool
+Progress::next (const std::function<void()> & flush_) {
+    if (m_inputs < m_resumeAt) {
+        ++m_inputs;
+        return false;
+    }
+
+    if (due()) {
+        record (flush_);
+    }
+
+    ++m_inputs;
+
+    return true;
+}
+
+/******************************************************************************/
+
+int
+Progress::finish() {
+    if (m_journal) {
+        record (nullptr);
+    }
+
+    return m_quarantine.finish();
+}
+
+/******************************************************************************/
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <string>
+#include <fstream>
+#include <cstdint>
+
+#include "types.h"
+#include "Journal.h"
+#include "Quarantine.h"
+
+/******************************************************************************/
+
+/**
+ * How far a batch has got through its input, and so where it should pick
+ * up again should it be killed. Each input, a line of stdin or a file,
+ * is announced by [next] and is taken to have been dealt with once the
+ * next one is. Every so often what's been dealt with is recorded in a
+ * [Journal], after the output, on stdout, and the quarantine have been
+ * synced to disk.
+ *
+ * Given a journal that's already got somewhere the inputs it says have
+ * been dealt with are skipped, and stdout and the quarantine cut back to
+ * how large they were at the time. For that stdout has to be a file, and
+ * one appended to with >> rather than truncated by the shell, the same
+ * inputs have to be given in the same order, and the same options.
+ *
+ * Without a journal nothing's skipped or recorded.
+ */
+class Progress {
+    private :
+        /**
+         * How often, at most, progress is recorded
+         */
+        static constexpr uint64_t INPUTS = 4096;
+        static constexpr std::chrono::seconds INTERVAL { 1 };
+
+        uPtr<Journal> m_journal;
+
+        std::ofstream m_rejects;
+        int m_rejectsFd;
+
+        Quarantine m_quarantine;
+
+        uint64_t m_inputs;
+        uint64_t m_resumeAt;
+        uint64_t m_recorded;
+
+        std::chrono::steady_clock::duration m_interval;
+        std::chrono::steady_clock::time_point m_recordedAt;
+
+        bool due() const;
+        void record (const std::function<void()> & flush_);
+
+    public :
+        /**
+         * @param journal_ null for a batch that isn't journaled
+         * @param quarantine_ null if there's nowhere failed inputs go
+         * @param interval_ the longest progress goes unrecorded
+         */
+        Progress (
+            std::ostream & log_,
+            const char * journal_,
+            const char * quarantine_,
+            std::chrono::milliseconds interval_ = INTERVAL);
+        ~Progress();
+
+        Progress (const Progress &) = delete;
+        Progress & operator = (const Progress &) = delete;
+
+        Quarantine & quarantine() { return m_quarantine; }
+
+        /**
+         * How many inputs an earlier run dealt with
+         */
+        uint64_t resumeAt() const { return m_resumeAt; }
+
+        /**
+         * Another input is about to be dealt with, everything before it
+         * has been
+         *
+         * @param flush_ should progress be recorded, called first to
+         * write whatever's been held back of the output of the inputs
+         * already dealt with
+         * @return false if an earlier run dealt with it, so it should be
+         * skipped
+         */
+        bool next (const std::function<void()> & flush_ = nullptr);
+
+        /**
+         * Everything's been dealt with
+         *
+         * @return how the batch as a whole should exit
+         */
+        int finish();
+};
+
+/******************************************************************************/
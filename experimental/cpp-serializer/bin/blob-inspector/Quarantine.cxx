@@ -0,0 +1,62 @@
+#include "Quarantine.h"
+
+#include <cstdlib>
+#include <ostream>
+
+#include "amqp/DecodeError.h"
+
+/******************************************************************************/
+
+Quarantine::Quarantine (
+    std::ostream & log_,
+    std::ostream * quarantine_,
+    size_t failed_
+) : m_log (log_)
+  , m_quarantine (quarantine_)
+  , m_failed (failed_)
+{
+}
+
+/******************************************************************************/
+
+void
+Quarantine::failed (
+    const std::exception & e_,
+    const std::string & blob_,
+    const std::string & input_
+) {
+    m_log << amqp::internal::DecodeError::of (e_, blob_).what() << std::endl;
+
+    add (input_);
+}
+
+/******************************************************************************/
+
+void
+Quarantine::add (const std::string & input_) {
+    ++m_failed;
+
+    if (m_quarantine) {
+        *m_quarantine << input_ << '\n';
+    }
+}
+
+/******************************************************************************/
+
+int
+Quarantine::finish() {
+    if (!m_failed) {
+        return EXIT_SUCCESS;
+    }
+
+    if (m_quarantine) {
+        m_quarantine->flush();
+    }
+
+    m_log << m_failed << (m_failed == 1 ? " blob" : " blobs") << " failed"
+        << (m_quarantine ? ", quarantined" : "") << std::endl;
+
+    return EXIT_FAILURE;
+}
+
+/******************************************************************************/
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <iosfwd>
+#include <stdexcept>
+
+/******************************************************************************/
+
+/**
+ * Keeps track of the blobs of a batch that couldn't be decoded so the
+ * batch can carry on without them. Each failure is reported as a
+ * [DecodeError], saying which blob it was and whereabouts in its
+ * envelope things went wrong, and whatever the blob was handed to us as,
+ * its line of stdin or the name of its file, is written to the quarantine
+ * should there be one.
+ *
+ * A quarantine is therefore itself a batch: fed back in as stdin, or as
+ * the list of files, only the blobs that failed are looked at again.
+ */
+class Quarantine {
+    private :
+        std::ostream & m_log;
+        std::ostream * m_quarantine;
+
+        size_t m_failed;
+
+    public :
+        /**
+         * @param quarantine_ where failed blobs go, there needn't be
+         * anywhere
+         * @param failed_ how many failed before, when carrying on from
+         * where an earlier run left off
+         */
+        explicit Quarantine (
+            std::ostream & log_,
+            std::ostream * quarantine_ = nullptr,
+            size_t failed_ = 0);
+
+        /**
+         * [blob_] names the blob in the report, [input_] is what's
+         * quarantined
+         */
+        void failed (
+            const std::exception &,
+            const std::string & blob_,
+            const std::string & input_);
+
+        /**
+         * For failures that have been reported some other way
+         */
+        void add (const std::string & input_);
+
+        size_t failures() const { return m_failed; }
+
+        /**
+         * Say how many blobs failed, if any did
+         *
+         * @return how the batch as a whole should exit
+         */
+        int finish();
+};
+
+/******************************************************************************/
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cstddef>
+#include <algorithm>
+
+/******************************************************************************/
+
+/**
+ * How a [Queue] has been used
+ */
+struct QueueMetrics {
+    size_t capacity;
+    size_t pushes;
+
+    /**
+     * the most there's been in the queue at once
+     */
+    size_t highWater;
+
+    /**
+     * summed over every push, divided by [pushes] it's how full the queue
+     * was on average
+     */
+    size_t depths;
+
+    /**
+     * how many pushes found the queue full, and how many pops found it
+     * empty
+     */
+    size_t fullWaits;
+    size_t emptyWaits;
+
+    double meanDepth() const {
+        return pushes ? static_cast<double>(depths) / pushes : 0.0;
+    }
+};
+
+/******************************************************************************/
+
+/**
+ * A bounded queue any number of threads may push onto and pop from
+ * without taking a lock. Each slot carries a sequence number saying
+ * whether it's waiting to be filled or emptied on the current lap around
+ * the ring, a thread claims a slot by advancing the head or tail past it
+ * and then owns it until it bumps the slot's sequence.
+ *
+ * Pushing onto a full queue, or popping from an empty one, waits: first
+ * by yielding, then by sleeping for a little longer each time. How often
+ * either happens, along with how full the queue tends to be, is kept as
+ * [QueueMetrics], they being what says which side of a pipeline is the
+ * bottleneck.
+ */
+template<typename T>
+class Queue {
+    private :
+        struct Slot {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        size_t m_mask;
+
+        alignas (64) std::atomic<size_t> m_head;
+        alignas (64) std::atomic<size_t> m_tail;
+        alignas (64) std::atomic<bool> m_closed;
+
+        std::atomic<size_t> m_pushes;
+        std::atomic<size_t> m_highWater;
+        std::atomic<size_t> m_depths;
+        std::atomic<size_t> m_fullWaits;
+        std::atomic<size_t> m_emptyWaits;
+
+        static size_t capacity (size_t capacity_) {
+            size_t rtn { 2 };
+
+            while (rtn < capacity_) {
+                rtn <<= 1U;
+            }
+
+            return rtn;
+        }
+
+        static void wait (unsigned & attempt_) {
+            if (attempt_ < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for (std::chrono::microseconds (
+                    std::min (1000U, 10U << std::min (attempt_ - 64, 7U))));
+            }
+
+            ++attempt_;
+        }
+
+        void pushed() {
+            auto depth = size();
+
+            m_pushes.fetch_add (1, std::memory_order_relaxed);
+            m_depths.fetch_add (depth, std::memory_order_relaxed);
+
+            auto high = m_highWater.load (std::memory_order_relaxed);
+
+            while (depth > high && !m_highWater.compare_exchange_weak (
+                    high, depth, std::memory_order_relaxed))
+            { }
+        }
+
+    public :
+        /**
+         * The capacity is rounded up to a power of two
+         */
+        explicit Queue (size_t capacity_)
+            : m_slots (new Slot[capacity (capacity_)])
+            , m_mask (capacity (capacity_) - 1)
+            , m_head (0)
+            , m_tail (0)
+            , m_closed (false)
+            , m_pushes (0)
+            , m_highWater (0)
+            , m_depths (0)
+            , m_fullWaits (0)
+            , m_emptyWaits (0)
+        {
+            for (size_t i { 0 } ; i <= m_mask ; ++i) {
+                m_slots[i].sequence.store (i, std::memory_order_relaxed);
+            }
+        }
+
+        Queue (const Queue &) = delete;
+        Queue & operator = (const Queue &) = delete;
+
+        /**
+         * @return false, leaving [value_] alone, if the queue is full
+         */
+        bool tryPush (T & value_) {
+            auto pos = m_head.load (std::memory_order_relaxed);
+
+            for (;;) {
+                auto & slot = m_slots[pos & m_mask];
+                auto seq = slot.sequence.load (std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+                if (diff == 0) {
+                    if (m_head.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed)) {
+                        slot.value = std::move (value_);
+                        slot.sequence.store (pos + 1, std::memory_order_release);
+                        pushed();
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_head.load (std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @return false if the queue is empty
+         */
+        bool tryPop (T & value_) {
+            auto pos = m_tail.load (std::memory_order_relaxed);
+
+            for (;;) {
+                auto & slot = m_slots[pos & m_mask];
+                auto seq = slot.sequence.load (std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+                if (diff == 0) {
+                    if (m_tail.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed)) {
+                        value_ = std::move (slot.value);
+                        slot.sequence.store (pos + m_mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_tail.load (std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void push (T value_) {
+            if (tryPush (value_)) {
+                return;
+            }
+
+            m_fullWaits.fetch_add (1, std::memory_order_relaxed);
+
+            for (unsigned attempt { 0 } ; !tryPush (value_) ; ) {
+                wait (attempt);
+            }
+        }
+
+        /**
+         * Waits for something to pop
+         *
+         * @return false once the queue's been closed and emptied
+         */
+        bool pop (T & value_) {
+            if (tryPop (value_)) {
+                return true;
+            }
+
+            m_emptyWaits.fetch_add (1, std::memory_order_relaxed);
+
+            for (unsigned attempt { 0 } ; ; ) {
+                if (tryPop (value_)) {
+                    return true;
+                }
+
+                /*
+                 * Anything pushed before the close is visible once the
+                 * close is, so one last look settles it
+                 */
+                if (m_closed.load (std::memory_order_acquire)) {
+                    return tryPop (value_);
+                }
+
+                wait (attempt);
+            }
+        }
+
+        /**
+         * Nothing more will be pushed
+         */
+        void close() {
+            m_closed.store (true, std::memory_order_release);
+        }
+
+        /**
+         * Only a snapshot, other threads may be pushing and popping
+         */
+        size_t size() const {
+            auto head = m_head.load (std::memory_order_relaxed);
+            auto tail = m_tail.load (std::memory_order_relaxed);
+
+            return head > tail ? head - tail : 0;
+        }
+
+        QueueMetrics metrics() const {
+            return {
+                m_mask + 1,
+                m_pushes.load(),
+                m_highWater.load(),
+                m_depths.load(),
+                m_fullWaits.load(),
+                m_emptyWaits.load()
+            };
+        }
+};
+
+/******************************************************************************/
@@ -0,0 +1,360 @@
+#include "TextDecoder.h"
+
+#include <array>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "amqp/AMQPHeader.h"
+
+/******************************************************************************/
+
+namespace {
+
+    bool
+    space (char c_) {
+        return c_ == ' ' || c_ == '\n' || c_ == '\r' || c_ == '\t';
+    }
+
+    /**
+     * The textual forms of the start of the Corda header, "corda" being
+     * five bytes the base64 form of the first six characters doesn't
+     * depend on what follows
+     */
+    const std::string hexHeader { "636f726461" }; // NOLINT
+    const std::string base64Header { "Y29yZGE" }; // NOLINT
+
+    bool
+    startsWith (const char * text_, size_t size_, const std::string & prefix_) {
+        if (size_ < prefix_.size()) {
+            return false;
+        }
+
+        for (size_t i { 0 } ; i < prefix_.size() ; ++i) {
+            if ((text_[i] | 0x20) != prefix_[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Skip past leading whitespace and any 0x or \x hex prefix
+     */
+    size_t
+    start (const char * text_, size_t size_) {
+        size_t i { 0 };
+
+        while (i < size_ && space (text_[i])) {
+            ++i;
+        }
+
+        if (size_ - i >= 2
+            && (text_[i] == '0' || text_[i] == '\\')
+            && text_[i + 1] == 'x')
+        {
+            i += 2;
+        }
+
+        return i;
+    }
+
+    int
+    nibble (char c_) {
+        if (c_ >= '0' && c_ <= '9') {
+            return c_ - '0';
+        }
+
+        c_ |= 0x20;
+
+        if (c_ >= 'a' && c_ <= 'f') {
+            return c_ - 'a' + 10;
+        }
+
+        return -1;
+    }
+
+#ifdef __SSE2__
+
+    /**
+     * Turn 16 characters into their nibble values, returning false if any
+     * of them isn't a hex digit. Bytes above 0x7f compare as negative and
+     * so fall outside both ranges.
+     */
+    bool
+    nibbles (const char * text_, __m128i & out_) {
+        auto v = _mm_loadu_si128 (reinterpret_cast<const __m128i *>(text_));
+        auto l = _mm_or_si128 (v, _mm_set1_epi8 (0x20));
+
+        auto digit = _mm_and_si128 (
+            _mm_cmpgt_epi8 (v, _mm_set1_epi8 ('0' - 1)),
+            _mm_cmpgt_epi8 (_mm_set1_epi8 ('9' + 1), v));
+
+        auto alpha = _mm_and_si128 (
+            _mm_cmpgt_epi8 (l, _mm_set1_epi8 ('a' - 1)),
+            _mm_cmpgt_epi8 (_mm_set1_epi8 ('f' + 1), l));
+
+        if (_mm_movemask_epi8 (_mm_or_si128 (digit, alpha)) != 0xffff) {
+            return false;
+        }
+
+        out_ = _mm_or_si128 (
+            _mm_and_si128 (digit, _mm_sub_epi8 (v, _mm_set1_epi8 ('0'))),
+            _mm_and_si128 (alpha, _mm_sub_epi8 (l, _mm_set1_epi8 ('a' - 10))));
+
+        return true;
+    }
+
+    /**
+     * Pairs of nibbles, high first, into bytes. Each 16 bit lane holds
+     * a pair with the high nibble in its low byte.
+     */
+    __m128i
+    pairs (__m128i nibbles_) {
+        return _mm_or_si128 (
+            _mm_slli_epi16 (_mm_and_si128 (nibbles_, _mm_set1_epi16 (0x00ff)), 4),
+            _mm_srli_epi16 (nibbles_, 8));
+    }
+
+    /**
+     * Decode as many whole blocks of 32 characters as we can, stopping
+     * at the first one that contains anything other than hex digits and
+     * leaving it, and the tail, for the scalar loop
+     */
+    size_t
+    hexBlocks (const char * text_, size_t size_, char * out_) {
+        size_t i { 0 };
+
+        for ( ; i + 32 <= size_ ; i += 32, out_ += 16) {
+            __m128i a, b;
+
+            if (!nibbles (text_ + i, a) || !nibbles (text_ + i + 16, b)) {
+                break;
+            }
+
+            _mm_storeu_si128 (
+                reinterpret_cast<__m128i *>(out_),
+                _mm_packus_epi16 (pairs (a), pairs (b)));
+        }
+
+        return i;
+    }
+
+#else
+
+    size_t
+    hexBlocks (const char *, size_t, char *) {
+        return 0;
+    }
+
+#endif
+
+    const std::array<uint8_t, 256> base64 = [] { // NOLINT
+        std::array<uint8_t, 256> table { };
+        table.fill (0xff);
+
+        const char * alphabet =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        for (uint8_t i { 0 } ; i < 64 ; ++i) {
+            table[static_cast<uint8_t>(alphabet[i])] = i;
+        }
+
+        return table;
+    }();
+
+}
+
+/******************************************************************************/
+
+text::Encoding
+text::detect (const char * text_, size_t size_) {
+    if (size_ >= amqp::AMQP_HEADER.size()
+        && std::memcmp (text_, amqp::AMQP_HEADER.data(), amqp::AMQP_HEADER.size()) == 0)
+    {
+        return binary_t;
+    }
+
+    size_t i { 0 };
+
+    while (i < size_ && space (text_[i])) {
+        ++i;
+    }
+
+    if (start (text_, size_) != i || startsWith (text_ + i, size_ - i, hexHeader)) {
+        return hex_t;
+    }
+
+    if (size_ - i >= base64Header.size()
+        && std::strncmp (text_ + i, base64Header.data(), base64Header.size()) == 0)
+    {
+        return base64_t;
+    }
+
+    throw std::runtime_error ("Not a Corda blob in binary, hex or base64");
+}
+
+/******************************************************************************/
+
+void
+text::fromHex (const char * text_, size_t size_, std::vector<char> & out_) {
+    size_t i = start (text_, size_);
+
+    auto base = out_.size();
+    out_.resize (base + (size_ - i) / 2);
+
+    auto * out = out_.data() + base;
+
+    int high { -1 };
+
+    while (i < size_) {
+        /*
+         * The fast path only runs from a byte boundary, whitespace
+         * in the middle of a byte is odd enough not to care about
+         */
+        if (high < 0) {
+            auto n = hexBlocks (text_ + i, size_ - i, out);
+            i += n;
+            out += n / 2;
+
+            if (i == size_) {
+                break;
+            }
+        }
+
+        auto c = text_[i++];
+
+        if (space (c)) {
+            continue;
+        }
+
+        auto n = nibble (c);
+
+        if (n < 0) {
+            throw std::runtime_error (
+                "Bad hex character at offset " + std::to_string (i - 1));
+        }
+
+        if (high < 0) {
+            high = n;
+        } else {
+            *out++ = static_cast<char>((high << 4) | n);
+            high = -1;
+        }
+    }
+
+    if (high >= 0) {
+        throw std::runtime_error ("Odd number of hex digits");
+    }
+
+    out_.resize (out - out_.data());
+}
+
+/******************************************************************************/
+
+void
+text::fromBase64 (const char * text_, size_t size_, std::vector<char> & out_) {
+    auto base = out_.size();
+    out_.resize (base + (size_ / 4 + 1) * 3);
+
+    auto * out = reinterpret_cast<uint8_t *>(out_.data() + base);
+    auto * in = reinterpret_cast<const uint8_t *>(text_);
+
+    size_t i { 0 };
+    uint32_t acc { 0 };
+    int have { 0 };
+
+    while (i < size_) {
+        /*
+         * Whole quads with nothing in the way, an invalid character maps
+         * to 0xff so a single test of the combined values catches it
+         */
+        if (!have) {
+            for ( ; i + 4 <= size_ ; i += 4) {
+                auto a = base64[in[i]], b = base64[in[i + 1]];
+                auto c = base64[in[i + 2]], d = base64[in[i + 3]];
+
+                if ((a | b | c | d) & 0xc0) {
+                    break;
+                }
+
+                uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+
+                *out++ = v >> 16;
+                *out++ = v >> 8;
+                *out++ = v;
+            }
+
+            if (i == size_) {
+                break;
+            }
+        }
+
+        auto c = text_[i++];
+        auto v = base64[static_cast<uint8_t>(c)];
+
+        if (v < 64) {
+            acc = (acc << 6) | v;
+
+            if (++have == 4) {
+                *out++ = acc >> 16;
+                *out++ = acc >> 8;
+                *out++ = acc;
+                acc = 0;
+                have = 0;
+            }
+        } else if (c == '=') {
+            break;
+        } else if (!space (c)) {
+            throw std::runtime_error (
+                "Bad base64 character at offset " + std::to_string (i - 1));
+        }
+    }
+
+    /*
+     * Only padding and whitespace can follow padding
+     */
+    for ( ; i < size_ ; ++i) {
+        if (text_[i] != '=' && !space (text_[i])) {
+            throw std::runtime_error ("Data after base64 padding");
+        }
+    }
+
+    switch (have) {
+        case 0 : break;
+        case 1 : throw std::runtime_error ("Truncated base64");
+        case 2 :
+            *out++ = acc >> 4;
+            break;
+        case 3 :
+            *out++ = acc >> 10;
+            *out++ = acc >> 2;
+            break;
+    }
+
+    out_.resize (reinterpret_cast<char *>(out) - out_.data());
+}
+
+/******************************************************************************/
+
+void
+text::decode (const char * text_, size_t size_, std::vector<char> & out_) {
+    switch (detect (text_, size_)) {
+        case binary_t :
+            out_.insert (out_.end(), text_, text_ + size_);
+            break;
+        case hex_t :
+            fromHex (text_, size_, out_);
+            break;
+        case base64_t :
+            fromBase64 (text_, size_, out_);
+            break;
+    }
+}
+
+/******************************************************************************/
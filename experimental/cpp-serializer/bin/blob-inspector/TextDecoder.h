@@ -0,0 +1,43 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <vector>
+#include <cstddef>
+
+/******************************************************************************
+ *
+ * Database tooling hands blobs over as text, either hex (optionally with
+ * the \x prefix Postgres puts on bytea) or base64. Rather than have to
+ * convert them before we can look at them these turn that text back into
+ * the original bytes.
+ *
+ ******************************************************************************/
+
+namespace text {
+
+    enum Encoding { binary_t, hex_t, base64_t };
+
+    /**
+     * Work out what we've been given by looking at how it starts, every
+     * Corda blob begins with the same header and so in each encoding so
+     * do their textual forms
+     */
+    Encoding detect (const char *, size_t);
+
+    /**
+     * Append the decoded form of the text to [out_]. Whitespace (such
+     * as the line breaks put in by xxd and base64) is ignored, anything
+     * else that isn't part of the encoding is an error
+     */
+    void fromHex (const char *, size_t, std::vector<char> & out_);
+    void fromBase64 (const char *, size_t, std::vector<char> & out_);
+
+    /**
+     * Detect and then decode, binary blobs are simply copied
+     */
+    void decode (const char *, size_t, std::vector<char> & out_);
+
+}
+
+/******************************************************************************/
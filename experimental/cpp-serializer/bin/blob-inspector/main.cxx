@@ -1,13 +1,18 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <memory>
+#include <thread>
+#include <optional>
+#include <iterator>
+#include <limits>
 #include <cstddef>
 
-#include <assert.h>
 #include <string.h>
+#include <getopt.h>
 #include <proton/types.h>
 #include <proton/codec.h>
-#include <sys/stat.h>
 
 #include "debug.h"
 
@@ -18,34 +23,919 @@
 #include "amqp/schema/descriptors/AMQPDescriptorRegistory.h"
 
 #include "amqp/schema/described-types/Envelope.h"
+#include "amqp/Limits.h"
+#include "amqp/DecodeError.h"
 #include "amqp/CompositeFactory.h"
 #include "CordaBytes.h"
 #include "BlobInspector.h"
+#include "BlobFilter.h"
+#include "BlobStreamer.h"
+#include "BlobValidator.h"
+#include "Pipeline.h"
+#include "Progress.h"
+#include "TextDecoder.h"
+#include "DecodeContext.h"
+
+#include "amqp/stream/Catalog.h"
+#include "amqp/stream/JSONWriter.h"
+#include "amqp/stream/BlobDecoder.h"
+#include "amqp/stream/ColumnWriter.h"
+#include "amqp/stream/ListSplitter.h"
+#include "amqp/stream/MsgPackWriter.h"
+#include "amqp/stream/OffsetIndex.h"
+
+/******************************************************************************/
+
+namespace {
+
+    void
+    usage (const char * name_) {
+        std::cerr << "usage: " << name_ << " [--stream [--expand]] <blob>" << std::endl
+            << "       " << name_ << " [--stream [--refs]] [--catalog <file>] --batch" << std::endl
+            << "       " << name_ << " --validate [--batch] [<blob>...]" << std::endl
+            << "       " << name_ << " --columns <file> [--catalog <file>] [--batch] [<blob>...]" << std::endl
+            << "       " << name_ << " --msgpack [--refs] [--catalog <file>] [--batch] [<blob>...]" << std::endl
+            << "       " << name_ << " --where <predicate> [--refs] [--batch] [<blob>...]" << std::endl
+            << "       " << name_ << " --index <file> [--query <path>...] [--refs] <blob>" << std::endl
+            << "  -s, --stream    decode the blob a chunk at a time writing"
+            << " values out as they're read" << std::endl
+            << "                  a blob of - is read from stdin" << std::endl
+            << "  -b, --batch     read one hex or base64 blob per line of stdin"
+            << " writing a line of output for each" << std::endl
+            << "  -r, --refs      when streaming write objects that appear more"
+            << " than once as { $ref : n } after the first" << std::endl
+            << "                  the default for a single --stream blob,"
+            << " so its memory stays bounded" << std::endl
+            << "  -x, --expand    write such objects out in full each time,"
+            << " remembering everything decoded" << std::endl
+            << "                  the default for everything bar a single"
+            << " --stream blob" << std::endl
+            << "  -v, --validate  only check each blob would decode, reporting"
+            << " OK or FAIL and why" << std::endl
+            << "  -c, --columns   write the blobs, all of one type, to a column"
+            << " file a row each" << std::endl
+            << "  -m, --msgpack   write each blob to stdout as a MessagePack value"
+            << " rather than as text" << std::endl
+            << "  -w, --where     only write blobs where a property, e.g."
+            << " 'a.b >= 10', holds" << std::endl
+            << "                  compare numbers with == != < <= > >=,"
+            << " strings with == != ^= (starts with)" << std::endl
+            << "  -C, --catalog   build readers for every type in a schema-catalog"
+            << " before decoding anything" << std::endl
+            << "  -i, --index     decode the blob in full noting where each value"
+            << " begins in an index file" << std::endl
+            << "  -q, --query     with an index, decode only the value at a path,"
+            << " e.g. 'a.b' or 'x[1000]'" << std::endl
+            << "  -L, --limit     bound what a blob may make us do, as name=value,"
+            << " any of" << std::endl
+            << "                  depth, elements (per list or map), bytes (of"
+            << " output), types or time (ms)" << std::endl
+            << "                  0 being no limit, a blob exceeding one fails" << std::endl
+            << "  -Q, --quarantine  with a batch, write each blob that fails"
+            << " there, as its line or file name," << std::endl
+            << "                  to be retried on its own" << std::endl
+            << "  -j, --journal   with a batch written to a file, note how far"
+            << " it's got so, if killed," << std::endl
+            << "                  it can be run again with the same input"
+            << " and carry on from there" << std::endl
+            << "  -T, --threads   how many blobs of a batch to decode at once,"
+            << " by default one per core" << std::endl
+            << "  -M, --metrics   once a batch is done report how full the queues"
+            << " between reading," << std::endl
+            << "                  decoding and writing were" << std::endl
+            << "  -H, --high-water  memory kept between the blobs of a batch"
+            << " is given back once a blob" << std::endl
+            << "                  needs more than this many bytes of it,"
+            << " 0 for never" << std::endl
+            << "  -S, --split     streaming a single blob, decode the elements"
+            << " of any list of at least" << std::endl
+            << "                  this many bytes on --threads threads at once,"
+            << " reading it into memory whole" << std::endl;
+    }
+
+    /**
+     * A queue that's usually full is waiting on whatever empties it, one
+     * that's usually empty on whatever fills it
+     */
+    void
+    report (const char * name_, const QueueMetrics & metrics_) {
+        std::cerr << "  " << std::left << std::setw (8) << name_ << std::right
+            << " capacity " << metrics_.capacity
+            << ", mean depth " << std::fixed << std::setprecision (1) << metrics_.meanDepth()
+            << ", high water " << metrics_.highWater
+            << ", waits full " << metrics_.fullWaits
+            << ", empty " << metrics_.emptyWaits << std::endl;
+    }
+
+    void
+    report (const Pipeline::Metrics & metrics_) {
+        std::cerr << metrics_.inputs << " input(s), " << metrics_.bytes
+            << " bytes in " << metrics_.writes << " write(s)";
+
+        if (metrics_.reader) {
+            std::cerr << ", files read with " << metrics_.reader;
+        }
+
+        std::cerr << std::endl;
+
+        report ("decode", metrics_.jobs);
+        report ("write", metrics_.results);
+    }
+
+    /**
+     * We can't seek on a pipe so rather than the [BlobStreamer] push
+     * whatever turns up through a decoder
+     */
+    int
+    streamStdin (
+        amqp::internal::stream::ObjectTable::refs_t refs_,
+        const amqp::internal::Limits & limits_
+    ) {
+        amqp::internal::stream::JSONWriter writer (std::cout);
+        amqp::internal::stream::BlobDecoder decoder (writer, refs_, limits_);
+
+        std::cout << "{ Parsed : ";
+
+        char buffer[64 * 1024];
+        while (!decoder.done() && std::cin.read (buffer, sizeof (buffer)).gcount()) {
+            decoder.feed (buffer, std::cin.gcount());
+        }
+
+        std::cout << " }" << std::endl;
+
+        return decoder.done() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /**
+     * A blob given to us as text has to be decoded in full before we can
+     * look at it so there's nothing to be gained from the [BlobStreamer].
+     * [out_] must be the stream the decoder's writer writes to.
+     */
+    void
+    streamBytes (
+        amqp::internal::stream::BlobDecoder & decoder_,
+        std::ostream & out_,
+        std::string_view bytes_
+    ) {
+        out_ << "{ Parsed : ";
+
+        decoder_.reset();
+        decoder_.feed (bytes_.data(), bytes_.size());
+
+        if (!decoder_.done()) {
+            throw std::runtime_error ("Truncated blob");
+        }
+
+        out_ << " }";
+    }
+
+    /**
+     * Having the readers for every type we're likely to see built before
+     * we start saves each being built part way through the first blob
+     * of its type. A catalog we can't read, or types in it that can't be
+     * built, are reported and left for their first blob to fail on.
+     */
+    void
+    prime (
+        amqp::internal::stream::BlobDecoder & decoder_,
+        const char * catalog_,
+        bool report_ = true
+    ) {
+        if (!catalog_) {
+            return;
+        }
+
+        std::unique_ptr<amqp::internal::stream::Catalog> catalog;
+
+        try {
+            catalog = std::make_unique<amqp::internal::stream::Catalog> (catalog_);
+        } catch (const std::exception & e) {
+            if (report_) {
+                std::cerr << e.what() << std::endl;
+            }
+            return;
+        }
+
+        for (size_t i { 0 } ; i < catalog->types() ; ++i) {
+            auto type = catalog->type (i);
+
+            try {
+                decoder_.prime (
+                    std::string (type.descriptor),
+                    type.schema.data(),
+                    type.schema.size());
+            } catch (const std::exception & e) {
+                if (report_) {
+                    std::cerr << type.name << ": " << e.what() << std::endl;
+                }
+            }
+        }
+    }
+
+    /**
+     * Lines that fail are reported and skipped, the rest of the batch
+     * is still worth decoding. Each worker keeps its own buffers, and when
+     * streaming its own decoder, so each schema is only loaded once per
+     * worker however many blobs share it. Should there be a catalog every
+     * worker primes from it, only the first saying what it couldn't use.
+     * Both decode straight into the output through the worker's context.
+     */
+    int
+    batch (
+        bool stream_,
+        amqp::internal::stream::ObjectTable::refs_t refs_,
+        const char * catalog_,
+        const amqp::internal::Limits & limits_,
+        Pipeline & pipeline_
+    ) {
+        struct State {
+            DecodeContext context;
+            amqp::internal::stream::JSONWriter writer;
+            amqp::internal::stream::BlobDecoder decoder;
+
+            State (
+                amqp::internal::stream::ObjectTable::refs_t refs_,
+                const amqp::internal::Limits & limits_,
+                size_t highWater_
+            ) : context (highWater_)
+              , writer (context.out())
+              , decoder (writer, refs_, limits_)
+            {
+                decoder.highWater (highWater_);
+            }
+        };
+
+        std::atomic<bool> first { true };
+
+        return pipeline_.run (&std::cin, nullptr, 0, [&]() -> Pipeline::Decode {
+            auto state = std::make_shared<State> (refs_, limits_, pipeline_.highWater());
+
+            if (stream_) {
+                prime (state->decoder, catalog_, first.exchange (false));
+            }
+
+            return [state, stream_, &limits_](const Pipeline::Job & job_, std::string & out_) {
+                auto & context = state->context;
+                auto bytes = job_.blob (context.bytes());
+
+                if (stream_) {
+                    streamBytes (state->decoder, context.out (out_), bytes);
+                } else {
+                    auto & cb = context.corda (bytes);
+
+                    if (cb.encoding() != amqp::DATA_AND_STOP
+                        && cb.encoding() != amqp::ALT_DATA_AND_STOP)
+                    {
+                        throw std::runtime_error ("BAD ENCODING");
+                    }
+
+                    BlobInspector (context.data (cb.size()), cb, limits_).dump (
+                        context.out (out_));
+                }
+
+                out_ += '\n';
+
+                context.recycle();
+
+                return true;
+            };
+        }, std::cout);
+    }
+
+    /**
+     * Each file named, or each line of stdin, gets a line saying whether
+     * it's a valid blob
+     */
+    int
+    validate (
+        bool batch_,
+        const amqp::internal::Limits & limits_,
+        Pipeline & pipeline_,
+        char ** files_,
+        int count_
+    ) {
+        return pipeline_.run (batch_ ? &std::cin : nullptr, files_, count_, [&]() -> Pipeline::Decode {
+            auto validator = std::make_shared<BlobValidator> (limits_);
+            auto context = std::make_shared<DecodeContext> (pipeline_.highWater());
+
+            validator->highWater (pipeline_.highWater());
+
+            return [validator, context](const Pipeline::Job & job_, std::string & out_) {
+                std::string reason;
+                bool valid { false };
+
+                try {
+                    auto bytes = job_.blob (context->bytes());
+
+                    valid = validator->validate (bytes.data(), bytes.size(), reason);
+
+                    if (!valid) {
+                        reason = validator->error().what();
+                    }
+                } catch (const std::exception & e) {
+                    reason = e.what();
+                }
+
+                out_.append (job_.name());
+
+                if (valid) {
+                    out_.append (": OK\n");
+                } else {
+                    out_.append (": FAIL ").append (reason).append ("\n");
+                }
+
+                context->recycle();
+
+                return valid;
+            };
+        }, std::cout);
+    }
+
+    /**
+     * The bytes of a blob held in a file, decoding it first should it be
+     * in one of the text encodings
+     */
+    void
+    load (const char * file_, std::vector<char> & bytes_) {
+        std::ifstream file { file_, std::ios::in | std::ios::binary };
+
+        if (!file) {
+            throw std::runtime_error ("Not a file");
+        }
+
+        std::string contents {
+            std::istreambuf_iterator<char> (file),
+            std::istreambuf_iterator<char>() };
+
+        if (contents.size() >= amqp::AMQP_HEADER.size()
+            && std::equal (
+                amqp::AMQP_HEADER.begin(),
+                amqp::AMQP_HEADER.end(),
+                contents.begin()))
+        {
+            bytes_.assign (contents.begin(), contents.end());
+        } else {
+            text::decode (contents.data(), contents.size(), bytes_);
+        }
+    }
+
+    /**
+     * Push an entire blob through a decoder, nothing may follow it
+     */
+    void
+    feed (
+        amqp::internal::stream::BlobDecoder & decoder_,
+        std::string_view bytes_
+    ) {
+        decoder_.reset();
+
+        if (decoder_.feed (bytes_.data(), bytes_.size()) != bytes_.size()) {
+            throw std::runtime_error ("Data after the end of the blob");
+        }
+
+        if (!decoder_.done()) {
+            throw std::runtime_error ("Truncated blob");
+        }
+    }
+
+    /**
+     * Each blob named, or each line of stdin, becomes a row of a column
+     * file. Any that can't be decoded are reported and left out.
+     */
+    int
+    columns (
+        const char * out_,
+        bool batch_,
+        const char * catalog_,
+        const amqp::internal::Limits & limits_,
+        Progress & progress_,
+        char ** files_,
+        int count_
+    ) {
+        std::ofstream out { out_, std::ios::out | std::ios::binary };
+
+        if (!out) {
+            std::cerr << "Can't write to " << out_ << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        amqp::internal::stream::ColumnWriter writer (out);
+        amqp::internal::stream::BlobDecoder decoder (
+            writer, amqp::internal::stream::ObjectTable::expand_r, limits_);
+
+        prime (decoder, catalog_);
+
+        std::vector<char> bytes;
+
+        auto row = [&](const std::string & name_, const std::string & input_, auto load_) {
+            try {
+                bytes.clear();
+                load_();
+
+                feed (decoder, { bytes.data(), bytes.size() });
+            } catch (const std::exception & e) {
+                writer.discard();
+
+                progress_.quarantine().failed (e, name_, input_);
+            }
+        };
+
+        if (batch_) {
+            std::string line;
+
+            for (size_t n { 1 } ; std::getline (std::cin, line) ; ++n) {
+                if (!progress_.next()
+                    || line.find_first_not_of (" \t\r") == std::string::npos)
+                {
+                    continue;
+                }
+
+                row ("line " + std::to_string (n), line, [&] {
+                    text::decode (line.data(), line.size(), bytes);
+                });
+            }
+        }
+
+        for (int i { 0 } ; i < count_ ; ++i) {
+            if (!progress_.next()) {
+                continue;
+            }
+
+            row (files_[i], files_[i], [&] { load (files_[i], bytes); });
+        }
+
+        writer.close();
+
+        return progress_.finish();
+    }
+
+    /**
+     * Each blob named, or each line of stdin, written to stdout as a
+     * MessagePack value one after the other. Blobs that can't be decoded
+     * are reported and left out.
+     */
+    int
+    transcode (
+        bool batch_,
+        amqp::internal::stream::ObjectTable::refs_t refs_,
+        const char * catalog_,
+        const amqp::internal::Limits & limits_,
+        Pipeline & pipeline_,
+        char ** files_,
+        int count_
+    ) {
+        struct State {
+            DecodeContext context;
+            amqp::internal::stream::MsgPackWriter writer;
+            amqp::internal::stream::BlobDecoder decoder;
+
+            State (
+                amqp::internal::stream::ObjectTable::refs_t refs_,
+                const amqp::internal::Limits & limits_,
+                size_t highWater_
+            ) : context (highWater_)
+              , writer (context.out())
+              , decoder (writer, refs_, limits_)
+            {
+                decoder.highWater (highWater_);
+            }
+        };
+
+        std::atomic<bool> first { true };
+
+        return pipeline_.run (batch_ ? &std::cin : nullptr, files_, count_, [&]() -> Pipeline::Decode {
+            auto state = std::make_shared<State> (refs_, limits_, pipeline_.highWater());
+
+            prime (state->decoder, catalog_, first.exchange (false));
+
+            return [state](const Pipeline::Job & job_, std::string & out_) {
+                auto & context = state->context;
+
+                context.out (out_);
+
+                try {
+                    feed (state->decoder, job_.blob (context.bytes()));
+                } catch (...) {
+                    state->writer.discard();
+                    throw;
+                }
+
+                context.recycle();
+
+                return true;
+            };
+        }, std::cout);
+    }
+
+    /**
+     * Each blob named, or each line of stdin, that matches the predicate
+     * is written out as it would be when streaming, the rest are skipped
+     * silently. Blobs that can't be read are reported.
+     */
+    int
+    where (
+        const char * expression_,
+        bool batch_,
+        amqp::internal::stream::ObjectTable::refs_t refs_,
+        const amqp::internal::Limits & limits_,
+        Pipeline & pipeline_,
+        char ** files_,
+        int count_
+    ) {
+        /*
+         * Every worker has its own filter, this one just makes sure the
+         * predicate makes sense before any of them start
+         */
+        try {
+            BlobFilter { expression_, refs_, limits_ };
+        } catch (const std::exception & e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        /*
+         * Whether a blob matches is only known once it's been decoded, so
+         * each is written to [matched] first and only then copied out
+         */
+        struct State {
+            BlobFilter filter;
+            DecodeContext context;
+            amqp::internal::stream::JSONWriter writer;
+            std::string matched;
+
+            State (
+                const char * expression_,
+                amqp::internal::stream::ObjectTable::refs_t refs_,
+                const amqp::internal::Limits & limits_,
+                size_t highWater_
+            ) : filter (expression_, refs_, limits_)
+              , context (highWater_)
+              , writer (context.out())
+            {
+                filter.highWater (highWater_);
+            }
+        };
+
+        return pipeline_.run (batch_ ? &std::cin : nullptr, files_, count_, [&]() -> Pipeline::Decode {
+            auto state = std::make_shared<State> (
+                expression_, refs_, limits_, pipeline_.highWater());
+
+            return [state](const Pipeline::Job & job_, std::string & out_) {
+                auto & context = state->context;
+                auto bytes = job_.blob (context.bytes());
+
+                state->matched.clear();
+                context.out (state->matched);
+
+                if (state->filter.filter (bytes.data(), bytes.size(), state->writer)) {
+                    out_.append ("{ Parsed : ").append (state->matched).append (" }\n");
+                }
+
+                context.recycle (state->matched);
+                context.recycle();
+
+                return true;
+            };
+        }, std::cout);
+    }
+
+    /**
+     * Without any queries the blob is decoded in full, as when streaming,
+     * and the index written. With them the index is expected to exist and
+     * each value asked for is decoded without touching anything else.
+     */
+    int
+    index (
+        const char * index_,
+        const std::vector<std::string> & queries_,
+        amqp::internal::stream::ObjectTable::refs_t refs_,
+        const amqp::internal::Limits & limits_,
+        const char * file_
+    ) {
+        try {
+            BlobStreamer streamer (file_, 64 * 1024, refs_, limits_);
+
+            if (queries_.empty()) {
+                amqp::internal::stream::JSONWriter writer (std::cout);
+
+                std::cout << "{ Parsed : ";
+                streamer.index (index_, writer);
+                std::cout << " }" << std::endl;
+
+                return EXIT_SUCCESS;
+            }
+
+            amqp::internal::stream::OffsetIndex index (index_);
+
+            for (const auto & query : queries_) {
+                std::stringstream ss;
+                amqp::internal::stream::JSONWriter writer (ss);
+
+                streamer.visit (index, query, writer);
+
+                std::cout << "{ " << (query.empty() ? "Parsed" : query)
+                    << " : " << ss.str() << " }" << std::endl;
+            }
+        } catch (const std::exception & e) {
+            if (queries_.empty()) {
+                std::cout << std::endl;
+            }
+
+            std::cerr << amqp::internal::DecodeError::of (e, file_).what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    /**
+     * A file whose first bytes aren't the Corda header, presumably text
+     */
+    bool
+    isText (const char * file_) {
+        std::ifstream file { file_, std::ios::in | std::ios::binary };
+        std::array<char, 7> header { };
+        file.read (header.data(), header.size());
+
+        return header != amqp::AMQP_HEADER;
+    }
+
+}
 
 /******************************************************************************/
 
 int
 main (int argc, char **argv) {
-    struct stat results { };
+    const struct option options[] = {
+        { "stream",   no_argument, nullptr, 's' },
+        { "batch",    no_argument, nullptr, 'b' },
+        { "validate", no_argument, nullptr, 'v' },
+        { "refs",     no_argument, nullptr, 'r' },
+        { "expand",   no_argument, nullptr, 'x' },
+        { "columns",  required_argument, nullptr, 'c' },
+        { "msgpack",  no_argument, nullptr, 'm' },
+        { "where",    required_argument, nullptr, 'w' },
+        { "catalog",  required_argument, nullptr, 'C' },
+        { "index",    required_argument, nullptr, 'i' },
+        { "query",    required_argument, nullptr, 'q' },
+        { "limit",    required_argument, nullptr, 'L' },
+        { "quarantine", required_argument, nullptr, 'Q' },
+        { "journal",  required_argument, nullptr, 'j' },
+        { "threads",  required_argument, nullptr, 'T' },
+        { "metrics",  no_argument, nullptr, 'M' },
+        { "high-water", required_argument, nullptr, 'H' },
+        { "split",    required_argument, nullptr, 'S' },
+        { nullptr,  0,           nullptr, 0   }
+    };
+
+    bool stream { false };
+    std::optional<amqp::internal::stream::ObjectTable::refs_t> refsGiven;
+    bool batched { false };
+    bool validating { false };
+    const char * columnFile { nullptr };
+    bool msgpack { false };
+    const char * predicate { nullptr };
+    const char * catalog { nullptr };
+    const char * indexFile { nullptr };
+    std::vector<std::string> queries;
+    amqp::internal::Limits limits;
+    const char * quarantineFile { nullptr };
+    const char * journalFile { nullptr };
+    unsigned threads { std::max (1U, std::thread::hardware_concurrency()) };
+    bool metrics { false };
+    size_t highWater { DecodeContext::HIGH_WATER };
+    size_t split { amqp::internal::stream::ListSplitter::THRESHOLD };
+
+    int opt;
+    while ((opt = getopt_long (argc, argv, "sbvrxc:mw:C:i:q:L:Q:j:T:MH:S:", options, nullptr)) != -1) {
+        switch (opt) {
+            case 's' : stream = true; break;
+            case 'r' : refsGiven = amqp::internal::stream::ObjectTable::reference_r; break;
+            case 'x' : refsGiven = amqp::internal::stream::ObjectTable::expand_r; break;
+            case 'b' : batched = true; break;
+            case 'v' : validating = true; break;
+            case 'c' : columnFile = optarg; break;
+            case 'm' : msgpack = true; break;
+            case 'w' :
+                if (predicate) {
+                    std::cerr << "--where can only be given once" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                predicate = optarg;
+                break;
+            case 'C' : catalog = optarg; break;
+            case 'i' : indexFile = optarg; break;
+            case 'q' : queries.emplace_back (optarg); break;
+            case 'Q' : quarantineFile = optarg; break;
+            case 'j' : journalFile = optarg; break;
+            case 'M' : metrics = true; break;
+            case 'H' : {
+                char * end { nullptr };
+                highWater = strtoull (optarg, &end, 10);
+
+                if (end == optarg || *end) {
+                    std::cerr << "--high-water needs a number of bytes" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+            case 'S' : {
+                char * end { nullptr };
+                split = strtoull (optarg, &end, 10);
+
+                if (end == optarg || *end) {
+                    std::cerr << "--split needs a number of bytes" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+            case 'T' : {
+                char * end { nullptr };
+                auto count = strtoul (optarg, &end, 10);
+
+                if (end == optarg || *end
+                    || count == 0 || count > std::numeric_limits<unsigned>::max())
+                {
+                    std::cerr << "--threads needs a number, at least 1" << std::endl;
+                    return EXIT_FAILURE;
+                }
+
+                threads = static_cast<unsigned> (count);
+                break;
+            }
+            case 'L' :
+                try {
+                    limits.set (optarg);
+                } catch (const std::exception & e) {
+                    std::cerr << e.what() << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            default :
+                usage (argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
 
-    if (stat(argv[1], &results) != 0) {
+    /*
+     * Expanding references means keeping everything decoded, so a single
+     * streamed blob, whose memory should be bounded by its nesting rather
+     * than its size, leaves them as references unless told otherwise
+     */
+    auto refs = refsGiven.value_or (stream && !batched
+        ? amqp::internal::stream::ObjectTable::reference_r
+        : amqp::internal::stream::ObjectTable::expand_r);
+
+    /*
+     * A column file is only complete once it's closed, so there's no
+     * picking one up part way through
+     */
+    if (journalFile && (columnFile || indexFile
+        || !(batched || validating || msgpack || predicate)))
+    {
+        std::cerr << "--journal is only for batches written to stdout" << std::endl;
         return EXIT_FAILURE;
     }
 
-    CordaBytes cb (argv[1]);
-    
-    if (cb.encoding() == amqp::DATA_AND_STOP) {
-        BlobInspector blobInspector (cb);
-        auto val = blobInspector.dump();
-        std::cout << val << std::endl;
-    } else {
-        std::cerr << "BAD ENCODING " << cb.encoding() << " != "
-            << amqp::DATA_AND_STOP << std::endl;
+    std::unique_ptr<Progress> progress;
 
+    try {
+        progress = std::make_unique<Progress> (std::cerr, journalFile, quarantineFile);
+    } catch (const std::exception & e) {
+        std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
     }
 
-    return EXIT_SUCCESS;
+    Pipeline pipeline (*progress, threads, Pipeline::DEPTH, highWater);
+
+    auto finish = [&](int rtn_) {
+        if (metrics) {
+            report (pipeline.metrics());
+        }
+
+        return rtn_;
+    };
+
+    if (validating) {
+        if (!batched && optind >= argc) {
+            usage (argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        return finish (validate (batched, limits, pipeline, argv + optind, argc - optind));
+    }
+
+    if (columnFile) {
+        if (!batched && optind >= argc) {
+            usage (argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        return columns (
+            columnFile, batched, catalog, limits, *progress, argv + optind, argc - optind);
+    }
+
+    if (msgpack) {
+        if (!batched && optind >= argc) {
+            usage (argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        return finish (transcode (
+            batched, refs, catalog, limits, pipeline, argv + optind, argc - optind));
+    }
+
+    if (predicate) {
+        if (!batched && optind >= argc) {
+            usage (argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        return finish (where (
+            predicate, batched, refs, limits, pipeline, argv + optind, argc - optind));
+    }
+
+    if (indexFile) {
+        if (optind + 1 != argc) {
+            usage (argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        return index (indexFile, queries, refs, limits, argv[optind]);
+    }
+
+    if (batched) {
+        return finish (batch (stream, refs, catalog, limits, pipeline));
+    }
+
+    if (optind >= argc) {
+        usage (argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char * file = argv[optind];
+
+    /*
+     * Anything wrong with the blob is reported, not left to abort us
+     */
+    try {
+        if (stream && strcmp (file, "-") == 0) {
+            return streamStdin (refs, limits);
+        }
+
+        if (stream && isText (file)) {
+            std::ifstream in { file, std::ios::in | std::ios::binary };
+            std::string text {
+                std::istreambuf_iterator<char> (in),
+                std::istreambuf_iterator<char>() };
+
+            std::vector<char> bytes;
+            text::decode (text.data(), text.size(), bytes);
+
+            std::stringstream ss;
+            amqp::internal::stream::JSONWriter writer (ss);
+            amqp::internal::stream::BlobDecoder decoder (writer, refs, limits);
+
+            streamBytes (decoder, ss, { bytes.data(), bytes.size() });
+            std::cout << ss.str() << std::endl;
+
+            return EXIT_SUCCESS;
+        }
+
+        if (stream) {
+            BlobStreamer streamer (file, 64 * 1024, refs, limits);
+
+            streamer.split (threads, split);
+            streamer.dump (std::cout);
+            std::cout << std::endl;
+
+            return EXIT_SUCCESS;
+        }
+
+        CordaBytes cb (file);
+    
+        if (cb.encoding() == amqp::DATA_AND_STOP
+            || cb.encoding() == amqp::ALT_DATA_AND_STOP)
+        {
+            BlobInspector blobInspector (cb, limits);
+            auto val = blobInspector.dump();
+            std::cout << val << std::endl;
+        } else {
+            std::cerr << "BAD ENCODING " << cb.encoding() << " != "
+                << amqp::DATA_AND_STOP << std::endl;
+
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    } catch (const std::exception & e) {
+        if (stream) {
+            std::cout << std::endl;
+        }
+
+        std::cerr << amqp::internal::DecodeError::of (e, file).what() << std::endl;
+        return EXIT_FAILURE;
+    }
 }
 
 /******************************************************************************/
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <random>
+
+#include "TextDecoder.h"
+
+/******************************************************************************/
+
+namespace {
+
+    std::string
+    toHex (const std::string & bytes_, bool upper_ = false) {
+        const char * digits = upper_ ? "0123456789ABCDEF" : "0123456789abcdef";
+        std::string rtn;
+
+        for (unsigned char c : bytes_) {
+            rtn += digits[c >> 4];
+            rtn += digits[c & 0xf];
+        }
+
+        return rtn;
+    }
+
+    std::string
+    toBase64 (const std::string & bytes_) {
+        const char * alphabet =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string rtn;
+
+        for (size_t i { 0 } ; i < bytes_.size() ; i += 3) {
+            uint32_t v = static_cast<uint8_t>(bytes_[i]) << 16;
+            if (i + 1 < bytes_.size()) v |= static_cast<uint8_t>(bytes_[i + 1]) << 8;
+            if (i + 2 < bytes_.size()) v |= static_cast<uint8_t>(bytes_[i + 2]);
+
+            rtn += alphabet[(v >> 18) & 0x3f];
+            rtn += alphabet[(v >> 12) & 0x3f];
+            rtn += i + 1 < bytes_.size() ? alphabet[(v >> 6) & 0x3f] : '=';
+            rtn += i + 2 < bytes_.size() ? alphabet[v & 0x3f] : '=';
+        }
+
+        return rtn;
+    }
+
+    std::string
+    bytes (size_t size_) {
+        std::mt19937 gen (size_);
+        std::string rtn (size_, 0);
+
+        for (auto & c : rtn) {
+            c = static_cast<char>(gen());
+        }
+
+        return rtn;
+    }
+
+    std::string
+    hex (const std::string & text_) {
+        std::vector<char> out;
+        text::fromHex (text_.data(), text_.size(), out);
+        return { out.begin(), out.end() };
+    }
+
+    std::string
+    base64 (const std::string & text_) {
+        std::vector<char> out;
+        text::fromBase64 (text_.data(), text_.size(), out);
+        return { out.begin(), out.end() };
+    }
+
+}
+
+/******************************************************************************/
+
+/**
+ * Sizes either side of the 32 character blocks the fast path works in
+ */
+TEST (TextDecoder, hex) { // NOLINT
+    for (size_t size : { 0, 1, 15, 16, 17, 31, 32, 33, 100, 1000 }) {
+        auto b = bytes (size);
+        EXPECT_EQ (b, hex (toHex (b)));
+        EXPECT_EQ (b, hex (toHex (b, true)));
+        EXPECT_EQ (b, hex ("\\x" + toHex (b)));
+        EXPECT_EQ (b, hex ("0x" + toHex (b)));
+    }
+}
+
+/******************************************************************************/
+
+TEST (TextDecoder, hexWhitespace) { // NOLINT
+    auto b = bytes (100);
+    auto h = toHex (b);
+
+    std::string wrapped;
+    for (size_t i { 0 } ; i < h.size() ; i += 60) {
+        wrapped += h.substr (i, 60) + "\n";
+    }
+
+    EXPECT_EQ (b, hex (wrapped));
+}
+
+/******************************************************************************/
+
+TEST (TextDecoder, hexBad) { // NOLINT
+    auto h = toHex (bytes (64));
+
+    /*
+     * Anywhere, including inside a block the fast path would take
+     */
+    for (size_t i : { 0, 5, 20, 31, 32, 100, 127 }) {
+        for (char c : { 'g', '/', ':', '@', '`', '\x80' }) {
+            auto bad { h };
+            bad[i] = c;
+            EXPECT_THROW (hex (bad), std::runtime_error);
+        }
+    }
+
+    EXPECT_THROW (hex (h + "a"), std::runtime_error);
+}
+
+/******************************************************************************/
+
+TEST (TextDecoder, base64) { // NOLINT
+    for (size_t size : { 0, 1, 2, 3, 4, 5, 47, 48, 49, 1000 }) {
+        auto b = bytes (size);
+        auto t = toBase64 (b);
+
+        EXPECT_EQ (b, base64 (t));
+
+        /*
+         * Padding is optional
+         */
+        EXPECT_EQ (b, base64 (t.substr (0, t.find ('='))));
+
+        std::string wrapped;
+        for (size_t i { 0 } ; i < t.size() ; i += 76) {
+            wrapped += t.substr (i, 76) + "\n";
+        }
+
+        EXPECT_EQ (b, base64 (wrapped));
+    }
+}
+
+/******************************************************************************/
+
+TEST (TextDecoder, base64Bad) { // NOLINT
+    EXPECT_THROW (base64 ("Y29y*GE="), std::runtime_error);
+    EXPECT_THROW (base64 ("Y29yZ"), std::runtime_error);
+    EXPECT_THROW (base64 ("Y2==yZGE"), std::runtime_error);
+}
+
+/******************************************************************************/
+
+TEST (TextDecoder, detect) { // NOLINT
+    const std::string blob { "corda\x01\x00\x00", 8 };
+
+    EXPECT_EQ (text::binary_t, text::detect (blob.data(), blob.size()));
+
+    for (const auto & t : { toHex (blob), toHex (blob, true), "\\x" + toHex (blob) }) {
+        EXPECT_EQ (text::hex_t, text::detect (t.data(), t.size()));
+    }
+
+    auto t = toBase64 (blob);
+    EXPECT_EQ (text::base64_t, text::detect (t.data(), t.size()));
+
+    EXPECT_THROW (text::detect ("hello", 5), std::runtime_error);
+}
+
+/******************************************************************************/
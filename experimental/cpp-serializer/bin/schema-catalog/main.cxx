@@ -0,0 +1,204 @@
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <limits>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include <string.h>
+#include <getopt.h>
+
+#include "amqp/stream/Catalog.h"
+#include "amqp/stream/SchemaScanner.h"
+
+/******************************************************************************/
+
+namespace {
+
+    void
+    usage (const char * name_) {
+        std::cerr << "usage: " << name_ << " [--jobs <n>] --output <catalog> <blob>..." << std::endl
+            << "       " << name_ << " --types <catalog>" << std::endl
+            << "       " << name_ << " --blobs <type> <catalog>" << std::endl
+            << "  -o, --output  scan the schema of every blob named, or of every"
+            << " blob named by a line of stdin given -, into a catalog" << std::endl
+            << "  -j, --jobs    how many blobs to scan at once, by default one"
+            << " per core" << std::endl
+            << "  -t, --types   list every top level type in a catalog" << std::endl
+            << "  -b, --blobs   list every blob in a catalog whose schema names"
+            << " a type" << std::endl;
+    }
+
+    /**
+     * Each blob's schema is found without reading its data, the schema only
+     * being loaded the first time its descriptor turns up. Blobs that can't
+     * be scanned are reported and left out.
+     */
+    int
+    build (const char * out_, unsigned jobs_, std::vector<std::string> blobs_) {
+        if (blobs_.size() > std::numeric_limits<uint32_t>::max()) {
+            std::cerr << "Too many blobs for one catalog" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        amqp::internal::stream::CatalogBuilder builder;
+
+        std::atomic<size_t> next { 0 };
+        std::atomic<bool> failed { false };
+        std::mutex errors;
+
+        auto work = [&]() {
+            amqp::internal::stream::SchemaScanner scanner;
+
+            for (size_t i ; (i = next++) < blobs_.size() ; ) {
+                try {
+                    std::ifstream in { blobs_[i], std::ios::in | std::ios::binary };
+
+                    if (!in) {
+                        throw std::runtime_error ("Not a file");
+                    }
+
+                    scanner.scan (in);
+
+                    in.clear();
+                    in.seekg (0, std::ios::end);
+
+                    builder.add (i, blobs_[i], in.tellg(), scanner);
+                } catch (const std::exception & e) {
+                    std::lock_guard<std::mutex> lock (errors);
+                    std::cerr << blobs_[i] << ": " << e.what() << std::endl;
+                    failed = true;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+
+        for (unsigned i { 0 } ; i < jobs_ ; ++i) {
+            threads.emplace_back (work);
+        }
+
+        for (auto & thread : threads) {
+            thread.join();
+        }
+
+        std::ofstream out { out_, std::ios::out | std::ios::binary };
+
+        if (!out) {
+            std::cerr << "Can't write to " << out_ << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        builder.write (out);
+
+        std::cerr << blobs_.size() << " blobs, " << builder.types()
+            << " types" << std::endl;
+
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    int
+    types (const char * catalog_) {
+        amqp::internal::stream::Catalog catalog (catalog_);
+
+        for (size_t i { 0 } ; i < catalog.types() ; ++i) {
+            auto type = catalog.type (i);
+
+            std::cout << type.descriptor << " " << type.name << std::endl
+                << "  blobs: " << type.count << ", bytes: " << type.bytes
+                << ", first: " << type.first << std::endl;
+
+            std::string_view fields { type.fields };
+
+            for (size_t eol ; (eol = fields.find ('\n')) != std::string_view::npos ; ) {
+                std::cout << "    " << fields.substr (0, eol) << std::endl;
+                fields.remove_prefix (eol + 1);
+            }
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    int
+    blobs (const char * type_, const char * catalog_) {
+        amqp::internal::stream::Catalog catalog (catalog_);
+
+        for (const auto & blob : catalog.blobs (type_)) {
+            std::cout << blob << std::endl;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+}
+
+/******************************************************************************/
+
+int
+main (int argc, char **argv) {
+    const struct option options[] = {
+        { "output", required_argument, nullptr, 'o' },
+        { "jobs",   required_argument, nullptr, 'j' },
+        { "types",  no_argument,       nullptr, 't' },
+        { "blobs",  required_argument, nullptr, 'b' },
+        { nullptr,  0,                 nullptr, 0   }
+    };
+
+    const char * output { nullptr };
+    const char * type { nullptr };
+    bool listing { false };
+    unsigned jobs { std::max (1U, std::thread::hardware_concurrency()) };
+
+    int opt;
+    while ((opt = getopt_long (argc, argv, "o:j:tb:", options, nullptr)) != -1) {
+        switch (opt) {
+            case 'o' : output = optarg; break;
+            case 'j' : jobs = std::max (1, atoi (optarg)); break;
+            case 't' : listing = true; break;
+            case 'b' : type = optarg; break;
+            default :
+                usage (argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        if (listing || type) {
+            if (optind + 1 != argc) {
+                usage (argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            return listing ? types (argv[optind]) : blobs (type, argv[optind]);
+        }
+    } catch (const std::exception & e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!output || optind >= argc) {
+        usage (argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> files;
+
+    for (int i { optind } ; i < argc ; ++i) {
+        if (strcmp (argv[i], "-") == 0) {
+            for (std::string line ; std::getline (std::cin, line) ; ) {
+                if (!line.empty()) {
+                    files.push_back (line);
+                }
+            }
+        } else {
+            files.emplace_back (argv[i]);
+        }
+    }
+
+    return build (output, jobs, std::move (files));
+}
+
+/******************************************************************************/
@@ -0,0 +1,158 @@
+#include "SchemaDumper.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <proton/codec.h>
+
+#include "amqp/DecodeError.h"
+#include "amqp/AMQPHeader.h"
+#include "amqp/AMQPSectionId.h"
+#include "amqp/schema/descriptors/AMQPDescriptorRegistory.h"
+
+#include "amqp/stream/Decompressor.h"
+#include "amqp/stream/SchemaScanner.h"
+
+/******************************************************************************/
+
+namespace {
+
+    using Data = std::unique_ptr<pn_data_t, decltype (&pn_data_free)>;
+
+    /**
+     * [what_] being the schema or the envelope, [offset_] where it began
+     */
+    Data
+    decode (const char * bytes_, size_t size_, const std::string & what_, size_t offset_) {
+        using amqp::internal::DecodeError;
+
+        Data data { pn_data (size_), &pn_data_free };
+
+        auto rtn = pn_data_decode (data.get(), bytes_, size_);
+
+        if (rtn < 0) {
+            throw DecodeError (
+                    "Malformed " + what_ + ", proton error " + std::to_string (rtn),
+                    offset_);
+        }
+
+        if (static_cast<size_t>(rtn) != size_) {
+            throw DecodeError (
+                    "Unexpected data after the end of the " + what_,
+                    offset_ + rtn);
+        }
+
+        return data;
+    }
+
+    void
+    printNode (pn_data_t * d_, std::ostream & out_) {
+        std::stringstream ss;
+
+        if (pn_data_is_described (d_)) {
+            amqp::internal::findDescriptor (PN_DESCRIBED).read (d_, ss);
+        }
+
+        out_ << ss.str() << std::endl;
+    }
+
+}
+
+/******************************************************************************/
+
+SchemaDumper::SchemaDumper (std::string file_)
+    : m_file (std::move (file_))
+{
+}
+
+/******************************************************************************/
+
+void
+SchemaDumper::load (amqp::internal::stream::SchemaScanner & scanner_) const {
+    std::ifstream f (m_file, std::ios::in | std::ios::binary);
+
+    if (!f) {
+        throw std::runtime_error ("Can't read " + m_file);
+    }
+
+    scanner_.scan (f);
+    scanner_.load();
+}
+
+/******************************************************************************/
+
+void
+SchemaDumper::schema (std::ostream & out_) const {
+    amqp::internal::stream::SchemaScanner scanner;
+
+    load (scanner);
+
+    const auto & bytes = scanner.bytes();
+
+    auto d = decode (bytes.data(), bytes.size(), "schema", scanner.schema().begin);
+
+    printNode (d.get(), out_);
+}
+
+/******************************************************************************/
+
+void
+SchemaDumper::envelope (std::ostream & out_) const {
+    amqp::internal::stream::SchemaScanner scanner;
+
+    load (scanner);
+
+    std::ifstream f (m_file, std::ios::in | std::ios::binary);
+
+    std::array<char, 7> header { };
+    f.read (header.data(), 7);
+
+    if (!f || header != amqp::AMQP_HEADER) {
+        throw std::runtime_error ("Bad Header in blob");
+    }
+
+    char section { };
+    f.read (&section, 1);
+
+    std::vector<char> blob;
+
+    /*
+     * A compressed blob wraps the section id and envelope of a plain one
+     * in the stream of whatever encoding is named by the next byte
+     */
+    if (section == amqp::ENCODING) {
+        char encoding { };
+        f.read (&encoding, 1);
+
+        blob = amqp::internal::stream::Decompressor::inflate (f, encoding);
+
+        if (blob.empty()) {
+            throw std::runtime_error ("Empty compressed blob");
+        }
+
+        section = blob.front();
+        blob.erase (blob.begin());
+    } else {
+        blob.assign (
+            std::istreambuf_iterator<char> (f),
+            std::istreambuf_iterator<char>());
+    }
+
+    if (section != amqp::DATA_AND_STOP && section != amqp::ALT_DATA_AND_STOP) {
+        std::stringstream ss;
+        ss << "BAD ENCODING " << int (section) << " != " << amqp::DATA_AND_STOP;
+        throw std::runtime_error (ss.str());
+    }
+
+    auto d = decode (blob.data(), blob.size(), "envelope", 0);
+
+    printNode (d.get(), out_);
+}
+
+/******************************************************************************/
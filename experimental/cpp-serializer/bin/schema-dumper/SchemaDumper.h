@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <iosfwd>
+
+/******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    class SchemaScanner;
+
+}
+
+/******************************************************************************/
+
+/**
+ * Writes out a blob's schema, or its entire envelope, as proton decodes
+ * it, every described type along with its descriptor. The schema is
+ * loaded first either way, so one that makes no sense fails with a
+ * [DecodeError] as it would anywhere else rather than part way through
+ * being written.
+ */
+class SchemaDumper {
+    private :
+        std::string m_file;
+
+        /**
+         * Find the schema and load it, throwing if it can't be
+         */
+        void load (amqp::internal::stream::SchemaScanner &) const;
+
+    public :
+        explicit SchemaDumper (std::string);
+
+        /**
+         * Only the schema is decoded, the data isn't even read
+         */
+        void schema (std::ostream &) const;
+
+        void envelope (std::ostream &) const;
+};
+
+/******************************************************************************/
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+
+#include "SchemaDumper.h"
+
+#include "amqp/DecodeError.h"
+
+/******************************************************************************/
+
+const std::string filepath ("../../test-files/"); // NOLINT
+
+/******************************************************************************/
+
+namespace {
+
+    std::string
+    read (const std::string & file_) {
+        std::ifstream in { file_, std::ios::in | std::ios::binary };
+
+        return {
+            std::istreambuf_iterator<char> (in),
+            std::istreambuf_iterator<char>() };
+    }
+
+    void
+    write (const std::string & file_, const std::string & blob_) {
+        std::ofstream out { file_, std::ios::out | std::ios::binary };
+        out << blob_;
+    }
+
+    /**
+     * What a [DecodeError] said about it, were one thrown
+     */
+    template<typename F>
+    std::string
+    reason (F dump_) {
+        try {
+            std::stringstream ss;
+            dump_ (ss);
+        } catch (const amqp::internal::DecodeError & e) {
+            return e.reason();
+        }
+
+        return "";
+    }
+
+}
+
+/******************************************************************************/
+
+TEST (SchemaDumper, blobs) { // NOLINT
+    for (const auto & file : { "_i_", "_Mis_", "_Mis_.deflate", "__i_LMis_l__.snappy" }) {
+        std::stringstream schema;
+        std::stringstream envelope;
+
+        SchemaDumper (filepath + file).schema (schema);
+        SchemaDumper (filepath + file).envelope (envelope);
+
+        EXPECT_EQ (0U, schema.str().find ("DESCRIBED")) << file;
+        EXPECT_NE (std::string::npos, schema.str().find ("-> SCHEMA")) << file;
+        EXPECT_NE (std::string::npos, envelope.str().find ("-> ENVELOPE")) << file;
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * A schema proton can't decode, or that names a descriptor we don't know,
+ * fails as the schema whether or not we're writing the whole envelope
+ */
+TEST (SchemaDumper, corrupt) { // NOLINT
+    const std::string file { "schema-dumper.test" };
+
+    auto blob = read (filepath + "_Mis_");
+
+    auto at = blob.find ("\xa1\x1ajava.util.Map");
+    ASSERT_NE (std::string::npos, at);
+
+    auto malformed = blob;
+    malformed[at + 1] = '\xff';
+
+    write (file, malformed);
+
+    EXPECT_EQ (0U, reason ([&](auto & out_) { SchemaDumper (file).schema (out_); })
+            .find ("Malformed schema"));
+    EXPECT_EQ (0U, reason ([&](auto & out_) { SchemaDumper (file).envelope (out_); })
+            .find ("Malformed schema"));
+
+    /*
+     * The descriptor of the schema's composite type
+     */
+    const std::string composite { "\x80\xc5\x62\x00\x00\x00\x00\x00\x05", 9 };
+
+    at = blob.find (composite);
+    ASSERT_NE (std::string::npos, at);
+
+    auto unknown = blob;
+    unknown[at + 8] = '\x3f';
+
+    write (file, unknown);
+
+    EXPECT_EQ (0U, reason ([&](auto & out_) { SchemaDumper (file).schema (out_); })
+            .find ("Unknown descriptor"));
+    EXPECT_EQ (0U, reason ([&](auto & out_) { SchemaDumper (file).envelope (out_); })
+            .find ("Unknown descriptor"));
+
+    std::remove (file.c_str());
+}
+
+/******************************************************************************/
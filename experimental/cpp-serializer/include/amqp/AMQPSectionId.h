@@ -14,6 +14,15 @@ namespace amqp {
         ENCODING          = 2
     };
 
+    /**
+     * An ENCODING section is a single byte identifying how everything
+     * following it has been compressed
+     */
+    enum amqp_encoding_t {
+        DEFLATE = 0,
+        SNAPPY  = 1
+    };
+
 }
 
 /******************************************************************************/
@@ -0,0 +1,70 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+/******************************************************************************
+ *
+ * class amqp::reader::IVisitor
+ *
+ ******************************************************************************/
+
+/**
+ * Where [IValue] represents a fully decoded tree that can be dumped once
+ * a blob has been read in its entirety, an [IVisitor] is told about each
+ * value as soon as the decoder has made sense of it. This is what lets us
+ * render (or count, or check) a blob without ever holding all of it in
+ * memory.
+ *
+ * Calls nest in the obvious way, every begin is matched by an end and
+ * within a composite each value is preceded by a call to [property]
+ * naming it. Within a map keys and values simply alternate.
+ *
+ * String data handed to a visitor is only valid for the duration of the
+ * call.
+ */
+namespace amqp::reader {
+
+    class IVisitor {
+        public :
+            virtual ~IVisitor() = default;
+
+            virtual void property (const std::string &) = 0;
+
+            /**
+             * A composite of the named type, its [fields] properties
+             * following
+             */
+            virtual void beginComposite (const std::string &, size_t fields_) = 0;
+            virtual void endComposite() = 0;
+
+            virtual void beginList (size_t) = 0;
+            virtual void endList() = 0;
+
+            virtual void beginMap (size_t) = 0;
+            virtual void endMap() = 0;
+
+            virtual void value (bool) = 0;
+            virtual void value (int32_t) = 0;
+            virtual void value (int64_t) = 0;
+            virtual void value (double) = 0;
+            virtual void value (std::string_view) = 0;
+
+            virtual void enumeration (std::string_view) = 0;
+
+            virtual void null() = 0;
+
+            /**
+             * In place of a value, the [index]th object read from the blob
+             * appearing again. Only seen when the decoder has been asked
+             * not to expand such references itself.
+             */
+            virtual void reference (size_t) = 0;
+    };
+
+}
+
+/******************************************************************************/
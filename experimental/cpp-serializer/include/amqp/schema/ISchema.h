@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string_view>
+
 #include "types.h"
 
 #include "amqp/AMQPDescribed.h"
@@ -9,8 +11,12 @@ namespace amqp::schema {
     template <class Iterator>
     class ISchema {
         public :
-            virtual Iterator fromType (const std::string &) const = 0;
-            virtual Iterator fromDescriptor (const std::string &) const = 0;
+            /**
+             * Looked up by view so a name or descriptor read straight
+             * out of a blob needn't be copied first
+             */
+            virtual Iterator fromType (std::string_view) const = 0;
+            virtual Iterator fromDescriptor (std::string_view) const = 0;
     };
 
 }
\ No newline at end of file
@@ -6,7 +6,6 @@
 #include <algorithm>
 #include <functional>
 
-#include <assert.h>
 
 #include "debug.h"
 
@@ -47,18 +46,15 @@ namespace {
             map_[k_] = std::move (f_());
             DBG ("                \"" << k_ << "\" - RTN: " << map_[k_]->name() << " : " << map_[k_]->type()
                                       << std::endl); // NOLINT
-            assert (map_[k_]);
-            assert (map_[k_] != nullptr);
-            DBG (k_ << " =?= " << map_[k_]->type() << std::endl);
-            assert (k_ == map_[k_]->type());
+            if (!map_[k_]) {
+                throw std::runtime_error ("Failed to build a reader for " + k_);
+            }
 
             return map_[k_];
         } else {
             DBG ("ComputeIfAbsent \"" << k_ << "\" - found it" << std::endl); // NOLINT
             DBG ("                \"" << k_ << "\" - RTN: " << map_[k_]->name() << std::endl); // NOLINT
 
-            assert (it->second != nullptr);
-
             return it->second;
         }
     }
@@ -86,11 +82,17 @@ amqp::internal::
 CompositeFactory::process (const SchemaType & schema_) {
     DBG ("process schema" << std::endl);
 
-    for (const auto & i : dynamic_cast<const schema::Schema &>(schema_)) {
-        for (const auto & j : i) {
-            process (*j);
-            m_readersByDescriptor[j->descriptor()] = m_readersByType[j->name()];
-        }
+    process (schema::FlatSchema (dynamic_cast<const schema::Schema &>(schema_)));
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::
+CompositeFactory::process (const schema::FlatSchema & schema_) {
+    for (const auto & type : schema_.types()) {
+        auto reader = process (schema_, type);
+        m_readersByDescriptor[std::string (schema_.string (type.descriptor))] = reader;
     }
 }
 
@@ -99,22 +101,36 @@ CompositeFactory::process (const SchemaType & schema_) {
 std::shared_ptr<amqp::internal::reader::Reader>
 amqp::internal::
 CompositeFactory::process (
-    const amqp::internal::schema::AMQPTypeNotation & schema_)
+    const schema::FlatSchema & schema_,
+    const FlatType & type_)
 {
-    DBG ("process::" << schema_.name() << std::endl);
+    const std::string name { schema_.string (type_.name) };
+
+    DBG ("process::" << name << std::endl);
 
     return computeIfAbsent<reader::Reader> (
         m_readersByType,
-        schema_.name(),
-        [& schema_, this] () -> std::shared_ptr<reader::Reader> {
-            switch (schema_.type()) {
-                case schema::AMQPTypeNotation::composite_t : {
-                    return processComposite (schema_);
+        name,
+        [& schema_, & type_, this] () -> std::shared_ptr<reader::Reader> {
+            switch (type_.kind) {
+                case schema::FlatSchema::composite_k : {
+                    return processComposite (schema_, type_);
+                }
+                case schema::FlatSchema::list_k : {
+                    return processList (schema_, type_);
+                }
+                case schema::FlatSchema::enum_k : {
+                    return processEnum (schema_, type_);
                 }
-                case schema::AMQPTypeNotation::restricted_t : {
-                    return processRestricted (schema_);
+                case schema::FlatSchema::map_k : {
+                    return processMap (schema_, type_);
+                }
+                case schema::FlatSchema::array_k : {
+                    return processArray (schema_, type_);
                 }
             }
+
+            throw std::runtime_error ("Unknown type kind");
         });
 }
 
@@ -123,44 +139,51 @@ CompositeFactory::process (
 std::shared_ptr<amqp::internal::reader::Reader>
 amqp::internal::
 CompositeFactory::processComposite (
-        const amqp::internal::schema::AMQPTypeNotation & type_
+    const schema::FlatSchema & schema_,
+    const FlatType & type_
 ) {
-    DBG ("processComposite - " << type_.name() << std::endl);
+    DBG ("processComposite - " << schema_.string (type_.name) << std::endl);
     std::vector<std::weak_ptr<reader::Reader>> readers;
 
-    const auto & fields = dynamic_cast<const schema::Composite &> (
-            type_).fields();
+    const auto fields = schema_.fields (type_);
 
     readers.reserve (fields.size());
 
     for (const auto & field : fields) {
-        DBG ("  Field: " << field->name() << ": \"" << field->type()
-            << "\" {" << field->resolvedType() << "} "
-            << field->fieldType() << std::endl); // NOLINT
+        const std::string resolved { schema_.string (field.resolved) };
 
-       decltype (m_readersByType)::mapped_type reader;
+        DBG ("  Field: " << schema_.string (field.name) << ": \""
+            << schema_.string (field.type) << "\" {" << resolved << "} "
+            << field.kind << std::endl); // NOLINT
 
-        if (field->primitive()) {
+        decltype (m_readersByType)::mapped_type reader;
+
+        if (field.kind == schema::FlatSchema::primitive_f) {
             reader = computeIfAbsent<reader::Reader> (
                     m_readersByType,
-                    field->resolvedType(),
-                    [&field]() -> std::shared_ptr<reader::PropertyReader> {
-                        return reader::PropertyReader::make (field);
+                    resolved,
+                    [&resolved]() -> std::shared_ptr<reader::PropertyReader> {
+                        return reader::PropertyReader::make (resolved);
                     });
         }
         else {
             // Insertion sorting ensures any type we depend on will have
             // already been created and thus exist in the map
-            reader = m_readersByType[field->resolvedType()];
+            reader = m_readersByType[resolved];
         }
 
+        if (!reader) {
+            throw std::runtime_error (
+                "No reader for " + resolved + " needed by "
+                + std::string (schema_.string (type_.name)));
+        }
 
-        assert (reader);
         readers.emplace_back (reader);
-        assert (readers.back().lock());
     }
 
-    return std::make_shared<reader::CompositeReader> (type_.name(), readers);
+    return std::make_shared<reader::CompositeReader> (
+        std::string (schema_.string (type_.name)),
+        readers);
 }
 
 /******************************************************************************/
@@ -168,13 +191,20 @@ CompositeFactory::processComposite (
 std::shared_ptr<amqp::internal::reader::Reader>
 amqp::internal::
 CompositeFactory::processEnum (
-    const amqp::internal::schema::Enum & enum_
+    const schema::FlatSchema & schema_,
+    const FlatType & type_
 ) {
-    DBG ("Processing Enum - " << enum_.name() << std::endl); // NOLINT
+    DBG ("Processing Enum - " << schema_.string (type_.name) << std::endl); // NOLINT
+
+    std::vector<std::string> choices;
+
+    for (auto choice : schema_.ids (type_.of)) {
+        choices.emplace_back (schema_.string (choice));
+    }
 
     return std::make_shared<reader::EnumReader> (
-        enum_.name(),
-        enum_.makeChoices());
+        std::string (schema_.string (type_.name)),
+        choices);
 }
 
 /******************************************************************************/
@@ -210,18 +240,19 @@ CompositeFactory::fetchReaderForRestricted (const std::string & type_) {
 std::shared_ptr<amqp::internal::reader::Reader>
 amqp::internal::
 CompositeFactory::processMap (
-    const amqp::internal::schema::Map & map_
+    const schema::FlatSchema & schema_,
+    const FlatType & type_
 ) {
-    DBG ("Processing Map - "
-        << map_.mapOf().first.get() << " "
-        << map_.mapOf().second.get() << std::endl); // NOLINT
+    const auto types = schema_.ids (type_.of);
 
-    const auto types = map_.mapOf();
+    DBG ("Processing Map - "
+        << schema_.string (types[0]) << " "
+        << schema_.string (types[1]) << std::endl); // NOLINT
 
     return std::make_shared<reader::MapReader> (
-            map_.name(),
-            fetchReaderForRestricted (types.first),
-            fetchReaderForRestricted (types.second));
+            std::string (schema_.string (type_.name)),
+            fetchReaderForRestricted (std::string (schema_.string (types[0]))),
+            fetchReaderForRestricted (std::string (schema_.string (types[1]))));
 }
 
 /******************************************************************************/
@@ -229,13 +260,16 @@ CompositeFactory::processMap (
 std::shared_ptr<amqp::internal::reader::Reader>
 amqp::internal::
 CompositeFactory::processList (
-    const amqp::internal::schema::List & list_
+    const schema::FlatSchema & schema_,
+    const FlatType & type_
 ) {
-    DBG ("Processing List - " << list_.listOf() << std::endl); // NOLINT
+    const auto of = schema_.ids (type_.of);
+
+    DBG ("Processing List - " << schema_.string (of[0]) << std::endl); // NOLINT
 
     return std::make_shared<reader::ListReader> (
-            list_.name(),
-            fetchReaderForRestricted (list_.listOf()));
+            std::string (schema_.string (type_.name)),
+            fetchReaderForRestricted (std::string (schema_.string (of[0]))));
 }
 
 /******************************************************************************/
@@ -243,48 +277,17 @@ CompositeFactory::processList (
 std::shared_ptr<amqp::internal::reader::Reader>
 amqp::internal::
 CompositeFactory::processArray (
-        const amqp::internal::schema::Array & array_
+    const schema::FlatSchema & schema_,
+    const FlatType & type_
 ) {
-    DBG ("Processing Array - " << array_.name() << " " << array_.arrayOf() << std::endl); // NOLINT
-
-    return std::make_shared<reader::ArrayReader> (
-            array_.name(),
-            fetchReaderForRestricted (array_.arrayOf()));
-}
-
-/******************************************************************************/
+    const auto of = schema_.ids (type_.of);
 
-std::shared_ptr<amqp::internal::reader::Reader>
-amqp::internal::
-CompositeFactory::processRestricted (
-        const amqp::internal::schema::AMQPTypeNotation & type_)
-{
-    DBG ("processRestricted - " << type_.name() << std::endl); // NOLINT
-    const auto & restricted = dynamic_cast<const schema::Restricted &> (
-            type_);
-
-    switch (restricted.restrictedType()) {
-        case schema::Restricted::RestrictedTypes::list_t : {
-            return processList (
-                dynamic_cast<const schema::List &> (restricted));
-        }
-        case schema::Restricted::RestrictedTypes::enum_t : {
-            return processEnum (
-                dynamic_cast<const schema::Enum &> (restricted));
-        }
-        case schema::Restricted::RestrictedTypes::map_t : {
-            return processMap (
-                dynamic_cast<const schema::Map &> (restricted));
-        }
-        case schema::Restricted::RestrictedTypes::array_t : {
-            DBG ("  array_t" << std::endl);
-            return processArray (
-                dynamic_cast<const schema::Array &> (restricted));
-        }
-    }
+    DBG ("Processing Array - " << schema_.string (type_.name) << " "
+        << schema_.string (of[0]) << std::endl); // NOLINT
 
-    DBG ("  ProcessRestricted: Returning nullptr"); // NOLINT
-    return nullptr;
+    return std::make_shared<reader::ArrayReader> (
+            std::string (schema_.string (type_.name)),
+            fetchReaderForRestricted (std::string (schema_.string (of[0]))));
 }
 
 /******************************************************************************/
@@ -9,6 +9,7 @@
 #include "types.h"
 
 #include "amqp/ICompositeFactory.h"
+#include "amqp/schema/FlatSchema.h"
 #include "amqp/schema/described-types/Schema.h"
 #include "amqp/schema/described-types/Envelope.h"
 #include "amqp/schema/described-types/Composite.h"
@@ -43,27 +44,32 @@ namespace amqp::internal {
             const std::shared_ptr<ReaderType> byDescriptor (
                     const std::string &) override;
 
+            /**
+             * Readers are made from the flattened form of a schema, a
+             * [Schema] being flattened on the way in
+             */
+            void process (const schema::FlatSchema &);
+
         private :
+            using FlatType = schema::FlatSchema::Type;
+
             std::shared_ptr<reader::Reader> process (
-                    const schema::AMQPTypeNotation &);
+                    const schema::FlatSchema &, const FlatType &);
 
             std::shared_ptr<reader::Reader> processComposite (
-                    const schema::AMQPTypeNotation &);
-
-            std::shared_ptr<reader::Reader> processRestricted (
-                    const schema::AMQPTypeNotation &);
+                    const schema::FlatSchema &, const FlatType &);
 
             std::shared_ptr<reader::Reader> processList (
-                    const schema::List &);
+                    const schema::FlatSchema &, const FlatType &);
 
             std::shared_ptr<reader::Reader> processEnum (
-                    const schema::Enum &);
+                    const schema::FlatSchema &, const FlatType &);
 
             std::shared_ptr<reader::Reader> processMap (
-                    const schema::Map &);
+                    const schema::FlatSchema &, const FlatType &);
 
             std::shared_ptr<reader::Reader> processArray (
-                    const schema::Array &);
+                    const schema::FlatSchema &, const FlatType &);
 
             decltype(m_readersByType)::mapped_type
             fetchReaderForRestricted (const std::string &);
@@ -0,0 +1,89 @@
+#include "DecodeError.h"
+
+#include <sstream>
+
+/******************************************************************************
+ *
+ * amqp::internal::DecodeError
+ *
+ ******************************************************************************/
+
+amqp::internal::
+DecodeError::DecodeError (std::string reason_, size_t offset_)
+    : std::runtime_error (reason_)
+    , m_reason (std::move (reason_))
+    , m_offset (offset_)
+{
+    describe();
+}
+
+/******************************************************************************/
+
+amqp::internal::DecodeError
+amqp::internal::
+DecodeError::of (const std::exception & e_, const std::string & blob_) {
+    DecodeError rtn = [&e_] {
+        if (auto e = dynamic_cast<const DecodeError *> (&e_)) {
+            return *e;
+        }
+
+        return DecodeError (e_.what());
+    }();
+
+    rtn.blob (blob_);
+
+    return rtn;
+}
+
+/******************************************************************************/
+
+/**
+ * e.g. "line 12: Unexpected PN_INT reading string at offset 96"
+ */
+void
+amqp::internal::
+DecodeError::describe() {
+    std::stringstream ss;
+
+    if (!m_blob.empty()) {
+        ss << m_blob << ": ";
+    }
+
+    ss << m_reason;
+
+    if (m_offset != npos) {
+        ss << " at offset " << m_offset;
+    }
+
+    m_what = ss.str();
+}
+
+/******************************************************************************/
+
+const char *
+amqp::internal::
+DecodeError::what() const noexcept {
+    return m_what.c_str();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::
+DecodeError::at (size_t offset_) {
+    if (m_offset == npos) {
+        m_offset = offset_;
+        describe();
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::
+DecodeError::blob (std::string blob_) {
+    m_blob = std::move (blob_);
+    describe();
+}
+
+/******************************************************************************/
@@ -0,0 +1,69 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+/******************************************************************************
+ *
+ * amqp::internal::DecodeError
+ *
+ ******************************************************************************/
+
+namespace amqp::internal {
+
+    /**
+     * Why a blob couldn't be decoded, where in it that was noticed and
+     * which blob it was, each filled in by whoever knows it. Whatever
+     * finds a problem knows why, the decoder driving it where it had got
+     * to and whoever handed the decoder the blob what it's called.
+     *
+     * Offsets are from the start of the envelope, as are those of tokens
+     * and in an offset index.
+     */
+    class DecodeError : public std::runtime_error {
+        public :
+            static constexpr size_t npos = SIZE_MAX;
+
+        private :
+            std::string m_reason;
+            size_t      m_offset;
+            std::string m_blob;
+
+            /**
+             * what() has to hand back something that outlives it
+             */
+            std::string m_what;
+
+            void describe();
+
+        public :
+            explicit DecodeError (std::string reason_, size_t offset_ = npos);
+
+            /**
+             * Any exception thrown decoding a blob as an error about
+             * that blob, keeping whatever an error already knew
+             */
+            static DecodeError of (const std::exception &, const std::string & blob_);
+
+            const char * what() const noexcept override;
+
+            const std::string & reason() const { return m_reason; }
+            const std::string & blob() const { return m_blob; }
+
+            size_t offset() const { return m_offset; }
+
+            /**
+             * Only if it's not already known, the first to set it having
+             * been closest to the problem
+             */
+            void at (size_t);
+
+            void blob (std::string);
+    };
+
+}
+
+/******************************************************************************/
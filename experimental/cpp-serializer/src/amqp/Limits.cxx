@@ -0,0 +1,179 @@
+#include "Limits.h"
+
+#include <sstream>
+
+/******************************************************************************
+ *
+ * amqp::internal::Limits
+ *
+ ******************************************************************************/
+
+void
+amqp::internal::
+Limits::set (const std::string & limit_) {
+    auto eq = limit_.find ('=');
+
+    if (eq == std::string::npos || eq + 1 == limit_.size()) {
+        throw std::runtime_error ("Expected a limit as name=value, not " + limit_);
+    }
+
+    auto name = limit_.substr (0, eq);
+
+    size_t used { 0 };
+    unsigned long long value { 0 };
+
+    try {
+        value = std::stoull (limit_.substr (eq + 1), &used);
+    } catch (const std::exception &) {
+        used = 0;
+    }
+
+    if (used != limit_.size() - eq - 1 || limit_[eq + 1] == '-') {
+        throw std::runtime_error ("Bad value for limit " + limit_);
+    }
+
+    if (name == "depth") {
+        depth = value;
+    } else if (name == "elements") {
+        elements = value;
+    } else if (name == "bytes") {
+        bytes = value;
+    } else if (name == "types") {
+        types = value;
+    } else if (name == "time") {
+        time = std::chrono::milliseconds (value);
+    } else {
+        throw std::runtime_error (
+            "Unknown limit " + name + ", expected one of depth, elements,"
+            " bytes, types or time");
+    }
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::LimitExceeded
+ *
+ ******************************************************************************/
+
+namespace {
+
+    std::string
+    message (
+        amqp::internal::LimitExceeded::limit_t which_,
+        size_t limit_,
+        size_t value_
+    ) {
+        using amqp::internal::LimitExceeded;
+
+        std::stringstream ss;
+
+        switch (which_) {
+            case LimitExceeded::depth_l :
+                ss << "Nested " << value_ << " deep, the limit is " << limit_;
+                break;
+            case LimitExceeded::elements_l :
+                ss << "Claims " << value_ << " elements, the limit is " << limit_;
+                break;
+            case LimitExceeded::bytes_l :
+                ss << "Output exceeds the limit of " << limit_ << " bytes";
+                break;
+            case LimitExceeded::types_l :
+                ss << "Schema has " << value_ << " types, the limit is " << limit_;
+                break;
+            case LimitExceeded::time_l :
+                ss << "Took longer than the limit of " << limit_ << "ms";
+                break;
+        }
+
+        return ss.str();
+    }
+
+}
+
+/******************************************************************************/
+
+amqp::internal::
+LimitExceeded::LimitExceeded (limit_t which_, size_t limit_, size_t value_)
+    : DecodeError (message (which_, limit_, value_))
+    , m_limit (which_)
+{ }
+
+/******************************************************************************
+ *
+ * amqp::internal::Budget
+ *
+ ******************************************************************************/
+
+thread_local amqp::internal::Budget *
+amqp::internal::
+Budget::m_current { nullptr };
+
+/******************************************************************************/
+
+amqp::internal::
+Budget::Budget (const Limits & limits_)
+    : m_limits (limits_)
+    , m_offset (0)
+{
+    reset();
+}
+
+/******************************************************************************/
+
+amqp::internal::
+Budget::Budget (const Budget & parent_, size_t depth_)
+    : m_limits (parent_.m_limits)
+    , m_depth (0)
+    , m_bytes (parent_.m_bytes)
+    , m_ticks (0)
+    , m_offset (parent_.m_offset + depth_)
+    , m_deadline (parent_.m_deadline)
+{
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::
+Budget::reset() {
+    m_depth = 0;
+    m_bytes = 0;
+    m_ticks = 0;
+    m_deadline = std::chrono::steady_clock::now() + m_limits.time;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::
+Budget::exceeded (LimitExceeded::limit_t which_, size_t limit_, size_t value_) {
+    throw LimitExceeded (which_, limit_, value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::
+Budget::clock() {
+    if (std::chrono::steady_clock::now() > m_deadline) {
+        exceeded (LimitExceeded::time_l, m_limits.time.count(), 0);
+    }
+}
+
+/******************************************************************************/
+
+amqp::internal::
+Budget::Scope::Scope (Budget & budget_)
+    : m_previous (m_current)
+{
+    m_current = &budget_;
+}
+
+/******************************************************************************/
+
+amqp::internal::
+Budget::Scope::~Scope() {
+    m_current = m_previous;
+}
+
+/******************************************************************************/
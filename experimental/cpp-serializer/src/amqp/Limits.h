@@ -0,0 +1,264 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <chrono>
+#include <string>
+#include <cstddef>
+
+#include "DecodeError.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::Limits
+ *
+ ******************************************************************************/
+
+namespace amqp::internal {
+
+    /**
+     * Bounds on how much a single blob may make us do. A blob is untrusted
+     * input, one claiming a list of four billion elements or nesting its
+     * values thousands deep shouldn't be able to take down whatever is
+     * decoding it, let alone the rest of a batch. A limit of zero is no
+     * limit at all.
+     */
+    struct Limits {
+        /**
+         * How deeply values, and the descriptors of a schema, may nest
+         */
+        size_t depth { 512 };
+
+        /**
+         * The most elements a single list, array or map may have
+         */
+        size_t elements { 1U << 24U };
+
+        /**
+         * Roughly how much decoded output a blob may produce, strings
+         * counting their length and every other value eight bytes. It's
+         * what stops back references being expanded exponentially.
+         */
+        size_t bytes { 1U << 30U };
+
+        /**
+         * The most types a blob's schema may describe
+         */
+        size_t types { 1U << 16U };
+
+        std::chrono::milliseconds time { 0 };
+
+        /**
+         * Change one limit given as "name=value", e.g. "depth=64" or
+         * "time=500", throwing if the name or value makes no sense
+         */
+        void set (const std::string &);
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::LimitExceeded
+ *
+ ******************************************************************************/
+
+namespace amqp::internal {
+
+    class LimitExceeded : public DecodeError {
+        public :
+            enum limit_t { depth_l, elements_l, bytes_l, types_l, time_l };
+
+        private :
+            limit_t m_limit;
+
+        public :
+            LimitExceeded (limit_t, size_t limit_, size_t value_);
+
+            limit_t limit() const { return m_limit; }
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::Budget
+ *
+ ******************************************************************************/
+
+namespace amqp::internal {
+
+    /**
+     * How much of its [Limits] the blob being decoded has used. The readers
+     * and descriptor builders can't be handed one, they're shared between
+     * blobs and threads and their signatures are fixed by the schema, so a
+     * budget is installed on the current thread by a [Scope] for as long as
+     * a decoder is working on its blob, and everything beneath charges to
+     * whichever budget that is. With none installed nothing is checked.
+     *
+     * Every check is an increment or comparison, the clock only being
+     * looked at every few thousand of them.
+     */
+    class Budget {
+        private :
+            static constexpr size_t TICKS = 4096;
+
+            Limits m_limits;
+
+            size_t m_depth;
+            size_t m_bytes;
+            size_t m_ticks;
+
+            /**
+             * how deeply nested whatever this budget is for already is
+             */
+            size_t m_offset;
+
+            std::chrono::steady_clock::time_point m_deadline;
+
+            static thread_local Budget * m_current;
+
+            [[noreturn]] static void exceeded (
+                LimitExceeded::limit_t, size_t limit_, size_t value_);
+
+            void clock();
+
+            void tick() {
+                if (++m_ticks % TICKS == 0 && m_limits.time.count()) {
+                    clock();
+                }
+            }
+
+        public :
+            explicit Budget (const Limits & = Limits());
+
+            /**
+             * For another thread working on part of the same blob, a
+             * value nested [depth_] deep within it. It has whatever's
+             * left of [parent_]'s time and output, but what it charges
+             * isn't charged to [parent_] as well.
+             */
+            Budget (const Budget & parent_, size_t depth_);
+
+            /**
+             * Start again for the next blob
+             */
+            void reset();
+
+            const Limits & limits() const { return m_limits; }
+
+            /**
+             * How much output has been charged so far
+             */
+            size_t used() const { return m_bytes; }
+
+            /**
+             * Null when there isn't one
+             */
+            static Budget * current() { return m_current; }
+
+            /**
+             * Installs a budget for its lifetime, putting back whichever
+             * was there before
+             */
+            class Scope {
+                private :
+                    Budget * m_previous;
+
+                public :
+                    explicit Scope (Budget &);
+                    ~Scope();
+
+                    Scope (const Scope &) = delete;
+                    Scope & operator = (const Scope &) = delete;
+            };
+
+            /**
+             * One level deeper for its lifetime, for anything recursing
+             */
+            class Level {
+                private :
+                    Budget * m_budget;
+
+                public :
+                    Level() : m_budget (m_current) {
+                        if (m_budget) {
+                            m_budget->tick();
+
+                            auto depth = ++m_budget->m_depth + m_budget->m_offset;
+
+                            if (depth > m_budget->m_limits.depth
+                                && m_budget->m_limits.depth)
+                            {
+                                --m_budget->m_depth;
+                                exceeded (
+                                    LimitExceeded::depth_l,
+                                    m_budget->m_limits.depth,
+                                    depth);
+                            }
+                        }
+                    }
+
+                    ~Level() {
+                        if (m_budget) {
+                            --m_budget->m_depth;
+                        }
+                    }
+
+                    Level (const Level &) = delete;
+                    Level & operator = (const Level &) = delete;
+            };
+
+            /**
+             * For anything tracking its own depth rather than recursing
+             */
+            static void depth (size_t depth_) {
+                if (auto b = m_current) {
+                    b->tick();
+
+                    auto depth = depth_ + b->m_offset;
+
+                    if (depth > b->m_limits.depth && b->m_limits.depth) {
+                        exceeded (LimitExceeded::depth_l, b->m_limits.depth, depth);
+                    }
+                }
+            }
+
+            /**
+             * A list, array or map about to be read
+             */
+            static void elements (size_t elements_) {
+                if (auto b = m_current) {
+                    if (elements_ > b->m_limits.elements && b->m_limits.elements) {
+                        exceeded (LimitExceeded::elements_l, b->m_limits.elements, elements_);
+                    }
+                }
+            }
+
+            static void output (size_t bytes_) {
+                if (auto b = m_current) {
+                    b->tick();
+
+                    b->m_bytes += bytes_;
+
+                    if (b->m_bytes > b->m_limits.bytes && b->m_limits.bytes) {
+                        exceeded (LimitExceeded::bytes_l, b->m_limits.bytes, b->m_bytes);
+                    }
+                }
+            }
+
+            /**
+             * A schema about to be loaded
+             */
+            static void types (size_t types_) {
+                if (auto b = m_current) {
+                    if (types_ > b->m_limits.types && b->m_limits.types) {
+                        exceeded (LimitExceeded::types_l, b->m_limits.types, types_);
+                    }
+                }
+            }
+    };
+
+}
+
+/******************************************************************************/
@@ -2,7 +2,6 @@
 
 #include <string>
 #include <iostream>
-#include <assert.h>
 
 #include <proton/codec.h>
 #include <sstream>
@@ -10,6 +9,7 @@
 #include "Reader.h"
 #include "amqp/reader/IReader.h"
 #include "proton/proton_wrapper.h"
+#include "amqp/Limits.h"
 
 /******************************************************************************/
 
@@ -33,10 +33,14 @@ CompositeReader::CompositeReader (
 {
     DBG ("MAKE CompositeReader: " << m_type << ": " << m_readers.size() << std::endl); // NOLINT
     for (auto const reader : m_readers) {
-        assert (reader.lock());
-        if (auto r = reader.lock()) {
-            DBG ("  prop: " << r->name() << " " << r->type() << std::endl); // NOLINT
+        auto r = reader.lock();
+
+        if (!r) {
+            throw std::runtime_error (
+                "Composite " + m_type + " has a property with no reader");
         }
+
+        DBG ("  prop: " << r->name() << " " << r->type() << std::endl); // NOLINT
     }
 }
 
@@ -91,15 +95,22 @@ CompositeReader::_dump (
         << std::endl); // NOLINT
 
     proton::is_described (data_);
+    unreferenced (data_);
+    Budget::Level level;
     proton::auto_enter ae (data_);
 
     const auto & it = schema_.fromDescriptor (
-            proton::get_symbol<std::string>(data_));
+            proton::get_symbol<std::string_view>(data_));
 
     auto & fields = dynamic_cast<schema::Composite &> (
             *(it->second.get())).fields();
 
-    assert (fields.size() == m_readers.size());
+    if (fields.size() != m_readers.size()) {
+        std::stringstream s;
+        s << type() << " has " << fields.size() << " fields but "
+          << m_readers.size() << " readers";
+        throw std::runtime_error (s.str());
+    }
 
     pn_data_next (data_);
 
@@ -112,6 +123,8 @@ CompositeReader::_dump (
 
         for (int i (0) ; i < m_readers.size() ; ++i) {
             if (auto l =  m_readers[i].lock()) {
+                Budget::output (8);
+
                 DBG (fields[i]->name() << " "
                     << (l ? "true" : "false") << std::endl); // NOLINT
 
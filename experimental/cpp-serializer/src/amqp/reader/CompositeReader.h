@@ -44,6 +44,10 @@ namespace amqp::internal::reader {
             const std::string & name() const override;
             const std::string & type() const override;
 
+            const std::vector<std::weak_ptr<Reader>> & readers() const {
+                return m_readers;
+            }
+
         private :
             std::vector<std::unique_ptr<amqp::reader::IValue>> _dump (
                 pn_data_t *,
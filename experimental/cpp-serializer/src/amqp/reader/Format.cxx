@@ -0,0 +1,227 @@
+#include "Format.h"
+
+#include <charconv>
+#include <algorithm>
+
+#if defined (__AVX2__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * U+FFFD, what we put in place of anything that isn't valid UTF-8
+     */
+    const char REPLACEMENT[] = "\xef\xbf\xbd";
+
+    /**
+     * Anything that can't be copied straight across, quotes, backslashes
+     * and control characters need escaping and anything outside of ASCII
+     * needs validating
+     */
+    inline bool
+    special (unsigned char c_) {
+        return c_ < 0x20 || c_ >= 0x80 || c_ == '"' || c_ == '\\';
+    }
+
+    /**
+     * How many bytes from [begin_] can be copied as they are. Looked at
+     * a block at a time where we can, chars being signed a single less
+     * than comparison against a space catches both control characters
+     * and everything from 0x80 up.
+     */
+    size_t
+    clean (const char * begin_, const char * end_) {
+        auto p = begin_;
+
+#if defined (__AVX2__)
+        for ( ; end_ - p >= 32 ; p += 32) {
+            auto v = _mm256_loadu_si256 (reinterpret_cast<const __m256i *>(p));
+
+            auto m = _mm256_or_si256 (
+                _mm256_cmpgt_epi8 (_mm256_set1_epi8 (0x20), v),
+                _mm256_or_si256 (
+                    _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('"')),
+                    _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('\\'))));
+
+            if (auto bits = static_cast<uint32_t> (_mm256_movemask_epi8 (m))) {
+                return p - begin_ + __builtin_ctz (bits);
+            }
+        }
+#endif
+
+#if defined (__SSE2__)
+        for ( ; end_ - p >= 16 ; p += 16) {
+            auto v = _mm_loadu_si128 (reinterpret_cast<const __m128i *>(p));
+
+            auto m = _mm_or_si128 (
+                _mm_cmplt_epi8 (v, _mm_set1_epi8 (0x20)),
+                _mm_or_si128 (
+                    _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('"')),
+                    _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('\\'))));
+
+            if (auto bits = static_cast<uint32_t> (_mm_movemask_epi8 (m))) {
+                return p - begin_ + __builtin_ctz (bits);
+            }
+        }
+#endif
+
+        while (p < end_ && !special (*p)) {
+            ++p;
+        }
+
+        return p - begin_;
+    }
+
+    /**
+     * The length of the UTF-8 sequence starting at [p_], or 0 if it isn't
+     * a valid one. Overlong forms, surrogates, anything beyond U+10FFFF
+     * and sequences cut short are all invalid.
+     */
+    size_t
+    sequence (const unsigned char * p_, size_t size_) {
+        size_t n;
+
+        // the range the second byte must fall within
+        unsigned char lo { 0x80 }, hi { 0xbf };
+
+        if (p_[0] >= 0xc2 && p_[0] <= 0xdf) {
+            n = 2;
+        } else if (p_[0] >= 0xe0 && p_[0] <= 0xef) {
+            n = 3;
+            if (p_[0] == 0xe0) lo = 0xa0;
+            if (p_[0] == 0xed) hi = 0x9f;
+        } else if (p_[0] >= 0xf0 && p_[0] <= 0xf4) {
+            n = 4;
+            if (p_[0] == 0xf0) lo = 0x90;
+            if (p_[0] == 0xf4) hi = 0x8f;
+        } else {
+            return 0;
+        }
+
+        if (size_ < n || p_[1] < lo || p_[1] > hi) {
+            return 0;
+        }
+
+        for (size_t i { 2 } ; i < n ; ++i) {
+            if ((p_[i] & 0xc0) != 0x80) {
+                return 0;
+            }
+        }
+
+        return n;
+    }
+
+    /**
+     * The JSON escape for a character below 0x80, using the short forms
+     * where there are any
+     */
+    void
+    escape (std::string & out_, unsigned char c_) {
+        switch (c_) {
+            case '"'  : out_.append ("\\\""); break;
+            case '\\' : out_.append ("\\\\"); break;
+            case '\b' : out_.append ("\\b"); break;
+            case '\f' : out_.append ("\\f"); break;
+            case '\n' : out_.append ("\\n"); break;
+            case '\r' : out_.append ("\\r"); break;
+            case '\t' : out_.append ("\\t"); break;
+            default : {
+                const char * hex = "0123456789abcdef";
+                char u[] = { '\\', 'u', '0', '0', hex[c_ >> 4], hex[c_ & 0xf] };
+                out_.append (u, sizeof (u));
+            }
+        }
+    }
+
+}
+
+/******************************************************************************/
+
+char *
+amqp::internal::reader::
+format (char * out_, bool value_) {
+    *out_ = value_ ? '1' : '0';
+    return out_ + 1;
+}
+
+/******************************************************************************/
+
+char *
+amqp::internal::reader::
+format (char * out_, int32_t value_) {
+    return std::to_chars (out_, out_ + FORMAT_MAX, value_).ptr;
+}
+
+/******************************************************************************/
+
+char *
+amqp::internal::reader::
+format (char * out_, int64_t value_) {
+    return std::to_chars (out_, out_ + FORMAT_MAX, value_).ptr;
+}
+
+/******************************************************************************/
+
+char *
+amqp::internal::reader::
+format (char * out_, double value_) {
+    auto end = std::to_chars (out_, out_ + FORMAT_MAX, value_).ptr;
+
+    /*
+     * Anything with an exponent, a point or that isn't a number at all
+     * (inf and nan) is clearly not an integer already
+     */
+    if (std::all_of (out_, end, [](char c_) { return c_ == '-' || (c_ >= '0' && c_ <= '9'); })) {
+        *end++ = '.';
+        *end++ = '0';
+    }
+
+    return end;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::reader::
+quote (std::string & out_, std::string_view value_) {
+    // escaping only ever adds to a string so this is the least we'll need
+    out_.reserve (out_.size() + value_.size() + 2);
+    out_.push_back ('"');
+
+    auto p = value_.data();
+    auto end = p + value_.size();
+
+    while (p < end) {
+        auto run = clean (p, end);
+        out_.append (p, run);
+        p += run;
+
+        if (p == end) {
+            break;
+        }
+
+        auto c = static_cast<unsigned char> (*p);
+
+        if (c < 0x80) {
+            escape (out_, c);
+            ++p;
+        } else if (auto n = sequence (
+                reinterpret_cast<const unsigned char *> (p), end - p))
+        {
+            out_.append (p, n);
+            p += n;
+        } else {
+            out_.append (REPLACEMENT);
+            ++p;
+        }
+    }
+
+    out_.push_back ('"');
+}
+
+/******************************************************************************/
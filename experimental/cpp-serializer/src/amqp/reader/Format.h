@@ -0,0 +1,68 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+/******************************************************************************
+ *
+ * Rendering of primitive values
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::reader {
+
+    /**
+     * Room enough for any value [format] can write
+     */
+    constexpr size_t FORMAT_MAX = 32;
+
+    /**
+     * Write the textual form of a value into the buffer, which must have
+     * at least [FORMAT_MAX] bytes free, returning the end of what was
+     * written. None of these are locale aware.
+     *
+     * Doubles are written in the shortest form that reads back to the
+     * same value, with ".0" added to those that would otherwise look
+     * like integers. Bools, as they always have been, are 1 or 0.
+     */
+    char * format (char *, bool);
+    char * format (char *, int32_t);
+    char * format (char *, int64_t);
+    char * format (char *, double);
+
+    template<typename T>
+    void
+    append (std::string & out_, T value_) {
+        char buffer[FORMAT_MAX];
+        out_.append (buffer, format (buffer, value_));
+    }
+
+    template<typename T>
+    std::string
+    toString (T value_) {
+        char buffer[FORMAT_MAX];
+        return { buffer, format (buffer, value_) };
+    }
+
+    /**
+     * Append a string, quoted and escaped, such that the result is a
+     * valid JSON string. Quotes, backslashes and control characters are
+     * escaped and anything that isn't valid UTF-8 is replaced, byte by
+     * byte, with U+FFFD. Everything else is copied across untouched, a
+     * run at a time.
+     */
+    void quote (std::string &, std::string_view);
+
+    inline std::string
+    quote (std::string_view value_) {
+        std::string rtn;
+        quote (rtn, value_);
+        return rtn;
+    }
+
+}
+
+/******************************************************************************/
@@ -8,6 +8,7 @@
 
 #include <map>
 #include <string>
+#include <sstream>
 #include <iostream>
 #include <functional>
 
@@ -15,6 +16,9 @@
 
 #include "proton/proton_wrapper.h"
 
+#include "amqp/DecodeError.h"
+#include "amqp/stream/Tokeniser.h"
+
 /******************************************************************************/
 
 namespace {
@@ -83,3 +87,14 @@ PropertyReader::make (const internal::schema::Field & field_) {
 }
 
 /******************************************************************************/
+
+void
+amqp::internal::reader::
+PropertyReader::unexpected (const stream::Token & token_) const {
+    std::stringstream ss;
+    ss << "Expected a " << type() << " but found "
+       << pn_type_name (token_.type);
+    throw DecodeError (ss.str(), token_.offset);
+}
+
+/******************************************************************************/
@@ -4,10 +4,19 @@
 
 #include "Reader.h"
 
+#include "amqp/reader/IVisitor.h"
 #include "amqp/schema/field-types/Field.h"
 
 /******************************************************************************/
 
+namespace amqp::internal::stream {
+
+    struct Token;
+
+}
+
+/******************************************************************************/
+
 namespace amqp::internal::reader {
 
     class PropertyReader : public Reader {
@@ -42,6 +51,19 @@ namespace amqp::internal::reader {
 
             const std::string & name() const override = 0;
             const std::string & type() const override = 0;
+
+            /**
+             * Where [dump] pulls a value out of a proton tree this is handed
+             * a single token by a streaming decoder and passes it on to the
+             * visitor
+             */
+            virtual void visit (
+                const stream::Token &,
+                amqp::reader::IVisitor &
+            ) const = 0;
+
+        protected :
+            [[noreturn]] void unexpected (const stream::Token &) const;
     };
 
 }
@@ -2,6 +2,14 @@
 
 #include <memory>
 #include <sstream>
+#include <stdexcept>
+
+#include <proton/codec.h>
+
+#include "proton/proton_wrapper.h"
+
+#include "amqp/schema/Descriptors.h"
+#include "amqp/schema/descriptors/AMQPDescriptorRegistory.h"
 
 /******************************************************************************/
 
@@ -172,3 +180,30 @@ TypedSingle<sVec<uPtr<amqp::internal::reader::Single>>>::dump() const {
 }
 
 /******************************************************************************/
+
+amqp::internal::reader::
+Referenced::Referenced() : std::runtime_error (
+    "Referenced objects are only supported when streaming")
+{
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::reader::
+unreferenced (pn_data_t * data_) {
+    if (pn_data_type (data_) != PN_DESCRIBED) {
+        return;
+    }
+
+    proton::auto_enter ae (data_);
+
+    if (pn_data_type (data_) == PN_ULONG
+        && amqp::stripCorda (pn_data_get_ulong (data_))
+                == static_cast<uint32_t>(amqp::schema::descriptors::REFERENCED_OBJECT))
+    {
+        throw Referenced();
+    }
+}
+
+/******************************************************************************/
@@ -7,9 +7,11 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <stdexcept>
 
 #include "amqp/schema/described-types/Schema.h"
 #include "amqp/reader/IReader.h"
+#include "amqp/reader/Format.h"
 
 /******************************************************************************/
 
@@ -158,7 +160,7 @@ template<typename T>
 inline std::string
 amqp::internal::reader::
 TypedSingle<T>::dump() const {
-    return std::to_string (m_value);
+    return toString (m_value);
 }
 
 template<>
@@ -198,14 +200,23 @@ template<typename T>
 inline std::string
 amqp::internal::reader::
 TypedPair<T>::dump() const {
-    return m_property + " : " + std::to_string (m_value);
+    std::string rtn;
+    rtn.reserve (m_property.size() + 3 + FORMAT_MAX);
+
+    rtn.append (m_property).append (" : ");
+    append (rtn, m_value);
+
+    return rtn;
 }
 
 template<>
 inline std::string
 amqp::internal::reader::
 TypedPair<std::string>::dump() const {
-    return m_property + " : " + m_value;
+    std::string rtn;
+    rtn.reserve (m_property.size() + 3 + m_value.size());
+
+    return rtn.append (m_property).append (" : ").append (m_value);
 }
 
 template<>
@@ -269,6 +280,23 @@ namespace amqp::internal::reader  {
                 const SchemaType &) const override = 0;
     };
 
+    /**
+     * What [unreferenced] throws, so whoever's driving the readers can
+     * tell a blob they can't read from a broken one
+     */
+    class Referenced : public std::runtime_error {
+        public :
+            Referenced();
+    };
+
+    /**
+     * Throws if the value at the cursor is a REFERENCED_OBJECT, a link
+     * back to an object already written to the blob. The readers are
+     * shared between blobs and have nowhere to keep the objects they've
+     * read, only the stream::StreamDecoder, which does, can cope.
+     */
+    void unreferenced (pn_data_t *);
+
 }
 
 /******************************************************************************/
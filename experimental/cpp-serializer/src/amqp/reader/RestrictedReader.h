@@ -30,6 +30,8 @@ namespace amqp::internal::reader {
 
             std::string readString (pn_data_t *) const override;
 
+            virtual internal::schema::Restricted::RestrictedTypes restrictedType() const = 0;
+
             std::unique_ptr<amqp::reader::IValue> dump(
                 const std::string &,
                 pn_data_t *,
@@ -2,6 +2,9 @@
 
 #include "proton/proton_wrapper.h"
 
+#include "amqp/reader/Format.h"
+#include "amqp/stream/Tokeniser.h"
+
 /******************************************************************************
  *
  * BoolPropertyReader statics
@@ -39,7 +42,7 @@ BoolPropertyReader::read (pn_data_t * data_) const {
 std::string
 amqp::internal::reader::
 BoolPropertyReader::readString (pn_data_t * data_) const {
-    return std::to_string (proton::readAndNext<bool> (data_));
+    return toString (proton::readAndNext<bool> (data_));
 }
 
 /******************************************************************************/
@@ -53,7 +56,7 @@ BoolPropertyReader::dump (
 {
     return std::make_unique<TypedPair<std::string>> (
             name_,
-            std::to_string (proton::readAndNext<bool> (data_)));
+            toString (proton::readAndNext<bool> (data_)));
 }
 
 /******************************************************************************/
@@ -65,7 +68,7 @@ BoolPropertyReader::dump (
         const SchemaType & schema_) const
 {
     return std::make_unique<TypedSingle<std::string>> (
-            std::to_string (proton::readAndNext<bool> (data_)));
+            toString (proton::readAndNext<bool> (data_)));
 }
 
 /******************************************************************************/
@@ -85,3 +88,18 @@ BoolPropertyReader::type() const {
 }
 
 /******************************************************************************/
+
+void
+amqp::internal::reader::
+BoolPropertyReader::visit (
+    const stream::Token & token_,
+    amqp::reader::IVisitor & visitor_
+) const {
+    if (token_.type != PN_BOOL) {
+        unexpected (token_);
+    }
+
+    visitor_.value (token_.value.b);
+}
+
+/******************************************************************************/
@@ -31,6 +31,11 @@ namespace amqp::internal::reader {
 
             const std::string & name() const override;
             const std::string & type() const override;
+
+            void visit (
+                const stream::Token &,
+                amqp::reader::IVisitor &
+            ) const override;
     };
 
 }
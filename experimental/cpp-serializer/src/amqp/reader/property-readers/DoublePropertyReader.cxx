@@ -2,6 +2,9 @@
 
 #include "proton/proton_wrapper.h"
 
+#include "amqp/reader/Format.h"
+#include "amqp/stream/Tokeniser.h"
+
 /******************************************************************************
  *
  * DoublePropertyReader statics
@@ -37,7 +40,7 @@ DoublePropertyReader::read (pn_data_t * data_) const {
 std::string
 amqp::internal::reader::
 DoublePropertyReader::readString (pn_data_t * data_) const {
-    return std::to_string (proton::readAndNext<double> (data_));
+    return toString (proton::readAndNext<double> (data_));
 }
 
 /******************************************************************************/
@@ -51,7 +54,7 @@ DoublePropertyReader::dump (
 {
     return std::make_unique<TypedPair<std::string>> (
             name_,
-            std::to_string (proton::readAndNext<double> (data_)));
+            toString (proton::readAndNext<double> (data_)));
 }
 
 /******************************************************************************/
@@ -63,7 +66,7 @@ DoublePropertyReader::dump (
         const SchemaType & schema_) const
 {
     return std::make_unique<TypedSingle<std::string>> (
-            std::to_string (proton::readAndNext<double> (data_)));
+            toString (proton::readAndNext<double> (data_)));
 }
 
 /******************************************************************************/
@@ -83,3 +86,18 @@ DoublePropertyReader::type() const {
 }
 
 /******************************************************************************/
+
+void
+amqp::internal::reader::
+DoublePropertyReader::visit (
+    const stream::Token & token_,
+    amqp::reader::IVisitor & visitor_
+) const {
+    if (token_.type != PN_DOUBLE) {
+        unexpected (token_);
+    }
+
+    visitor_.value (token_.value.d);
+}
+
+/******************************************************************************/
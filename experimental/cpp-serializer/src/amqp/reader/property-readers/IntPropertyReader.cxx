@@ -6,6 +6,9 @@
 #include <proton/codec.h>
 
 #include "proton/proton_wrapper.h"
+
+#include "amqp/reader/Format.h"
+#include "amqp/stream/Tokeniser.h"
 #include "amqp/reader/IReader.h"
 
 /******************************************************************************
@@ -45,7 +48,7 @@ IntPropertyReader::read (pn_data_t * data_) const {
 std::string
 amqp::internal::reader::
 IntPropertyReader::readString (pn_data_t * data_) const {
-    return std::to_string (proton::readAndNext<int> (data_));
+    return toString (proton::readAndNext<int> (data_));
 }
 
 /******************************************************************************/
@@ -59,7 +62,7 @@ IntPropertyReader::dump (
 {
     return std::make_unique<TypedPair<std::string>> (
             name_,
-            std::to_string (proton::readAndNext<int> (data_)));
+            toString (proton::readAndNext<int> (data_)));
 }
 
 /******************************************************************************/
@@ -71,7 +74,7 @@ IntPropertyReader::dump (
     const SchemaType & schema_) const
 {
     return std::make_unique<TypedSingle<std::string>> (
-            std::to_string (proton::readAndNext<int> (data_)));
+            toString (proton::readAndNext<int> (data_)));
 }
 
 /******************************************************************************/
@@ -91,3 +94,18 @@ IntPropertyReader::type() const {
 }
 
 /******************************************************************************/
+
+void
+amqp::internal::reader::
+IntPropertyReader::visit (
+    const stream::Token & token_,
+    amqp::reader::IVisitor & visitor_
+) const {
+    if (token_.type != PN_INT) {
+        unexpected (token_);
+    }
+
+    visitor_.value (static_cast<int32_t>(token_.value.l));
+}
+
+/******************************************************************************/
@@ -2,6 +2,9 @@
 
 #include "proton/proton_wrapper.h"
 
+#include "amqp/reader/Format.h"
+#include "amqp/stream/Tokeniser.h"
+
 /******************************************************************************
  *
  * LongPropertyReader statics
@@ -39,7 +42,7 @@ LongPropertyReader::read (pn_data_t * data_) const {
 std::string
 amqp::internal::reader::
 LongPropertyReader::readString (pn_data_t * data_) const {
-    return std::to_string (proton::readAndNext<long> (data_));
+    return toString<int64_t> (proton::readAndNext<long> (data_));
 }
 
 /******************************************************************************/
@@ -53,7 +56,7 @@ LongPropertyReader::dump (
 {
     return std::make_unique<TypedPair<std::string>> (
             name_,
-            std::to_string (proton::readAndNext<long> (data_)));
+            toString<int64_t> (proton::readAndNext<long> (data_)));
 }
 
 /******************************************************************************/
@@ -65,7 +68,7 @@ LongPropertyReader::dump (
     const SchemaType & schema_) const
 {
     return std::make_unique<TypedSingle<std::string>> (
-            std::to_string (proton::readAndNext<long> (data_)));
+            toString<int64_t> (proton::readAndNext<long> (data_)));
 }
 
 /******************************************************************************/
@@ -85,3 +88,18 @@ LongPropertyReader::type() const {
 }
 
 /******************************************************************************/
+
+void
+amqp::internal::reader::
+LongPropertyReader::visit (
+    const stream::Token & token_,
+    amqp::reader::IVisitor & visitor_
+) const {
+    if (token_.type != PN_LONG) {
+        unexpected (token_);
+    }
+
+    visitor_.value (static_cast<int64_t>(token_.value.l));
+}
+
+/******************************************************************************/
@@ -4,6 +4,10 @@
 
 #include "proton/proton_wrapper.h"
 
+#include "amqp/Limits.h"
+#include "amqp/reader/Format.h"
+#include "amqp/stream/Tokeniser.h"
+
 /******************************************************************************
  *
  * StringPropertyReader statics
@@ -53,9 +57,12 @@ StringPropertyReader::dump (
     pn_data_t * data_,
     const SchemaType & schema_) const
 {
-    return std::make_unique<TypedPair<std::string>> (
-            name_,
-            "\"" + proton::readAndNext<std::string> (data_) + "\"");
+    unreferenced (data_);
+
+    auto value = proton::readAndNext<std::string_view> (data_);
+    Budget::output (value.size());
+
+    return std::make_unique<TypedPair<std::string>> (name_, quote (value));
 }
 
 /******************************************************************************/
@@ -66,8 +73,12 @@ StringPropertyReader::dump (
         pn_data_t * data_,
         const SchemaType & schema_) const
 {
-    return std::make_unique<TypedSingle<std::string>> (
-            "\"" + proton::readAndNext<std::string> (data_) + "\"");
+    unreferenced (data_);
+
+    auto value = proton::readAndNext<std::string_view> (data_);
+    Budget::output (value.size());
+
+    return std::make_unique<TypedSingle<std::string>> (quote (value));
 }
 
 /******************************************************************************/
@@ -87,3 +98,18 @@ StringPropertyReader::type() const {
 }
 
 /******************************************************************************/
+
+void
+amqp::internal::reader::
+StringPropertyReader::visit (
+    const stream::Token & token_,
+    amqp::reader::IVisitor & visitor_
+) const {
+    if (token_.type != PN_STRING && token_.type != PN_SYMBOL) {
+        unexpected (token_);
+    }
+
+    visitor_.value (std::string_view (token_.bytes, token_.size));
+}
+
+/******************************************************************************/
@@ -19,35 +19,33 @@ EnumReader::EnumReader (
 
 /******************************************************************************/
 
+amqp::internal::schema::Restricted::RestrictedTypes
+amqp::internal::reader::
+EnumReader::restrictedType() const {
+    return internal::schema::Restricted::RestrictedTypes::enum_t;
+}
+
+/******************************************************************************/
+
 namespace {
 
     std::string
     getValue (pn_data_t * data_) {
         proton::is_described (data_);
 
+        amqp::internal::reader::unreferenced (data_);
+
         {
             proton::auto_enter ae (data_);
 
             /*
-             * Referenced objects are added to a stream when the serialiser
-             * notices it's writing a value it's already written, so to save
-             * space it will just link back to that. Currently we have
-             * no mechanism for decoding that so just throw an error
+             * skip the fingerprint
              */
-            if (pn_data_type (data_) == PN_ULONG) {
-                if (amqp::stripCorda(pn_data_get_ulong(data_)) ==
-                amqp::schema::descriptors::REFERENCED_OBJECT
-            ) {
-                    throw std::runtime_error (
-                            "Currently don't support referenced objects");
-                }
-            }
-
-            auto fingerprint = proton::readAndNext<std::string>(data_);
+            pn_data_next (data_);
 
             proton::auto_list_enter ale (data_, true);
 
-            return proton::readAndNext<std::string>(data_);
+            return std::string (proton::readAndNext<std::string_view>(data_));
 
             /*
              * After a string representation of the enumerated value
@@ -12,6 +12,8 @@ namespace amqp::internal::reader {
         public :
             EnumReader (std::string, std::vector<std::string>);
 
+            internal::schema::Restricted::RestrictedTypes restrictedType() const override;
+
             std::unique_ptr<amqp::reader::IValue> dump(
                 const std::string &,
                 pn_data_t *,
@@ -2,6 +2,8 @@
 
 #include "proton/proton_wrapper.h"
 
+#include "amqp/Limits.h"
+
 /******************************************************************************
  *
  * class ListReader
@@ -53,17 +55,21 @@ ListReader::dump_(
         const SchemaType & schema_
 ) const {
     proton::is_described (data_);
+    unreferenced (data_);
+    Budget::Level level;
 
     decltype (dump_(data_, schema_)) read;
 
     {
         proton::auto_enter ae (data_);
-        schema_.fromDescriptor (proton::readAndNext<std::string>(data_));
+        schema_.fromDescriptor (proton::readAndNext<std::string_view>(data_));
 
         {
             proton::auto_list_enter ale (data_, true);
+            Budget::elements (ale.elements());
 
             for (size_t i { 0 } ; i < ale.elements() ; ++i) {
+                Budget::output (8);
                 read.emplace_back (m_reader.lock()->dump (data_, schema_));
             }
         }
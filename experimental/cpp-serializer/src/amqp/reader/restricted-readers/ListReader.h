@@ -27,7 +27,9 @@ namespace amqp::internal::reader {
 
             ~ListReader() final = default;
 
-            internal::schema::Restricted::RestrictedTypes restrictedType() const;
+            internal::schema::Restricted::RestrictedTypes restrictedType() const override;
+
+            const std::weak_ptr<Reader> & reader() const { return m_reader; }
 
             std::unique_ptr<amqp::reader::IValue> dump(
                 const std::string &,
@@ -4,6 +4,8 @@
 #include "amqp/reader/IReader.h"
 #include "proton/proton_wrapper.h"
 
+#include "amqp/Limits.h"
+
 /******************************************************************************/
 
 amqp::internal::schema::Restricted::RestrictedTypes
@@ -21,6 +23,8 @@ MapReader::dump_(
     const SchemaType & schema_
 ) const {
     proton::is_described (data_);
+    unreferenced (data_);
+    Budget::Level level;
     proton::auto_enter ae (data_);
 
     // gloss over fetching the descriptor from the schema since
@@ -28,18 +32,25 @@ MapReader::dump_(
     // and don't need context from the schema as there isn't
     // any. Maps have a Key and a Value, they aren't named
     // parameters, unlike composite types.
-    schema_.fromDescriptor (proton::readAndNext<std::string>(data_));
+    schema_.fromDescriptor (proton::readAndNext<std::string_view>(data_));
 
     {
         proton::auto_map_enter am (data_, true);
+        Budget::elements (am.elements() / 2);
 
         decltype (dump_(data_, schema_)) rtn;
         rtn.reserve (am.elements() / 2);
 
         for (int i {0} ; i < am.elements() ; i += 2) {
+            Budget::output (8);
+
+            // the key has to be consumed before the value, argument
+            // evaluation order isn't something we can rely on
+            auto key = m_keyReader.lock()->dump (data_, schema_);
+
             rtn.emplace_back (
                 std::make_unique<ValuePair> (
-                    m_keyReader.lock()->dump (data_, schema_),
+                    std::move (key),
                     m_valueReader.lock()->dump (data_, schema_)
                 )
             );
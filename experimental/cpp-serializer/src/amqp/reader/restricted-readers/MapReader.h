@@ -30,7 +30,10 @@ namespace amqp::internal::reader {
 
             ~MapReader() final = default;
 
-            internal::schema::Restricted::RestrictedTypes restrictedType() const;
+            internal::schema::Restricted::RestrictedTypes restrictedType() const override;
+
+            const std::weak_ptr<Reader> & keyReader() const { return m_keyReader; }
+            const std::weak_ptr<Reader> & valueReader() const { return m_valueReader; }
 
             std::unique_ptr<amqp::reader::IValue> dump(
                 const std::string &,
@@ -0,0 +1,283 @@
+#include "FlatSchema.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "described-types/Schema.h"
+#include "described-types/Composite.h"
+#include "restricted-types/Restricted.h"
+#include "restricted-types/Map.h"
+#include "restricted-types/List.h"
+#include "restricted-types/Enum.h"
+#include "restricted-types/Array.h"
+
+/******************************************************************************/
+
+namespace {
+
+    using amqp::internal::schema::FlatSchema;
+
+    /**
+     * Hands out IDs as the schema is flattened, only needed until it has
+     * been
+     */
+    class Interner {
+        private :
+            std::unordered_map<std::string, FlatSchema::id_t> m_ids;
+
+            std::string & m_strings;
+            std::vector<FlatSchema::Range> & m_offsets;
+
+        public :
+            Interner (std::string & strings_, std::vector<FlatSchema::Range> & offsets_)
+                : m_strings (strings_)
+                , m_offsets (offsets_)
+            {
+                (*this)("");
+            }
+
+            FlatSchema::id_t operator () (const std::string & s_) {
+                auto it = m_ids.find (s_);
+
+                if (it != m_ids.end()) {
+                    return it->second;
+                }
+
+                auto id = static_cast<FlatSchema::id_t> (m_offsets.size());
+
+                m_offsets.push_back ({
+                    static_cast<uint32_t> (m_strings.size()),
+                    static_cast<uint32_t> (m_strings.size() + s_.size()) });
+
+                m_strings += s_;
+                m_ids.emplace (s_, id);
+
+                return id;
+            }
+    };
+
+    FlatSchema::field_t
+    fieldKind (const std::string & fieldType_) {
+        if (fieldType_ == "primitive") {
+            return FlatSchema::primitive_f;
+        } else if (fieldType_ == "composite") {
+            return FlatSchema::composite_f;
+        } else if (fieldType_ == "restricted") {
+            return FlatSchema::restricted_f;
+        } else if (fieldType_ == "array") {
+            return FlatSchema::array_f;
+        }
+
+        throw std::runtime_error ("Unknown field type " + fieldType_);
+    }
+
+    FlatSchema::kind_t
+    restrictedKind (amqp::internal::schema::Restricted::RestrictedTypes type_) {
+        using amqp::internal::schema::Restricted;
+
+        switch (type_) {
+            case Restricted::list_t  : return FlatSchema::list_k;
+            case Restricted::map_t   : return FlatSchema::map_k;
+            case Restricted::enum_t  : return FlatSchema::enum_k;
+            case Restricted::array_t : return FlatSchema::array_k;
+        }
+
+        throw std::runtime_error ("Unknown restricted type");
+    }
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::schema::FlatSchema
+ *
+ ******************************************************************************/
+
+amqp::internal::schema::
+FlatSchema::FlatSchema (const Schema & schema_) {
+    Interner intern (m_strings, m_offsets);
+
+    auto range = [this, &intern](auto begin_, auto end_) {
+        Range rtn { static_cast<uint32_t> (m_ids.size()), 0 };
+
+        for (auto i = begin_ ; i != end_ ; ++i) {
+            m_ids.push_back (intern (*i));
+        }
+
+        rtn.end = static_cast<uint32_t> (m_ids.size());
+
+        return rtn;
+    };
+
+    for (const auto & level : schema_) {
+        for (const auto & t : level) {
+            Type type { };
+
+            type.name = intern (t->name());
+            type.descriptor = intern (t->descriptor());
+
+            if (t->type() == AMQPTypeNotation::composite_t) {
+                const auto & c = dynamic_cast<const Composite &> (*t);
+
+                type.kind = composite_k;
+                type.label = intern (c.label());
+                type.provides = range (c.provides().begin(), c.provides().end());
+                type.fields.begin = static_cast<uint32_t> (m_fields.size());
+
+                for (const auto & f : c.fields()) {
+                    Field field { };
+
+                    field.name = intern (f->name());
+                    field.type = intern (f->type());
+                    field.resolved = intern (f->resolvedType());
+                    field.defaultValue = intern (f->defaultValue());
+                    field.label = intern (f->label());
+                    field.kind = fieldKind (f->fieldType());
+                    field.mandatory = f->mandatory();
+                    field.multiple = f->multiple();
+                    field.requires = range (f->requires().begin(), f->requires().end());
+
+                    m_fields.push_back (field);
+                }
+
+                type.fields.end = static_cast<uint32_t> (m_fields.size());
+            } else {
+                const auto & r = dynamic_cast<const Restricted &> (*t);
+
+                type.kind = restrictedKind (r.restrictedType());
+                type.label = intern (r.label());
+                type.provides = range (r.provides().begin(), r.provides().end());
+
+                switch (type.kind) {
+                    case list_k : {
+                        const auto & of = dynamic_cast<const List &> (r).listOf();
+                        type.of = range (&of, &of + 1);
+                        break;
+                    }
+                    case array_k : {
+                        const auto & of = dynamic_cast<const Array &> (r).arrayOf();
+                        type.of = range (&of, &of + 1);
+                        break;
+                    }
+                    case map_k : {
+                        auto of = dynamic_cast<const Map &> (r).mapOf();
+                        const std::string kv[] = { of.first.get(), of.second.get() };
+                        type.of = range (std::begin (kv), std::end (kv));
+                        break;
+                    }
+                    case enum_k : {
+                        auto of = dynamic_cast<const Enum &> (r).makeChoices();
+                        type.of = range (of.begin(), of.end());
+                        break;
+                    }
+                    case composite_k : break;
+                }
+            }
+
+            m_types.push_back (type);
+        }
+    }
+
+    m_byName.resize (m_types.size());
+    m_byDescriptor.resize (m_types.size());
+
+    for (uint32_t i = 0 ; i < m_types.size() ; ++i) {
+        m_byName[i] = m_byDescriptor[i] = i;
+    }
+
+    auto order = [this](id_t Type::* id_) {
+        return [this, id_](uint32_t lhs_, uint32_t rhs_) {
+            return string (m_types[lhs_].*id_) < string (m_types[rhs_].*id_);
+        };
+    };
+
+    std::sort (m_byName.begin(), m_byName.end(), order (&Type::name));
+    std::sort (m_byDescriptor.begin(), m_byDescriptor.end(), order (&Type::descriptor));
+}
+
+/******************************************************************************/
+
+std::string_view
+amqp::internal::schema::
+FlatSchema::string (id_t id_) const {
+    const auto & r = m_offsets.at (id_);
+
+    return std::string_view (m_strings.data() + r.begin, r.size());
+}
+
+/******************************************************************************/
+
+amqp::internal::schema::FlatSchema::Span<amqp::internal::schema::FlatSchema::Field>
+amqp::internal::schema::
+FlatSchema::fields (const Type & type_) const {
+    return Span<Field> (
+        m_fields.data() + type_.fields.begin,
+        m_fields.data() + type_.fields.end);
+}
+
+/******************************************************************************/
+
+amqp::internal::schema::FlatSchema::Span<amqp::internal::schema::FlatSchema::id_t>
+amqp::internal::schema::
+FlatSchema::ids (const Range & range_) const {
+    return Span<id_t> (
+        m_ids.data() + range_.begin,
+        m_ids.data() + range_.end);
+}
+
+/******************************************************************************/
+
+const amqp::internal::schema::FlatSchema::Type *
+amqp::internal::schema::
+FlatSchema::find (
+    const std::vector<uint32_t> & index_,
+    id_t Type::* id_,
+    std::string_view key_
+) const {
+    auto it = std::lower_bound (
+        index_.begin(),
+        index_.end(),
+        key_,
+        [this, id_](uint32_t lhs_, std::string_view rhs_) {
+            return string (m_types[lhs_].*id_) < rhs_;
+        });
+
+    if (it == index_.end() || string (m_types[*it].*id_) != key_) {
+        return nullptr;
+    }
+
+    return &m_types[*it];
+}
+
+/******************************************************************************/
+
+const amqp::internal::schema::FlatSchema::Type *
+amqp::internal::schema::
+FlatSchema::byName (std::string_view name_) const {
+    return find (m_byName, &Type::name, name_);
+}
+
+/******************************************************************************/
+
+const amqp::internal::schema::FlatSchema::Type *
+amqp::internal::schema::
+FlatSchema::byDescriptor (std::string_view descriptor_) const {
+    return find (m_byDescriptor, &Type::descriptor, descriptor_);
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::schema::
+FlatSchema::bytes() const {
+    return sizeof (*this)
+        + m_types.capacity() * sizeof (Type)
+        + m_fields.capacity() * sizeof (Field)
+        + m_ids.capacity() * sizeof (id_t)
+        + m_strings.capacity()
+        + m_offsets.capacity() * sizeof (Range)
+        + (m_byName.capacity() + m_byDescriptor.capacity()) * sizeof (uint32_t);
+}
+
+/******************************************************************************/
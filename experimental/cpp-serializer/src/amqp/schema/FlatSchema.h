@@ -0,0 +1,165 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+/******************************************************************************/
+
+namespace amqp::internal::schema {
+
+    class Schema;
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::schema::FlatSchema
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::schema {
+
+    /**
+     * A [Schema] frozen into a handful of contiguous arrays. Where the
+     * parsed schema is a list of lists of polymorphic types, each owning
+     * its fields, each of which owns a list of strings, here every type is
+     * a fixed size record, every field of every composite sits in a single
+     * array, and any list of names is a range of a shared array of string
+     * IDs. Each distinct string, and Corda's class names and descriptors
+     * are long and much repeated, is held once and referred to by ID.
+     *
+     * Built once from the parsed descriptors, it's what readers are made
+     * from, and is small and cheap enough to walk that thousands can be
+     * held at once.
+     */
+    class FlatSchema {
+        public :
+            /**
+             * An interned string, the same text always has the same ID
+             * and an absent (null) string is the empty one, ID 0
+             */
+            using id_t = uint32_t;
+
+            struct Range {
+                uint32_t begin;
+                uint32_t end;
+
+                uint32_t size() const { return end - begin; }
+            };
+
+            template<typename T>
+            class Span {
+                private :
+                    const T * m_begin;
+                    const T * m_end;
+
+                public :
+                    Span (const T * begin_, const T * end_)
+                        : m_begin (begin_), m_end (end_)
+                    { }
+
+                    const T * begin() const { return m_begin; }
+                    const T * end() const { return m_end; }
+                    size_t size() const { return m_end - m_begin; }
+                    const T & operator [] (size_t i_) const { return m_begin[i_]; }
+            };
+
+            enum kind_t : uint8_t {
+                composite_k, list_k, map_k, enum_k, array_k
+            };
+
+            enum field_t : uint8_t {
+                primitive_f, composite_f, restricted_f, array_f
+            };
+
+            struct Type {
+                id_t    name;
+                id_t    descriptor;
+                id_t    label;
+                kind_t  kind;
+
+                /**
+                 * A composite's fields, within [fields]
+                 */
+                Range   fields;
+
+                /**
+                 * Within [ids], what a restricted type is of: a list's or
+                 * array's element type, a map's key then value types, or
+                 * an enum's constants
+                 */
+                Range   of;
+
+                Range   provides;
+            };
+
+            struct Field {
+                id_t    name;
+                id_t    type;
+
+                /**
+                 * The type actually read, for a restricted field the
+                 * first type it requires
+                 */
+                id_t    resolved;
+
+                id_t    defaultValue;
+                id_t    label;
+                field_t kind;
+                bool    mandatory;
+                bool    multiple;
+                Range   requires;
+            };
+
+        private :
+            std::vector<Type>  m_types;
+            std::vector<Field> m_fields;
+            std::vector<id_t>  m_ids;
+
+            /**
+             * Every string end to end, and where in that each ID's is
+             */
+            std::string        m_strings;
+            std::vector<Range> m_offsets;
+
+            /**
+             * Indexes of [m_types], ordered by name and by descriptor
+             */
+            std::vector<uint32_t> m_byName;
+            std::vector<uint32_t> m_byDescriptor;
+
+            const Type * find (const std::vector<uint32_t> &, id_t Type::*, std::string_view) const;
+
+        public :
+            explicit FlatSchema (const Schema &);
+
+            std::string_view string (id_t) const;
+
+            /**
+             * In the order they depend on one another, anything a type
+             * refers to preceding it
+             */
+            const std::vector<Type> & types() const { return m_types; }
+
+            Span<Field> fields (const Type &) const;
+            Span<id_t> ids (const Range &) const;
+
+            /**
+             * Null if there's no such type
+             */
+            const Type * byName (std::string_view) const;
+            const Type * byDescriptor (std::string_view) const;
+
+            /**
+             * Roughly how much memory we're occupying
+             */
+            size_t bytes() const;
+    };
+
+}
+
+/******************************************************************************/
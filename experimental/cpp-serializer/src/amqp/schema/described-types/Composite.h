@@ -76,6 +76,9 @@ namespace amqp::internal::schema {
             int dependsOnRHS (const class Restricted &) const override;
             int dependsOnRHS (const Composite &) const override;
 
+            const decltype (m_label) & label() const { return m_label; }
+            const decltype (m_provides) & provides() const { return m_provides; }
+
             decltype(m_fields)::const_iterator begin() const { return m_fields.cbegin();}
             decltype(m_fields)::const_iterator end() const { return m_fields.cend(); }
     };
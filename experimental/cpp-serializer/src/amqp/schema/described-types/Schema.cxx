@@ -8,6 +8,7 @@
 #include "debug.h"
 
 #include <memory>
+#include <stdexcept>
 #include <iostream>
 
 /******************************************************************************
@@ -63,16 +64,29 @@ Schema::types() const {
 
 amqp::internal::schema::SchemaMap::const_iterator
 amqp::internal::schema::
-Schema::fromType (const std::string & type_) const {
-    return m_typeToDescriptor.find(type_);
+Schema::fromType (std::string_view type_) const {
+    auto it = m_typeToDescriptor.find (type_);
+
+    if (it == m_typeToDescriptor.end()) {
+        throw std::runtime_error ("Schema has no type " + std::string (type_));
+    }
+
+    return it;
 }
 
 /******************************************************************************/
 
 amqp::internal::schema::SchemaMap::const_iterator
 amqp::internal::schema::
-Schema::fromDescriptor (const std::string & descriptor_) const {
-    return m_descriptorToType.find (descriptor_);
+Schema::fromDescriptor (std::string_view descriptor_) const {
+    auto it = m_descriptorToType.find (descriptor_);
+
+    if (it == m_descriptorToType.end()) {
+        throw std::runtime_error (
+                "Schema has no type with descriptor " + std::string (descriptor_));
+    }
+
+    return it;
 }
 
 /******************************************************************************/
@@ -18,9 +18,13 @@
 
 namespace amqp::internal::schema {
 
+    /**
+     * Transparently compared so it can be searched with a string_view
+     */
     using SchemaMap = std::map<
             std::string,
-            const std::reference_wrapper<const uPtr <AMQPTypeNotation>>>;
+            const std::reference_wrapper<const uPtr <AMQPTypeNotation>>,
+            std::less<>>;
 
     using ISchemaType = amqp::schema::ISchema<SchemaMap::const_iterator>;
 
@@ -48,8 +52,12 @@ namespace amqp::internal::schema {
 
             const OrderedTypeNotations<AMQPTypeNotation> & types() const;
 
-            SchemaMap::const_iterator fromType (const std::string &) const override;
-            SchemaMap::const_iterator fromDescriptor (const std::string &) const override ;
+            /**
+             * Both throw rather than hand back an iterator to nothing
+             * when asked about a type the schema doesn't contain
+             */
+            SchemaMap::const_iterator fromType (std::string_view) const override;
+            SchemaMap::const_iterator fromDescriptor (std::string_view) const override ;
 
             decltype (m_types.begin()) begin() const { return m_types.begin(); }
             decltype (m_types.end()) end() const { return m_types.end(); }
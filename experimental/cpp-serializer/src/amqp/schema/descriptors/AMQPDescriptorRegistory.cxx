@@ -1,6 +1,7 @@
 #include "AMQPDescriptorRegistory.h"
 #include "AMQPDescriptors.h"
 
+#include "amqp/DecodeError.h"
 #include "amqp/schema/Descriptors.h"
 
 #include "corda-descriptors/FieldDescriptor.h"
@@ -98,6 +99,19 @@ namespace amqp::internal {
 
 /******************************************************************************/
 
+const amqp::internal::schema::descriptors::AMQPDescriptor &
+amqp::internal::findDescriptor (uint64_t id_) {
+    auto descriptor = AMQPDescriptorRegistory.find (id_);
+
+    if (descriptor == AMQPDescriptorRegistory.end()) {
+        throw DecodeError ("Unknown descriptor " + std::to_string (id_));
+    }
+
+    return *descriptor->second;
+}
+
+/******************************************************************************/
+
 uint32_t
 amqp::stripCorda (uint64_t id) {
     return static_cast<uint32_t>(id & (uint64_t)UINT_MAX);
@@ -21,6 +21,13 @@ namespace amqp::internal {
 
     extern std::map<uint64_t, std::shared_ptr<internal::schema::descriptors::AMQPDescriptor>> AMQPDescriptorRegistory;
 
+    /**
+     * Looked up rather than indexed so an unknown descriptor can't add
+     * itself to a registry other threads are reading, throwing a
+     * [DecodeError] instead
+     */
+    const internal::schema::descriptors::AMQPDescriptor & findDescriptor (uint64_t);
+
 }
 
 /******************************************************************************
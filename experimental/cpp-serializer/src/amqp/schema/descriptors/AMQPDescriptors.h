@@ -9,6 +9,8 @@
 #include <iostream>
 
 #include "types.h"
+#include "amqp/Limits.h"
+#include "amqp/DecodeError.h"
 #include "amqp/AMQPDescribed.h"
 #include "AMQPDescriptor.h"
 #include "amqp/schema/described-types/Descriptor.h"
@@ -32,6 +34,8 @@ namespace amqp::internal::schema::descriptors {
     template<class T>
     uPtr <T>
     dispatchDescribed(pn_data_t *data_) {
+        Budget::Level level;
+
         proton::is_described(data_);
         proton::auto_enter p(data_);
         proton::is_ulong(data_);
@@ -40,7 +44,7 @@ namespace amqp::internal::schema::descriptors {
 
         return uPtr<T>(
             static_cast<T *>(
-                AMQPDescriptorRegistory[id]->build(data_).release()));
+                findDescriptor (id).build(data_).release()));
     }
 }
 
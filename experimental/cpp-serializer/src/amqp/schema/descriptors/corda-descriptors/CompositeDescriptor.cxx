@@ -128,7 +128,7 @@ CompositeDescriptor::read (
 
         ss_ << ai << "4] Descriptor:" << std::endl;
 
-        AMQPDescriptorRegistory[pn_data_type(data_)]->read (
+        findDescriptor (pn_data_type(data_)).read (
             (pn_data_t *)proton::auto_next(data_), ss_, AutoIndent { ai });
 
         ss_ << ai << "5] List: Fields: " << std::endl;
@@ -141,7 +141,7 @@ CompositeDescriptor::read (
                     << ale.elements() << "]"
                     << std::endl;
 
-                AMQPDescriptorRegistory[pn_data_type(data_)]->read (
+                findDescriptor (pn_data_type(data_)).read (
                         data_, ss_, AutoIndent { ai2 });
             }
         }
@@ -40,10 +40,14 @@ SchemaDescriptor::build (pn_data_t * data_) const {
     {
         proton::auto_list_enter ale (data_);
 
+        size_t types { 0 };
+
         for (int i { 1 } ; pn_data_next(data_) ; ++i) {
             DBG ("  " << i << "/" << ale.elements() << std::endl); // NOLINT
             proton::auto_list_enter ale2 (data_);
             while (pn_data_next(data_)) {
+                Budget::types (++types);
+
                 schemas.insert (
                     descriptors::dispatchDescribed<schema::AMQPTypeNotation> (
                         data_));
@@ -85,7 +89,7 @@ SchemaDescriptor::read (
                 ss_ << ai2 << i << ":" << j << "/" << ale2.elements()
                         << "] " << std::endl;
 
-                AMQPDescriptorRegistory[pn_data_type(data_)]->read (
+                findDescriptor (pn_data_type(data_)).read (
                         data_, ss_,
                         AutoIndent { ai2 });
             }
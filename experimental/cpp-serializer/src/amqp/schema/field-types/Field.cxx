@@ -151,3 +151,34 @@ Field::requires() const {
 
 /******************************************************************************/
 
+const std::string &
+amqp::internal::schema::
+Field::defaultValue() const {
+    return m_default;
+}
+
+/******************************************************************************/
+
+const std::string &
+amqp::internal::schema::
+Field::label() const {
+    return m_label;
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::schema::
+Field::mandatory() const {
+    return m_mandatory;
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::schema::
+Field::multiple() const {
+    return m_multiple;
+}
+
+/******************************************************************************/
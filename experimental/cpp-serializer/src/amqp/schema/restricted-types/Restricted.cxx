@@ -256,6 +256,8 @@ Restricted::dependsOnRHS (const Restricted & lhs_) const  {
             return dependsOnArray (
                     static_cast<const amqp::internal::schema::Array &>(lhs_)); // NOLINT
     }
+
+    throw std::runtime_error ("Unknown restricted type");
 }
 
 /*********************************************************o*********************/
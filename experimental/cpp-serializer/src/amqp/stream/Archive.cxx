@@ -0,0 +1,363 @@
+#include "Archive.h"
+
+#include <ostream>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Tokeniser.h"
+#include "Decompressor.h"
+#include "SchemaScanner.h"
+#include "StreamDecoder.h"
+#include "EnvelopeScanner.h"
+
+#include "amqp/AMQPHeader.h"
+#include "amqp/AMQPSectionId.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ArchiveWriter
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+ArchiveWriter::ArchiveWriter (std::ostream & out_)
+    : m_out (out_)
+    , m_position (0)
+{
+    write (archive::MAGIC, sizeof (archive::MAGIC));
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::archive::Bytes
+amqp::internal::stream::
+ArchiveWriter::write (const char * data_, size_t size_) {
+    archive::Bytes rtn { m_position, size_ };
+
+    m_out.write (data_, size_);
+    m_position += size_;
+
+    if (!m_out) {
+        throw std::runtime_error ("Failed to write the archive");
+    }
+
+    return rtn;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+ArchiveWriter::add (const char * blob_, size_t size_) {
+    auto headerSize = amqp::AMQP_HEADER.size();
+
+    if (size_ <= headerSize
+        || std::memcmp (blob_, amqp::AMQP_HEADER.data(), headerSize) != 0)
+    {
+        throw std::runtime_error ("Not a Corda stream");
+    }
+
+    char section = blob_[headerSize];
+
+    blob_ += headerSize + 1;
+    size_ -= headerSize + 1;
+
+    if (section == amqp::ENCODING) {
+        if (!size_) {
+            throw std::runtime_error ("Missing encoding");
+        }
+
+        m_inflated = Decompressor::inflate (blob_ + 1, size_ - 1, *blob_);
+
+        if (m_inflated.empty()) {
+            throw std::runtime_error ("Empty compressed blob");
+        }
+
+        section = m_inflated.front();
+        blob_ = m_inflated.data() + 1;
+        size_ = m_inflated.size() - 1;
+    }
+
+    if (section != amqp::DATA_AND_STOP && section != amqp::ALT_DATA_AND_STOP) {
+        throw std::runtime_error ("Unsupported encoding");
+    }
+
+    EnvelopeScanner scanner;
+
+    {
+        Tokeniser tokeniser (scanner);
+
+        if (tokeniser.feed (blob_, size_) != size_) {
+            throw std::runtime_error ("Data after the end of the blob");
+        }
+    }
+
+    if (!scanner.complete()) {
+        throw std::runtime_error ("Truncated envelope");
+    }
+
+    auto it = m_ids.find (scanner.descriptor());
+
+    if (it == m_ids.end()) {
+        archive::Schema schema { };
+
+        schema.descriptor = write (scanner.descriptor().data(), scanner.descriptor().size());
+        schema.schema = write (blob_ + scanner.schema().begin, scanner.schema().size());
+
+        m_schemas.push_back (schema);
+
+        it = m_ids.emplace (scanner.descriptor(), m_schemas.size() - 1).first;
+    }
+
+    m_records.push_back ({
+        it->second,
+        write (blob_ + scanner.data().begin, scanner.data().size()) });
+
+    return m_records.size() - 1;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ArchiveWriter::close() {
+    const char padding[8] { };
+    write (padding, (8 - m_position % 8) % 8);
+
+    archive::Trailer trailer { };
+
+    trailer.schemas = m_schemas.size();
+    trailer.schemasAt = write (
+            reinterpret_cast<const char *>(m_schemas.data()),
+            m_schemas.size() * sizeof (archive::Schema)).offset;
+
+    trailer.records = m_records.size();
+    trailer.recordsAt = write (
+            reinterpret_cast<const char *>(m_records.data()),
+            m_records.size() * sizeof (archive::Record)).offset;
+
+    trailer.version = archive::VERSION;
+    trailer.orderMark = archive::ORDER_MARK;
+    std::memcpy (trailer.magic, archive::MAGIC, sizeof (trailer.magic));
+
+    write (reinterpret_cast<const char *>(&trailer), sizeof (trailer));
+
+    m_out.flush();
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Archive
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+Archive::Archive (const std::string & file_)
+    : m_base (nullptr)
+    , m_size (0)
+    , m_trailer (nullptr)
+    , m_schemas (nullptr)
+    , m_records (nullptr)
+{
+    int fd = open (file_.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        throw std::runtime_error ("Can't open " + file_);
+    }
+
+    struct stat results { };
+
+    if (fstat (fd, &results) != 0
+        || static_cast<size_t>(results.st_size)
+                < sizeof (archive::MAGIC) + sizeof (archive::Trailer))
+    {
+        close (fd);
+        throw std::runtime_error ("Not an archive: " + file_);
+    }
+
+    m_size = results.st_size;
+
+    auto base = mmap (nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close (fd);
+
+    if (base == MAP_FAILED) {
+        throw std::runtime_error ("Can't map " + file_);
+    }
+
+    m_base = static_cast<const char *>(base);
+
+    try {
+        auto at = m_size - sizeof (archive::Trailer);
+
+        if (at % alignof (archive::Trailer)) {
+            throw std::runtime_error ("Not an archive: " + file_);
+        }
+
+        m_trailer = reinterpret_cast<const archive::Trailer *>(m_base + at);
+
+        if (std::memcmp (m_base, archive::MAGIC, sizeof (archive::MAGIC)) != 0
+            || std::memcmp (m_trailer->magic, archive::MAGIC, sizeof (archive::MAGIC)) != 0)
+        {
+            throw std::runtime_error ("Not an archive: " + file_);
+        }
+
+        if (m_trailer->version != archive::VERSION
+            || m_trailer->orderMark != archive::ORDER_MARK)
+        {
+            throw std::runtime_error ("Unsupported archive: " + file_);
+        }
+
+        auto table = [&](uint64_t at_, uint64_t count_, size_t size_) {
+            if (at_ % 8 || at_ > at || count_ > (at - at_) / size_) {
+                throw std::runtime_error ("Truncated archive: " + file_);
+            }
+
+            return m_base + at_;
+        };
+
+        m_schemas = reinterpret_cast<const archive::Schema *>(table (
+                m_trailer->schemasAt, m_trailer->schemas, sizeof (archive::Schema)));
+
+        m_records = reinterpret_cast<const archive::Record *>(table (
+                m_trailer->recordsAt, m_trailer->records, sizeof (archive::Record)));
+    } catch (...) {
+        munmap (const_cast<char *>(m_base), m_size);
+        throw;
+    }
+
+    m_cache.resize (m_trailer->schemas);
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::
+Archive::~Archive() {
+    munmap (const_cast<char *>(m_base), m_size);
+}
+
+/******************************************************************************/
+
+std::string_view
+amqp::internal::stream::
+Archive::view (const archive::Bytes & bytes_) const {
+    if (bytes_.offset > m_size || bytes_.size > m_size - bytes_.offset) {
+        throw std::runtime_error ("Corrupt archive");
+    }
+
+    return { m_base + bytes_.offset, bytes_.size };
+}
+
+/******************************************************************************/
+
+const amqp::internal::stream::archive::Record &
+amqp::internal::stream::
+Archive::record (size_t record_) const {
+    if (record_ >= m_trailer->records) {
+        throw std::out_of_range ("No record " + std::to_string (record_));
+    }
+
+    const auto & rtn = m_records[record_];
+
+    if (rtn.schema >= m_trailer->schemas) {
+        throw std::runtime_error ("Corrupt archive");
+    }
+
+    return rtn;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+Archive::records() const {
+    return m_trailer->records;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+Archive::schemas() const {
+    return m_trailer->schemas;
+}
+
+/******************************************************************************/
+
+std::string_view
+amqp::internal::stream::
+Archive::descriptor (size_t record_) const {
+    return view (m_schemas[record (record_).schema].descriptor);
+}
+
+/******************************************************************************/
+
+std::string_view
+amqp::internal::stream::
+Archive::data (size_t record_) const {
+    return view (record (record_).data);
+}
+
+/******************************************************************************/
+
+const amqp::internal::stream::Archive::Cached &
+amqp::internal::stream::
+Archive::cached (uint64_t schema_) const {
+    auto & cached = m_cache[schema_];
+
+    if (cached) {
+        return *cached;
+    }
+
+    auto descriptor = std::string (view (m_schemas[schema_].descriptor));
+    auto bytes = view (m_schemas[schema_].schema);
+
+    auto c = std::make_unique<Cached>();
+
+    c->schema = SchemaScanner::load (bytes.data(), bytes.size());
+
+    c->factory = std::make_unique<CompositeFactory>();
+    c->factory->process (*c->schema);
+
+    c->reader = std::dynamic_pointer_cast<reader::Reader> (
+            c->factory->byDescriptor (descriptor));
+
+    if (!c->reader) {
+        throw std::runtime_error ("No reader for " + descriptor);
+    }
+
+    cached = std::move (c);
+
+    return *cached;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+Archive::visit (
+    size_t record_,
+    amqp::reader::IVisitor & visitor_,
+    ObjectTable::refs_t refs_
+) const {
+    const auto & r = record (record_);
+    const auto & c = cached (r.schema);
+
+    auto bytes = view (r.data);
+
+    StreamDecoder decoder (*c.reader, *c.schema, visitor_, refs_);
+    Tokeniser tokeniser (decoder);
+
+    tokeniser.feed (bytes.data(), bytes.size());
+
+    if (!decoder.done()) {
+        throw std::runtime_error ("Truncated record " + std::to_string (record_));
+    }
+}
+
+/******************************************************************************/
@@ -0,0 +1,200 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <iosfwd>
+#include <cstdint>
+#include <string_view>
+
+#include "types.h"
+#include "ObjectTable.h"
+
+#include "amqp/CompositeFactory.h"
+#include "amqp/reader/IVisitor.h"
+#include "amqp/schema/described-types/Schema.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::archive
+ *
+ ******************************************************************************/
+
+/**
+ * Every Corda blob carries the entire schema of its type, more often than
+ * not larger than the data itself. An archive keeps each distinct schema
+ * once, identified by the descriptor of the top level type it's for, and
+ * each blob as just its data section and the ID of its schema.
+ *
+ *      char[8]         MAGIC
+ *      char[]          schemas and data, in the order they were added
+ *      Schema[schemas]
+ *      Record[records]
+ *      Trailer
+ *
+ * The tables follow everything they refer to so an archive can be written
+ * a blob at a time without knowing how many there'll be. Like a catalog
+ * it's written as the structures are laid out in memory, to be mapped and
+ * used in place, and all offsets are from the start of the file.
+ *
+ * The transforms section of a blob isn't kept, nothing decoding it needs
+ * it.
+ */
+namespace amqp::internal::stream::archive {
+
+    constexpr char MAGIC[8] = { 'C', 'O', 'R', 'D', 'A', 'A', 'R', 'C' };
+    constexpr uint64_t VERSION = 1;
+    constexpr uint64_t ORDER_MARK = 0x0102030405060708ULL;
+
+    struct Bytes {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct Schema {
+        Bytes descriptor;
+
+        /**
+         * the encoded schema section
+         */
+        Bytes schema;
+    };
+
+    struct Record {
+        uint64_t schema;
+
+        /**
+         * the encoded data section
+         */
+        Bytes data;
+    };
+
+    struct Trailer {
+        uint64_t schemas;
+        uint64_t schemasAt;
+        uint64_t records;
+        uint64_t recordsAt;
+        uint64_t version;
+        uint64_t orderMark;
+        char     magic[8];
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ArchiveWriter
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    class ArchiveWriter {
+        private :
+            std::ostream & m_out;
+
+            uint64_t m_position;
+
+            std::map<std::string, uint64_t> m_ids;
+
+            std::vector<archive::Schema> m_schemas;
+            std::vector<archive::Record> m_records;
+
+            std::vector<char> m_inflated;
+
+            archive::Bytes write (const char *, size_t);
+
+        public :
+            explicit ArchiveWriter (std::ostream &);
+
+            /**
+             * Add a blob, header and all, compressed or not. Throws if
+             * it's not a blob, in which case nothing is added.
+             *
+             * @return the record number of the blob
+             */
+            size_t add (const char *, size_t);
+
+            size_t schemas() const { return m_schemas.size(); }
+            size_t records() const { return m_records.size(); }
+
+            /**
+             * Write the tables, nothing can be added after this
+             */
+            void close();
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Archive
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * An archive, mapped into memory. Finding a record is a lookup in the
+     * record table. Each schema is loaded, and its readers built, the
+     * first time a record of it is decoded, after which every record of
+     * that type goes straight to its readers.
+     *
+     * Decoding from several threads at once isn't safe.
+     */
+    class Archive {
+        private :
+            struct Cached {
+                uPtr<schema::Schema>            schema;
+                uPtr<CompositeFactory>          factory;
+                std::shared_ptr<reader::Reader> reader;
+            };
+
+            const char * m_base;
+            size_t m_size;
+
+            const archive::Trailer * m_trailer;
+            const archive::Schema * m_schemas;
+            const archive::Record * m_records;
+
+            mutable std::vector<uPtr<Cached>> m_cache;
+
+            std::string_view view (const archive::Bytes &) const;
+            const archive::Record & record (size_t) const;
+            const Cached & cached (uint64_t) const;
+
+        public :
+            /**
+             * Throws if the file isn't an archive we can read
+             */
+            explicit Archive (const std::string &);
+            ~Archive();
+
+            Archive (const Archive &) = delete;
+            Archive & operator = (const Archive &) = delete;
+
+            size_t records() const;
+            size_t schemas() const;
+
+            std::string_view descriptor (size_t record_) const;
+
+            /**
+             * The encoded data section of a record
+             */
+            std::string_view data (size_t record_) const;
+
+            /**
+             * Tell the visitor about the values of a record
+             */
+            void visit (
+                size_t record_,
+                amqp::reader::IVisitor &,
+                ObjectTable::refs_t = ObjectTable::expand_r) const;
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,428 @@
+#include "BlobDecoder.h"
+
+#include <limits>
+#include <string_view>
+#include <algorithm>
+#include <stdexcept>
+
+#include "proton/codec.h"
+
+#include "SchemaScanner.h"
+
+#include "amqp/DecodeError.h"
+#include "amqp/AMQPHeader.h"
+#include "amqp/AMQPSectionId.h"
+#include "amqp/schema/descriptors/AMQPDescriptors.h"
+
+/******************************************************************************/
+
+namespace {
+
+    const size_t npos = std::numeric_limits<size_t>::max();
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::BlobDecoder
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+BlobDecoder::BlobDecoder (
+    amqp::reader::IVisitor & visitor_,
+    ObjectTable::refs_t refs_,
+    const Limits & limits_
+) : m_visitor (visitor_)
+  , m_refs (refs_)
+  , m_budget (limits_)
+  , m_inflated (64 * 1024)
+  , m_tokeniser (std::make_unique<Tokeniser> (static_cast<ITokenHandler &>(*this)))
+  , m_decoder (nullptr)
+  , m_position (0)
+  , m_highWater (0)
+{
+    reset();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobDecoder::reset() {
+    /*
+     * Everything holding onto something the size of the last blob is
+     * remade, or with the decoders left to be, rather than reset
+     */
+    if (m_highWater && m_position > m_highWater) {
+        m_tokeniser = std::make_unique<Tokeniser> (static_cast<ITokenHandler &>(*this));
+
+        for (auto & cached : m_cache) {
+            cached.second.decoder.reset();
+        }
+
+        std::string().swap (m_data);
+        std::string().swap (m_schema);
+    }
+
+    EnvelopeScanner::reset();
+
+    m_tokeniser->reset();
+    m_decoder = nullptr;
+    m_decompressor.reset();
+
+    m_state = header_s;
+
+    m_header.clear();
+    m_position = 0;
+    m_data.clear();
+    m_retainData = false;
+    m_schema.clear();
+    m_retainSchema = false;
+    m_opening = { };
+    m_complete = false;
+
+    m_budget.reset();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobDecoder::highWater (size_t bytes_) {
+    m_highWater = bytes_;
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+BlobDecoder::done() const {
+    return m_complete;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+BlobDecoder::feed (const char * data_, size_t size_) {
+    Budget::Scope scope (m_budget);
+
+    /*
+     * Whatever went wrong, if it didn't say where then it was wherever
+     * the tokeniser had got to. Before the envelope there's nowhere to
+     * point at.
+     */
+    try {
+        return consume (data_, size_);
+    } catch (DecodeError & e) {
+        if (m_state == envelope_s) {
+            e.at (m_tokeniser->offset());
+        }
+        throw;
+    } catch (const std::exception & e) {
+        throw DecodeError (
+            e.what(),
+            m_state == envelope_s ? m_tokeniser->offset() : DecodeError::npos);
+    }
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+BlobDecoder::consume (const char * data_, size_t size_) {
+    size_t used { 0 };
+
+    if (!m_decompressor) {
+        used = plain (data_, size_);
+
+        if (!m_decompressor || used == size_) {
+            return used;
+        }
+    }
+
+    m_decompressor->input (data_ + used, size_ - used);
+
+    for (size_t n ; (n = m_decompressor->output (
+            m_inflated.data(), m_inflated.size())) ; )
+    {
+        /*
+         * Unlike raw input, where the blob might just be followed by
+         * something else, there's no reason for anything to have been
+         * compressed along with it
+         */
+        if (plain (m_inflated.data(), n) != n) {
+            throw std::runtime_error ("Compressed data after the end of the blob");
+        }
+    }
+
+    return size_;
+}
+
+/******************************************************************************/
+
+/**
+ * Deal with uncompressed bytes, either those we've been handed directly
+ * or the output of a decompressor
+ */
+size_t
+amqp::internal::stream::
+BlobDecoder::plain (const char * data_, size_t size_) {
+    size_t used { 0 };
+
+    /*
+     * Up until the envelope starts things are only ever a byte long so
+     * don't bother doing anything more complicated than looking at
+     * them one at a time
+     */
+    while (used < size_ && m_state != envelope_s) {
+        auto c = data_[used++];
+
+        switch (m_state) {
+            case header_s :
+                m_header.push_back (c);
+
+                if (m_header.size() == amqp::AMQP_HEADER.size()) {
+                    if (!std::equal (
+                            amqp::AMQP_HEADER.begin(),
+                            amqp::AMQP_HEADER.end(),
+                            m_header.begin()))
+                    {
+                        throw std::runtime_error ("Not a Corda stream");
+                    }
+                    m_state = section_s;
+                }
+                break;
+            case section_s :
+                section (c);
+                break;
+            case encoding_s :
+                m_decompressor = Decompressor::make (c);
+                m_state = section_s;
+
+                // what follows is compressed
+                return used;
+            case envelope_s :
+                break;
+        }
+    }
+
+    while (used < size_ && !m_complete) {
+        auto n = m_tokeniser->feed (data_ + used, size_ - used);
+
+        retain (data_ + used, n);
+
+        m_position += n;
+        used += n;
+
+        if (m_retainSchema && sections() > schema_s) {
+            load();
+        }
+    }
+
+    if (m_complete && !(m_decoder && m_decoder->done())) {
+        throw std::runtime_error ("Blob ended before its data was decoded");
+    }
+
+    return used;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobDecoder::section (char section_) {
+    switch (section_) {
+        case amqp::DATA_AND_STOP :
+        case amqp::ALT_DATA_AND_STOP :
+            m_state = envelope_s;
+            break;
+        case amqp::ENCODING :
+            if (m_decompressor) {
+                throw std::runtime_error ("Blob is compressed twice");
+            }
+            m_state = encoding_s;
+            break;
+        default :
+            throw std::runtime_error (
+                "Unknown section " + std::to_string (section_));
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * Hold onto whichever parts of what we've just been handed belong to the
+ * sections we've not been able to decode yet
+ */
+void
+amqp::internal::stream::
+BlobDecoder::retain (const char * data_, size_t size_) {
+    auto slice = [&](size_t begin_, size_t end_) {
+        auto lo = std::max (begin_, m_position);
+        auto hi = std::min (end_, m_position + size_);
+
+        return lo < hi
+            ? std::string_view (data_ + (lo - m_position), hi - lo)
+            : std::string_view();
+    };
+
+    if (m_retainData) {
+        m_data += slice (
+                EnvelopeScanner::data().begin,
+                sections() > data_s ? EnvelopeScanner::data().end : npos);
+    }
+
+    if (m_retainSchema) {
+        m_schema += slice (
+                schema().begin,
+                sections() > schema_s ? schema().end : npos);
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * With the schema in hand we can finally make sense of the data
+ */
+void
+amqp::internal::stream::
+BlobDecoder::load() {
+    auto & c = cache (
+            descriptor(), m_schema.data(), m_schema.size(), schema().begin);
+
+    m_decoder = &decoder (c);
+
+    Tokeniser replay (*m_decoder, EnvelopeScanner::data().begin);
+    replay.feed (m_data.data(), m_data.size());
+
+    m_data.clear();
+    m_retainData = false;
+    m_schema.clear();
+    m_retainSchema = false;
+}
+
+/******************************************************************************/
+
+/**
+ * Load a schema and build the readers for its top level type
+ */
+amqp::internal::stream::BlobDecoder::Cached &
+amqp::internal::stream::
+BlobDecoder::cache (
+    const std::string & descriptor_,
+    const char * schema_,
+    size_t size_,
+    size_t offset_
+) {
+    Cached cached;
+
+    cached.schema = SchemaScanner::load (schema_, size_, offset_);
+
+    cached.factory = std::make_unique<CompositeFactory>();
+    cached.factory->process (*cached.schema);
+
+    cached.reader = std::dynamic_pointer_cast<reader::Reader> (
+            cached.factory->byDescriptor (descriptor_));
+
+    if (!cached.reader) {
+        throw std::runtime_error ("No reader for " + descriptor_);
+    }
+
+    return m_cache[descriptor_] = std::move (cached);
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::StreamDecoder &
+amqp::internal::stream::
+BlobDecoder::decoder (Cached & cached_) {
+    if (cached_.decoder) {
+        cached_.decoder->reset (*cached_.reader);
+    } else {
+        cached_.decoder = std::make_unique<StreamDecoder> (
+                *cached_.reader, *cached_.schema, m_visitor, m_refs);
+    }
+
+    return *cached_.decoder;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobDecoder::prime (
+    const std::string & descriptor_,
+    const char * schema_,
+    size_t size_
+) {
+    if (m_cache.find (descriptor_) == m_cache.end()) {
+        Budget budget (m_budget.limits());
+        Budget::Scope scope (budget);
+
+        cache (descriptor_, schema_, size_);
+    }
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::ITokenHandler::Action
+amqp::internal::stream::
+BlobDecoder::token (const Token & token_) {
+    auto action = EnvelopeScanner::token (token_);
+
+    if (token_.end) {
+        if (depth() == 0) {
+            m_complete = true;
+        } else if (depth() == 2 && m_retainSchema && sections() > schema_s) {
+            /*
+             * Come up for air so the schema can be loaded before we
+             * carry on
+             */
+            return stop_a;
+        }
+    } else if (depth() == 3 && sections() == schema_s
+               && token_.type == PN_DESCRIBED)
+    {
+        m_retainSchema = !m_decoder;
+    }
+
+    return action;
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::ITokenHandler::Action
+amqp::internal::stream::
+BlobDecoder::data (const Token & token_) {
+    if (depth() == 2 && !token_.end) {
+        m_opening = token_;
+        m_retainData = true;
+
+        return next_a;
+    }
+
+    if (!m_decoder && depth() == 3 && token_.type == PN_SYMBOL) {
+        auto it = m_cache.find (descriptor());
+
+        if (it != m_cache.end()) {
+            m_decoder = &decoder (it->second);
+
+            m_decoder->token (m_opening);
+
+            m_data.clear();
+            m_retainData = false;
+        }
+    }
+
+    if (m_decoder) {
+        m_decoder->token (token_);
+
+        return next_a;
+    }
+
+    return EnvelopeScanner::data (token_);
+}
+
+/******************************************************************************/
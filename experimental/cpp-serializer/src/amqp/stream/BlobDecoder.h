@@ -0,0 +1,183 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "Tokeniser.h"
+#include "Decompressor.h"
+#include "StreamDecoder.h"
+#include "EnvelopeScanner.h"
+
+#include "amqp/Limits.h"
+#include "amqp/DecodeError.h"
+#include "amqp/CompositeFactory.h"
+#include "amqp/reader/IVisitor.h"
+#include "amqp/schema/described-types/Schema.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::BlobDecoder
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Decodes a complete Corda blob, header and all, handed to us in
+     * whatever sized pieces it arrives in, e.g. frames off a socket or
+     * message queue. Nothing requires the blob to ever be contiguous in
+     * memory and decoded values are handed to the visitor as soon as
+     * they're complete.
+     *
+     * Since the data precedes the schema we normally can't make sense of
+     * it until the entire blob has arrived so its undecoded bytes are held
+     * onto, as they arrived, until it can be. However, the descriptor of a
+     * type is a fingerprint of it and everything it references so once
+     * we've seen a schema for a given top level type we keep it and any
+     * subsequent blob of the same type is decoded as it arrives.
+     *
+     * Compressed blobs are inflated as they're fed to us, only as much
+     * of the uncompressed stream as fits in a small buffer ever exists
+     * at once.
+     */
+    class BlobDecoder : private EnvelopeScanner {
+        private :
+            struct Cached {
+                uPtr<schema::Schema>            schema;
+                uPtr<CompositeFactory>          factory;
+                std::shared_ptr<reader::Reader> reader;
+
+                /**
+                 * made by the first blob of the type and reset for each
+                 * after it, so the stacks and tables it needs are only
+                 * allocated once
+                 */
+                uPtr<StreamDecoder>             decoder;
+            };
+
+            /**
+             * Where we are in the bytes preceding the envelope
+             */
+            enum state_t { header_s, section_s, encoding_s, envelope_s };
+
+            amqp::reader::IVisitor & m_visitor;
+
+            ObjectTable::refs_t m_refs;
+
+            /**
+             * What the blob being decoded has used of our limits
+             */
+            Budget m_budget;
+
+            state_t m_state;
+
+            /**
+             * Set once we've seen an ENCODING section, everything
+             * following it is then compressed
+             */
+            uPtr<Decompressor> m_decompressor;
+            std::vector<char> m_inflated;
+
+            std::map<std::string, Cached> m_cache;
+
+            uPtr<Tokeniser> m_tokeniser;
+
+            /**
+             * the decoder of whichever cached type the blob is
+             */
+            StreamDecoder * m_decoder;
+
+            /**
+             * the Corda header preceding everything else
+             */
+            std::string m_header;
+
+            /**
+             * Offset into the envelope of the next byte we're handed
+             */
+            size_t m_position;
+
+            /**
+             * The data section, as much as has arrived
+             */
+            std::string m_data;
+            bool m_retainData;
+
+            std::string m_schema;
+            bool m_retainSchema;
+
+            /**
+             * the data section's opening token, held onto until we
+             * know whether we can decode it immediately
+             */
+            Token m_opening;
+
+            bool m_complete;
+
+            /**
+             * A blob larger than this leaves behind buffers large enough
+             * to hold it, they're given up rather than kept for the next
+             */
+            size_t m_highWater;
+
+            Action token (const Token &) override;
+            Action data (const Token &) override;
+
+            size_t consume (const char *, size_t);
+            size_t plain (const char *, size_t);
+            void section (char);
+            void retain (const char *, size_t);
+            void load();
+
+            Cached & cache (
+                const std::string &,
+                const char *,
+                size_t,
+                size_t offset_ = DecodeError::npos);
+            StreamDecoder & decoder (Cached &);
+
+        public :
+            explicit BlobDecoder (
+                amqp::reader::IVisitor &,
+                ObjectTable::refs_t = ObjectTable::expand_r,
+                const Limits & = Limits());
+
+            /**
+             * Consume as much of the blob as we can, returns how many bytes
+             * were used which will only be fewer than were passed in if
+             * they run past the end of the blob. Anything wrong with it is
+             * thrown as a [DecodeError] saying where.
+             */
+            size_t feed (const char *, size_t);
+
+            /**
+             * True once an entire blob has been decoded
+             */
+            bool done() const;
+
+            /**
+             * Get ready for the next blob. Any schemas we've already seen
+             * are remembered, as is the memory the last blob needed unless
+             * it was larger than the high water mark.
+             */
+            void reset();
+
+            /**
+             * @param bytes_ 0 for buffers that are never given back
+             */
+            void highWater (size_t bytes_);
+
+            /**
+             * Build the readers for a type ahead of seeing any blobs of
+             * it, given its encoded schema section, e.g. from a catalog
+             */
+            void prime (const std::string & descriptor_, const char *, size_t);
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,882 @@
+#include "BlobEncoder.h"
+
+#include <set>
+#include <limits>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "amqp/AMQPHeader.h"
+#include "amqp/AMQPSectionId.h"
+
+#include "amqp/reader/PropertyReader.h"
+#include "amqp/reader/CompositeReader.h"
+#include "amqp/reader/RestrictedReader.h"
+#include "amqp/reader/restricted-readers/MapReader.h"
+#include "amqp/reader/restricted-readers/ListReader.h"
+#include "amqp/reader/restricted-readers/ArrayReader.h"
+#include "amqp/reader/property-readers/IntPropertyReader.h"
+#include "amqp/reader/property-readers/BoolPropertyReader.h"
+#include "amqp/reader/property-readers/LongPropertyReader.h"
+#include "amqp/reader/property-readers/DoublePropertyReader.h"
+#include "amqp/reader/property-readers/StringPropertyReader.h"
+
+#include "amqp/schema/Descriptors.h"
+#include "amqp/schema/described-types/Composite.h"
+#include "amqp/schema/restricted-types/Enum.h"
+#include "amqp/schema/restricted-types/Restricted.h"
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * The AMQP constructors we write, always the smallest able to hold
+     * the value except for lists and maps which are always given four
+     * byte sizes so they can be written before we know how big they are
+     */
+    enum code_t : uint8_t {
+        described_c = 0x00,
+        null_c      = 0x40,
+        true_c      = 0x41,
+        false_c     = 0x42,
+        smalluint_c = 0x52,
+        smallint_c  = 0x54,
+        smalllong_c = 0x55,
+        uint_c      = 0x70,
+        int_c       = 0x71,
+        ulong_c     = 0x80,
+        long_c      = 0x81,
+        double_c    = 0x82,
+        str8_c      = 0xa1,
+        sym8_c      = 0xa3,
+        str32_c     = 0xb1,
+        sym32_c     = 0xb3,
+        map8_c      = 0xc1,
+        list32_c    = 0xd0,
+        map32_c     = 0xd1
+    };
+
+    template<typename T>
+    void
+    putBigEndian (std::string & out_, T value_) {
+        char bytes[sizeof (T)];
+
+        for (size_t i { 0 } ; i < sizeof (T) ; ++i) {
+            bytes[i] = static_cast<char>(
+                    static_cast<uint64_t>(value_) >> (8 * (sizeof (T) - 1 - i)));
+        }
+
+        out_.append (bytes, sizeof (T));
+    }
+
+    void
+    putCode (std::string & out_, code_t code_) {
+        out_.push_back (static_cast<char>(code_));
+    }
+
+    void
+    putBytes (std::string & out_, std::string_view value_, code_t small_, code_t large_) {
+        if (value_.size() <= std::numeric_limits<uint8_t>::max()) {
+            putCode (out_, small_);
+            out_.push_back (static_cast<char>(value_.size()));
+        } else if (value_.size() <= std::numeric_limits<uint32_t>::max()) {
+            putCode (out_, large_);
+            putBigEndian (out_, static_cast<uint32_t>(value_.size()));
+        } else {
+            throw std::runtime_error ("String too long to encode");
+        }
+
+        out_.append (value_.data(), value_.size());
+    }
+
+    void
+    putString (std::string & out_, std::string_view value_) {
+        putBytes (out_, value_, str8_c, str32_c);
+    }
+
+    void
+    putSymbol (std::string & out_, std::string_view value_) {
+        putBytes (out_, value_, sym8_c, sym32_c);
+    }
+
+    /**
+     * The schema represents nullable strings that were null as empty
+     */
+    void
+    putNullable (std::string & out_, const std::string & value_) {
+        if (value_.empty()) {
+            putCode (out_, null_c);
+        } else {
+            putString (out_, value_);
+        }
+    }
+
+    void
+    putBool (std::string & out_, bool value_) {
+        putCode (out_, value_ ? true_c : false_c);
+    }
+
+    void
+    putInt (std::string & out_, int32_t value_) {
+        if (value_ >= std::numeric_limits<int8_t>::min()
+            && value_ <= std::numeric_limits<int8_t>::max())
+        {
+            putCode (out_, smallint_c);
+            out_.push_back (static_cast<char>(value_));
+        } else {
+            putCode (out_, int_c);
+            putBigEndian (out_, value_);
+        }
+    }
+
+    void
+    putLong (std::string & out_, int64_t value_) {
+        if (value_ >= std::numeric_limits<int8_t>::min()
+            && value_ <= std::numeric_limits<int8_t>::max())
+        {
+            putCode (out_, smalllong_c);
+            out_.push_back (static_cast<char>(value_));
+        } else {
+            putCode (out_, long_c);
+            putBigEndian (out_, value_);
+        }
+    }
+
+    void
+    putDouble (std::string & out_, double value_) {
+        uint64_t bits;
+        std::memcpy (&bits, &value_, sizeof (bits));
+
+        putCode (out_, double_c);
+        putBigEndian (out_, bits);
+    }
+
+    /**
+     * The opening of one of the types described by the Corda
+     * serialization scheme itself
+     */
+    void
+    putDescriptor (std::string & out_, int descriptor_) {
+        putCode (out_, described_c);
+        putCode (out_, ulong_c);
+        putBigEndian (out_,
+                amqp::schema::descriptors::DESCRIPTOR_TOP_32BITS
+                    | static_cast<uint64_t>(descriptor_));
+    }
+
+    /**
+     * Returns where the list's size is, to be filled in by [closeList]
+     */
+    size_t
+    openList (std::string & out_, code_t code_, size_t count_) {
+        if (count_ > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error ("Too many elements to encode");
+        }
+
+        putCode (out_, code_);
+
+        auto at = out_.size();
+
+        putBigEndian (out_, uint32_t { 0 });
+        putBigEndian (out_, static_cast<uint32_t>(count_));
+
+        return at;
+    }
+
+    void
+    closeList (std::string & out_, size_t at_) {
+        auto size = out_.size() - at_ - sizeof (uint32_t);
+
+        if (size > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error ("Too much data to encode");
+        }
+
+        for (size_t i { 0 } ; i < sizeof (uint32_t) ; ++i) {
+            out_[at_ + i] = static_cast<char>(size >> (8 * (3 - i)));
+        }
+    }
+
+    template<typename C>
+    void
+    putStrings (std::string & out_, const C & values_) {
+        auto at = openList (out_, list32_c, values_.size());
+
+        for (const auto & value : values_) {
+            putString (out_, value);
+        }
+
+        closeList (out_, at);
+    }
+
+    void
+    putTypeDescriptor (std::string & out_, const std::string & descriptor_) {
+        using namespace amqp::schema::descriptors;
+
+        putDescriptor (out_, OBJECT);
+
+        auto at = openList (out_, list32_c, 2);
+
+        putSymbol (out_, descriptor_);
+        putCode (out_, null_c);
+
+        closeList (out_, at);
+    }
+
+    /**
+     * The schema entry of a composite, laid out as [CompositeDescriptor]
+     * expects to read it
+     */
+    std::string
+    fragment (const amqp::internal::schema::Composite & composite_) {
+        using namespace amqp::schema::descriptors;
+
+        std::string out;
+
+        putDescriptor (out, COMPOSITE_TYPE);
+
+        auto at = openList (out, list32_c, 5);
+
+        putString (out, composite_.name());
+        putNullable (out, composite_.label());
+        putStrings (out, composite_.provides());
+        putTypeDescriptor (out, composite_.descriptor());
+
+        auto fields = openList (out, list32_c, composite_.fields().size());
+
+        for (const auto & field : composite_.fields()) {
+            putDescriptor (out, FIELD);
+
+            auto f = openList (out, list32_c, 7);
+
+            putString (out, field->name());
+            putString (out, field->type());
+            putStrings (out, field->requires());
+            putNullable (out, field->defaultValue());
+            putNullable (out, field->label());
+            putBool (out, field->mandatory());
+            putBool (out, field->multiple());
+
+            closeList (out, f);
+        }
+
+        closeList (out, fields);
+        closeList (out, at);
+
+        return out;
+    }
+
+    /**
+     * The schema entry of a list, map, array or enum, laid out as
+     * [RestrictedDescriptor] expects to read it
+     */
+    std::string
+    fragment (const amqp::internal::schema::Restricted & restricted_) {
+        using namespace amqp::schema::descriptors;
+        using amqp::internal::schema::Restricted;
+
+        std::string out;
+
+        putDescriptor (out, RESTRICTED_TYPE);
+
+        auto at = openList (out, list32_c, 6);
+
+        putString (out, restricted_.name());
+        putNullable (out, restricted_.label());
+        putStrings (out, restricted_.provides());
+        putString (out, restricted_.source() == Restricted::map_t ? "map" : "list");
+        putTypeDescriptor (out, restricted_.descriptor());
+
+        std::vector<std::string> choices;
+
+        if (auto e = dynamic_cast<const amqp::internal::schema::Enum *>(&restricted_)) {
+            choices = e->makeChoices();
+        }
+
+        auto c = openList (out, list32_c, choices.size());
+
+        for (const auto & choice : choices) {
+            putDescriptor (out, CHOICE);
+
+            auto ch = openList (out, list32_c, 1);
+            putString (out, choice);
+            closeList (out, ch);
+        }
+
+        closeList (out, c);
+        closeList (out, at);
+
+        return out;
+    }
+
+    [[noreturn]]
+    void
+    mismatch (const std::string & type_, const char * what_) {
+        throw std::runtime_error ("Expected a " + type_ + " but was given " + what_);
+    }
+
+    const amqp::internal::reader::Reader &
+    lock (const std::weak_ptr<amqp::internal::reader::Reader> & reader_) {
+        auto reader = reader_.lock();
+
+        if (!reader) {
+            throw std::runtime_error ("null reader");
+        }
+
+        return *reader;
+    }
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::BlobEncoder
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+BlobEncoder::BlobEncoder (uPtr<schema::Schema> schema_)
+    : m_schema (std::move (schema_))
+    , m_root (nullptr)
+    , m_expected (nullptr)
+    , m_envelope (0)
+{
+    m_factory.process (*m_schema);
+}
+
+/******************************************************************************/
+
+/**
+ * Readers are shared between everything of the same type so so are these,
+ * and since a type can contain itself one is remembered before anything
+ * it contains is looked at
+ */
+const amqp::internal::stream::BlobEncoder::Type &
+amqp::internal::stream::
+BlobEncoder::type (const reader::Reader & reader_) {
+    auto it = m_types.find (reader_.type());
+
+    if (it != m_types.end()) {
+        return it->second;
+    }
+
+    auto & rtn = m_types[reader_.type()];
+
+    rtn.name = reader_.type();
+
+    if (dynamic_cast<const reader::PropertyReader *>(&reader_)) {
+        if (dynamic_cast<const reader::IntPropertyReader *>(&reader_)) {
+            rtn.kind = int_k;
+        } else if (dynamic_cast<const reader::LongPropertyReader *>(&reader_)) {
+            rtn.kind = long_k;
+        } else if (dynamic_cast<const reader::BoolPropertyReader *>(&reader_)) {
+            rtn.kind = bool_k;
+        } else if (dynamic_cast<const reader::DoublePropertyReader *>(&reader_)) {
+            rtn.kind = double_k;
+        } else if (dynamic_cast<const reader::StringPropertyReader *>(&reader_)) {
+            rtn.kind = string_k;
+        } else {
+            m_types.erase (reader_.type());
+            throw std::runtime_error ("Can't encode a " + reader_.type());
+        }
+
+        return rtn;
+    }
+
+    const auto & notation = *(m_schema->fromType (reader_.type())->second.get());
+
+    rtn.descriptor = notation.descriptor();
+
+    if (auto c = dynamic_cast<const reader::CompositeReader *>(&reader_)) {
+        const auto & composite = dynamic_cast<const schema::Composite &>(notation);
+
+        if (composite.fields().size() != c->readers().size()) {
+            std::stringstream ss;
+            ss << reader_.type() << " has " << composite.fields().size()
+               << " fields but " << c->readers().size() << " readers";
+            throw std::runtime_error (ss.str());
+        }
+
+        rtn.kind = composite_k;
+        rtn.fragment = fragment (composite);
+
+        for (size_t i { 0 } ; i < c->readers().size() ; ++i) {
+            rtn.names.push_back (composite.fields()[i]->name());
+            rtn.children.push_back (&type (lock (c->readers()[i])));
+        }
+    } else if (auto r = dynamic_cast<const reader::RestrictedReader *>(&reader_)) {
+        rtn.fragment = fragment (dynamic_cast<const schema::Restricted &>(notation));
+
+        switch (r->restrictedType()) {
+            case schema::Restricted::RestrictedTypes::list_t :
+                rtn.kind = list_k;
+                rtn.children.push_back (&type (lock (
+                        static_cast<const reader::ListReader *>(r)->reader())));
+                break;
+            case schema::Restricted::RestrictedTypes::array_t :
+                rtn.kind = list_k;
+                rtn.children.push_back (&type (lock (
+                        static_cast<const reader::ArrayReader *>(r)->reader())));
+                break;
+            case schema::Restricted::RestrictedTypes::map_t : {
+                auto m = static_cast<const reader::MapReader *>(r);
+                rtn.kind = map_k;
+                rtn.children.push_back (&type (lock (m->keyReader())));
+                rtn.children.push_back (&type (lock (m->valueReader())));
+                break;
+            }
+            case schema::Restricted::RestrictedTypes::enum_t :
+                rtn.kind = enum_k;
+                rtn.names = dynamic_cast<const schema::Enum &>(notation).makeChoices();
+                break;
+        }
+    } else {
+        throw std::runtime_error ("Unknown reader type: " + reader_.type());
+    }
+
+    return rtn;
+}
+
+/******************************************************************************/
+
+/**
+ * The schema of a blob lists the type of its value and everything that
+ * type references, each once
+ */
+const amqp::internal::stream::BlobEncoder::Root &
+amqp::internal::stream::
+BlobEncoder::root (const std::string & type_) {
+    auto it = m_roots.find (type_);
+
+    if (it != m_roots.end()) {
+        return it->second;
+    }
+
+    auto reader = std::dynamic_pointer_cast<reader::Reader> (
+            m_factory.byType (type_));
+
+    if (!reader) {
+        throw std::runtime_error ("No type " + type_ + " in the schema");
+    }
+
+    Root rtn { &type (*reader), { } };
+
+    std::vector<const Type *> types;
+    std::set<const Type *> seen { rtn.type };
+    std::vector<const Type *> todo { rtn.type };
+
+    while (!todo.empty()) {
+        auto t = todo.back();
+        todo.pop_back();
+
+        if (!t->fragment.empty()) {
+            types.push_back (t);
+        }
+
+        for (auto child : t->children) {
+            if (seen.insert (child).second) {
+                todo.push_back (child);
+            }
+        }
+    }
+
+    putDescriptor (rtn.schema, amqp::schema::descriptors::SCHEMA);
+
+    auto outer = openList (rtn.schema, list32_c, 1);
+    auto inner = openList (rtn.schema, list32_c, types.size());
+
+    for (auto t : types) {
+        rtn.schema.append (t->fragment);
+    }
+
+    closeList (rtn.schema, inner);
+    closeList (rtn.schema, outer);
+
+    return m_roots.emplace (type_, std::move (rtn)).first->second;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::begin (const std::string & type_) {
+    m_root = &root (type_);
+
+    m_buffer.clear();
+    m_stack.clear();
+
+    m_buffer.append (amqp::AMQP_HEADER.data(), amqp::AMQP_HEADER.size());
+    m_buffer.push_back (amqp::DATA_AND_STOP);
+
+    putDescriptor (m_buffer, amqp::schema::descriptors::ENVELOPE);
+    m_envelope = openList (m_buffer, list32_c, 3);
+
+    m_expected = m_root->type;
+}
+
+/******************************************************************************/
+
+std::string_view
+amqp::internal::stream::
+BlobEncoder::end() {
+    if (!m_root) {
+        throw std::runtime_error ("No blob has been begun");
+    }
+
+    if (m_expected || !m_stack.empty()) {
+        throw std::runtime_error ("The value of the blob is incomplete");
+    }
+
+    m_buffer.append (m_root->schema);
+
+    /*
+     * No transforms, an empty map
+     */
+    putDescriptor (m_buffer, amqp::schema::descriptors::TRANSFORM_SCHEMA);
+    putCode (m_buffer, map8_c);
+    m_buffer.push_back (1);
+    m_buffer.push_back (0);
+
+    closeList (m_buffer, m_envelope);
+
+    m_root = nullptr;
+
+    return m_buffer;
+}
+
+/******************************************************************************/
+
+const amqp::internal::stream::BlobEncoder::Type &
+amqp::internal::stream::
+BlobEncoder::expect (const char * what_) {
+    if (!m_expected) {
+        throw std::runtime_error (std::string ("Unexpected ") + what_);
+    }
+
+    return *m_expected;
+}
+
+/******************************************************************************/
+
+/**
+ * A value has been written, work out what the next one has to be
+ */
+void
+amqp::internal::stream::
+BlobEncoder::next() {
+    m_expected = nullptr;
+
+    if (m_stack.empty()) {
+        return;
+    }
+
+    auto & frame = m_stack.back();
+
+    if (++frame.idx < frame.count) {
+        switch (frame.type->kind) {
+            case list_k : m_expected = frame.type->children[0]; break;
+            case map_k : m_expected = frame.type->children[frame.idx % 2]; break;
+            default : break;
+        }
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::open (const Type & type_, uint8_t code_, size_t count_) {
+    putCode (m_buffer, described_c);
+    putSymbol (m_buffer, type_.descriptor);
+
+    auto at = openList (m_buffer, static_cast<code_t>(code_), count_);
+
+    m_stack.push_back ({ &type_, at, 0, count_ });
+
+    m_expected = (count_ && type_.kind != composite_k)
+        ? type_.children[0]
+        : nullptr;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::close (kind_t kind_, const char * what_) {
+    if (m_stack.empty() || m_stack.back().type->kind != kind_) {
+        throw std::runtime_error (std::string ("Unexpected ") + what_);
+    }
+
+    auto & frame = m_stack.back();
+
+    if (frame.idx != frame.count) {
+        std::stringstream ss;
+        ss << frame.type->name << " ended after " << frame.idx << " of its "
+           << frame.count << " elements";
+        throw std::runtime_error (ss.str());
+    }
+
+    closeList (m_buffer, frame.at);
+
+    m_stack.pop_back();
+    next();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::property (const std::string & name_) {
+    if (m_expected || m_stack.empty() || m_stack.back().type->kind != composite_k) {
+        throw std::runtime_error ("Unexpected property " + name_);
+    }
+
+    auto & frame = m_stack.back();
+
+    if (frame.idx == frame.count) {
+        throw std::runtime_error (
+                frame.type->name + " has no more properties, was given " + name_);
+    }
+
+    if (frame.type->names[frame.idx] != name_) {
+        throw std::runtime_error (
+                "Expected property " + frame.type->names[frame.idx] + " of "
+                + frame.type->name + " but was given " + name_);
+    }
+
+    m_expected = frame.type->children[frame.idx];
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::beginComposite (const std::string & name_, size_t fields_) {
+    const auto & t = expect ("composite");
+
+    if (t.kind != composite_k || t.name != name_) {
+        mismatch (t.name, name_.c_str());
+    }
+
+    if (fields_ != t.names.size()) {
+        std::stringstream ss;
+        ss << name_ << " has " << t.names.size() << " properties but was given "
+           << fields_;
+        throw std::runtime_error (ss.str());
+    }
+
+    open (t, list32_c, fields_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::endComposite() {
+    close (composite_k, "end of composite");
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::beginList (size_t size_) {
+    const auto & t = expect ("list");
+
+    if (t.kind != list_k) {
+        mismatch (t.name, "list");
+    }
+
+    open (t, list32_c, size_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::endList() {
+    close (list_k, "end of list");
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::beginMap (size_t size_) {
+    const auto & t = expect ("map");
+
+    if (t.kind != map_k) {
+        mismatch (t.name, "map");
+    }
+
+    open (t, map32_c, size_ * 2);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::endMap() {
+    close (map_k, "end of map");
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::value (bool value_) {
+    const auto & t = expect ("boolean");
+
+    if (t.kind != bool_k) {
+        mismatch (t.name, "boolean");
+    }
+
+    putBool (m_buffer, value_);
+    next();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::value (int32_t value_) {
+    const auto & t = expect ("int");
+
+    switch (t.kind) {
+        case int_k : putInt (m_buffer, value_); break;
+        case long_k : putLong (m_buffer, value_); break;
+        default : mismatch (t.name, "int");
+    }
+
+    next();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::value (int64_t value_) {
+    const auto & t = expect ("long");
+
+    if (t.kind == long_k) {
+        putLong (m_buffer, value_);
+    } else if (t.kind == int_k
+        && value_ >= std::numeric_limits<int32_t>::min()
+        && value_ <= std::numeric_limits<int32_t>::max())
+    {
+        putInt (m_buffer, static_cast<int32_t>(value_));
+    } else {
+        mismatch (t.name, "long");
+    }
+
+    next();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::value (double value_) {
+    const auto & t = expect ("double");
+
+    if (t.kind != double_k) {
+        mismatch (t.name, "double");
+    }
+
+    putDouble (m_buffer, value_);
+    next();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::value (std::string_view value_) {
+    const auto & t = expect ("string");
+
+    if (t.kind != string_k) {
+        mismatch (t.name, "string");
+    }
+
+    putString (m_buffer, value_);
+    next();
+}
+
+/******************************************************************************/
+
+/**
+ * An enum is its constant followed by that constant's ordinal
+ */
+void
+amqp::internal::stream::
+BlobEncoder::enumeration (std::string_view value_) {
+    const auto & t = expect ("enum");
+
+    if (t.kind != enum_k) {
+        mismatch (t.name, "enum");
+    }
+
+    size_t ordinal { 0 };
+
+    while (ordinal < t.names.size() && t.names[ordinal] != value_) {
+        ++ordinal;
+    }
+
+    if (ordinal == t.names.size()) {
+        throw std::runtime_error (
+                std::string (value_) + " is not a constant of " + t.name);
+    }
+
+    putCode (m_buffer, described_c);
+    putSymbol (m_buffer, t.descriptor);
+
+    auto at = openList (m_buffer, list32_c, 2);
+
+    putString (m_buffer, value_);
+    putInt (m_buffer, static_cast<int32_t>(ordinal));
+
+    closeList (m_buffer, at);
+
+    next();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+BlobEncoder::null() {
+    expect ("null");
+
+    putCode (m_buffer, null_c);
+    next();
+}
+
+/******************************************************************************/
+
+/**
+ * Only objects can be referred back to, of the primitives that's just
+ * strings that aren't a composite's property which we can't tell apart
+ * from those that are so we leave it to the decoder to complain
+ */
+void
+amqp::internal::stream::
+BlobEncoder::reference (size_t index_) {
+    expect ("reference");
+
+    putDescriptor (m_buffer, amqp::schema::descriptors::REFERENCED_OBJECT);
+
+    if (index_ <= std::numeric_limits<uint8_t>::max()) {
+        putCode (m_buffer, smalluint_c);
+        m_buffer.push_back (static_cast<char>(index_));
+    } else if (index_ <= std::numeric_limits<uint32_t>::max()) {
+        putCode (m_buffer, uint_c);
+        putBigEndian (m_buffer, static_cast<uint32_t>(index_));
+    } else {
+        putCode (m_buffer, ulong_c);
+        putBigEndian (m_buffer, static_cast<uint64_t>(index_));
+    }
+
+    next();
+}
+
+/******************************************************************************/
@@ -0,0 +1,181 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <map>
+#include <string>
+#include <vector>
+#include <string_view>
+
+#include "types.h"
+
+#include "amqp/CompositeFactory.h"
+#include "amqp/reader/IVisitor.h"
+#include "amqp/reader/Reader.h"
+#include "amqp/schema/described-types/Schema.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::BlobEncoder
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Writes complete Corda blobs, header, envelope, schema and all, from
+     * the same calls a [StreamDecoder] makes of its visitor. What type each
+     * value is, and so how it's encoded, comes from the schema the encoder
+     * was built with, walked alongside the values just as the decoder walks
+     * it alongside the tokens of a blob. Anything that can be decoded can
+     * therefore be encoded again by handing an encoder to the decoder.
+     *
+     *      BlobEncoder encoder (std::move (schema));
+     *
+     *      encoder.begin ("net.corda.Foo");
+     *      encoder.beginComposite ("net.corda.Foo", 1);
+     *      encoder.property ("a");
+     *      encoder.value (1);
+     *      encoder.endComposite();
+     *
+     *      auto blob = encoder.end();
+     *
+     * Everything is written in a single pass into one buffer that's reused
+     * from blob to blob. Lists, maps and the envelope are given four byte
+     * size prefixes as they're opened which are filled in as they close,
+     * nothing is ever measured beforehand or moved afterwards.
+     *
+     * The schema entry of each type is encoded the first time the type is
+     * needed, as is the whole schema section of a blob holding a value of
+     * it, after which they're simply copied so repeatedly writing values of
+     * the same type only costs their data.
+     */
+    class BlobEncoder : public amqp::reader::IVisitor {
+        private :
+            enum kind_t {
+                int_k, long_k, bool_k, double_k, string_k,
+                composite_k, list_k, map_k, enum_k
+            };
+
+            /**
+             * Everything about a type needed to encode values of it,
+             * worked out once from its reader and schema entry
+             */
+            struct Type {
+                kind_t                    kind;
+                std::string               name;
+                std::string               descriptor;
+
+                /**
+                 * A composite's properties, a list's elements, or a map's
+                 * keys and values in that order
+                 */
+                std::vector<const Type *> children;
+
+                /**
+                 * The names of a composite's properties or an enum's
+                 * constants
+                 */
+                std::vector<std::string>  names;
+
+                /**
+                 * The type's entry in a schema, empty for primitives
+                 */
+                std::string               fragment;
+            };
+
+            /**
+             * A type blobs have been written with, and the schema section
+             * describing it and everything it references
+             */
+            struct Root {
+                const Type * type;
+                std::string  schema;
+            };
+
+            struct Frame {
+                const Type * type;
+
+                /**
+                 * Where the size prefix of the frame's list or map is
+                 */
+                size_t       at;
+                size_t       idx;
+                size_t       count;
+            };
+
+            uPtr<schema::Schema> m_schema;
+            CompositeFactory m_factory;
+
+            std::map<std::string, Type> m_types;
+            std::map<std::string, Root> m_roots;
+
+            std::string m_buffer;
+
+            std::vector<Frame> m_stack;
+
+            const Root * m_root;
+
+            /**
+             * The type the next value has to be, null when nothing can be
+             * written until the enclosing value is closed or, within a
+             * composite, the next property named
+             */
+            const Type * m_expected;
+
+            /**
+             * Where the size prefix of the envelope is
+             */
+            size_t m_envelope;
+
+            const Type & type (const reader::Reader &);
+            const Root & root (const std::string &);
+
+            const Type & expect (const char *);
+            void next();
+
+            void open (const Type &, uint8_t, size_t);
+            void close (kind_t, const char *);
+
+        public :
+            explicit BlobEncoder (uPtr<schema::Schema>);
+
+            /**
+             * Start a new blob, its value being of the named type. Whatever
+             * was returned by the last call to [end] is overwritten.
+             */
+            void begin (const std::string &);
+
+            /**
+             * Finish the blob, throwing if its value is incomplete. The
+             * blob returned is valid until the next call to [begin].
+             */
+            std::string_view end();
+
+            void property (const std::string &) override;
+
+            void beginComposite (const std::string &, size_t) override;
+            void endComposite() override;
+
+            void beginList (size_t) override;
+            void endList() override;
+
+            void beginMap (size_t) override;
+            void endMap() override;
+
+            void value (bool) override;
+            void value (int32_t) override;
+            void value (int64_t) override;
+            void value (double) override;
+            void value (std::string_view) override;
+
+            void enumeration (std::string_view) override;
+
+            void null() override;
+
+            void reference (size_t) override;
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,432 @@
+#include "Catalog.h"
+
+#include <ostream>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "amqp/schema/FlatSchema.h"
+#include "amqp/schema/described-types/Schema.h"
+
+/******************************************************************************/
+
+namespace {
+
+    std::string
+    restricted (amqp::internal::schema::FlatSchema::kind_t kind_) {
+        using amqp::internal::schema::FlatSchema;
+
+        switch (kind_) {
+            case FlatSchema::list_k  : return "list";
+            case FlatSchema::map_k   : return "map";
+            case FlatSchema::enum_k  : return "enum";
+            case FlatSchema::array_k : return "array";
+            case FlatSchema::composite_k : break;
+        }
+
+        return "unknown";
+    }
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::CatalogBuilder
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::CatalogBuilder::Entry
+amqp::internal::stream::
+CatalogBuilder::describe (const SchemaScanner & scanner_) {
+    const schema::FlatSchema schema (*scanner_.load());
+
+    const auto * type = schema.byDescriptor (scanner_.descriptor());
+
+    if (!type) {
+        throw std::runtime_error (
+            "Schema has no type with descriptor " + scanner_.descriptor());
+    }
+
+    Entry entry { };
+
+    entry.name = schema.string (type->name);
+
+    if (type->kind == schema::FlatSchema::composite_k) {
+        entry.kind = schema::AMQPTypeNotation::composite_t;
+
+        for (const auto & field : schema.fields (*type)) {
+            entry.fields += std::string (schema.string (field.name)) + " ";
+            entry.fields += std::string (schema.string (field.type)) + "\n";
+        }
+    } else {
+        entry.kind = schema::AMQPTypeNotation::restricted_t;
+        entry.fields = restricted (type->kind) + "\n";
+
+        // an enum is described by its name rather than its constants, as
+        // catalogs always have
+        if (type->kind == schema::FlatSchema::enum_k) {
+            entry.fields += std::string (schema.string (type->name)) + "\n";
+        } else {
+            for (auto of : schema.ids (type->of)) {
+                entry.fields += std::string (schema.string (of)) + "\n";
+            }
+        }
+    }
+
+    entry.schema.assign (scanner_.bytes().begin(), scanner_.bytes().end());
+
+    for (const auto & t : schema.types()) {
+        entry.names.emplace_back (schema.string (t.name));
+    }
+
+    return entry;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+CatalogBuilder::add (
+    uint32_t id_,
+    const std::string & blob_,
+    uint64_t bytes_,
+    const SchemaScanner & scanner_
+) {
+    auto count = [&](Entry & entry_) {
+        entry_.first = std::min<uint64_t> (entry_.first, id_);
+        ++entry_.count;
+        entry_.bytes += bytes_;
+
+        for (const auto & name : entry_.names) {
+            m_postings[name].push_back (id_);
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock (m_mutex);
+
+        if (m_blobs.size() <= id_) {
+            m_blobs.resize (id_ + 1);
+        }
+
+        m_blobs[id_] = blob_;
+
+        auto it = m_types.find (scanner_.descriptor());
+
+        if (it != m_types.end()) {
+            count (it->second);
+            return;
+        }
+    }
+
+    /*
+     * Loading the schema is the only expensive part so don't hold everyone
+     * else up while we do it. Should another thread get there first we've
+     * just wasted a little effort.
+     */
+    auto entry = describe (scanner_);
+    entry.first = id_;
+
+    std::lock_guard<std::mutex> lock (m_mutex);
+
+    count (m_types.emplace (scanner_.descriptor(), std::move (entry)).first->second);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+CatalogBuilder::write (std::ostream & out_) const {
+    auto postings { m_postings };
+    uint64_t total { 0 };
+
+    for (auto & [ name, ids ] : postings) {
+        std::sort (ids.begin(), ids.end());
+        ids.erase (std::unique (ids.begin(), ids.end()), ids.end());
+        total += ids.size();
+    }
+
+    catalog::Header header { };
+
+    std::memcpy (header.magic, catalog::MAGIC, sizeof (header.magic));
+    header.version = catalog::VERSION;
+    header.orderMark = catalog::ORDER_MARK;
+
+    header.blobs = m_blobs.size();
+    header.blobsAt = sizeof (catalog::Header);
+
+    header.types = m_types.size();
+    header.typesAt = header.blobsAt + header.blobs * sizeof (catalog::String);
+
+    header.names = postings.size();
+    header.namesAt = header.typesAt + header.types * sizeof (catalog::Type);
+
+    header.postings = total;
+    header.postingsAt = header.namesAt + header.names * sizeof (catalog::Name);
+
+    header.stringsAt = (header.postingsAt + total * sizeof (uint32_t) + 7) & ~7ULL;
+
+    std::string strings;
+
+    auto intern = [&](const std::string & str_) {
+        catalog::String rtn { header.stringsAt + strings.size(), str_.size() };
+        strings += str_;
+        return rtn;
+    };
+
+    std::vector<catalog::String> blobs;
+    blobs.reserve (m_blobs.size());
+
+    for (const auto & blob : m_blobs) {
+        blobs.push_back (intern (blob));
+    }
+
+    std::vector<catalog::Type> types;
+    types.reserve (m_types.size());
+
+    for (const auto & [ descriptor, entry ] : m_types) {
+        catalog::Type type { };
+
+        type.descriptor = intern (descriptor);
+        type.name = intern (entry.name);
+        type.kind = entry.kind;
+        type.fields = intern (entry.fields);
+        type.schema = intern (entry.schema);
+        type.first = entry.first;
+        type.count = entry.count;
+        type.bytes = entry.bytes;
+
+        types.push_back (type);
+    }
+
+    std::vector<catalog::Name> names;
+    std::vector<uint32_t> ids;
+
+    names.reserve (postings.size());
+    ids.reserve (total);
+
+    for (const auto & [ name, postings_ ] : postings) {
+        names.push_back ({ intern (name), postings_.size(), ids.size() });
+        ids.insert (ids.end(), postings_.begin(), postings_.end());
+    }
+
+    header.stringsSize = strings.size();
+
+    auto write = [&](const void * data_, size_t size_) {
+        out_.write (static_cast<const char *>(data_), size_);
+    };
+
+    write (&header, sizeof (header));
+    write (blobs.data(), blobs.size() * sizeof (catalog::String));
+    write (types.data(), types.size() * sizeof (catalog::Type));
+    write (names.data(), names.size() * sizeof (catalog::Name));
+    write (ids.data(), ids.size() * sizeof (uint32_t));
+
+    const char padding[8] { };
+    write (padding, header.stringsAt - (header.postingsAt + total * sizeof (uint32_t)));
+
+    write (strings.data(), strings.size());
+
+    if (!out_) {
+        throw std::runtime_error ("Failed to write the catalog");
+    }
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Catalog
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+Catalog::Catalog (const std::string & file_)
+    : m_base (nullptr)
+    , m_size (0)
+    , m_header (nullptr)
+{
+    int fd = open (file_.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        throw std::runtime_error ("Can't open " + file_);
+    }
+
+    struct stat results { };
+
+    if (fstat (fd, &results) != 0
+        || static_cast<size_t>(results.st_size) < sizeof (catalog::Header))
+    {
+        close (fd);
+        throw std::runtime_error ("Not a catalog: " + file_);
+    }
+
+    m_size = results.st_size;
+
+    auto base = mmap (nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close (fd);
+
+    if (base == MAP_FAILED) {
+        throw std::runtime_error ("Can't map " + file_);
+    }
+
+    m_base = static_cast<const char *>(base);
+    m_header = reinterpret_cast<const catalog::Header *>(m_base);
+
+    try {
+        if (std::memcmp (m_header->magic, catalog::MAGIC, sizeof (catalog::MAGIC)) != 0) {
+            throw std::runtime_error ("Not a catalog: " + file_);
+        }
+
+        if (m_header->version != catalog::VERSION
+            || m_header->orderMark != catalog::ORDER_MARK)
+        {
+            throw std::runtime_error ("Unsupported catalog: " + file_);
+        }
+
+        array<catalog::String> (m_header->blobsAt, m_header->blobs);
+        array<catalog::Type> (m_header->typesAt, m_header->types);
+        array<catalog::Name> (m_header->namesAt, m_header->names);
+        array<uint32_t> (m_header->postingsAt, m_header->postings);
+        array<char> (m_header->stringsAt, m_header->stringsSize);
+    } catch (...) {
+        munmap (const_cast<char *>(m_base), m_size);
+        throw;
+    }
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::
+Catalog::~Catalog() {
+    munmap (const_cast<char *>(m_base), m_size);
+}
+
+/******************************************************************************/
+
+template<typename T>
+const T *
+amqp::internal::stream::
+Catalog::array (uint64_t at_, uint64_t count_) const {
+    if (at_ % alignof (T) || at_ > m_size || count_ > (m_size - at_) / sizeof (T)) {
+        throw std::runtime_error ("Truncated catalog");
+    }
+
+    return reinterpret_cast<const T *>(m_base + at_);
+}
+
+/******************************************************************************/
+
+std::string_view
+amqp::internal::stream::
+Catalog::view (const catalog::String & str_) const {
+    return { array<char> (str_.offset, str_.size), str_.size };
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::Catalog::Type
+amqp::internal::stream::
+Catalog::type (const catalog::Type & type_) const {
+    if (type_.first >= m_header->blobs) {
+        throw std::runtime_error ("Corrupt catalog");
+    }
+
+    return {
+        view (type_.descriptor),
+        view (type_.name),
+        type_.kind,
+        view (type_.fields),
+        view (type_.schema),
+        view (array<catalog::String> (m_header->blobsAt, m_header->blobs)[type_.first]),
+        type_.count,
+        type_.bytes
+    };
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+Catalog::types() const {
+    return m_header->types;
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::Catalog::Type
+amqp::internal::stream::
+Catalog::type (size_t index_) const {
+    if (index_ >= m_header->types) {
+        throw std::out_of_range ("No type " + std::to_string (index_));
+    }
+
+    return type (array<catalog::Type> (m_header->typesAt, m_header->types)[index_]);
+}
+
+/******************************************************************************/
+
+std::optional<amqp::internal::stream::Catalog::Type>
+amqp::internal::stream::
+Catalog::find (std::string_view descriptor_) const {
+    auto begin = array<catalog::Type> (m_header->typesAt, m_header->types);
+    auto end = begin + m_header->types;
+
+    auto it = std::lower_bound (begin, end, descriptor_,
+        [this](const catalog::Type & type_, std::string_view descriptor_) {
+            return view (type_.descriptor) < descriptor_;
+        });
+
+    if (it == end || view (it->descriptor) != descriptor_) {
+        return std::nullopt;
+    }
+
+    return type (*it);
+}
+
+/******************************************************************************/
+
+std::vector<std::string_view>
+amqp::internal::stream::
+Catalog::blobs (std::string_view name_) const {
+    auto begin = array<catalog::Name> (m_header->namesAt, m_header->names);
+    auto end = begin + m_header->names;
+
+    auto it = std::lower_bound (begin, end, name_,
+        [this](const catalog::Name & entry_, std::string_view name_) {
+            return view (entry_.name) < name_;
+        });
+
+    std::vector<std::string_view> rtn;
+
+    if (it == end || view (it->name) != name_) {
+        return rtn;
+    }
+
+    if (it->postingsAt > m_header->postings
+        || it->postings > m_header->postings - it->postingsAt)
+    {
+        throw std::runtime_error ("Corrupt catalog");
+    }
+
+    auto ids = array<uint32_t> (m_header->postingsAt, m_header->postings) + it->postingsAt;
+    auto blobs = array<catalog::String> (m_header->blobsAt, m_header->blobs);
+
+    rtn.reserve (it->postings);
+
+    for (uint64_t i { 0 } ; i < it->postings ; ++i) {
+        if (ids[i] >= m_header->blobs) {
+            throw std::runtime_error ("Corrupt catalog");
+        }
+
+        rtn.push_back (view (blobs[ids[i]]));
+    }
+
+    return rtn;
+}
+
+/******************************************************************************/
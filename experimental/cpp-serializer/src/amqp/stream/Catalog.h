@@ -0,0 +1,231 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "SchemaScanner.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::catalog
+ *
+ ******************************************************************************/
+
+/**
+ * The layout of a catalog file, everything in it being one of these
+ * structures or a string they refer to. It's written as the structures
+ * are laid out in memory so can be mapped and used as is, the header's
+ * byte order mark telling us it was written by a machine like ours.
+ *
+ *      Header
+ *      String[blobs]   the name of each blob, indexed by blob ID
+ *      Type[types]     sorted by descriptor
+ *      Name[names]     sorted by name
+ *      uint32_t[]      the postings of every name, blob IDs ascending
+ *      char[]          the bytes of every string
+ *
+ * All offsets are from the start of the file.
+ */
+namespace amqp::internal::stream::catalog {
+
+    constexpr char MAGIC[8] = { 'C', 'O', 'R', 'D', 'A', 'C', 'A', 'T' };
+    constexpr uint64_t VERSION = 1;
+    constexpr uint64_t ORDER_MARK = 0x0102030405060708ULL;
+
+    struct String {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct Header {
+        char     magic[8];
+        uint64_t version;
+        uint64_t orderMark;
+
+        uint64_t blobs;
+        uint64_t blobsAt;
+
+        uint64_t types;
+        uint64_t typesAt;
+
+        uint64_t names;
+        uint64_t namesAt;
+
+        uint64_t postings;
+        uint64_t postingsAt;
+
+        uint64_t stringsAt;
+        uint64_t stringsSize;
+    };
+
+    /**
+     * A top level type, one for every distinct descriptor seen
+     */
+    struct Type {
+        String   descriptor;
+        String   name;
+
+        /**
+         * an AMQPTypeNotation::Type
+         */
+        uint64_t kind;
+
+        /**
+         * For a composite each of its fields as a line of its name, a
+         * space and its type. For a restricted type what it restricts,
+         * list, map, enum or array, followed by a line for each of the
+         * types it's made of.
+         */
+        String   fields;
+
+        /**
+         * the encoded schema section of the first blob of this type
+         */
+        String   schema;
+
+        /**
+         * ID of the first blob of the type, how many there were and the
+         * total size of them
+         */
+        uint64_t first;
+        uint64_t count;
+        uint64_t bytes;
+    };
+
+    /**
+     * Every type named in the schema of a blob, top level or not,
+     * and the blobs it was named in
+     */
+    struct Name {
+        String   name;
+        uint64_t postings;
+        uint64_t postingsAt;
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::CatalogBuilder
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Collects what a [SchemaScanner] finds in each blob of a vault into a
+     * catalog. Since a descriptor is a fingerprint of its type and every
+     * type it refers to, a schema is only loaded the first time its
+     * descriptor is seen, every other blob of that type just counts.
+     *
+     * Blobs may be added from as many threads as there are.
+     */
+    class CatalogBuilder {
+        private :
+            struct Entry {
+                std::string name;
+                uint64_t    kind;
+                std::string fields;
+                std::string schema;
+                uint64_t    first;
+                uint64_t    count;
+                uint64_t    bytes;
+
+                /**
+                 * every type named in the schema
+                 */
+                std::vector<std::string> names;
+            };
+
+            std::mutex m_mutex;
+
+            std::vector<std::string> m_blobs;
+            std::map<std::string, Entry> m_types;
+            std::map<std::string, std::vector<uint32_t>> m_postings;
+
+            static Entry describe (const SchemaScanner &);
+
+        public :
+            /**
+             * Blobs are identified by whatever ID the caller assigns them,
+             * they need not be added in order
+             */
+            void add (uint32_t id_, const std::string & blob_, uint64_t bytes_, const SchemaScanner &);
+
+            size_t types() const { return m_types.size(); }
+
+            void write (std::ostream &) const;
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Catalog
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * A catalog file, mapped into memory. Nothing is read until it's
+     * asked for and lookups are binary searches of the file itself.
+     */
+    class Catalog {
+        public :
+            struct Type {
+                std::string_view descriptor;
+                std::string_view name;
+                uint64_t kind;
+                std::string_view fields;
+                std::string_view schema;
+                std::string_view first;
+                uint64_t count;
+                uint64_t bytes;
+            };
+
+        private :
+            const char * m_base;
+            size_t m_size;
+
+            const catalog::Header * m_header;
+
+            template<typename T>
+            const T * array (uint64_t at_, uint64_t count_) const;
+
+            std::string_view view (const catalog::String &) const;
+
+            Type type (const catalog::Type &) const;
+
+        public :
+            /**
+             * Throws if the file isn't a catalog we can read
+             */
+            explicit Catalog (const std::string &);
+            ~Catalog();
+
+            Catalog (const Catalog &) = delete;
+            Catalog & operator = (const Catalog &) = delete;
+
+            size_t types() const;
+            Type type (size_t) const;
+
+            std::optional<Type> find (std::string_view descriptor_) const;
+
+            /**
+             * Every blob whose schema names the type
+             */
+            std::vector<std::string_view> blobs (std::string_view name_) const;
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,665 @@
+#include "ColumnWriter.h"
+
+#include <limits>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+
+/******************************************************************************/
+
+namespace {
+
+    using amqp::internal::stream::ColumnWriter;
+
+    const char * names[] = {
+        "null", "bool", "int", "long", "double", "string",
+        "struct", "list", "map"
+    };
+
+    /**
+     * Bytes per value of the fixed width types, zero for everything else
+     */
+    size_t
+    width (ColumnWriter::type_t type_) {
+        switch (type_) {
+            case ColumnWriter::int_t    : return sizeof (int32_t);
+            case ColumnWriter::long_t   : return sizeof (int64_t);
+            case ColumnWriter::double_t : return sizeof (double);
+            default                     : return 0;
+        }
+    }
+
+    bool
+    offsets (ColumnWriter::type_t type_) {
+        return type_ == ColumnWriter::string_t
+            || type_ == ColumnWriter::list_t
+            || type_ == ColumnWriter::map_t;
+    }
+
+    template<typename T>
+    void
+    put (std::string & out_, T value_) {
+        out_.append (reinterpret_cast<const char *> (&value_), sizeof (value_));
+    }
+
+    template<class C>
+    void
+    setBit (C & bits_, size_t index_, bool value_) {
+        if (bits_.size() <= index_ / 8) {
+            bits_.resize (index_ / 8 + 1);
+        }
+
+        if (value_) {
+            bits_[index_ / 8] |= (1 << (index_ % 8));
+        } else {
+            bits_[index_ / 8] &= ~(1 << (index_ % 8));
+        }
+    }
+
+    void
+    pad (std::string & out_) {
+        out_.append ((8 - out_.size() % 8) % 8, '\0');
+    }
+
+    /**
+     * Offsets are 32 bits, as Arrow's are for all but its "large" types
+     */
+    int32_t
+    offset (size_t offset_) {
+        if (offset_ > static_cast<size_t> (std::numeric_limits<int32_t>::max())) {
+            throw std::runtime_error ("Too much data for one group of rows");
+        }
+
+        return static_cast<int32_t> (offset_);
+    }
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ColumnWriter
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+ColumnWriter::ColumnWriter (std::ostream & out_, size_t groupSize_)
+    : m_out (out_)
+    , m_groupSize (groupSize_)
+    , m_pending (nullptr)
+    , m_started (false)
+    , m_rows (0)
+    , m_total (0)
+{
+    m_out.write ("CORDACOL", 8);
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+ColumnWriter::rows() const {
+    return m_total;
+}
+
+/******************************************************************************/
+
+/**
+ * The column the next value belongs in, which if we're not already within
+ * a value is the root as a new row
+ */
+amqp::internal::stream::ColumnWriter::Column &
+amqp::internal::stream::
+ColumnWriter::next() {
+    if (m_pending) {
+        auto column = m_pending;
+        m_pending = nullptr;
+
+        return *column;
+    }
+
+    if (m_frames.empty()) {
+        mark (m_root);
+        m_started = true;
+
+        return m_root;
+    }
+
+    auto & frame = m_frames.back();
+
+    switch (frame.column->type) {
+        case list_t : return *frame.column->children[0];
+        case map_t  : return *frame.column->children[frame.written++ % 2];
+        default :
+            throw std::runtime_error ("Value within a composite without a property");
+    }
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::ColumnWriter::Column &
+amqp::internal::stream::
+ColumnWriter::child (Column & parent_, const std::string & name_) {
+    auto it = parent_.byName.find (name_);
+
+    if (it != parent_.byName.end()) {
+        return *it->second;
+    }
+
+    auto column = std::make_unique<Column>();
+    column->name = name_;
+
+    /*
+     * The parent's already been told about the row this is part of,
+     * in every row before it this was null
+     */
+    for (size_t i { 1 } ; i < parent_.length ; ++i) {
+        null (*column);
+    }
+
+    column->markLength = column->markNulls = parent_.markLength;
+
+    auto & rtn = *column;
+    parent_.byName[name_] = &rtn;
+    parent_.children.push_back (std::move (column));
+
+    return rtn;
+}
+
+/******************************************************************************/
+
+/**
+ * Make sure a column is of the type we're about to write to it. Columns
+ * only ever go from being null to something else, every value they've
+ * had up until then being null.
+ */
+void
+amqp::internal::stream::
+ColumnWriter::as (Column & column_, type_t type_) {
+    if (column_.type == type_) {
+        return;
+    }
+
+    if (column_.type != null_t) {
+        throw std::runtime_error (
+            "Column " + column_.name + " holds both " + names[column_.type]
+                + " and " + names[type_] + " values");
+    }
+
+    column_.type = type_;
+
+    if (type_ == bool_t) {
+        column_.values.assign ((column_.length + 7) / 8, '\0');
+    } else {
+        column_.values.assign (column_.length * width (type_), '\0');
+    }
+
+    if (offsets (type_)) {
+        column_.offsets.assign (column_.length + 1, 0);
+    }
+
+    auto add = [&column_](const char * name_) {
+        column_.children.push_back (std::make_unique<Column>());
+        column_.children.back()->name = name_;
+    };
+
+    if (type_ == list_t) {
+        add ("item");
+    } else if (type_ == map_t) {
+        add ("key");
+        add ("value");
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::valid (Column & column_, bool valid_) {
+    setBit (column_.validity, column_.length, valid_);
+
+    if (!valid_) {
+        ++column_.nulls;
+    }
+
+    ++column_.length;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::null (Column & column_) {
+    switch (column_.type) {
+        case bool_t :
+            setBit (column_.values, column_.length, false);
+            break;
+        case int_t :
+        case long_t :
+        case double_t :
+            column_.values.append (width (column_.type), '\0');
+            break;
+        case string_t :
+        case list_t :
+        case map_t :
+            column_.offsets.push_back (column_.offsets.back());
+            break;
+        case struct_t :
+            for (auto & child : column_.children) {
+                null (*child);
+            }
+            break;
+        case null_t :
+            break;
+    }
+
+    valid (column_, false);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::mark (Column & column_) {
+    column_.markLength = column_.length;
+    column_.markNulls = column_.nulls;
+
+    for (auto & child : column_.children) {
+        mark (*child);
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::truncate (Column & column_) {
+    column_.length = column_.markLength;
+    column_.nulls = column_.markNulls;
+
+    if (width (column_.type)) {
+        column_.values.resize (column_.length * width (column_.type));
+    }
+
+    if (offsets (column_.type)) {
+        column_.offsets.resize (column_.length + 1);
+
+        if (column_.type == string_t) {
+            column_.data.resize (column_.offsets.back());
+        }
+    }
+
+    for (auto & child : column_.children) {
+        truncate (*child);
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::clear (Column & column_) {
+    column_.length = column_.nulls = 0;
+    column_.markLength = column_.markNulls = 0;
+
+    column_.validity.clear();
+    column_.values.clear();
+    column_.data.clear();
+    column_.offsets.clear();
+
+    if (offsets (column_.type)) {
+        column_.offsets.push_back (0);
+    }
+
+    for (auto & child : column_.children) {
+        clear (*child);
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::finished() {
+    if (!m_frames.empty()) {
+        return;
+    }
+
+    m_started = false;
+    ++m_total;
+
+    if (++m_rows == m_groupSize) {
+        flush();
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::discard() {
+    if (m_started) {
+        truncate (m_root);
+    }
+
+    m_frames.clear();
+    m_pending = nullptr;
+    m_started = false;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::flush() {
+    if (!m_rows) {
+        return;
+    }
+
+    std::string metadata;
+    std::string body;
+
+    size_t columns { 0 };
+
+    put<uint64_t> (metadata, 0);
+    put<uint64_t> (metadata, m_rows);
+    put<uint32_t> (metadata, 0);
+
+    auto buffer = [&](const void * data_, size_t size_) {
+        pad (body);
+
+        put<uint64_t> (metadata, body.size());
+        put<uint64_t> (metadata, size_);
+
+        body.append (static_cast<const char *> (data_), size_);
+    };
+
+    std::function<void (const Column &)> describe = [&](const Column & column_) {
+        ++columns;
+
+        put<uint16_t> (metadata, column_.name.size());
+        metadata.append (column_.name);
+        put<uint8_t> (metadata, column_.type);
+        put<uint32_t> (metadata, column_.children.size());
+        put<uint64_t> (metadata, column_.length);
+        put<uint64_t> (metadata, column_.nulls);
+
+        auto bytes = (column_.length + 7) / 8;
+
+        switch (column_.type) {
+            case null_t :
+                put<uint8_t> (metadata, 0);
+                break;
+            case struct_t :
+                put<uint8_t> (metadata, 1);
+                buffer (column_.validity.data(), bytes);
+                break;
+            case bool_t :
+                put<uint8_t> (metadata, 2);
+                buffer (column_.validity.data(), bytes);
+                buffer (column_.values.data(), bytes);
+                break;
+            case int_t :
+            case long_t :
+            case double_t :
+                put<uint8_t> (metadata, 2);
+                buffer (column_.validity.data(), bytes);
+                buffer (column_.values.data(), column_.values.size());
+                break;
+            case list_t :
+            case map_t :
+                put<uint8_t> (metadata, 2);
+                buffer (column_.validity.data(), bytes);
+                buffer (column_.offsets.data(), column_.offsets.size() * sizeof (int32_t));
+                break;
+            case string_t :
+                put<uint8_t> (metadata, 3);
+                buffer (column_.validity.data(), bytes);
+                buffer (column_.offsets.data(), column_.offsets.size() * sizeof (int32_t));
+                buffer (column_.data.data(), column_.data.size());
+                break;
+        }
+
+        for (const auto & child : column_.children) {
+            describe (*child);
+        }
+    };
+
+    describe (m_root);
+
+    pad (body);
+    pad (metadata);
+
+    uint64_t size = body.size();
+    metadata.replace (0, sizeof (size), reinterpret_cast<const char *> (&size), sizeof (size));
+
+    uint32_t count = columns;
+    metadata.replace (16, sizeof (count), reinterpret_cast<const char *> (&count), sizeof (count));
+
+    std::string head;
+    put<uint32_t> (head, 0xffffffff);
+    put<uint32_t> (head, metadata.size());
+
+    m_out.write (head.data(), head.size());
+    m_out.write (metadata.data(), metadata.size());
+    m_out.write (body.data(), body.size());
+
+    if (!m_out) {
+        throw std::runtime_error ("Failed to write columns");
+    }
+
+    clear (m_root);
+    m_rows = 0;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::close() {
+    discard();
+    flush();
+
+    std::string eos;
+    put<uint32_t> (eos, 0xffffffff);
+    put<uint32_t> (eos, 0);
+
+    m_out.write (eos.data(), eos.size());
+    m_out.flush();
+
+    if (!m_out) {
+        throw std::runtime_error ("Failed to write columns");
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::property (const std::string & name_) {
+    if (m_frames.empty() || m_frames.back().column->type != struct_t) {
+        throw std::runtime_error ("Property " + name_ + " outside of a composite");
+    }
+
+    m_pending = &child (*m_frames.back().column, name_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::beginComposite (const std::string &, size_t) {
+    auto & column = next();
+
+    as (column, struct_t);
+    valid (column, true);
+
+    m_frames.push_back ({ &column, 0 });
+}
+
+/******************************************************************************/
+
+/**
+ * Any property we've not been told about this time round is null
+ */
+void
+amqp::internal::stream::
+ColumnWriter::endComposite() {
+    auto & column = *m_frames.back().column;
+
+    for (auto & child : column.children) {
+        while (child->length < column.length) {
+            null (*child);
+        }
+    }
+
+    m_frames.pop_back();
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::beginList (size_t) {
+    auto & column = next();
+
+    as (column, list_t);
+
+    m_frames.push_back ({ &column, 0 });
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::endList() {
+    auto & column = *m_frames.back().column;
+
+    column.offsets.push_back (offset (column.children[0]->length));
+    valid (column, true);
+
+    m_frames.pop_back();
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::beginMap (size_t) {
+    auto & column = next();
+
+    as (column, map_t);
+
+    m_frames.push_back ({ &column, 0 });
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::endMap() {
+    auto & column = *m_frames.back().column;
+
+    column.offsets.push_back (offset (column.children[0]->length));
+    valid (column, true);
+
+    m_frames.pop_back();
+    finished();
+}
+
+/******************************************************************************/
+
+template<typename T>
+void
+amqp::internal::stream::
+ColumnWriter::fixed (type_t type_, T value_) {
+    auto & column = next();
+
+    as (column, type_);
+    put (column.values, value_);
+    valid (column, true);
+
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::value (bool value_) {
+    auto & column = next();
+
+    as (column, bool_t);
+    setBit (column.values, column.length, value_);
+    valid (column, true);
+
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::value (int32_t value_) {
+    fixed (int_t, value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::value (int64_t value_) {
+    fixed (long_t, value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::value (double value_) {
+    fixed (double_t, value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::value (std::string_view value_) {
+    auto & column = next();
+
+    as (column, string_t);
+    column.data.append (value_);
+    column.offsets.push_back (offset (column.data.size()));
+    valid (column, true);
+
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::enumeration (std::string_view value_) {
+    value (value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::null() {
+    null (next());
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ColumnWriter::reference (size_t) {
+    throw std::runtime_error (
+        "References must be expanded before being written as columns");
+}
+
+/******************************************************************************/
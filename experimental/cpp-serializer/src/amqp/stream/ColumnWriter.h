@@ -0,0 +1,202 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <map>
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+
+#include "types.h"
+
+#include "amqp/reader/IVisitor.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ColumnWriter
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Shreds the values of many blobs, each a row, into a column per path
+     * through the data and writes them out in groups of rows. Intended for
+     * loading large numbers of blobs of the same type into something that
+     * would rather have them column by column.
+     *
+     * Each column's buffers are laid out as Apache Arrow lays out the
+     * equivalent array so they can be handed to Arrow as they are. All
+     * numbers are little endian.
+     *
+     *   file     : "CORDACOL" group* 0xffffffff 0x00000000
+     *   group    : 0xffffffff, u32 metadata size, metadata, body
+     *   metadata : u64 body size, u64 rows, u32 columns, column*
+     *              padded with zeros to a multiple of 8 bytes
+     *   column   : u16 name size, name, u8 type, u32 children,
+     *              u64 length, u64 nulls, u8 buffers, (u64 offset, u64 size)*
+     *
+     * Columns are listed depth first, each followed by its children. The
+     * root column, named "", has one value per row. Buffer offsets are
+     * from the start of the body and each buffer starts on a multiple of
+     * 8 bytes.
+     *
+     *   type          buffers                         children
+     *   0 null        -                               -
+     *   1 bool        validity, values (1 bit each)   -
+     *   2 int         validity, int32 values          -
+     *   3 long        validity, int64 values          -
+     *   4 double      validity, float64 values        -
+     *   5 string      validity, int32 offsets, utf8   -
+     *   6 struct      validity                        one per property
+     *   7 list        validity, int32 offsets         item
+     *   8 map         validity, int32 offsets         key, value
+     *
+     * Validity bitmaps have a bit per value, least significant first, set
+     * for values that aren't null. Offsets have one more entry than the
+     * column has values, the nth value being those between the nth and
+     * n+1th offset into its data or child columns. Enumerations are
+     * written as strings.
+     *
+     * A column's type is learnt from the first value that isn't null, a
+     * column that's only ever null is of type null. Columns first seen
+     * part way through a group are null in the rows before. Each group
+     * describes its own columns so a later group can know more of them,
+     * or know them better, than an earlier one.
+     */
+    class ColumnWriter : public amqp::reader::IVisitor {
+        public :
+            enum type_t {
+                null_t, bool_t, int_t, long_t, double_t, string_t,
+                struct_t, list_t, map_t
+            };
+
+        private :
+            struct Column {
+                std::string name;
+                type_t type { null_t };
+
+                size_t length { 0 };
+                size_t nulls { 0 };
+
+                std::vector<uint8_t> validity;
+
+                /**
+                 * fixed width values as raw bytes, or bools as bits
+                 */
+                std::string values;
+
+                std::vector<int32_t> offsets;
+
+                /**
+                 * the bytes of a string column's values
+                 */
+                std::string data;
+
+                std::vector<uPtr<Column>> children;
+                std::map<std::string, Column *> byName;
+
+                /**
+                 * where we were before the current row, so a row that
+                 * fails part way through can be undone
+                 */
+                size_t markLength { 0 };
+                size_t markNulls { 0 };
+            };
+
+            struct Frame {
+                Column * column;
+                size_t   written;
+            };
+
+            std::ostream & m_out;
+
+            const size_t m_groupSize;
+
+            Column m_root;
+
+            std::vector<Frame> m_frames;
+
+            /**
+             * set between naming a property and being told its value
+             */
+            Column * m_pending;
+
+            /**
+             * set once a row's begun until it's complete
+             */
+            bool m_started;
+
+            /**
+             * rows in the current group and in all
+             */
+            size_t m_rows;
+            size_t m_total;
+
+            Column & next();
+            Column & child (Column &, const std::string &);
+            void as (Column &, type_t);
+            void finished();
+
+            void flush();
+
+            static void valid (Column &, bool);
+            static void null (Column &);
+            static void mark (Column &);
+            static void truncate (Column &);
+            static void clear (Column &);
+
+            template<typename T>
+            void fixed (type_t, T);
+
+        public :
+            /**
+             * @param groupSize_ how many rows to hold before writing them out
+             */
+            explicit ColumnWriter (std::ostream &, size_t groupSize_ = 64 * 1024);
+
+            /**
+             * Forget whatever has been written of the current row, for when
+             * a blob couldn't be decoded in its entirety
+             */
+            void discard();
+
+            /**
+             * Write out any rows still held and mark the end of the file.
+             * Nothing more may be written afterwards.
+             */
+            void close();
+
+            /**
+             * Rows written so far, both those written out and those held
+             */
+            size_t rows() const;
+
+            void property (const std::string &) override;
+
+            void beginComposite (const std::string &, size_t) override;
+            void endComposite() override;
+
+            void beginList (size_t) override;
+            void endList() override;
+
+            void beginMap (size_t) override;
+            void endMap() override;
+
+            void value (bool) override;
+            void value (int32_t) override;
+            void value (int64_t) override;
+            void value (double) override;
+            void value (std::string_view) override;
+
+            void enumeration (std::string_view) override;
+
+            void null() override;
+
+            void reference (size_t) override;
+    };
+
+}
+
+/******************************************************************************/
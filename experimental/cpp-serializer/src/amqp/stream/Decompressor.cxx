@@ -0,0 +1,100 @@
+#include "Decompressor.h"
+
+#include <istream>
+#include <stdexcept>
+
+#include "DeflateDecompressor.h"
+#include "SnappyDecompressor.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Decompressor
+ *
+ ******************************************************************************/
+
+std::unique_ptr<amqp::internal::stream::Decompressor>
+amqp::internal::stream::
+Decompressor::make (int encoding_) {
+    switch (encoding_) {
+        case amqp::DEFLATE :
+            return std::make_unique<DeflateDecompressor>();
+        case amqp::SNAPPY :
+            return std::make_unique<SnappyDecompressor>();
+        default :
+            throw std::runtime_error (
+                "Unknown encoding " + std::to_string (encoding_));
+    }
+}
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * Pull everything the decompressor can give us from what it's been
+     * given so far
+     */
+    void
+    drain (
+        amqp::internal::stream::Decompressor & decompressor_,
+        std::vector<char> & out_
+    ) {
+        const size_t chunk { 64 * 1024 };
+
+        for (size_t n ; ; ) {
+            auto size = out_.size();
+            out_.resize (size + chunk);
+
+            n = decompressor_.output (out_.data() + size, chunk);
+            out_.resize (size + n);
+
+            if (!n) {
+                break;
+            }
+        }
+    }
+
+}
+
+/******************************************************************************/
+
+std::vector<char>
+amqp::internal::stream::
+Decompressor::inflate (std::istream & in_, int encoding_) {
+    auto decompressor = make (encoding_);
+
+    std::vector<char> in (64 * 1024);
+    std::vector<char> rtn;
+
+    while (!decompressor->finished()) {
+        auto got = in_.read (in.data(), in.size()).gcount();
+
+        if (!got) {
+            break;
+        }
+
+        decompressor->input (in.data(), got);
+
+        drain (*decompressor, rtn);
+    }
+
+    return rtn;
+}
+
+/******************************************************************************/
+
+std::vector<char>
+amqp::internal::stream::
+Decompressor::inflate (const char * in_, size_t size_, int encoding_) {
+    auto decompressor = make (encoding_);
+
+    std::vector<char> rtn;
+
+    decompressor->input (in_, size_);
+
+    drain (*decompressor, rtn);
+
+    return rtn;
+}
+
+/******************************************************************************/
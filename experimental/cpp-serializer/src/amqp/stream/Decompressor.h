@@ -0,0 +1,58 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <iosfwd>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include "amqp/AMQPSectionId.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Decompressor
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Corda can compress everything following an ENCODING section. This
+     * undoes that a piece at a time, modelled on zlib's own interface: hand
+     * over some compressed input then repeatedly ask for output until none
+     * is forthcoming, at which point it wants more input.
+     *
+     * Input handed over must remain valid until it's been drained.
+     */
+    class Decompressor {
+        public :
+            static std::unique_ptr<Decompressor> make (int);
+
+            /**
+             * Inflate everything left in the stream into memory, for the
+             * places that need the entire blob anyway
+             */
+            static std::vector<char> inflate (std::istream &, int);
+            static std::vector<char> inflate (const char *, size_t, int);
+
+            virtual ~Decompressor() = default;
+
+            virtual void input (const char *, size_t) = 0;
+
+            /**
+             * @return how much of the buffer was filled, 0 meaning we need
+             * more input or the stream has ended
+             */
+            virtual size_t output (char *, size_t) = 0;
+
+            /**
+             * True if the compressed stream has an explicit end and we've
+             * reached it
+             */
+            virtual bool finished() const = 0;
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,79 @@
+#include "DeflateDecompressor.h"
+
+#include <stdexcept>
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::DeflateDecompressor
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+DeflateDecompressor::DeflateDecompressor()
+    : m_stream { }
+    , m_finished (false)
+{
+    if (inflateInit (&m_stream) != Z_OK) {
+        throw std::runtime_error ("Failed to initialise zlib");
+    }
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::
+DeflateDecompressor::~DeflateDecompressor() {
+    inflateEnd (&m_stream);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+DeflateDecompressor::input (const char * data_, size_t size_) {
+    if (m_stream.avail_in) {
+        throw std::logic_error ("Previous input has not been consumed");
+    }
+
+    m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data_));
+    m_stream.avail_in = size_;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+DeflateDecompressor::output (char * data_, size_t size_) {
+    if (m_finished) {
+        return 0;
+    }
+
+    m_stream.next_out = reinterpret_cast<Bytef *>(data_);
+    m_stream.avail_out = size_;
+
+    switch (::inflate (&m_stream, Z_NO_FLUSH)) {
+        case Z_STREAM_END :
+            m_finished = true;
+            // anything after the end of the stream isn't ours
+            m_stream.avail_in = 0;
+            break;
+        case Z_OK :
+        case Z_BUF_ERROR :
+            break;
+        default :
+            throw std::runtime_error (
+                std::string ("Corrupt deflate stream: ")
+                    + (m_stream.msg ? m_stream.msg : "unknown error"));
+    }
+
+    return size_ - m_stream.avail_out;
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+DeflateDecompressor::finished() const {
+    return m_finished;
+}
+
+/******************************************************************************/
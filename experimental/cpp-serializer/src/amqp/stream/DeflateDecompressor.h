@@ -0,0 +1,40 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <zlib.h>
+
+#include "Decompressor.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::DeflateDecompressor
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * The JVM's DeflaterOutputStream, which is what Corda uses, writes
+     * zlib wrapped deflate
+     */
+    class DeflateDecompressor : public Decompressor {
+        private :
+            z_stream m_stream;
+            bool m_finished;
+
+        public :
+            DeflateDecompressor();
+            ~DeflateDecompressor() override;
+
+            DeflateDecompressor (const DeflateDecompressor &) = delete;
+            DeflateDecompressor & operator = (const DeflateDecompressor &) = delete;
+
+            void input (const char *, size_t) override;
+            size_t output (char *, size_t) override;
+            bool finished() const override;
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,196 @@
+#include "EnvelopeScanner.h"
+
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#include "amqp/DecodeError.h"
+
+#include "amqp/schema/Descriptors.h"
+#include "amqp/schema/descriptors/AMQPDescriptorRegistory.h"
+
+/******************************************************************************/
+
+namespace {
+
+    bool
+    compound (const amqp::internal::stream::Token & token_) {
+        switch (token_.type) {
+            case PN_DESCRIBED :
+            case PN_LIST :
+            case PN_MAP :
+            case PN_ARRAY :
+                return true;
+            default :
+                return false;
+        }
+    }
+
+    [[noreturn]] void
+    malformed (const std::string & what_, size_t offset_) {
+        throw amqp::internal::DecodeError ("Malformed envelope, " + what_, offset_);
+    }
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::EnvelopeScanner
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+EnvelopeScanner::EnvelopeScanner()
+    : m_sections { }
+    , m_depth (0)
+    , m_section (0)
+    , m_element (0)
+{
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+EnvelopeScanner::reset() {
+    std::fill (std::begin (m_sections), std::end (m_sections), Section { });
+
+    m_depth = 0;
+    m_section = 0;
+    m_element = 0;
+    m_descriptor.clear();
+}
+
+/******************************************************************************/
+
+/**
+ * depth 0 - the described envelope itself
+ * depth 1 - its descriptor and then the list of sections
+ * depth 2 - each section, itself a described type
+ * depth 3 - a section's descriptor and body
+ */
+amqp::internal::stream::ITokenHandler::Action
+amqp::internal::stream::
+EnvelopeScanner::token (const Token & token_) {
+    auto action = next_a;
+
+    if (token_.end) {
+        if (m_section == data_s && m_depth > 2) {
+            action = data (token_);
+        }
+
+        if (--m_depth == 2) {
+            if (m_section < sections_s) {
+                m_sections[m_section].end = token_.offset;
+            }
+            ++m_section;
+        }
+
+        return m_depth == 0 ? stop_a : action;
+    }
+
+    switch (m_depth) {
+        case 0 :
+            if (token_.type != PN_DESCRIBED) {
+                malformed ("expected a described type", token_.offset);
+            }
+            break;
+        case 1 :
+            if (token_.type == PN_ULONG) {
+                if (amqp::stripCorda (token_.value.ul) !=
+                        static_cast<uint32_t>(amqp::schema::descriptors::ENVELOPE)) {
+                    malformed ("not an envelope", token_.offset);
+                }
+            } else if (token_.type != PN_LIST) {
+                malformed ("expected a list of sections", token_.offset);
+            }
+            break;
+        case 2 :
+            if (token_.type != PN_DESCRIBED) {
+                malformed ("expected a described section", token_.offset);
+            }
+            if (m_section < sections_s) {
+                m_sections[m_section].begin = token_.offset;
+            }
+            m_element = 0;
+            break;
+        case 3 :
+            if (m_element++ == 0) {
+                if (m_section == data_s) {
+                    if (token_.type != PN_SYMBOL) {
+                        malformed ("data has no descriptor", token_.offset);
+                    }
+                    m_descriptor.assign (token_.bytes, token_.size);
+                }
+            } else if (m_section != data_s && compound (token_)) {
+                return skip_a;
+            }
+            break;
+        default :
+            break;
+    }
+
+    if (m_section == data_s && m_depth > 1) {
+        action = data (token_);
+    }
+
+    if (compound (token_) && action != skip_a) {
+        ++m_depth;
+    }
+
+    return action;
+}
+
+/******************************************************************************/
+
+/**
+ * By default we're not interested in the data itself, only where it is
+ */
+amqp::internal::stream::ITokenHandler::Action
+amqp::internal::stream::
+EnvelopeScanner::data (const Token & token_) {
+    return (m_depth == 3 && compound (token_)) ? skip_a : next_a;
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+EnvelopeScanner::complete() const {
+    return m_depth == 0 && m_section >= schema_s + 1;
+}
+
+/******************************************************************************/
+
+const std::string &
+amqp::internal::stream::
+EnvelopeScanner::descriptor() const {
+    return m_descriptor;
+}
+
+/******************************************************************************/
+
+const amqp::internal::stream::EnvelopeScanner::Section &
+amqp::internal::stream::
+EnvelopeScanner::data() const {
+    return m_sections[data_s];
+}
+
+/******************************************************************************/
+
+const amqp::internal::stream::EnvelopeScanner::Section &
+amqp::internal::stream::
+EnvelopeScanner::schema() const {
+    return m_sections[schema_s];
+}
+
+/******************************************************************************/
+
+const amqp::internal::stream::EnvelopeScanner::Section &
+amqp::internal::stream::
+EnvelopeScanner::transforms() const {
+    return m_sections[transforms_s];
+}
+
+/******************************************************************************/
@@ -0,0 +1,92 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <cstddef>
+
+#include "Tokeniser.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::EnvelopeScanner
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * A Corda envelope is a described list of three things, the data, the
+     * schema describing that data, and any evolution transforms. Annoyingly
+     * for anyone wanting to stream the data it comes first.
+     *
+     * Feeding an envelope through a [Tokeniser] with one of these attached
+     * notes where each of those sections lives without looking inside any
+     * of them, their bodies are skipped by size. Once we know where the
+     * schema is we can go and load just that before coming back to the
+     * data.
+     *
+     * Everything within the data section, including the described type
+     * that wraps it, is passed through [data] which can be overridden by
+     * anything that wants to do more than just skip it.
+     */
+    class EnvelopeScanner : public ITokenHandler {
+        public :
+            struct Section {
+                size_t begin;
+                size_t end;
+
+                size_t size() const { return end - begin; }
+            };
+
+        protected :
+            enum { data_s, schema_s, transforms_s, sections_s };
+
+            virtual Action data (const Token &);
+
+            size_t depth() const { return m_depth; }
+
+            /**
+             * How many sections have been seen in their entirety
+             */
+            size_t sections() const { return m_section; }
+
+        private :
+            Section m_sections[sections_s];
+
+            size_t m_depth;
+            size_t m_section;
+            size_t m_element;
+
+            /**
+             * The descriptor of the top level type serialised in the
+             * blob, this is what tells us which reader to start with
+             */
+            std::string m_descriptor;
+
+        public :
+            EnvelopeScanner();
+            ~EnvelopeScanner() override = default;
+
+            Action token (const Token &) override;
+
+            /**
+             * Ready to scan another envelope
+             */
+            void reset();
+
+            /**
+             * True once the entire envelope has been seen
+             */
+            bool complete() const;
+
+            const std::string & descriptor() const;
+
+            const Section & data() const;
+            const Section & schema() const;
+            const Section & transforms() const;
+    };
+
+}
+
+/******************************************************************************/
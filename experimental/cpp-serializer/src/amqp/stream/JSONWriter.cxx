@@ -0,0 +1,221 @@
+#include "JSONWriter.h"
+
+#include <string>
+#include <ostream>
+
+#include "amqp/reader/Format.h"
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * Format straight into a buffer of our own rather than via a
+     * temporary string or the stream's locale aware conversions
+     */
+    template<typename T>
+    void
+    write (std::ostream & out_, T value_) {
+        char buffer[amqp::internal::reader::FORMAT_MAX];
+
+        out_.write (buffer, amqp::internal::reader::format (buffer, value_) - buffer);
+    }
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::JSONWriter
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+JSONWriter::JSONWriter (std::ostream & out_)
+    : m_out (out_)
+    , m_named (false)
+{
+}
+
+/******************************************************************************/
+
+/**
+ * Work out what, if anything, needs writing before the next value. Within
+ * a map keys and values alternate so every odd element is a value.
+ */
+void
+amqp::internal::stream::
+JSONWriter::separate() {
+    if (m_named) {
+        m_named = false;
+        return;
+    }
+
+    if (m_levels.empty()) {
+        return;
+    }
+
+    auto & level = m_levels.back();
+
+    if (level.type == map_l && (level.written % 2)) {
+        m_out << " : ";
+    } else if (level.written) {
+        m_out << ", ";
+    }
+
+    ++level.written;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::open (level_t type_, const char * open_) {
+    separate();
+    m_out << open_;
+    m_levels.push_back ({ type_, 0 });
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::close (const char * close_) {
+    m_out << close_;
+    m_levels.pop_back();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::property (const std::string & name_) {
+    separate();
+    m_out << name_ << " : ";
+    m_named = true;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::beginComposite (const std::string &, size_t) {
+    open (composite_l, "{ ");
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::endComposite() {
+    close (" }");
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::beginList (size_t) {
+    open (list_l, "[ ");
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::endList() {
+    close (" ]");
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::beginMap (size_t) {
+    open (map_l, "{ ");
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::endMap() {
+    close (" }");
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::value (bool value_) {
+    separate();
+    write (m_out, value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::value (int32_t value_) {
+    separate();
+    write (m_out, value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::value (int64_t value_) {
+    separate();
+    write (m_out, value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::value (double value_) {
+    separate();
+    write (m_out, value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::value (std::string_view value_) {
+    separate();
+
+    m_escaped.clear();
+    reader::quote (m_escaped, value_);
+
+    m_out.write (m_escaped.data(), m_escaped.size());
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::enumeration (std::string_view value_) {
+    separate();
+    m_out << value_;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::null() {
+    separate();
+    m_out << "null";
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+JSONWriter::reference (size_t index_) {
+    separate();
+    m_out << "{ $ref : " << index_ << " }";
+}
+
+/******************************************************************************/
@@ -0,0 +1,86 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#include "amqp/reader/IVisitor.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::JSONWriter
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Renders the values a decoder tells us about straight to an output
+     * stream in exactly the form [IValue::dump] would have produced had
+     * the whole tree been built first. Only the nesting is remembered.
+     */
+    class JSONWriter : public amqp::reader::IVisitor {
+        private :
+            enum level_t { composite_l, list_l, map_l };
+
+            struct Level {
+                level_t type;
+                size_t  written;
+            };
+
+            std::ostream & m_out;
+
+            std::vector<Level> m_levels;
+
+            /**
+             * set between naming a property and being told its value
+             */
+            bool m_named;
+
+            /**
+             * strings are escaped into here before being written, kept
+             * between values so it's only ever as big as the longest
+             */
+            std::string m_escaped;
+
+            void open (level_t, const char *);
+            void close (const char *);
+
+        protected :
+            /**
+             * Write whatever goes before the next value
+             */
+            void separate();
+
+        public :
+            explicit JSONWriter (std::ostream &);
+
+            void property (const std::string &) override;
+
+            void beginComposite (const std::string &, size_t) override;
+            void endComposite() override;
+
+            void beginList (size_t) override;
+            void endList() override;
+
+            void beginMap (size_t) override;
+            void endMap() override;
+
+            void value (bool) override;
+            void value (int32_t) override;
+            void value (int64_t) override;
+            void value (double) override;
+            void value (std::string_view) override;
+
+            void enumeration (std::string_view) override;
+
+            void null() override;
+
+            void reference (size_t) override;
+    };
+
+}
+
+/******************************************************************************/
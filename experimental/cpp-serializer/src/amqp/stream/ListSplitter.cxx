@@ -0,0 +1,446 @@
+#include "ListSplitter.h"
+
+#include <mutex>
+#include <limits>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <sstream>
+#include <optional>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <condition_variable>
+
+#include "types.h"
+
+#include "amqp/Limits.h"
+#include "amqp/DecodeError.h"
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * A chunk's objects are numbered from here so none can be mistaken
+     * for one of the blob's, every reference a chunk sees being passed
+     * on to its writer
+     */
+    const size_t DETACHED = std::numeric_limits<size_t>::max() / 2;
+
+    /**
+     * Chunks per worker, enough that one finishing early can take on
+     * some of what's left rather than sit waiting on the others
+     */
+    const size_t CHUNKS = 4;
+
+    /**
+     * The most of a list a single chunk takes on, however long the list
+     */
+    const size_t CHUNK = 1U << 20U;
+
+    /**
+     * Chunks per worker that may be decoded ahead of the one being
+     * written, bounding how much output is held at once
+     */
+    const size_t WINDOW = 2;
+
+    /**
+     * Renders a chunk, leaving a gap wherever there's a reference and
+     * noting what belongs there, it being filled in once we know how many
+     * objects preceded the chunk
+     */
+    class ChunkWriter : public amqp::internal::stream::JSONWriter {
+        private :
+            std::ostream & m_out;
+
+            const amqp::internal::stream::StreamDecoder * m_decoder;
+            const amqp::internal::stream::Tokeniser * m_tokeniser;
+
+        public :
+            struct Reference {
+                /**
+                 * where in the chunk's output it belongs
+                 */
+                size_t at;
+
+                size_t index;
+
+                /**
+                 * how many of the chunk's objects had been read
+                 */
+                size_t seen;
+
+                /**
+                 * where the tokeniser had got to
+                 */
+                size_t offset;
+            };
+
+            std::vector<Reference> references;
+
+            explicit ChunkWriter (std::ostream & out_)
+                : JSONWriter (out_)
+                , m_out (out_)
+                , m_decoder (nullptr)
+                , m_tokeniser (nullptr)
+            { }
+
+            void attach (
+                const amqp::internal::stream::StreamDecoder & decoder_,
+                const amqp::internal::stream::Tokeniser & tokeniser_
+            ) {
+                m_decoder = &decoder_;
+                m_tokeniser = &tokeniser_;
+            }
+
+            void reference (size_t index_) override {
+                separate();
+
+                references.push_back ({
+                    static_cast<size_t>(m_out.tellp()),
+                    index_,
+                    m_decoder->objects() - DETACHED,
+                    m_tokeniser->offset() });
+            }
+    };
+
+}
+
+/******************************************************************************/
+
+struct amqp::internal::stream::ListSplitter::Chunk {
+    size_t offset;
+    size_t size;
+    size_t count;
+
+    std::ostringstream out;
+    uPtr<ChunkWriter> writer;
+    uPtr<StreamDecoder> decoder;
+
+    /**
+     * of its worker's budget
+     */
+    size_t used { 0 };
+
+    /**
+     * set, along with [error] should it have failed, once a worker's
+     * done with it
+     */
+    bool done { false };
+    std::exception_ptr error;
+
+    Chunk (size_t offset_, size_t size_, size_t count_)
+        : offset (offset_)
+        , size (size_)
+        , count (count_)
+    { }
+};
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ListSplitter
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+ListSplitter::ListSplitter (
+    IListSource & source_,
+    const Tokeniser & tokeniser_,
+    const reader::Reader::SchemaType & schema_,
+    ObjectTable::refs_t refs_,
+    std::ostream & out_,
+    unsigned workers_,
+    size_t threshold_
+) : m_source (source_)
+  , m_tokeniser (tokeniser_)
+  , m_schema (schema_)
+  , m_refs (refs_)
+  , m_out (out_)
+  , m_workers (workers_)
+  , m_threshold (threshold_)
+  , m_lists (0)
+{
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+ListSplitter::split (
+    const reader::Reader & element_,
+    const Token & list_,
+    size_t depth_,
+    ObjectTable & objects_
+) {
+    if (m_workers < 2 || list_.count < 2 || list_.size < m_threshold) {
+        return false;
+    }
+
+    /*
+     * The tokeniser has just read the list's header so is waiting on
+     * its first element
+     */
+    auto begin = m_tokeniser.offset();
+    auto end = begin + list_.size;
+
+    uint8_t constructor = list_.type == PN_ARRAY ? list_.element : 0xff;
+
+    /*
+     * Find where each element begins, cutting a chunk whenever one's
+     * grown large enough. Anything wrong with the list is left for the
+     * decoder to find as it reads it.
+     */
+    std::string_view data;
+    std::vector<Chunk> chunks;
+
+    try {
+        data = m_source.list (begin, list_.size);
+
+        auto target = std::clamp (
+                list_.size / (m_workers * CHUNKS), size_t { 1 }, CHUNK);
+
+        size_t start { begin };
+        size_t offset { begin };
+        size_t count { 0 };
+
+        for (size_t i { 0 } ; i < list_.count ; ++i) {
+            offset += Tokeniser::span (
+                    data.data() + (offset - begin), end - offset, constructor);
+
+            ++count;
+
+            if (offset - start >= target || i + 1 == list_.count) {
+                chunks.emplace_back (start, offset - start, count);
+                start = offset;
+                count = 0;
+            }
+        }
+
+        if (offset != end) {
+            return false;
+        }
+    } catch (const std::exception &) {
+        return false;
+    }
+
+    if (chunks.size() < 2) {
+        return false;
+    }
+
+    ++m_lists;
+
+    auto workers = std::min (static_cast<size_t> (m_workers), chunks.size());
+
+    /*
+     * Each worker charges a budget of its own, sharing the blob's
+     * deadline, and starting as deep as the list's elements are
+     */
+    std::vector<Budget> budgets;
+
+    if (auto budget = Budget::current()) {
+        budgets.reserve (workers);
+
+        for (size_t i { 0 } ; i < workers ; ++i) {
+            budgets.emplace_back (*budget, depth_);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    size_t next { 0 };
+    size_t written { 0 };
+    bool stopped { false };
+
+    auto work = [&] (Budget * budget_) {
+        std::optional<Budget::Scope> scope;
+
+        if (budget_) {
+            scope.emplace (*budget_);
+        }
+
+        for ( ; ; ) {
+            Chunk * chunk;
+
+            {
+                std::unique_lock<std::mutex> lock (mutex);
+
+                changed.wait (lock, [&] {
+                    return stopped
+                        || next == chunks.size()
+                        || next < written + workers * WINDOW;
+                });
+
+                if (stopped || next == chunks.size()) {
+                    return;
+                }
+
+                chunk = &chunks[next++];
+            }
+
+            uPtr<Tokeniser> tokeniser;
+
+            try {
+                auto used = budget_ ? budget_->used() : 0;
+
+                /*
+                 * The writer's told it's within a list, then what it
+                 * wrote to open it thrown away, so it separates the
+                 * elements as it would within the real one
+                 */
+                chunk->writer = std::make_unique<ChunkWriter> (chunk->out);
+                chunk->writer->beginList (chunk->count);
+                chunk->out.str ("");
+
+                chunk->decoder = std::make_unique<StreamDecoder> (
+                        element_, m_schema, *chunk->writer, m_refs, DETACHED, chunk->count);
+
+                tokeniser = std::make_unique<Tokeniser> (*chunk->decoder, chunk->offset);
+
+                chunk->writer->attach (*chunk->decoder, *tokeniser);
+
+                if (constructor != 0xff) {
+                    tokeniser->elements (constructor);
+                }
+
+                auto fed = tokeniser->feed (data.data() + (chunk->offset - begin), chunk->size);
+
+                if (fed != chunk->size || !chunk->decoder->done() || !tokeniser->complete()) {
+                    throw std::runtime_error ("Chunk didn't end with its last element");
+                }
+
+                chunk->used = budget_ ? budget_->used() - used : 0;
+            } catch (DecodeError & e) {
+                e.at (tokeniser ? tokeniser->offset() : chunk->offset);
+                chunk->error = std::current_exception();
+            } catch (const std::exception & e) {
+                chunk->error = std::make_exception_ptr (DecodeError (
+                        e.what(), tokeniser ? tokeniser->offset() : chunk->offset));
+            }
+
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                chunk->done = true;
+            }
+
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    auto stop = [&] {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            stopped = true;
+        }
+
+        changed.notify_all();
+
+        for (auto & thread : threads) {
+            thread.join();
+        }
+    };
+
+    /*
+     * We write each chunk as soon as it, and those before it, are done
+     */
+    try {
+        for (size_t i { 0 } ; i < workers ; ++i) {
+            threads.emplace_back (work, budgets.empty() ? nullptr : &budgets[i]);
+        }
+
+        JSONWriter expander (m_out);
+
+        for (size_t i { 0 } ; i < chunks.size() ; ++i) {
+            auto & chunk = chunks[i];
+
+            {
+                std::unique_lock<std::mutex> lock (mutex);
+                changed.wait (lock, [&] { return chunk.done; });
+            }
+
+            if (chunk.error) {
+                std::rethrow_exception (chunk.error);
+            }
+
+            if (i) {
+                m_out << ", ";
+            }
+
+            write (chunk, objects_, expander);
+
+            chunk.out = std::ostringstream();
+            chunk.writer.reset();
+            chunk.decoder.reset();
+
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                ++written;
+            }
+
+            changed.notify_all();
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+
+    stop();
+
+    return true;
+}
+
+/******************************************************************************/
+
+/**
+ * Hand the chunk's objects on to [objects_] and write what it rendered,
+ * filling in its references as we go now we know how many objects
+ * preceded it
+ */
+void
+amqp::internal::stream::
+ListSplitter::write (
+    Chunk & chunk_,
+    ObjectTable & objects_,
+    JSONWriter & expander_
+) const {
+    auto base = objects_.size();
+
+    objects_.append (chunk_.decoder->table());
+
+    try {
+        Budget::output (chunk_.used);
+    } catch (DecodeError & e) {
+        e.at (chunk_.offset);
+        throw;
+    }
+
+    auto text = chunk_.out.str();
+
+    size_t from { 0 };
+
+    for (const auto & reference : chunk_.writer->references) {
+        m_out.write (text.data() + from, reference.at - from);
+        from = reference.at;
+
+        if (reference.index >= base + reference.seen) {
+            std::stringstream ss;
+            ss << "Reference to object " << reference.index << " but only "
+               << base + reference.seen << " have been read";
+            throw DecodeError (ss.str(), reference.offset);
+        }
+
+        try {
+            objects_.expand (reference.index, expander_);
+        } catch (DecodeError & e) {
+            e.at (reference.offset);
+            throw;
+        }
+    }
+
+    m_out.write (text.data() + from, text.size() - from);
+}
+
+/******************************************************************************/
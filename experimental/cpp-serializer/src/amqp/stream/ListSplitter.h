@@ -0,0 +1,118 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <iosfwd>
+#include <cstddef>
+#include <string_view>
+
+#include "Tokeniser.h"
+#include "JSONWriter.h"
+#include "ObjectTable.h"
+#include "StreamDecoder.h"
+
+#include "amqp/reader/Reader.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::IListSource
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Wherever the bytes the decoder's [Tokeniser] is being fed come from
+     */
+    class IListSource {
+        public :
+            virtual ~IListSource() = default;
+
+            /**
+             * The [size_] bytes from [begin_], counted as the tokeniser
+             * counts them, valid until the next call. Throws if they
+             * can't be had.
+             */
+            virtual std::string_view list (size_t begin_, size_t size_) = 0;
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ListSplitter
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Spreads the elements of a single huge list, or array, across several
+     * threads. The list's elements are stepped over using the sizes they
+     * were encoded with to find where each begins, that range cut into
+     * chunks and each chunk decoded by whichever thread is free, rendered
+     * as a [JSONWriter] would render it. Each chunk is written out as soon
+     * as those before it have been, the list looking just as it would had
+     * it been decoded one element at a time.
+     *
+     * Only lists of at least [threshold_] bytes are split, anything within
+     * a chunk, smaller lists included, being read as normal. A list that's
+     * split is fetched from [source_] in its entirety, so that's how much
+     * of the blob is held in memory at once, along with the output of the
+     * few chunks decoded ahead of the one being written. The decoder has
+     * to be writing through a [JSONWriter] to [out_].
+     *
+     * A chunk can't see the objects before it so it notes where each back
+     * reference it meets belongs in its output. They're checked, and when
+     * expanding references expanded, as the chunk is written, by which
+     * time everything before it has been handed to the decoder's
+     * [ObjectTable], and the chunk's own objects along with them. Should a
+     * chunk fail it's reported as the decoder would have reported it once
+     * the chunks before it have been written.
+     */
+    class ListSplitter : public ISplitter {
+        private :
+            struct Chunk;
+
+            IListSource & m_source;
+
+            const Tokeniser & m_tokeniser;
+            const reader::Reader::SchemaType & m_schema;
+            ObjectTable::refs_t m_refs;
+
+            std::ostream & m_out;
+
+            unsigned m_workers;
+            size_t m_threshold;
+
+            size_t m_lists;
+
+            void write (Chunk &, ObjectTable &, JSONWriter &) const;
+
+        public :
+            static constexpr size_t THRESHOLD = 1U << 20U;
+
+            ListSplitter (
+                IListSource & source_,
+                const Tokeniser &,
+                const reader::Reader::SchemaType &,
+                ObjectTable::refs_t,
+                std::ostream & out_,
+                unsigned workers_,
+                size_t threshold_ = THRESHOLD);
+
+            bool split (
+                const reader::Reader & element_,
+                const Token & list_,
+                size_t depth_,
+                ObjectTable & objects_) override;
+
+            /**
+             * How many lists have been split so far
+             */
+            size_t lists() const { return m_lists; }
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,297 @@
+#include "MsgPackWriter.h"
+
+#include <limits>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::MsgPackWriter
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+MsgPackWriter::MsgPackWriter (std::ostream & out_)
+    : m_out (out_)
+    , m_depth (0)
+{
+}
+
+/******************************************************************************/
+
+/**
+ * MessagePack is big endian throughout
+ */
+template<typename T>
+void
+amqp::internal::stream::
+MsgPackWriter::put (T value_) {
+    static_assert (std::is_unsigned<T>::value, "Only unsigned values are written");
+
+    for (auto i = sizeof (T) ; i-- ; ) {
+        m_buffer.push_back (static_cast<char> (value_ >> (i * 8)));
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * The header of an array or map, its fixed form having room for counts
+ * up to [fixMax_] and the 16 and 32 bit forms following [base_]
+ */
+void
+amqp::internal::stream::
+MsgPackWriter::header (size_t count_, uint8_t fix_, uint8_t fixMax_, uint8_t base_) {
+    if (count_ <= fixMax_) {
+        put<uint8_t> (fix_ | count_);
+    } else if (count_ <= std::numeric_limits<uint16_t>::max()) {
+        put<uint8_t> (base_);
+        put<uint16_t> (count_);
+    } else if (count_ <= std::numeric_limits<uint32_t>::max()) {
+        put<uint8_t> (base_ + 1);
+        put<uint32_t> (count_);
+    } else {
+        throw std::runtime_error ("Too many elements for MessagePack");
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::string (std::string_view value_) {
+    auto size = value_.size();
+
+    if (size < 32) {
+        put<uint8_t> (0xa0 | size);
+    } else if (size <= std::numeric_limits<uint8_t>::max()) {
+        put<uint8_t> (0xd9);
+        put<uint8_t> (size);
+    } else if (size <= std::numeric_limits<uint16_t>::max()) {
+        put<uint8_t> (0xda);
+        put<uint16_t> (size);
+    } else if (size <= std::numeric_limits<uint32_t>::max()) {
+        put<uint8_t> (0xdb);
+        put<uint32_t> (size);
+    } else {
+        throw std::runtime_error ("String too long for MessagePack");
+    }
+
+    m_buffer.append (value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::integer (int64_t value_) {
+    if (value_ >= 0) {
+        auto u = static_cast<uint64_t> (value_);
+
+        if (u < 0x80) {
+            put<uint8_t> (u);
+        } else if (u <= std::numeric_limits<uint8_t>::max()) {
+            put<uint8_t> (0xcc);
+            put<uint8_t> (u);
+        } else if (u <= std::numeric_limits<uint16_t>::max()) {
+            put<uint8_t> (0xcd);
+            put<uint16_t> (u);
+        } else if (u <= std::numeric_limits<uint32_t>::max()) {
+            put<uint8_t> (0xce);
+            put<uint32_t> (u);
+        } else {
+            put<uint8_t> (0xcf);
+            put<uint64_t> (u);
+        }
+    } else if (value_ >= -32) {
+        put<uint8_t> (static_cast<uint8_t> (value_));
+    } else if (value_ >= std::numeric_limits<int8_t>::min()) {
+        put<uint8_t> (0xd0);
+        put<uint8_t> (static_cast<uint8_t> (value_));
+    } else if (value_ >= std::numeric_limits<int16_t>::min()) {
+        put<uint8_t> (0xd1);
+        put<uint16_t> (static_cast<uint16_t> (value_));
+    } else if (value_ >= std::numeric_limits<int32_t>::min()) {
+        put<uint8_t> (0xd2);
+        put<uint32_t> (static_cast<uint32_t> (value_));
+    } else {
+        put<uint8_t> (0xd3);
+        put<uint64_t> (static_cast<uint64_t> (value_));
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * Once we're no longer within anything the value's complete
+ */
+void
+amqp::internal::stream::
+MsgPackWriter::finished() {
+    if (m_depth) {
+        return;
+    }
+
+    m_out.write (m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::discard() {
+    m_buffer.clear();
+    m_depth = 0;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::property (const std::string & name_) {
+    string (name_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::beginComposite (const std::string &, size_t fields_) {
+    header (fields_, 0x80, 15, 0xde);
+    ++m_depth;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::endComposite() {
+    --m_depth;
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::beginList (size_t size_) {
+    header (size_, 0x90, 15, 0xdc);
+    ++m_depth;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::endList() {
+    --m_depth;
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::beginMap (size_t size_) {
+    header (size_, 0x80, 15, 0xde);
+    ++m_depth;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::endMap() {
+    --m_depth;
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::value (bool value_) {
+    put<uint8_t> (value_ ? 0xc3 : 0xc2);
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::value (int32_t value_) {
+    integer (value_);
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::value (int64_t value_) {
+    integer (value_);
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::value (double value_) {
+    uint64_t bits;
+    std::memcpy (&bits, &value_, sizeof (bits));
+
+    put<uint8_t> (0xcb);
+    put<uint64_t> (bits);
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::value (std::string_view value_) {
+    string (value_);
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::enumeration (std::string_view value_) {
+    string (value_);
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::null() {
+    put<uint8_t> (0xc0);
+    finished();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+MsgPackWriter::reference (size_t index_) {
+    if (index_ <= std::numeric_limits<uint32_t>::max()) {
+        put<uint8_t> (0xd6);
+        put<uint8_t> (REFERENCE);
+        put<uint32_t> (index_);
+    } else {
+        put<uint8_t> (0xd7);
+        put<uint8_t> (REFERENCE);
+        put<uint64_t> (index_);
+    }
+
+    finished();
+}
+
+/******************************************************************************/
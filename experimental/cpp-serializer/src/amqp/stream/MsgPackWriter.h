@@ -0,0 +1,91 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <iosfwd>
+#include <cstdint>
+
+#include "amqp/reader/IVisitor.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::MsgPackWriter
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Writes the values a decoder tells us about as MessagePack rather than
+     * text, each blob becoming a single MessagePack value. Composites are
+     * maps keyed by their property names, lists are arrays and maps are
+     * maps. Enumerations are their constant's name as a string. Everything
+     * is written in its smallest form.
+     *
+     * A reference back to an earlier object, only seen when they're not
+     * being expanded, is the extension type [REFERENCE] holding the index
+     * of the object as a big endian unsigned integer of 4 bytes, or 8 for
+     * an index that won't fit in 4.
+     *
+     * Each value is held until it's complete before being written so a
+     * blob that can't be decoded in its entirety can be [discard]ed
+     * without leaving half a value behind.
+     */
+    class MsgPackWriter : public amqp::reader::IVisitor {
+        public :
+            static constexpr int8_t REFERENCE = 1;
+
+        private :
+            std::ostream & m_out;
+
+            std::string m_buffer;
+
+            /**
+             * how many containers we're within
+             */
+            size_t m_depth;
+
+            void header (size_t, uint8_t fix_, uint8_t fixMax_, uint8_t base_);
+            void string (std::string_view);
+            void integer (int64_t);
+            void finished();
+
+            template<typename T>
+            void put (T);
+
+        public :
+            explicit MsgPackWriter (std::ostream &);
+
+            /**
+             * Forget the value currently being written
+             */
+            void discard();
+
+            void property (const std::string &) override;
+
+            void beginComposite (const std::string &, size_t) override;
+            void endComposite() override;
+
+            void beginList (size_t) override;
+            void endList() override;
+
+            void beginMap (size_t) override;
+            void endMap() override;
+
+            void value (bool) override;
+            void value (int32_t) override;
+            void value (int64_t) override;
+            void value (double) override;
+            void value (std::string_view) override;
+
+            void enumeration (std::string_view) override;
+
+            void null() override;
+
+            void reference (size_t) override;
+    };
+
+}
+
+/******************************************************************************/
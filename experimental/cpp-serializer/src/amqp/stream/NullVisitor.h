@@ -0,0 +1,48 @@
+#pragma once
+
+/******************************************************************************/
+
+#include "amqp/reader/IVisitor.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::NullVisitor
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * For when we only care whether a blob can be decoded, not what's in
+     * it. All the checking happens in the decoder driving us, nothing
+     * it tells us about is kept or rendered.
+     */
+    class NullVisitor : public amqp::reader::IVisitor {
+        public :
+            void property (const std::string &) override { }
+
+            void beginComposite (const std::string &, size_t) override { }
+            void endComposite() override { }
+
+            void beginList (size_t) override { }
+            void endList() override { }
+
+            void beginMap (size_t) override { }
+            void endMap() override { }
+
+            void value (bool) override { }
+            void value (int32_t) override { }
+            void value (int64_t) override { }
+            void value (double) override { }
+            void value (std::string_view) override { }
+
+            void enumeration (std::string_view) override { }
+
+            void null() override { }
+
+            void reference (size_t) override { }
+    };
+
+}
+
+/******************************************************************************/
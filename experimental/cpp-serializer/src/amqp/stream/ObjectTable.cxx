@@ -0,0 +1,372 @@
+#include "ObjectTable.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "amqp/Limits.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ObjectTable
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+ObjectTable::ObjectTable (
+    amqp::reader::IVisitor & visitor_,
+    refs_t refs_,
+    size_t first_
+) : m_visitor (visitor_)
+  , m_refs (refs_)
+  , m_first (first_)
+  , m_count (first_)
+{
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::reset() {
+    m_events.clear();
+    m_strings.clear();
+    m_objects.clear();
+    m_open.clear();
+    m_count = m_first;
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+ObjectTable::recording() const {
+    return m_refs == expand_r;
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::ObjectTable::Event *
+amqp::internal::stream::
+ObjectTable::record (event_t type_) {
+    if (!recording()) {
+        return nullptr;
+    }
+
+    m_events.push_back ({ type_, { }, 0, 0, nullptr });
+
+    return &m_events.back();
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::ObjectTable::Event *
+amqp::internal::stream::
+ObjectTable::record (event_t type_, std::string_view value_) {
+    auto e = record (type_);
+
+    if (e) {
+        e->offset = m_strings.size();
+        e->size = value_.size();
+
+        m_strings.append (value_);
+    }
+
+    return e;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::begin() {
+    m_open.push_back (m_events.size());
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::end() {
+    if (recording()) {
+        m_objects.emplace_back (m_open.back(), m_events.size());
+    }
+
+    m_open.pop_back();
+    ++m_count;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+ObjectTable::size() const {
+    return m_count;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::append (const ObjectTable & other_) {
+    if (!other_.m_open.empty()) {
+        throw std::runtime_error ("Appending a table with objects still open");
+    }
+
+    if (recording()) {
+        auto events = m_events.size();
+        auto strings = m_strings.size();
+
+        for (auto e : other_.m_events) {
+            if (e.type == string_e || e.type == enumeration_e) {
+                e.offset += strings;
+            }
+
+            m_events.push_back (e);
+        }
+
+        m_strings.append (other_.m_strings);
+
+        for (const auto & object : other_.m_objects) {
+            m_objects.emplace_back (object.first + events, object.second + events);
+        }
+    }
+
+    m_count += other_.m_count - other_.m_first;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::expand (size_t index_, amqp::reader::IVisitor & visitor_) {
+    if (!recording() || index_ < m_first) {
+        visitor_.reference (index_);
+    } else {
+        replay (index_, visitor_);
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * Hand everything recorded for an object to the visitor again, expanding
+ * any references it contained as we go
+ */
+void
+amqp::internal::stream::
+ObjectTable::replay (size_t index_, amqp::reader::IVisitor & visitor_) {
+    Budget::Level level;
+
+    const auto & range = m_objects[index_ - m_first];
+
+    for (auto i = range.first ; i < range.second ; ++i) {
+        const auto & e = m_events[i];
+
+        /*
+         * Replaying is where a small blob can become an enormous amount
+         * of output, references to objects full of references
+         */
+        Budget::output ((e.type == string_e || e.type == enumeration_e) ? e.size : 8);
+
+        std::string_view str { m_strings.data() + e.offset, e.size };
+
+        switch (e.type) {
+            case property_e : visitor_.property (*e.name); break;
+            case beginComposite_e : visitor_.beginComposite (*e.name, e.value.n); break;
+            case endComposite_e : visitor_.endComposite(); break;
+            case beginList_e : visitor_.beginList (e.value.n); break;
+            case endList_e : visitor_.endList(); break;
+            case beginMap_e : visitor_.beginMap (e.value.n); break;
+            case endMap_e : visitor_.endMap(); break;
+            case bool_e : visitor_.value (e.value.b); break;
+            case int_e : visitor_.value (e.value.i); break;
+            case long_e : visitor_.value (e.value.l); break;
+            case double_e : visitor_.value (e.value.d); break;
+            case string_e : visitor_.value (str); break;
+            case enumeration_e : visitor_.enumeration (str); break;
+            case null_e : visitor_.null(); break;
+            case reference_e : expand (e.value.n, visitor_); break;
+        }
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::property (const std::string & name_) {
+    if (auto e = record (property_e)) {
+        e->name = &name_;
+    }
+
+    m_visitor.property (name_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::beginComposite (const std::string & name_, size_t fields_) {
+    if (auto e = record (beginComposite_e)) {
+        e->value.n = fields_;
+        e->name = &name_;
+    }
+
+    m_visitor.beginComposite (name_, fields_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::endComposite() {
+    record (endComposite_e);
+    m_visitor.endComposite();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::beginList (size_t size_) {
+    if (auto e = record (beginList_e)) {
+        e->value.n = size_;
+    }
+
+    m_visitor.beginList (size_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::endList() {
+    record (endList_e);
+    m_visitor.endList();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::beginMap (size_t size_) {
+    if (auto e = record (beginMap_e)) {
+        e->value.n = size_;
+    }
+
+    m_visitor.beginMap (size_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::endMap() {
+    record (endMap_e);
+    m_visitor.endMap();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::value (bool value_) {
+    if (auto e = record (bool_e)) {
+        e->value.b = value_;
+    }
+
+    Budget::output (8);
+    m_visitor.value (value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::value (int32_t value_) {
+    if (auto e = record (int_e)) {
+        e->value.i = value_;
+    }
+
+    Budget::output (8);
+    m_visitor.value (value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::value (int64_t value_) {
+    if (auto e = record (long_e)) {
+        e->value.l = value_;
+    }
+
+    Budget::output (8);
+    m_visitor.value (value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::value (double value_) {
+    if (auto e = record (double_e)) {
+        e->value.d = value_;
+    }
+
+    Budget::output (8);
+    m_visitor.value (value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::value (std::string_view value_) {
+    record (string_e, value_);
+    Budget::output (value_.size());
+    m_visitor.value (value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::enumeration (std::string_view value_) {
+    record (enumeration_e, value_);
+    Budget::output (value_.size());
+    m_visitor.enumeration (value_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::null() {
+    record (null_e);
+    Budget::output (8);
+    m_visitor.null();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+ObjectTable::reference (size_t index_) {
+    if (index_ >= m_count) {
+        std::stringstream ss;
+        ss << "Reference to object " << index_ << " but only "
+           << m_count << " have been read";
+        throw std::runtime_error (ss.str());
+    }
+
+    if (auto e = record (reference_e)) {
+        e->value.n = index_;
+
+        expand (index_, m_visitor);
+    } else {
+        m_visitor.reference (index_);
+    }
+}
+
+/******************************************************************************/
@@ -0,0 +1,177 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "amqp/reader/IVisitor.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ObjectTable
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * When Corda writes an object it's already written to the same blob it
+     * writes a REFERENCED_OBJECT instead, the index of the earlier object
+     * in the order they were completed. Everything bar primitives, nulls
+     * and the primitive properties of composites is an object for these
+     * purposes, strings included.
+     *
+     * This sits between a decoder and the visitor it's feeding, numbering
+     * objects as the decoder tells us where they begin and end. When
+     * expanding references everything passing through is recorded so a
+     * reference can be resolved by replaying the events of the object it
+     * refers to rather than decoding it again, the record itself holding
+     * only a marker for any references within it. Otherwise references are
+     * passed on to the visitor as they are and nothing is kept.
+     */
+    class ObjectTable : public amqp::reader::IVisitor {
+        public :
+            enum refs_t { expand_r, reference_r };
+
+        private :
+            enum event_t {
+                property_e,
+                beginComposite_e, endComposite_e,
+                beginList_e, endList_e,
+                beginMap_e, endMap_e,
+                bool_e, int_e, long_e, double_e, string_e,
+                enumeration_e, null_e, reference_e
+            };
+
+            struct Event {
+                event_t type;
+
+                union {
+                    bool     b;
+                    int32_t  i;
+                    int64_t  l;
+                    double   d;
+                    size_t   n;
+                } value;
+
+                /**
+                 * where in [m_strings] any string we were given was put
+                 */
+                size_t offset;
+                size_t size;
+
+                /**
+                 * Property names and composite types come from the
+                 * schema, which outlives us, so are kept by reference
+                 * rather than copied in and out of [m_strings]
+                 */
+                const std::string * name;
+            };
+
+            amqp::reader::IVisitor & m_visitor;
+
+            refs_t m_refs;
+
+            std::vector<Event> m_events;
+
+            std::string m_strings;
+
+            /**
+             * for each object, the range of [m_events] it spans
+             */
+            std::vector<std::pair<size_t, size_t>> m_objects;
+
+            /**
+             * where in [m_events] each of the objects still being read
+             * started
+             */
+            std::vector<size_t> m_open;
+
+            /**
+             * the index of the first object we'll see, non zero when
+             * reading a value from part way through a blob
+             */
+            size_t m_first;
+
+            size_t m_count;
+
+            bool recording() const;
+
+            /**
+             * @return the event recorded, null if we're not recording
+             */
+            Event * record (event_t);
+            Event * record (event_t, std::string_view);
+
+            void replay (size_t, amqp::reader::IVisitor &);
+
+        public :
+            ObjectTable (amqp::reader::IVisitor &, refs_t, size_t first_ = 0);
+
+            /**
+             * Forget every object, but not the memory they took up, ready
+             * for the next value
+             */
+            void reset();
+
+            /**
+             * Objects nest so every [begin] is matched by an [end], the
+             * object being given the next index on the latter
+             */
+            void begin();
+            void end();
+
+            /**
+             * How many objects have been completed, counting those before
+             * the first we saw
+             */
+            size_t size() const;
+
+            /**
+             * Take on every object another table saw, as if its events had
+             * come to us instead, its first object being our next. What it
+             * passed on to its visitor is not passed on to ours.
+             */
+            void append (const ObjectTable &);
+
+            /**
+             * Hand [visitor_] the object [index_] as a reference to it
+             * would have been handed to ours, without checking it's been
+             * read
+             */
+            void expand (size_t index_, amqp::reader::IVisitor & visitor_);
+
+            void property (const std::string &) override;
+
+            void beginComposite (const std::string &, size_t) override;
+            void endComposite() override;
+
+            void beginList (size_t) override;
+            void endList() override;
+
+            void beginMap (size_t) override;
+            void endMap() override;
+
+            void value (bool) override;
+            void value (int32_t) override;
+            void value (int64_t) override;
+            void value (double) override;
+            void value (std::string_view) override;
+
+            void enumeration (std::string_view) override;
+
+            void null() override;
+
+            /**
+             * Throws if the object referred to hasn't been read. One
+             * from before the first we saw can't be expanded so is passed
+             * on as a reference whatever we're doing.
+             */
+            void reference (size_t) override;
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,645 @@
+#include "OffsetIndex.h"
+
+#include <ostream>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <charconv>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "amqp/reader/CompositeReader.h"
+#include "amqp/reader/restricted-readers/ListReader.h"
+#include "amqp/reader/restricted-readers/ArrayReader.h"
+
+#include "amqp/schema/field-types/Field.h"
+#include "amqp/schema/described-types/Composite.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::OffsetIndexBuilder
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+OffsetIndexBuilder::OffsetIndexBuilder (amqp::reader::IVisitor & visitor_)
+    : m_visitor (visitor_)
+    , m_decoder (nullptr)
+    , m_pending (true)
+    , m_hidden (0)
+    , m_lists (0)
+    , m_last (PN_NULL)
+    , m_listCount (0)
+    , m_skip (0)
+{
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::attach (StreamDecoder & decoder_) {
+    m_decoder = &decoder_;
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::ITokenHandler::Action
+amqp::internal::stream::
+OffsetIndexBuilder::token (const Token & token_) {
+    if (!m_decoder) {
+        throw std::runtime_error ("No decoder to index");
+    }
+
+    /*
+     * Nothing begins with a closing token
+     */
+    if (!token_.end) {
+        if (m_skip) {
+            --m_skip;
+        } else if (m_pending) {
+            if (!m_hidden) {
+                offsets::Value value { token_.offset, m_decoder->objects() };
+
+                if (!m_lists) {
+                    m_entries[m_next].value = value;
+                } else if (m_lists == 1 && m_levels.back().type == list_l) {
+                    m_levels.back().elements.push_back (value);
+                }
+            }
+
+            m_pending = false;
+        }
+
+        m_last = token_.type;
+
+        if (token_.type == PN_LIST) {
+            m_listCount = token_.count;
+        }
+    }
+
+    return m_decoder->token (token_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::push (level_t type_, size_t count_, bool hidden_) {
+    m_levels.push_back ({ type_, m_next, 0, count_, hidden_, { } });
+
+    if (hidden_) {
+        ++m_hidden;
+    } else if (type_ == list_l) {
+        ++m_lists;
+    }
+
+    m_pending = false;
+
+    if (type_ != composite_l && count_) {
+        m_next = m_levels.back().path + "[0]";
+        m_pending = true;
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::pop() {
+    auto level = std::move (m_levels.back());
+    m_levels.pop_back();
+
+    if (level.hidden) {
+        --m_hidden;
+    } else if (level.type == list_l && !--m_lists && !m_hidden) {
+        m_entries[level.path].elements = std::move (level.elements);
+    }
+
+    done();
+}
+
+/******************************************************************************/
+
+/**
+ * A value's been read in its entirety, if it was an element of a list the
+ * next one is up
+ */
+void
+amqp::internal::stream::
+OffsetIndexBuilder::done() {
+    m_pending = false;
+
+    if (m_levels.empty() || m_levels.back().type == composite_l) {
+        return;
+    }
+
+    auto & level = m_levels.back();
+
+    if (++level.idx < level.count) {
+        m_next = level.path + "[" + std::to_string (level.idx) + "]";
+        m_pending = true;
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::property (const std::string & name_) {
+    m_visitor.property (name_);
+
+    if (!m_levels.empty()) {
+        const auto & path = m_levels.back().path;
+        m_next = path.empty() ? name_ : path + "." + name_;
+        m_pending = true;
+    }
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::beginComposite (const std::string & name_, size_t fields_) {
+    m_visitor.beginComposite (name_, fields_);
+    push (composite_l, fields_);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::endComposite() {
+    m_visitor.endComposite();
+    pop();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::beginList (size_t entries_) {
+    m_visitor.beginList (entries_);
+    push (list_l, entries_, m_last == PN_ARRAY);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::endList() {
+    m_visitor.endList();
+    pop();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::beginMap (size_t entries_) {
+    m_visitor.beginMap (entries_);
+    push (map_l, entries_ * 2, true);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::endMap() {
+    m_visitor.endMap();
+    pop();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::value (bool value_) {
+    m_visitor.value (value_);
+    done();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::value (int32_t value_) {
+    m_visitor.value (value_);
+    done();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::value (int64_t value_) {
+    m_visitor.value (value_);
+    done();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::value (double value_) {
+    m_visitor.value (value_);
+    done();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::value (std::string_view value_) {
+    m_visitor.value (value_);
+    done();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::enumeration (std::string_view value_) {
+    m_visitor.enumeration (value_);
+
+    /*
+     * Unless it's a reference to an enum being expanded
+     */
+    if (m_last == PN_STRING || m_last == PN_SYMBOL) {
+        m_skip = m_listCount ? m_listCount - 1 : 0;
+    }
+
+    done();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::null() {
+    m_visitor.null();
+    done();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::reference (size_t index_) {
+    m_visitor.reference (index_);
+    done();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+OffsetIndexBuilder::write (
+    std::ostream & out_,
+    const EnvelopeScanner & scanner_,
+    uint64_t blobSize_
+) const {
+    uint64_t total { 0 };
+
+    for (const auto & [ path, entry ] : m_entries) {
+        total += entry.elements.size();
+    }
+
+    offsets::Header header { };
+
+    std::memcpy (header.magic, offsets::MAGIC, sizeof (header.magic));
+    header.version = offsets::VERSION;
+    header.orderMark = offsets::ORDER_MARK;
+
+    header.blobSize = blobSize_;
+    header.dataBegin = scanner_.data().begin;
+    header.dataEnd = scanner_.data().end;
+    header.schemaBegin = scanner_.schema().begin;
+    header.schemaEnd = scanner_.schema().end;
+
+    header.entries = m_entries.size();
+    header.entriesAt = sizeof (offsets::Header);
+
+    header.elements = total;
+    header.elementsAt = header.entriesAt + header.entries * sizeof (offsets::Entry);
+
+    header.stringsAt = header.elementsAt + total * sizeof (offsets::Value);
+
+    std::string strings;
+
+    auto intern = [&](const std::string & str_) {
+        offsets::String rtn { header.stringsAt + strings.size(), str_.size() };
+        strings += str_;
+        return rtn;
+    };
+
+    header.descriptor = intern (scanner_.descriptor());
+
+    std::vector<offsets::Entry> entries;
+    std::vector<offsets::Value> elements;
+
+    entries.reserve (m_entries.size());
+    elements.reserve (total);
+
+    for (const auto & [ path, entry ] : m_entries) {
+        entries.push_back ({
+            intern (path), entry.value, entry.elements.size(), elements.size() });
+
+        elements.insert (elements.end(), entry.elements.begin(), entry.elements.end());
+    }
+
+    header.stringsSize = strings.size();
+
+    auto write = [&](const void * data_, size_t size_) {
+        out_.write (static_cast<const char *>(data_), size_);
+    };
+
+    write (&header, sizeof (header));
+    write (entries.data(), entries.size() * sizeof (offsets::Entry));
+    write (elements.data(), elements.size() * sizeof (offsets::Value));
+    write (strings.data(), strings.size());
+
+    if (!out_) {
+        throw std::runtime_error ("Failed to write the index");
+    }
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::OffsetIndex
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+OffsetIndex::OffsetIndex (const std::string & file_)
+    : m_base (nullptr)
+    , m_size (0)
+    , m_header (nullptr)
+{
+    int fd = open (file_.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        throw std::runtime_error ("Can't open " + file_);
+    }
+
+    struct stat results { };
+
+    if (fstat (fd, &results) != 0
+        || static_cast<size_t>(results.st_size) < sizeof (offsets::Header))
+    {
+        close (fd);
+        throw std::runtime_error ("Not an index: " + file_);
+    }
+
+    m_size = results.st_size;
+
+    auto base = mmap (nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close (fd);
+
+    if (base == MAP_FAILED) {
+        throw std::runtime_error ("Can't map " + file_);
+    }
+
+    m_base = static_cast<const char *>(base);
+    m_header = reinterpret_cast<const offsets::Header *>(m_base);
+
+    try {
+        if (std::memcmp (m_header->magic, offsets::MAGIC, sizeof (offsets::MAGIC)) != 0) {
+            throw std::runtime_error ("Not an index: " + file_);
+        }
+
+        if (m_header->version != offsets::VERSION
+            || m_header->orderMark != offsets::ORDER_MARK)
+        {
+            throw std::runtime_error ("Unsupported index: " + file_);
+        }
+
+        array<offsets::Entry> (m_header->entriesAt, m_header->entries);
+        array<offsets::Value> (m_header->elementsAt, m_header->elements);
+        array<char> (m_header->stringsAt, m_header->stringsSize);
+        view (m_header->descriptor);
+    } catch (...) {
+        munmap (const_cast<char *>(m_base), m_size);
+        throw;
+    }
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::
+OffsetIndex::~OffsetIndex() {
+    munmap (const_cast<char *>(m_base), m_size);
+}
+
+/******************************************************************************/
+
+template<typename T>
+const T *
+amqp::internal::stream::
+OffsetIndex::array (uint64_t at_, uint64_t count_) const {
+    if (at_ % alignof (T) || at_ > m_size || count_ > (m_size - at_) / sizeof (T)) {
+        throw std::runtime_error ("Truncated index");
+    }
+
+    return reinterpret_cast<const T *>(m_base + at_);
+}
+
+/******************************************************************************/
+
+std::string_view
+amqp::internal::stream::
+OffsetIndex::view (const offsets::String & str_) const {
+    return { array<char> (str_.offset, str_.size), str_.size };
+}
+
+/******************************************************************************/
+
+std::string_view
+amqp::internal::stream::
+OffsetIndex::descriptor() const {
+    return view (m_header->descriptor);
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+OffsetIndex::entries() const {
+    return m_header->entries;
+}
+
+/******************************************************************************/
+
+const amqp::internal::stream::offsets::Entry *
+amqp::internal::stream::
+OffsetIndex::entry (std::string_view path_) const {
+    auto begin = array<offsets::Entry> (m_header->entriesAt, m_header->entries);
+    auto end = begin + m_header->entries;
+
+    auto it = std::lower_bound (begin, end, path_,
+        [this](const offsets::Entry & entry_, std::string_view path_) {
+            return view (entry_.path) < path_;
+        });
+
+    if (it == end || view (it->path) != path_) {
+        return nullptr;
+    }
+
+    return it;
+}
+
+/******************************************************************************/
+
+std::optional<amqp::internal::stream::offsets::Value>
+amqp::internal::stream::
+OffsetIndex::element (std::string_view path_) const {
+    auto open = path_.rfind ('[');
+
+    if (path_.empty() || path_.back() != ']' || open == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    uint64_t idx { 0 };
+    auto digits = path_.substr (open + 1, path_.size() - open - 2);
+    auto [ ptr, ec ] = std::from_chars (
+            digits.data(), digits.data() + digits.size(), idx);
+
+    if (digits.empty() || ec != std::errc() || ptr != digits.data() + digits.size()) {
+        return std::nullopt;
+    }
+
+    auto list = entry (path_.substr (0, open));
+
+    if (!list || idx >= list->elements) {
+        return std::nullopt;
+    }
+
+    if (list->elementsAt > m_header->elements
+        || list->elements > m_header->elements - list->elementsAt)
+    {
+        throw std::runtime_error ("Corrupt index");
+    }
+
+    return array<offsets::Value> (m_header->elementsAt, m_header->elements)
+            [list->elementsAt + idx];
+}
+
+/******************************************************************************/
+
+/**
+ * Try the whole path, then ever shorter prefixes of it ending at a
+ * property or an element, until one was indexed. An element out of range
+ * of a list whose elements were indexed isn't there at all.
+ */
+std::optional<amqp::internal::stream::OffsetIndex::Found>
+amqp::internal::stream::
+OffsetIndex::find (std::string_view path_) const {
+    for (auto end = path_.size() ; ; ) {
+        auto prefix = path_.substr (0, end);
+
+        if (auto e = entry (prefix)) {
+            return Found { e->value, end };
+        }
+
+        if (auto e = element (prefix)) {
+            return Found { *e, end };
+        }
+
+        /*
+         * Past the end of a list whose elements we have, there's no point
+         * decoding all of them to find that out
+         */
+        auto open = prefix.rfind ('[');
+
+        if (!prefix.empty() && prefix.back() == ']' && open != std::string_view::npos) {
+            auto list = entry (prefix.substr (0, open));
+
+            if (list && list->elements) {
+                return std::nullopt;
+            }
+        }
+
+        if (!end) {
+            return std::nullopt;
+        }
+
+        end = path_.find_last_of (".[", end - 1);
+
+        if (end == std::string_view::npos) {
+            end = 0;
+        }
+    }
+}
+
+/******************************************************************************/
+
+const amqp::internal::reader::Reader &
+amqp::internal::stream::
+OffsetIndex::resolve (
+    const reader::Reader & root_,
+    const reader::Reader::SchemaType & schema_,
+    std::string_view path_
+) {
+    const reader::Reader * reader = &root_;
+
+    for (size_t i { 0 } ; i < path_.size() ; ) {
+        if (path_[i] == '[') {
+            auto close = path_.find (']', i);
+
+            if (close == std::string_view::npos) {
+                throw std::runtime_error ("Bad path " + std::string (path_));
+            }
+
+            if (auto l = dynamic_cast<const reader::ListReader *>(reader)) {
+                reader = l->reader().lock().get();
+            } else if (auto a = dynamic_cast<const reader::ArrayReader *>(reader)) {
+                reader = a->reader().lock().get();
+            } else {
+                throw std::runtime_error (reader->type() + " isn't a list");
+            }
+
+            i = close + 1;
+        } else {
+            if (path_[i] == '.') {
+                ++i;
+            }
+
+            auto end = std::min (path_.find_first_of (".[", i), path_.size());
+            auto name = std::string (path_.substr (i, end - i));
+
+            auto c = dynamic_cast<const reader::CompositeReader *>(reader);
+
+            if (!c) {
+                throw std::runtime_error (reader->type() + " has no property " + name);
+            }
+
+            const auto & composite = dynamic_cast<const schema::Composite &>(
+                    *(schema_.fromType (c->type())->second.get()));
+
+            const auto & fields = composite.fields();
+
+            auto field = std::find_if (fields.begin(), fields.end(),
+                [&name](const auto & field_) { return field_->name() == name; });
+
+            if (field == fields.end() || fields.size() != c->readers().size()) {
+                throw std::runtime_error (c->type() + " has no property " + name);
+            }
+
+            reader = c->readers()[field - fields.begin()].lock().get();
+
+            i = end;
+        }
+
+        if (!reader) {
+            throw std::runtime_error ("null reader");
+        }
+    }
+
+    return *reader;
+}
+
+/******************************************************************************/
@@ -0,0 +1,302 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <map>
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "Tokeniser.h"
+#include "StreamDecoder.h"
+#include "EnvelopeScanner.h"
+
+#include "amqp/reader/IVisitor.h"
+#include "amqp/reader/Reader.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::offsets
+ *
+ ******************************************************************************/
+
+/**
+ * The layout of an offset index, a sidecar to a single blob recording
+ * where in its envelope each value of its data begins. Like a catalog
+ * it's written as the structures are laid out in memory.
+ *
+ *      Header
+ *      Entry[entries]  sorted by path
+ *      Value[]         the elements of every list not within another
+ *      char[]          the bytes of every string
+ *
+ * A value is found by its path, the names of the properties leading to it
+ * separated by dots with list elements as [n], the path of the value
+ * itself being empty. To keep the index of a long list small its elements
+ * are kept with it rather than each having an entry of its own, and
+ * nothing within an element is indexed, anything there being found by
+ * decoding the element. Nor is anything within a map or an array, the
+ * former having nothing to name them by and the elements of the latter
+ * sharing a constructor so being undecodable alone, though the map or
+ * array itself is.
+ *
+ * Offsets within the blob are from the start of the envelope, all other
+ * offsets from the start of the index.
+ */
+namespace amqp::internal::stream::offsets {
+
+    constexpr char MAGIC[8] = { 'C', 'O', 'R', 'D', 'A', 'I', 'D', 'X' };
+    constexpr uint64_t VERSION = 1;
+    constexpr uint64_t ORDER_MARK = 0x0102030405060708ULL;
+
+    struct String {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct Value {
+        uint64_t offset;
+
+        /**
+         * how many objects had been read before this one began, for
+         * numbering back references from it
+         */
+        uint64_t objects;
+    };
+
+    struct Entry {
+        String   path;
+        Value    value;
+        uint64_t elements;
+        uint64_t elementsAt;
+    };
+
+    struct Header {
+        char     magic[8];
+        uint64_t version;
+        uint64_t orderMark;
+
+        /**
+         * the size of the blob indexed, a cheap check the index still
+         * belongs to it
+         */
+        uint64_t blobSize;
+
+        uint64_t dataBegin;
+        uint64_t dataEnd;
+        uint64_t schemaBegin;
+        uint64_t schemaEnd;
+        String   descriptor;
+
+        uint64_t entries;
+        uint64_t entriesAt;
+
+        uint64_t elements;
+        uint64_t elementsAt;
+
+        uint64_t stringsAt;
+        uint64_t stringsSize;
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::OffsetIndexBuilder
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Sits between a [Tokeniser] and the [StreamDecoder] it's feeding, and
+     * between that decoder and its visitor, so it sees both where each
+     * token is and what the decoder made of it. A property or the next
+     * element of a list is announced before the token beginning it so
+     * whichever token arrives next is where that value starts.
+     *
+     *      OffsetIndexBuilder builder (visitor);
+     *      StreamDecoder decoder (reader, schema, builder);
+     *      builder.attach (decoder);
+     *      Tokeniser tokeniser (builder, scanner.data().begin);
+     */
+    class OffsetIndexBuilder
+        : public ITokenHandler
+        , public amqp::reader::IVisitor
+    {
+        private :
+            enum level_t { composite_l, list_l, map_l };
+
+            struct Level {
+                level_t     type;
+                std::string path;
+                size_t      idx;
+                size_t      count;
+
+                /**
+                 * a map or array, nothing within it is indexed
+                 */
+                bool        hidden;
+
+                std::vector<offsets::Value> elements;
+            };
+
+            struct Entry {
+                offsets::Value              value;
+                std::vector<offsets::Value> elements;
+            };
+
+            amqp::reader::IVisitor & m_visitor;
+
+            StreamDecoder * m_decoder;
+
+            std::vector<Level> m_levels;
+
+            /**
+             * the path of the next value to begin, and whether its first
+             * token is yet to arrive
+             */
+            std::string m_next;
+            bool m_pending;
+
+            size_t m_hidden;
+
+            /**
+             * how many lists we're within, only the elements of the
+             * outermost are indexed
+             */
+            size_t m_lists;
+
+            /**
+             * the type of the last opening token, to tell arrays from
+             * lists
+             */
+            pn_type_t m_last;
+
+            /**
+             * An enum is announced on the first element of the list it's
+             * encoded as, the rest of which are skipped rather than taken
+             * for the beginning of whatever comes next
+             */
+            size_t m_listCount;
+            size_t m_skip;
+
+            std::map<std::string, Entry> m_entries;
+
+            void push (level_t, size_t, bool hidden_ = false);
+            void pop();
+            void done();
+
+        public :
+            explicit OffsetIndexBuilder (amqp::reader::IVisitor &);
+
+            void attach (StreamDecoder &);
+
+            Action token (const Token &) override;
+
+            void property (const std::string &) override;
+
+            void beginComposite (const std::string &, size_t) override;
+            void endComposite() override;
+
+            void beginList (size_t) override;
+            void endList() override;
+
+            void beginMap (size_t) override;
+            void endMap() override;
+
+            void value (bool) override;
+            void value (int32_t) override;
+            void value (int64_t) override;
+            void value (double) override;
+            void value (std::string_view) override;
+
+            void enumeration (std::string_view) override;
+
+            void null() override;
+
+            void reference (size_t) override;
+
+            size_t entries() const { return m_entries.size(); }
+
+            void write (std::ostream &, const EnvelopeScanner &, uint64_t blobSize_) const;
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::OffsetIndex
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * An offset index, mapped into memory
+     */
+    class OffsetIndex {
+        private :
+            const char * m_base;
+            size_t m_size;
+
+            const offsets::Header * m_header;
+
+            template<typename T>
+            const T * array (uint64_t at_, uint64_t count_) const;
+
+            std::string_view view (const offsets::String &) const;
+
+            const offsets::Entry * entry (std::string_view) const;
+            std::optional<offsets::Value> element (std::string_view) const;
+
+        public :
+            struct Found {
+                offsets::Value value;
+
+                /**
+                 * how much of the path led to the value, anything
+                 * left is within it
+                 */
+                size_t prefix;
+            };
+
+            /**
+             * Throws if the file isn't an index we can read
+             */
+            explicit OffsetIndex (const std::string &);
+            ~OffsetIndex();
+
+            OffsetIndex (const OffsetIndex &) = delete;
+            OffsetIndex & operator = (const OffsetIndex &) = delete;
+
+            const offsets::Header & header() const { return *m_header; }
+
+            std::string_view descriptor() const;
+
+            size_t entries() const;
+
+            /**
+             * Where the value at the path, or the closest value it's
+             * within that was indexed, begins
+             */
+            std::optional<Found> find (std::string_view path_) const;
+
+            /**
+             * The index only says where a value is, not what it is. This
+             * follows a path from the reader of the top level type to the
+             * reader of the value it leads to, throwing if there's no
+             * such property or a list index is applied to something else.
+             */
+            static const reader::Reader & resolve (
+                const reader::Reader & root_,
+                const reader::Reader::SchemaType &,
+                std::string_view path_);
+    };
+
+}
+
+/******************************************************************************/
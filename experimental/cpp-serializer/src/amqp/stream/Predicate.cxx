@@ -0,0 +1,382 @@
+#include "Predicate.h"
+
+#include <limits>
+#include <charconv>
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+#include "Tokeniser.h"
+
+#include "amqp/schema/described-types/Composite.h"
+
+/******************************************************************************/
+
+namespace {
+
+    using amqp::internal::stream::Token;
+    using amqp::internal::stream::ITokenHandler;
+    using amqp::internal::stream::Predicate;
+
+    std::string
+    trim (const std::string & str_) {
+        auto begin = str_.find_first_not_of (" \t");
+
+        if (begin == std::string::npos) {
+            return "";
+        }
+
+        return str_.substr (begin, str_.find_last_not_of (" \t") - begin + 1);
+    }
+
+    bool
+    compound (const Token & token_) {
+        return !token_.end && (
+            token_.type == PN_DESCRIBED || token_.type == PN_LIST
+            || token_.type == PN_MAP || token_.type == PN_ARRAY);
+    }
+
+    /**
+     * Follows a compiled path down through a data section, stepping over
+     * every field not on it, until it finds the value at its end. Should
+     * anything along the way be null, or not what the path expects, there
+     * is no value.
+     */
+    class Probe : public ITokenHandler {
+        private :
+            enum state_t {
+                composite_s, descriptor_s, body_s, fields_s, found_s, missing_s
+            };
+
+            const Predicate::Path & m_path;
+
+            state_t m_state;
+
+            /**
+             * which step of the path we're on, and the field within the
+             * composite that step is looking at
+             */
+            size_t m_step;
+            size_t m_field;
+
+            Token m_value;
+            std::string m_bytes;
+
+        public :
+            explicit Probe (const Predicate::Path & path_)
+                : m_path (path_)
+                , m_state (composite_s)
+                , m_step (0)
+                , m_field (0)
+                , m_value { }
+            { }
+
+            const Token * value() const {
+                return m_state == found_s ? &m_value : nullptr;
+            }
+
+            Action token (const Token & token_) override {
+                switch (m_state) {
+                    case composite_s :
+                        if (token_.type == PN_DESCRIBED && !token_.end) {
+                            m_state = descriptor_s;
+                            return next_a;
+                        }
+                        break;
+                    case descriptor_s :
+                        m_state = body_s;
+                        return next_a;
+                    case body_s :
+                        if (token_.type == PN_LIST && !token_.end) {
+                            m_state = fields_s;
+                            m_field = 0;
+                            return next_a;
+                        }
+                        break;
+                    case fields_s :
+                        if (token_.end) {
+                            break;
+                        }
+
+                        if (m_field++ < m_path[m_step]) {
+                            return compound (token_) ? skip_a : next_a;
+                        }
+
+                        if (++m_step < m_path.size()) {
+                            m_state = composite_s;
+                            return token (token_);
+                        }
+
+                        m_value = token_;
+
+                        if (token_.bytes) {
+                            m_bytes.assign (token_.bytes, token_.size);
+                            m_value.bytes = m_bytes.data();
+                        }
+
+                        m_state = found_s;
+                        return stop_a;
+                    case found_s :
+                    case missing_s :
+                        return stop_a;
+                }
+
+                m_state = missing_s;
+                return stop_a;
+            }
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Predicate
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+Predicate::Predicate (const std::string & expression_)
+    : m_integer (0)
+    , m_double (0)
+{
+    /*
+     * The path can't contain any of the operator's characters so the
+     * first of them is the start of it, whatever the value contains
+     */
+    auto at = expression_.find_first_of ("=!<>^");
+
+    if (at == std::string::npos) {
+        throw std::runtime_error ("No operator in " + expression_);
+    }
+
+    auto two = expression_.size() > at + 1 && expression_[at + 1] == '=';
+
+    switch (expression_[at]) {
+        case '=' : m_op = eq_o; break;
+        case '<' : m_op = two ? le_o : lt_o; break;
+        case '>' : m_op = two ? ge_o : gt_o; break;
+        case '!' : m_op = ne_o; break;
+        case '^' : m_op = prefix_o; break;
+    }
+
+    if (!two && (expression_[at] == '!' || expression_[at] == '^')) {
+        throw std::runtime_error ("Unknown operator in " + expression_);
+    }
+
+    auto path = trim (expression_.substr (0, at));
+
+    for (size_t begin { 0 } ; ; ) {
+        auto end = path.find ('.', begin);
+        auto step = path.substr (begin, end == std::string::npos ? end : end - begin);
+
+        if (step.empty()) {
+            throw std::runtime_error ("Missing property name in " + expression_);
+        }
+
+        m_path.push_back (step);
+
+        if (end == std::string::npos) {
+            break;
+        }
+
+        begin = end + 1;
+    }
+
+    auto value = trim (expression_.substr (at + (two ? 2 : 1)));
+
+    if (value.empty()) {
+        throw std::runtime_error ("No value in " + expression_);
+    }
+
+    const char * first = value.data();
+    const char * last = value.data() + value.size();
+
+    if (value.size() >= 2 && (value[0] == '"' || value[0] == '\'')
+        && value.back() == value[0])
+    {
+        m_type = string_v;
+        m_text = value.substr (1, value.size() - 2);
+    } else {
+        m_text = value;
+
+        /*
+         * An integer too large for us is still a number, if not one we
+         * can compare exactly
+         */
+        auto integer = std::from_chars (first, last, m_integer);
+        auto real = std::from_chars (first, last, m_double);
+
+        if (value == "true" || value == "false") {
+            m_type = bool_v;
+        } else if (integer.ptr == last && integer.ec == std::errc()) {
+            m_type = integer_v;
+            m_double = static_cast<double> (m_integer);
+        } else if (real.ptr == last) {
+            if (real.ec != std::errc()) {
+                throw std::runtime_error ("Number out of range in " + expression_);
+            }
+            m_type = double_v;
+        } else {
+            m_type = string_v;
+        }
+    }
+
+    if (m_op != eq_o && m_op != ne_o && m_op != prefix_o
+        && m_type != integer_v && m_type != double_v)
+    {
+        throw std::runtime_error ("Only numbers can be ordered in " + expression_);
+    }
+}
+
+/******************************************************************************/
+
+std::optional<amqp::internal::stream::Predicate::Path>
+amqp::internal::stream::
+Predicate::compile (
+    const schema::Schema & schema_,
+    const std::string & descriptor_
+) const {
+    Path rtn;
+
+    const schema::Composite * composite;
+
+    try {
+        composite = dynamic_cast<const schema::Composite *> (
+                schema_.fromDescriptor (descriptor_)->second.get().get());
+
+        for (size_t i { 0 } ; i < m_path.size() ; ++i) {
+            if (!composite) {
+                return std::nullopt;
+            }
+
+            const auto & fields = composite->fields();
+
+            auto field = std::find_if (
+                fields.begin(),
+                fields.end(),
+                [this, i](const auto & field_) { return field_->name() == m_path[i]; });
+
+            if (field == fields.end()) {
+                return std::nullopt;
+            }
+
+            rtn.push_back (field - fields.begin());
+
+            if (i + 1 < m_path.size()) {
+                composite = dynamic_cast<const schema::Composite *> (
+                        schema_.fromType ((*field)->resolvedType())->second.get().get());
+
+                continue;
+            }
+
+            /*
+             * Strings compare as strings whatever the value looks like,
+             * anything else has to be the same sort of thing as the value
+             */
+            const auto & type = (*field)->type();
+
+            if (type == "string") {
+                if (m_op != eq_o && m_op != ne_o && m_op != prefix_o) {
+                    return std::nullopt;
+                }
+            } else if (type == "boolean") {
+                if (m_type != bool_v || m_op == prefix_o) {
+                    return std::nullopt;
+                }
+            } else if (type == "int" || type == "long" || type == "double") {
+                if (m_type != integer_v && m_type != double_v) {
+                    return std::nullopt;
+                }
+            } else {
+                return std::nullopt;
+            }
+        }
+    } catch (const std::runtime_error &) {
+        // a type the schema doesn't have
+        return std::nullopt;
+    }
+
+    return rtn;
+}
+
+/******************************************************************************/
+
+template<typename T>
+bool
+amqp::internal::stream::
+Predicate::compare (T lhs_, T rhs_) const {
+    switch (m_op) {
+        case eq_o : return lhs_ == rhs_;
+        case ne_o : return lhs_ != rhs_;
+        case lt_o : return lhs_ < rhs_;
+        case le_o : return lhs_ <= rhs_;
+        case gt_o : return lhs_ > rhs_;
+        case ge_o : return lhs_ >= rhs_;
+        default   : return false;
+    }
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+Predicate::test (const Token & token_) const {
+    switch (token_.type) {
+        case PN_STRING :
+        case PN_SYMBOL : {
+            std::string_view value { token_.bytes, token_.size };
+
+            switch (m_op) {
+                case eq_o     : return value == m_text;
+                case ne_o     : return value != m_text;
+                case prefix_o : return value.substr (0, m_text.size()) == m_text;
+                default       : return false;
+            }
+        }
+        case PN_BOOL :
+            return m_type == bool_v && compare (token_.value.b, m_text == "true");
+        case PN_BYTE :
+        case PN_SHORT :
+        case PN_INT :
+        case PN_LONG :
+            if (m_type == integer_v) {
+                return compare (token_.value.l, m_integer);
+            }
+            return m_type == double_v
+                && compare (static_cast<double> (token_.value.l), m_double);
+        case PN_UBYTE :
+        case PN_USHORT :
+        case PN_UINT :
+        case PN_ULONG :
+            if (m_type == integer_v
+                && token_.value.ul <= static_cast<uint64_t> (std::numeric_limits<int64_t>::max()))
+            {
+                return compare (static_cast<int64_t> (token_.value.ul), m_integer);
+            }
+            return (m_type == integer_v || m_type == double_v)
+                && compare (static_cast<double> (token_.value.ul), m_double);
+        case PN_FLOAT :
+        case PN_DOUBLE :
+            return (m_type == integer_v || m_type == double_v)
+                && compare (token_.value.d, m_double);
+        default :
+            return false;
+    }
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+Predicate::matches (const char * data_, size_t size_, const Path & path_) const {
+    Probe probe (path_);
+    Tokeniser tokeniser (probe);
+
+    tokeniser.feed (data_, size_);
+
+    auto value = probe.value();
+
+    return value && test (*value);
+}
+
+/******************************************************************************/
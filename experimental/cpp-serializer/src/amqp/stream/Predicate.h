@@ -0,0 +1,90 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+#include "amqp/schema/described-types/Schema.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Predicate
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    struct Token;
+
+    /**
+     * A test of one property of a blob, written as
+     *
+     *      path op value
+     *
+     * where the path names a property of the blob's top level composite,
+     * and of the composites within it, separated by dots and the operator
+     * is one of ==, !=, <, <=, >, >= or ^= (starts with). Values are
+     * numbers, true or false, or strings, quoted or not. Ordering only
+     * applies to numbers and ^= only to strings. A null never matches.
+     *
+     * A predicate is compiled against the schema of each type it's asked
+     * about into the index of the field to take at each step, for which
+     * reason every step but the last must be a composite. A type that
+     * doesn't have the path, or where its last step is of a type the
+     * value can't be compared to, can't match and compiles to nothing.
+     *
+     * Testing a blob only looks at the data along the path, every other
+     * field is stepped over by its encoded size without being read.
+     */
+    class Predicate {
+        public :
+            enum op_t { eq_o, ne_o, lt_o, le_o, gt_o, ge_o, prefix_o };
+
+            using Path = std::vector<size_t>;
+
+        private :
+            std::vector<std::string> m_path;
+
+            op_t m_op;
+
+            /**
+             * the value as written, less any quotes
+             */
+            std::string m_text;
+
+            enum { string_v, bool_v, integer_v, double_v } m_type;
+
+            int64_t m_integer;
+            double m_double;
+
+            template<typename T>
+            bool compare (T, T) const;
+
+        public :
+            /**
+             * Throws if the expression can't be parsed
+             */
+            explicit Predicate (const std::string &);
+
+            std::optional<Path> compile (
+                const schema::Schema &,
+                const std::string & descriptor_) const;
+
+            /**
+             * Whether the data section of a blob, its bytes in their
+             * entirety, matches, given the path compiled for its type
+             */
+            bool matches (const char *, size_t, const Path &) const;
+
+            /**
+             * Whether a single value matches
+             */
+            bool test (const Token &) const;
+    };
+
+}
+
+/******************************************************************************/
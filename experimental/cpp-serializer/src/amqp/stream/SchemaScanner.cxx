@@ -0,0 +1,330 @@
+#include "SchemaScanner.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <istream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "proton/codec.h"
+
+#include "Tokeniser.h"
+#include "Decompressor.h"
+
+#include "amqp/Limits.h"
+#include "amqp/DecodeError.h"
+#include "amqp/AMQPHeader.h"
+#include "amqp/AMQPSectionId.h"
+#include "amqp/schema/descriptors/AMQPDescriptors.h"
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * The envelope, whether it's compressed or not
+     */
+    class Input {
+        public :
+            virtual ~Input() = default;
+
+            /**
+             * @return how many bytes were read, 0 at the end of the blob
+             */
+            virtual size_t read (char *, size_t) = 0;
+
+            /**
+             * Step over bytes we've no interest in
+             */
+            virtual void skip (size_t) = 0;
+    };
+
+    class PlainInput : public Input {
+        private :
+            std::istream & m_in;
+
+        public :
+            explicit PlainInput (std::istream & in_) : m_in (in_) { }
+
+            size_t read (char * data_, size_t size_) override {
+                return m_in.read (data_, size_).gcount();
+            }
+
+            /**
+             * Seek when we can, a pipe we'll just have to read through
+             */
+            void skip (size_t size_) override {
+                if (!m_in.seekg (size_, std::ios::cur)) {
+                    m_in.clear();
+                    m_in.ignore (size_);
+                }
+            }
+    };
+
+    class InflatingInput : public Input {
+        private :
+            std::istream & m_in;
+
+            std::unique_ptr<amqp::internal::stream::Decompressor> m_decompressor;
+
+            std::vector<char> m_raw;
+
+        public :
+            InflatingInput (std::istream & in_, int encoding_)
+                : m_in (in_)
+                , m_decompressor (amqp::internal::stream::Decompressor::make (encoding_))
+                , m_raw (64 * 1024)
+            { }
+
+            size_t read (char * data_, size_t size_) override {
+                for ( ; ; ) {
+                    if (auto n = m_decompressor->output (data_, size_)) {
+                        return n;
+                    }
+
+                    if (m_decompressor->finished()) {
+                        return 0;
+                    }
+
+                    auto got = m_in.read (m_raw.data(), m_raw.size()).gcount();
+
+                    if (!got) {
+                        return 0;
+                    }
+
+                    m_decompressor->input (m_raw.data(), got);
+                }
+            }
+
+            void skip (size_t size_) override {
+                std::array<char, 4096> scratch { };
+
+                while (size_) {
+                    auto n = read (scratch.data(), std::min (scratch.size(), size_));
+
+                    if (!n) {
+                        throw std::runtime_error ("Truncated blob");
+                    }
+
+                    size_ -= n;
+                }
+            }
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::SchemaScanner
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+SchemaScanner::SchemaScanner()
+    : m_retainedFrom (0)
+{
+}
+
+/******************************************************************************/
+
+/**
+ * Stop once the data has been stepped over, so we know where to start
+ * keeping what we're given, and again once the schema has been
+ */
+amqp::internal::stream::ITokenHandler::Action
+amqp::internal::stream::
+SchemaScanner::token (const Token & token_) {
+    auto action = EnvelopeScanner::token (token_);
+
+    if (token_.end && depth() == 2 && sections() <= schema_s + 1) {
+        return stop_a;
+    }
+
+    return action;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+SchemaScanner::scan (std::istream & in_) {
+    static_cast<EnvelopeScanner &>(*this) = EnvelopeScanner();
+
+    m_retained.clear();
+    m_retainedFrom = 0;
+    m_schema.clear();
+
+    std::array<char, 7> header { };
+
+    if (!in_.read (header.data(), header.size()) || header != amqp::AMQP_HEADER) {
+        throw std::runtime_error ("Not a Corda stream");
+    }
+
+    char section { };
+    in_.read (&section, 1);
+
+    uPtr<Input> input;
+
+    if (section == amqp::ENCODING) {
+        char encoding { };
+        in_.read (&encoding, 1);
+
+        input = std::make_unique<InflatingInput> (in_, encoding);
+
+        if (!input->read (&section, 1)) {
+            throw std::runtime_error ("Empty compressed blob");
+        }
+    } else {
+        input = std::make_unique<PlainInput> (in_);
+    }
+
+    if (section != amqp::DATA_AND_STOP && section != amqp::ALT_DATA_AND_STOP) {
+        throw std::runtime_error ("Unsupported encoding");
+    }
+
+    Tokeniser tokeniser (*this);
+
+    bool retaining { false };
+
+    /*
+     * Once we're past the data everything we're handed is kept, the
+     * schema's body being skipped over by the tokeniser doesn't mean
+     * we're not interested in it
+     */
+    auto stopped = [&]() {
+        if (!tokeniser.stopped()) {
+            return false;
+        }
+
+        if (sections() > schema_s) {
+            return true;
+        }
+
+        retaining = true;
+        m_retainedFrom = tokeniser.offset();
+
+        return false;
+    };
+
+    std::vector<char> buffer (4096);
+
+    for ( ; ; ) {
+        if (auto skip = tokeniser.skipping()) {
+            if (retaining) {
+                auto size = m_retained.size();
+                m_retained.resize (size + skip);
+
+                for (size_t got { 0 } ; got < skip ; ) {
+                    auto n = input->read (m_retained.data() + size + got, skip - got);
+
+                    if (!n) {
+                        throw std::runtime_error ("Truncated blob");
+                    }
+
+                    got += n;
+                }
+            } else {
+                input->skip (skip);
+            }
+
+            tokeniser.skipped (skip);
+
+            if (stopped()) {
+                break;
+            }
+
+            continue;
+        }
+
+        auto got = input->read (buffer.data(), buffer.size());
+
+        if (!got) {
+            throw std::runtime_error ("Truncated blob");
+        }
+
+        bool finished { false };
+
+        for (size_t used { 0 } ; used < got && !finished ; ) {
+            auto n = tokeniser.feed (buffer.data() + used, got - used);
+
+            if (retaining) {
+                m_retained.append (buffer.data() + used, n);
+            }
+
+            used += n;
+
+            finished = stopped();
+        }
+
+        if (finished) {
+            break;
+        }
+    }
+
+    if (schema().begin < m_retainedFrom
+        || schema().end - m_retainedFrom > m_retained.size())
+    {
+        throw std::runtime_error ("Malformed envelope, schema not found");
+    }
+
+    m_schema.assign (
+        m_retained.begin() + (schema().begin - m_retainedFrom),
+        m_retained.begin() + (schema().end - m_retainedFrom));
+
+    m_retained.clear();
+}
+
+/******************************************************************************/
+
+const std::vector<char> &
+amqp::internal::stream::
+SchemaScanner::bytes() const {
+    return m_schema;
+}
+
+/******************************************************************************/
+
+uPtr<amqp::internal::schema::Schema>
+amqp::internal::stream::
+SchemaScanner::load() const {
+    /*
+     * Whoever's loading us might not be decoding a blob, a catalog being
+     * built say, the default limits still apply to them
+     */
+    Budget budget;
+    std::optional<Budget::Scope> scope;
+
+    if (!Budget::current()) {
+        scope.emplace (budget);
+    }
+
+    return load (m_schema.data(), m_schema.size(), schema().begin);
+}
+
+/******************************************************************************/
+
+uPtr<amqp::internal::schema::Schema>
+amqp::internal::stream::
+SchemaScanner::load (const char * schema_, size_t size_, size_t offset_) {
+    std::unique_ptr<pn_data_t, decltype (&pn_data_free)> data {
+        pn_data (size_), &pn_data_free };
+
+    auto rtn = pn_data_decode (data.get(), schema_, size_);
+
+    if (rtn < 0) {
+        throw DecodeError (
+                "Malformed schema, proton error " + std::to_string (rtn),
+                offset_);
+    }
+
+    if (static_cast<size_t>(rtn) != size_) {
+        throw DecodeError (
+                "Unexpected data after the end of the schema",
+                offset_ == DecodeError::npos ? offset_ : offset_ + rtn);
+    }
+
+    return schema::descriptors::dispatchDescribed<schema::Schema> (data.get());
+}
+
+/******************************************************************************/
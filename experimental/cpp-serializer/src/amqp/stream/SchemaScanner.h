@@ -0,0 +1,92 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#include "types.h"
+
+#include "EnvelopeScanner.h"
+
+#include "amqp/DecodeError.h"
+#include "amqp/schema/described-types/Schema.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::SchemaScanner
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Reads only as much of a blob as it takes to find its schema, for
+     * anything that wants to know what's in a blob's schema but has no
+     * interest in the values themselves.
+     *
+     * The data section is stepped over by its encoded size without any of
+     * it being read, for an uncompressed blob in a file by seeking past
+     * it. A compressed blob still has to be inflated that far but nothing
+     * inflated is kept or looked at. Everything after the schema, the
+     * transforms, is never read at all. The cost of finding the schema is
+     * then proportional to its size, not that of the blob.
+     */
+    class SchemaScanner : private EnvelopeScanner {
+        private :
+            /**
+             * the bytes of the envelope from the end of the data section,
+             * where the schema begins, up to wherever we've read
+             */
+            std::string m_retained;
+            size_t m_retainedFrom;
+
+            std::vector<char> m_schema;
+
+            Action token (const Token &) override;
+
+        public :
+            SchemaScanner();
+
+            /**
+             * Find the schema of the blob, header and all, at the current
+             * position of the stream. Throws if it's not a blob or ends
+             * before we've found everything.
+             */
+            void scan (std::istream &);
+
+            /**
+             * The descriptor of the blob's top level type
+             */
+            using EnvelopeScanner::descriptor;
+
+            /**
+             * Where the schema section is within the envelope
+             */
+            using EnvelopeScanner::schema;
+
+            /**
+             * The encoded schema section, a described SCHEMA type
+             */
+            const std::vector<char> & bytes() const;
+
+            /**
+             * Decode just the schema, its composite and restricted types
+             */
+            uPtr<schema::Schema> load() const;
+
+            /**
+             * Decode an encoded schema section however it was found,
+             * throwing a DecodeError at [offset_], where the section began
+             * in its envelope, if proton can't make sense of it
+             */
+            static uPtr<schema::Schema> load (
+                const char * schema_,
+                size_t size_,
+                size_t offset_ = DecodeError::npos);
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,285 @@
+#include "SnappyDecompressor.h"
+
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+/******************************************************************************/
+
+namespace {
+
+    const char identifier[] = "sNaPpY";
+
+    const size_t maxChunk = 64 * 1024;
+
+    uint32_t
+    le (const char * p_, size_t n_) {
+        uint32_t rtn { 0 };
+        for (size_t i { n_ } ; i > 0 ; --i) {
+            rtn = (rtn << 8U) | static_cast<uint8_t>(p_[i - 1]);
+        }
+        return rtn;
+    }
+
+    /**
+     * CRC-32C (Castagnoli), which is what the framing format checksums
+     * with rather than the more common CRC-32
+     */
+    uint32_t
+    crc32c (const char * p_, size_t n_) {
+        static const auto table = [] {
+            std::array<uint32_t, 256> t { };
+            for (uint32_t i { 0 } ; i < 256 ; ++i) {
+                uint32_t c = i;
+                for (int j { 0 } ; j < 8 ; ++j) {
+                    c = (c & 1U) ? (c >> 1U) ^ 0x82f63b78U : (c >> 1U);
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        uint32_t crc { 0xffffffffU };
+        for (size_t i { 0 } ; i < n_ ; ++i) {
+            crc = table[(crc ^ static_cast<uint8_t>(p_[i])) & 0xffU] ^ (crc >> 8U);
+        }
+
+        return ~crc;
+    }
+
+    uint32_t
+    masked (uint32_t crc_) {
+        return ((crc_ >> 15U) | (crc_ << 17U)) + 0xa282ead8U;
+    }
+
+    [[noreturn]] void
+    corrupt (const std::string & what_) {
+        throw std::runtime_error ("Corrupt snappy stream: " + what_);
+    }
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::SnappyDecompressor
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+SnappyDecompressor::SnappyDecompressor()
+    : m_consumed (0)
+    , m_read (0)
+    , m_identified (false)
+{
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+SnappyDecompressor::input (const char * data_, size_t size_) {
+    m_in.erase (0, m_consumed);
+    m_consumed = 0;
+    m_in.append (data_, size_);
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+SnappyDecompressor::output (char * data_, size_t size_) {
+    while (m_read == m_out.size()) {
+        if (!chunk()) {
+            return 0;
+        }
+    }
+
+    auto n = std::min (size_, m_out.size() - m_read);
+    std::memcpy (data_, m_out.data() + m_read, n);
+    m_read += n;
+
+    return n;
+}
+
+/******************************************************************************/
+
+/**
+ * The framing format has no end marker, the stream just stops
+ */
+bool
+amqp::internal::stream::
+SnappyDecompressor::finished() const {
+    return false;
+}
+
+/******************************************************************************/
+
+/**
+ * Deal with the next chunk if we've got all of it
+ *
+ * @return false if we need more input
+ */
+bool
+amqp::internal::stream::
+SnappyDecompressor::chunk() {
+    if (m_in.size() - m_consumed < 4) {
+        return false;
+    }
+
+    const char * header = m_in.data() + m_consumed;
+    auto type = static_cast<uint8_t>(header[0]);
+    auto length = le (header + 1, 3);
+
+    if (m_in.size() - m_consumed - 4 < length) {
+        return false;
+    }
+
+    const char * body = header + 4;
+    m_consumed += 4 + length;
+
+    m_out.clear();
+    m_read = 0;
+
+    if (type == 0xff) {
+        if (length != sizeof (identifier) - 1
+            || std::memcmp (body, identifier, length) != 0)
+        {
+            corrupt ("bad stream identifier");
+        }
+        m_identified = true;
+        return true;
+    }
+
+    if (!m_identified) {
+        corrupt ("missing stream identifier");
+    }
+
+    switch (type) {
+        case 0x00 :
+        case 0x01 :
+            if (length < 4) {
+                corrupt ("short chunk");
+            }
+
+            if (type == 0x00) {
+                uncompress (body + 4, length - 4);
+            } else {
+                m_out.assign (body + 4, length - 4);
+            }
+
+            if (m_out.size() > maxChunk) {
+                corrupt ("chunk too large");
+            }
+
+            if (masked (crc32c (m_out.data(), m_out.size())) != le (body, 4)) {
+                corrupt ("checksum mismatch");
+            }
+            return true;
+        default :
+            // 0x80 - 0xfe can be skipped, anything else we're meant to
+            // understand but don't
+            if (type < 0x80) {
+                corrupt ("unknown chunk type " + std::to_string (type));
+            }
+            return true;
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * Decode a single block of raw snappy, a varint holding the uncompressed
+ * length followed by a sequence of literals and back references into
+ * what's already been written
+ */
+void
+amqp::internal::stream::
+SnappyDecompressor::uncompress (const char * p_, size_t size_) {
+    const auto * p = reinterpret_cast<const uint8_t *>(p_);
+    const auto * end = p + size_;
+
+    size_t length { 0 };
+    for (unsigned shift { 0 } ; ; shift += 7) {
+        if (p == end || shift > 28) {
+            corrupt ("bad length");
+        }
+        length |= static_cast<size_t>(*p & 0x7fU) << shift;
+        if (!(*p++ & 0x80U)) {
+            break;
+        }
+    }
+
+    if (length > maxChunk) {
+        corrupt ("chunk too large");
+    }
+
+    m_out.reserve (length);
+
+    while (p < end) {
+        uint8_t tag = *p++;
+        size_t len;
+        size_t offset;
+
+        switch (tag & 3U) {
+            case 0 : {
+                len = tag >> 2U;
+                if (len >= 60) {
+                    auto bytes = len - 59;
+                    if (static_cast<size_t>(end - p) < bytes) {
+                        corrupt ("truncated literal");
+                    }
+                    len = le (reinterpret_cast<const char *>(p), bytes);
+                    p += bytes;
+                }
+                ++len;
+                if (static_cast<size_t>(end - p) < len) {
+                    corrupt ("truncated literal");
+                }
+                if (m_out.size() + len > length) {
+                    corrupt ("length mismatch");
+                }
+                m_out.append (reinterpret_cast<const char *>(p), len);
+                p += len;
+                continue;
+            }
+            case 1 :
+                if (p == end) {
+                    corrupt ("truncated copy");
+                }
+                len = ((tag >> 2U) & 7U) + 4;
+                offset = ((tag >> 5U) << 8U) | *p++;
+                break;
+            case 2 :
+            case 3 : {
+                size_t bytes = (tag & 3U) == 2 ? 2 : 4;
+                if (static_cast<size_t>(end - p) < bytes) {
+                    corrupt ("truncated copy");
+                }
+                len = (tag >> 2U) + 1;
+                offset = le (reinterpret_cast<const char *>(p), bytes);
+                p += bytes;
+                break;
+            }
+        }
+
+        if (offset == 0 || offset > m_out.size()) {
+            corrupt ("bad copy offset");
+        }
+
+        if (m_out.size() + len > length) {
+            corrupt ("length mismatch");
+        }
+
+        // copies can overlap what they're producing so go a byte at a time
+        for (auto from = m_out.size() - offset ; len > 0 ; --len) {
+            m_out.push_back (m_out[from++]);
+        }
+    }
+
+    if (m_out.size() != length) {
+        corrupt ("length mismatch");
+    }
+}
+
+/******************************************************************************/
@@ -0,0 +1,52 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <cstdint>
+
+#include "Decompressor.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::SnappyDecompressor
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Snappy using the framing format, a stream of chunks each holding at
+     * most 64KiB of uncompressed data. Each chunk is decoded as soon as
+     * we've got the whole of it so we only ever hold one chunk's worth,
+     * compressed and uncompressed, at a time.
+     *
+     * See https://github.com/google/snappy/blob/master/framing_format.txt
+     */
+    class SnappyDecompressor : public Decompressor {
+        private :
+            /**
+             * compressed bytes not yet making up an entire chunk
+             */
+            std::string m_in;
+            size_t m_consumed;
+
+            std::string m_out;
+            size_t m_read;
+
+            bool m_identified;
+
+            bool chunk();
+            void uncompress (const char *, size_t);
+
+        public :
+            SnappyDecompressor();
+
+            void input (const char *, size_t) override;
+            size_t output (char *, size_t) override;
+            bool finished() const override;
+    };
+
+}
+
+/******************************************************************************/
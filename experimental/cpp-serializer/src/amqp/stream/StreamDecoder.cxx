@@ -0,0 +1,465 @@
+#include "StreamDecoder.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "amqp/Limits.h"
+#include "amqp/DecodeError.h"
+#include "amqp/reader/PropertyReader.h"
+#include "amqp/reader/CompositeReader.h"
+#include "amqp/reader/RestrictedReader.h"
+#include "amqp/reader/restricted-readers/MapReader.h"
+#include "amqp/reader/restricted-readers/ListReader.h"
+#include "amqp/reader/restricted-readers/ArrayReader.h"
+
+#include "amqp/schema/Descriptors.h"
+#include "amqp/schema/described-types/Composite.h"
+#include "amqp/schema/descriptors/AMQPDescriptorRegistory.h"
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::StreamDecoder
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+StreamDecoder::StreamDecoder (
+    const reader::Reader & reader_,
+    const reader::Reader::SchemaType & schema_,
+    amqp::reader::IVisitor & visitor_,
+    ObjectTable::refs_t refs_,
+    size_t first_,
+    size_t values_
+) : m_schema (schema_)
+  , m_objects (visitor_, refs_, first_)
+  , m_reader (&reader_)
+  , m_values (values_)
+  , m_value (0)
+  , m_splitter (nullptr)
+  , m_done (false)
+{
+    push (m_reader);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+StreamDecoder::reset (const reader::Reader & reader_) {
+    m_objects.reset();
+    m_stack.clear();
+    m_reader = &reader_;
+    m_value = 0;
+    m_done = false;
+
+    push (m_reader);
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+StreamDecoder::done() const {
+    return m_done;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+StreamDecoder::objects() const {
+    return m_objects.size();
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+StreamDecoder::push (const std::weak_ptr<reader::Reader> & reader_, bool field_) {
+    push (reader_.lock().get(), field_);
+}
+
+/******************************************************************************/
+
+/**
+ * Work out what sort of reader we've been given once, as it's pushed,
+ * rather than every time a token arrives for it
+ */
+void
+amqp::internal::stream::
+StreamDecoder::push (const reader::Reader * reader_, bool field_) {
+    if (!reader_) {
+        throw std::runtime_error ("null reader");
+    }
+
+    Budget::depth (m_stack.size() + 1);
+
+    Frame frame { reader_, property_k, value_s, nullptr, 0, 0, field_, false };
+
+    if (dynamic_cast<const reader::PropertyReader *>(reader_)) {
+        frame.kind = property_k;
+    } else if (dynamic_cast<const reader::CompositeReader *>(reader_)) {
+        frame.kind = composite_k;
+    } else if (auto r = dynamic_cast<const reader::RestrictedReader *>(reader_)) {
+        switch (r->restrictedType()) {
+            case schema::Restricted::RestrictedTypes::list_t :
+            case schema::Restricted::RestrictedTypes::array_t :
+                frame.kind = list_k;
+                break;
+            case schema::Restricted::RestrictedTypes::map_t :
+                frame.kind = map_k;
+                break;
+            case schema::Restricted::RestrictedTypes::enum_t :
+                frame.kind = enum_k;
+                break;
+        }
+    } else {
+        throw std::runtime_error ("Unknown reader type: " + reader_->type());
+    }
+
+    m_stack.push_back (frame);
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+StreamDecoder::unexpected (const Frame & frame_, const Token & token_) const {
+    std::stringstream ss;
+    ss << "Unexpected " << (token_.end ? "end of " : "")
+       << pn_type_name (token_.type) << " reading " << frame_.reader->type();
+    throw DecodeError (ss.str(), token_.offset);
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::ITokenHandler::Action
+amqp::internal::stream::
+StreamDecoder::token (const Token & token_) {
+    if (m_done) {
+        throw DecodeError (
+            "Unexpected data after the end of the value", token_.offset);
+    }
+
+    auto & frame = m_stack.back();
+
+    switch (frame.stage) {
+        case value_s :
+            if (token_.type == PN_NULL) {
+                m_objects.null();
+                m_stack.pop_back();
+                next();
+            } else if (token_.type == PN_DESCRIBED && !token_.end) {
+                frame.stage = descriptor_s;
+            } else if (frame.kind == property_k) {
+                /*
+                 * Of the primitives only strings are objects, and then
+                 * only when not a composite's property
+                 */
+                bool object = token_.type == PN_STRING && !frame.field;
+
+                if (object) {
+                    m_objects.begin();
+                }
+
+                static_cast<const reader::PropertyReader *>(
+                        frame.reader)->visit (token_, m_objects);
+
+                if (object) {
+                    m_objects.end();
+                }
+
+                m_stack.pop_back();
+                next();
+            } else {
+                unexpected (frame, token_);
+            }
+            break;
+        case descriptor_s :
+            descriptor (frame, token_);
+            break;
+        case body_s :
+            if (body (frame, token_)) {
+                return ITokenHandler::skip_a;
+            }
+            break;
+        case elements_s :
+            element (frame, token_);
+            break;
+        case close_s :
+            close (frame, token_);
+            break;
+        case reference_s :
+            reference (frame, token_);
+            break;
+    }
+
+    return m_done ? stop_a : next_a;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+StreamDecoder::descriptor (Frame & frame_, const Token & token_) {
+    if (token_.type == PN_ULONG
+        && amqp::stripCorda (token_.value.ul)
+                == static_cast<uint32_t>(amqp::schema::descriptors::REFERENCED_OBJECT))
+    {
+        frame_.stage = reference_s;
+        return;
+    }
+
+    if (token_.type != PN_SYMBOL || frame_.kind == property_k) {
+        unexpected (frame_, token_);
+    }
+
+    const auto & it = m_schema.fromDescriptor (
+            std::string_view (token_.bytes, token_.size));
+
+    /*
+     * A descriptor belonging to some other type in the schema would
+     * otherwise have us reading its body with the wrong reader
+     */
+    if (it->second.get()->name() != frame_.reader->type()) {
+        std::stringstream ss;
+        ss << "Expected " << frame_.reader->type() << " but found "
+           << it->second.get()->name();
+        throw DecodeError (ss.str(), token_.offset);
+    }
+
+    if (frame_.kind == composite_k) {
+        frame_.composite = &dynamic_cast<const schema::Composite &> (
+                *(it->second.get()));
+
+        auto & readers = static_cast<const reader::CompositeReader *>(
+                frame_.reader)->readers();
+
+        if (frame_.composite->fields().size() != readers.size()) {
+            std::stringstream ss;
+            ss << frame_.reader->type() << " has "
+               << frame_.composite->fields().size() << " fields but "
+               << readers.size() << " readers";
+            throw std::runtime_error (ss.str());
+        }
+    }
+
+    /*
+     * Anything we get this far with, that isn't one of a composite's
+     * primitive properties, is an object that can be referred back to
+     */
+    frame_.object = true;
+    m_objects.begin();
+
+    frame_.stage = body_s;
+}
+
+/******************************************************************************/
+
+/**
+ * @return true if the body's elements have already been read, there being
+ * nothing left but to step over them
+ */
+bool
+amqp::internal::stream::
+StreamDecoder::body (Frame & frame_, const Token & token_) {
+    if (token_.end) {
+        unexpected (frame_, token_);
+    }
+
+    switch (frame_.kind) {
+        case composite_k :
+            if (token_.type != PN_LIST) {
+                unexpected (frame_, token_);
+            }
+            if (token_.count != frame_.composite->fields().size()) {
+                std::stringstream ss;
+                ss << frame_.reader->type() << " has "
+                   << frame_.composite->fields().size() << " fields but "
+                   << token_.count << " were encoded";
+                throw DecodeError (ss.str(), token_.offset);
+            }
+            m_objects.beginComposite (
+                    frame_.reader->type(), frame_.composite->fields().size());
+            break;
+        case list_k :
+            if (token_.type != PN_LIST && token_.type != PN_ARRAY) {
+                unexpected (frame_, token_);
+            }
+            Budget::elements (token_.count);
+            m_objects.beginList (token_.count);
+            break;
+        case map_k :
+            if (token_.type != PN_MAP) {
+                unexpected (frame_, token_);
+            }
+            Budget::elements (token_.count / 2);
+            m_objects.beginMap (token_.count / 2);
+            break;
+        case enum_k :
+            if (token_.type != PN_LIST) {
+                unexpected (frame_, token_);
+            }
+            break;
+        case property_k :
+            unexpected (frame_, token_);
+    }
+
+    frame_.stage = elements_s;
+    frame_.count = token_.count;
+    frame_.idx = 0;
+
+    if (frame_.kind == list_k && frame_.count && m_splitter) {
+        const reader::Reader * element;
+
+        if (auto l = dynamic_cast<const reader::ListReader *>(frame_.reader)) {
+            element = l->reader().lock().get();
+        } else {
+            element = static_cast<const reader::ArrayReader *>(
+                    frame_.reader)->reader().lock().get();
+        }
+
+        if (element && m_splitter->split (*element, token_, m_stack.size(), m_objects)) {
+            m_objects.endList();
+            frame_.stage = close_s;
+            return true;
+        }
+    }
+
+    if (frame_.kind != enum_k && frame_.count) {
+        start();
+    }
+
+    return false;
+}
+
+/******************************************************************************/
+
+/**
+ * The element a child frame was reading is done, move the parent on to
+ * its next one. If there isn't one we wait for the token closing it.
+ */
+void
+amqp::internal::stream::
+StreamDecoder::next() {
+    if (m_stack.empty()) {
+        if (++m_value < m_values) {
+            push (m_reader);
+        } else {
+            m_done = true;
+        }
+        return;
+    }
+
+    if (++m_stack.back().idx < m_stack.back().count) {
+        start();
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * Push a frame for whichever reader knows how to read the current
+ * element of the frame on the top of the stack
+ */
+void
+amqp::internal::stream::
+StreamDecoder::start() {
+    auto & frame = m_stack.back();
+
+    switch (frame.kind) {
+        case composite_k : {
+            auto & readers = static_cast<const reader::CompositeReader *>(
+                    frame.reader)->readers();
+
+            m_objects.property (frame.composite->fields()[frame.idx]->name());
+            push (readers[frame.idx], true);
+            break;
+        }
+        case list_k :
+            if (auto l = dynamic_cast<const reader::ListReader *>(frame.reader)) {
+                push (l->reader());
+            } else {
+                push (static_cast<const reader::ArrayReader *>(
+                        frame.reader)->reader());
+            }
+            break;
+        case map_k : {
+            auto m = static_cast<const reader::MapReader *>(frame.reader);
+            push ((frame.idx % 2) ? m->valueReader() : m->keyReader());
+            break;
+        }
+        default :
+            break;
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * Anything turning up here wasn't claimed by a child frame so is either
+ * the end of the body or, for an enum, its contents. The latter is the
+ * string representation of the constant followed by its ordinal.
+ */
+void
+amqp::internal::stream::
+StreamDecoder::element (Frame & frame_, const Token & token_) {
+    if (frame_.kind == enum_k && !token_.end) {
+        if (frame_.idx++ == 0) {
+            if (token_.type != PN_STRING && token_.type != PN_SYMBOL) {
+                unexpected (frame_, token_);
+            }
+            m_objects.enumeration (std::string_view (token_.bytes, token_.size));
+        }
+        return;
+    }
+
+    if (!token_.end) {
+        unexpected (frame_, token_);
+    }
+
+    switch (frame_.kind) {
+        case composite_k : m_objects.endComposite(); break;
+        case list_k : m_objects.endList(); break;
+        case map_k : m_objects.endMap(); break;
+        default : break;
+    }
+
+    frame_.stage = close_s;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+StreamDecoder::close (Frame & frame_, const Token & token_) {
+    if (!token_.end || token_.type != PN_DESCRIBED) {
+        unexpected (frame_, token_);
+    }
+
+    if (frame_.object) {
+        m_objects.end();
+    }
+
+    m_stack.pop_back();
+    next();
+}
+
+/******************************************************************************/
+
+/**
+ * Within a REFERENCED_OBJECT, the index of the object it refers to
+ */
+void
+amqp::internal::stream::
+StreamDecoder::reference (Frame & frame_, const Token & token_) {
+    if (token_.end || (token_.type != PN_UINT && token_.type != PN_ULONG)) {
+        unexpected (frame_, token_);
+    }
+
+    m_objects.reference (token_.value.ul);
+
+    frame_.stage = close_s;
+}
+
+/******************************************************************************/
@@ -0,0 +1,194 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <vector>
+
+#include "Tokeniser.h"
+#include "ObjectTable.h"
+
+#include "amqp/reader/IVisitor.h"
+#include "amqp/reader/Reader.h"
+
+/******************************************************************************/
+
+namespace amqp::internal::schema {
+
+    class Composite;
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ISplitter
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Offered every list and array a [StreamDecoder] is about to read the
+     * elements of, so it can read them some other way instead
+     */
+    class ISplitter {
+        public :
+            virtual ~ISplitter() = default;
+
+            /**
+             * The list has been opened, [objects_] told as much, but none
+             * of its elements read. If the splitter reads them all, telling
+             * [objects_] about them, the decoder steps over them and goes
+             * straight on to the list's end.
+             *
+             * @param element_ reads every element of the list
+             * @param depth_ how deeply nested the list is
+             * @return false to have the decoder read them as usual
+             */
+            virtual bool split (
+                const reader::Reader & element_,
+                const Token & list_,
+                size_t depth_,
+                ObjectTable & objects_) = 0;
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::StreamDecoder
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * Walks the same graph of readers [dump] would, but driven by tokens
+     * as they come off a [Tokeniser] rather than by navigating a fully
+     * decoded proton tree. Values are handed to the visitor as soon as
+     * they're recognised.
+     *
+     * The readers themselves are stateless, where we are in each of them
+     * is tracked here with a frame per reader currently being read from
+     * so we can be suspended at any token boundary.
+     */
+    class StreamDecoder : public ITokenHandler {
+        private :
+            enum kind_t {
+                property_k, composite_k, list_k, map_k, enum_k
+            };
+
+            enum stage_t {
+                /** waiting for the value's opening token */
+                value_s,
+
+                /** inside the described type, waiting on its descriptor */
+                descriptor_s,
+
+                /** waiting on the body the descriptor describes */
+                body_s,
+
+                /** reading the body's elements */
+                elements_s,
+
+                /** body closed, waiting for the described type to */
+                close_s,
+
+                /** a back reference, waiting on the index it refers to */
+                reference_s
+            };
+
+            struct Frame {
+                const reader::Reader      * reader;
+                kind_t                      kind;
+                stage_t                     stage;
+                const schema::Composite   * composite;
+                size_t                      idx;
+                size_t                      count;
+
+                /** the value is one of a composite's properties */
+                bool                        field;
+
+                /** it's been numbered as an object by [m_objects] */
+                bool                        object;
+            };
+
+            const reader::Reader::SchemaType & m_schema;
+
+            /**
+             * everything we'd tell the visitor goes through here
+             */
+            ObjectTable m_objects;
+
+            std::vector<Frame> m_stack;
+
+            /**
+             * what reads each of the values, and how many of them there
+             * are, usually the one
+             */
+            const reader::Reader * m_reader;
+            size_t m_values;
+            size_t m_value;
+
+            ISplitter * m_splitter;
+
+            bool m_done;
+
+            void push (const std::weak_ptr<reader::Reader> &, bool field_ = false);
+            void push (const reader::Reader *, bool field_ = false);
+
+            void descriptor (Frame &, const Token &);
+            bool body (Frame &, const Token &);
+            void close (Frame &, const Token &);
+            void reference (Frame &, const Token &);
+            void element (Frame &, const Token &);
+            void next();
+            void start();
+
+            [[noreturn]] void unexpected (const Frame &, const Token &) const;
+
+        public :
+            /**
+             * A value read from part way through a blob is told how many
+             * objects preceded it so back references are numbered as
+             * they were written. Should there be [values_] of them one
+             * after the other, the elements of a list say, each is read
+             * in turn.
+             */
+            StreamDecoder (
+                const reader::Reader &,
+                const reader::Reader::SchemaType &,
+                amqp::reader::IVisitor &,
+                ObjectTable::refs_t = ObjectTable::expand_r,
+                size_t first_ = 0,
+                size_t values_ = 1);
+
+            Action token (const Token &) override;
+
+            /**
+             * Decode another value of the same schema, starting with
+             * [reader], without giving up the memory the last one needed
+             */
+            void reset (const reader::Reader &);
+
+            /**
+             * Offer the lists and arrays we read to [splitter_], null for
+             * none
+             */
+            void splitter (ISplitter * splitter_) { m_splitter = splitter_; }
+
+            /**
+             * True once the entire value has been decoded
+             */
+            bool done() const;
+
+            /**
+             * How many objects have been completed so far
+             */
+            size_t objects() const;
+
+            const ObjectTable & table() const { return m_objects; }
+    };
+
+}
+
+/******************************************************************************/
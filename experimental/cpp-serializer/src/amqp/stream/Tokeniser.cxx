@@ -0,0 +1,649 @@
+#include "Tokeniser.h"
+
+#include <limits>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "amqp/Limits.h"
+#include "amqp/DecodeError.h"
+
+/******************************************************************************/
+
+namespace {
+
+    const size_t npos = std::numeric_limits<size_t>::max();
+
+    /**
+     * AMQP is big endian throughout
+     */
+    uint64_t
+    be (const uint8_t * p_, size_t n_) {
+        uint64_t rtn { 0 };
+        for (size_t i { 0 } ; i < n_ ; ++i) {
+            rtn = (rtn << 8U) | p_[i];
+        }
+        return rtn;
+    }
+
+    /**
+     * Bytes of payload following the constructor of a fixed width
+     * type, or -1 if [code_] isn't one
+     */
+    int
+    fixedWidth (uint8_t code_) {
+        switch (code_) {
+            case 0x40 : case 0x41 : case 0x42 :
+            case 0x43 : case 0x44 : case 0x45 :
+                return 0;
+            case 0x50 : case 0x51 : case 0x52 : case 0x53 :
+            case 0x54 : case 0x55 : case 0x56 :
+                return 1;
+            case 0x60 : case 0x61 :
+                return 2;
+            case 0x70 : case 0x71 : case 0x72 : case 0x73 : case 0x74 :
+                return 4;
+            case 0x80 : case 0x81 : case 0x82 : case 0x83 : case 0x84 :
+                return 8;
+            case 0x94 : case 0x98 :
+                return 16;
+            default :
+                return -1;
+        }
+    }
+
+    pn_type_t
+    typeOf (uint8_t code_) {
+        switch (code_) {
+            case 0x40 : return PN_NULL;
+            case 0x41 : case 0x42 : case 0x56 : return PN_BOOL;
+            case 0x43 : case 0x52 : case 0x70 : return PN_UINT;
+            case 0x44 : case 0x53 : case 0x80 : return PN_ULONG;
+            case 0x45 : case 0xc0 : case 0xd0 : return PN_LIST;
+            case 0x50 : return PN_UBYTE;
+            case 0x51 : return PN_BYTE;
+            case 0x54 : case 0x71 : return PN_INT;
+            case 0x55 : case 0x81 : return PN_LONG;
+            case 0x60 : return PN_USHORT;
+            case 0x61 : return PN_SHORT;
+            case 0x72 : return PN_FLOAT;
+            case 0x73 : return PN_CHAR;
+            case 0x74 : return PN_DECIMAL32;
+            case 0x82 : return PN_DOUBLE;
+            case 0x83 : return PN_TIMESTAMP;
+            case 0x84 : return PN_DECIMAL64;
+            case 0x94 : return PN_DECIMAL128;
+            case 0x98 : return PN_UUID;
+            case 0xa0 : case 0xb0 : return PN_BINARY;
+            case 0xa1 : case 0xb1 : return PN_STRING;
+            case 0xa3 : case 0xb3 : return PN_SYMBOL;
+            case 0xc1 : case 0xd1 : return PN_MAP;
+            case 0xe0 : case 0xf0 : return PN_ARRAY;
+            case 0x00 : return PN_DESCRIBED;
+            default : return PN_INVALID;
+        }
+    }
+
+    [[noreturn]] void
+    unknown (uint8_t code_, size_t offset_) {
+        std::stringstream ss;
+        ss << "Unknown AMQP format code 0x" << std::hex << (int)code_;
+        throw amqp::internal::DecodeError (ss.str(), offset_);
+    }
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Tokeniser
+ *
+ ******************************************************************************/
+
+amqp::internal::stream::
+Tokeniser::Tokeniser (
+    ITokenHandler & handler_,
+    size_t offset_
+) : m_handler (handler_)
+  , m_offset (offset_)
+  , m_skip (0)
+  , m_silentAt (npos)
+  , m_values (0)
+  , m_stopped (false)
+  , m_element (0xff)
+{
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+Tokeniser::reset (size_t offset_) {
+    m_stack.clear();
+    m_carry.clear();
+    m_offset = offset_;
+    m_skip = 0;
+    m_silentAt = npos;
+    m_values = 0;
+    m_stopped = false;
+    m_element = 0xff;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+Tokeniser::elements (uint8_t constructor_) {
+    if (typeOf (constructor_) == PN_INVALID) {
+        unknown (constructor_, m_offset);
+    }
+
+    m_element = constructor_;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+Tokeniser::span (const char * data_, size_t size_, uint8_t constructor_) {
+    auto p = reinterpret_cast<const uint8_t *>(data_);
+
+    uint8_t code = constructor_;
+    size_t ctor = 0;
+
+    if (code == 0xff) {
+        if (!size_) {
+            throw std::runtime_error ("Truncated element");
+        }
+        code = p[0];
+        ctor = 1;
+    }
+
+    /*
+     * bytes in the header holding how many bytes follow it
+     */
+    auto sized = [&](size_t width_) -> size_t {
+        if (size_ < ctor + width_) {
+            throw std::runtime_error ("Truncated element");
+        }
+        return ctor + width_ + be (p + ctor, width_);
+    };
+
+    size_t len;
+
+    int fixed = fixedWidth (code);
+
+    if (fixed >= 0) {
+        len = ctor + fixed;
+    } else {
+        switch (code) {
+            /*
+             * A descriptor and then the value it describes, each with its
+             * own constructor
+             */
+            case 0x00 : {
+                if (!ctor) {
+                    throw std::runtime_error (
+                        "Arrays of described types are not supported");
+                }
+
+                Budget::Level level;
+
+                auto descriptor = span (data_ + 1, size_ - 1);
+                len = 1 + descriptor + span (
+                        data_ + 1 + descriptor, size_ - 1 - descriptor);
+                break;
+            }
+            case 0xa0 : case 0xa1 : case 0xa3 :
+            case 0xc0 : case 0xc1 : case 0xe0 :
+                len = sized (1);
+                break;
+            case 0xb0 : case 0xb1 : case 0xb3 :
+            case 0xd0 : case 0xd1 : case 0xf0 :
+                len = sized (4);
+                break;
+            default :
+                unknown (code, 0);
+        }
+    }
+
+    if (len > size_) {
+        throw std::runtime_error ("Truncated element");
+    }
+
+    return len;
+}
+
+/******************************************************************************/
+
+/**
+ * If we're inside an array, or reading a run of one's elements, the
+ * constructor isn't repeated for each element, this is the one they
+ * share. 0xff if we're not
+ */
+uint8_t
+amqp::internal::stream::
+Tokeniser::implicit() const {
+    if (m_stack.empty()) {
+        return m_element;
+    }
+    if (m_stack.back().type == PN_ARRAY) {
+        return m_stack.back().element;
+    }
+    return 0xff;
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+Tokeniser::silent() const {
+    return m_silentAt != npos;
+}
+
+/******************************************************************************/
+
+/**
+ * Work out how many bytes the next element's constructor and header, or
+ * for a scalar the entire element, occupies.
+ *
+ * @return true if [len_] is that length. If we haven't been given enough
+ * to know, false with [len_] set to how many bytes we'd need to be able
+ * to tell.
+ */
+bool
+amqp::internal::stream::
+Tokeniser::measure (
+    const uint8_t * p_,
+    size_t avail_,
+    size_t & len_
+) const {
+    uint8_t code = implicit();
+    size_t ctor = 0;
+
+    if (code == 0xff) {
+        if (avail_ < 1) {
+            len_ = 1;
+            return false;
+        }
+        code = p_[0];
+        ctor = 1;
+    }
+
+    int fixed = fixedWidth (code);
+    if (fixed >= 0) {
+        len_ = ctor + fixed;
+        return true;
+    }
+
+    switch (code) {
+        case 0x00 :
+            if (!ctor) {
+                throw std::runtime_error (
+                    "Arrays of described types are not supported");
+            }
+            len_ = 1;
+            return true;
+        case 0xa0 : case 0xa1 : case 0xa3 :
+            if (avail_ < ctor + 1) {
+                len_ = ctor + 1;
+                return false;
+            }
+            len_ = ctor + 1 + p_[ctor];
+            return true;
+        case 0xb0 : case 0xb1 : case 0xb3 :
+            if (avail_ < ctor + 4) {
+                len_ = ctor + 4;
+                return false;
+            }
+            len_ = ctor + 4 + be (p_ + ctor, 4);
+            return true;
+        case 0xc0 : case 0xc1 :
+            len_ = ctor + 2;
+            return true;
+        case 0xd0 : case 0xd1 :
+            len_ = ctor + 8;
+            return true;
+        case 0xe0 :
+            len_ = ctor + 3;
+            return true;
+        case 0xf0 :
+            len_ = ctor + 9;
+            return true;
+        default :
+            unknown (code, m_offset);
+    }
+}
+
+/******************************************************************************/
+
+amqp::internal::stream::ITokenHandler::Action
+amqp::internal::stream::
+Tokeniser::emit (const Token & token_) {
+    if (silent()) {
+        return ITokenHandler::next_a;
+    }
+
+    auto action = m_handler.token (token_);
+
+    if (action == ITokenHandler::stop_a) {
+        m_stopped = true;
+    }
+
+    return action;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+Tokeniser::skip (size_t bytes_) {
+    m_skip = bytes_;
+    if (!m_skip) {
+        finishValue();
+    }
+}
+
+/******************************************************************************/
+
+/**
+ * A value has been fully read, let its parent know and, if that was
+ * the last thing it was waiting on, close it too and so on up the
+ * stack
+ */
+void
+amqp::internal::stream::
+Tokeniser::finishValue() {
+    while (!m_stack.empty()) {
+        if (--m_stack.back().remaining > 0) {
+            return;
+        }
+
+        Token end { };
+        end.type = m_stack.back().type;
+        end.end = true;
+        end.offset = m_offset;
+
+        bool wasSilent = silent();
+
+        m_stack.pop_back();
+
+        if (m_silentAt == m_stack.size()) {
+            m_silentAt = npos;
+        }
+
+        if (!wasSilent) {
+            emit (end);
+        }
+    }
+
+    ++m_values;
+}
+
+/******************************************************************************/
+
+/**
+ * Tokenise a single element whose bytes (as [measure] told us how many
+ * we needed) are all present
+ */
+void
+amqp::internal::stream::
+Tokeniser::atom (const uint8_t * p_, size_t len_) {
+    uint8_t code = implicit();
+    const uint8_t * body = p_;
+
+    if (code == 0xff) {
+        code = *body++;
+    }
+
+    Token token { };
+    token.type = typeOf (code);
+    token.offset = m_offset;
+
+    m_offset += len_;
+
+    switch (code) {
+        /*
+         * The compound types
+         */
+        case 0x00 :
+            token.count = 2;
+            m_stack.push_back ({ PN_DESCRIBED, 2, 0 });
+            if (emit (token) == ITokenHandler::skip_a) {
+                m_silentAt = m_stack.size() - 1;
+            }
+            return;
+        case 0x45 :
+        case 0xc0 : case 0xc1 : case 0xd0 : case 0xd1 :
+        case 0xe0 : case 0xf0 : {
+            size_t width = (code & 0x10U) ? 4 : 1;
+            uint8_t element = 0;
+
+            if (code != 0x45) {
+                token.size = be (body, width) - width;
+                token.count = be (body + width, width);
+            }
+
+            if (token.type == PN_ARRAY) {
+                element = body[2 * width];
+                token.element = element;
+                token.size -= 1;
+                if (typeOf (element) == PN_INVALID) {
+                    unknown (element, m_offset - 1);
+                }
+            }
+
+            /*
+             * Nothing is pushed for a compound we're skipping, once we've
+             * stepped over it it's just another value in its parent
+             */
+            if (silent() || emit (token) == ITokenHandler::skip_a) {
+                skip (token.size);
+                return;
+            }
+
+            if (token.count == 0) {
+                Token end { token };
+                end.end = true;
+                emit (end);
+                finishValue();
+                return;
+            }
+
+            m_stack.push_back ({ token.type, token.count, element });
+            return;
+        }
+        default :
+            break;
+    }
+
+    /*
+     * and the scalars
+     */
+    switch (code) {
+        case 0x40 : break;
+        case 0x41 : token.value.b = true; break;
+        case 0x42 : token.value.b = false; break;
+        case 0x56 : token.value.b = body[0] != 0; break;
+        case 0x43 : case 0x44 : token.value.ul = 0; break;
+        case 0x50 : case 0x52 : case 0x53 :
+            token.value.ul = body[0];
+            break;
+        case 0x51 : token.value.l = (int8_t)body[0]; break;
+        case 0x54 : token.value.l = (int8_t)body[0]; break;
+        case 0x55 : token.value.l = (int8_t)body[0]; break;
+        case 0x60 : token.value.ul = be (body, 2); break;
+        case 0x61 : token.value.l = (int16_t)be (body, 2); break;
+        case 0x70 : case 0x73 : case 0x74 :
+            token.value.ul = be (body, 4);
+            break;
+        case 0x71 : token.value.l = (int32_t)be (body, 4); break;
+        case 0x72 : {
+            auto bits = (uint32_t)be (body, 4);
+            float f;
+            std::memcpy (&f, &bits, sizeof (f));
+            token.value.d = f;
+            break;
+        }
+        case 0x80 : case 0x84 :
+            token.value.ul = be (body, 8);
+            break;
+        case 0x81 : case 0x83 :
+            token.value.l = (int64_t)be (body, 8);
+            break;
+        case 0x82 : {
+            auto bits = be (body, 8);
+            std::memcpy (&token.value.d, &bits, sizeof (double));
+            break;
+        }
+        case 0x94 : case 0x98 :
+            token.size = 16;
+            token.bytes = reinterpret_cast<const char *>(body);
+            break;
+        case 0xa0 : case 0xa1 : case 0xa3 :
+            token.size = body[0];
+            token.bytes = reinterpret_cast<const char *>(body + 1);
+            break;
+        case 0xb0 : case 0xb1 : case 0xb3 :
+            token.size = be (body, 4);
+            token.bytes = reinterpret_cast<const char *>(body + 4);
+            break;
+        default :
+            unknown (code, token.offset);
+    }
+
+    emit (token);
+    finishValue();
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+Tokeniser::feed (const char * data_, size_t size_) {
+    auto p = reinterpret_cast<const uint8_t *>(data_);
+    size_t used { 0 };
+
+    m_stopped = false;
+
+    while (used < size_ && !m_stopped) {
+        if (m_skip) {
+            auto n = std::min (m_skip, size_ - used);
+            used += n;
+            skipped (n);
+            continue;
+        }
+
+        size_t len;
+
+        if (!m_carry.empty()) {
+            /*
+             * Finish off the element we started last time, we may need
+             * a couple of goes if we didn't even have enough to know how
+             * long it is
+             */
+            while (!measure (
+                    reinterpret_cast<const uint8_t *>(m_carry.data()),
+                    m_carry.size(),
+                    len))
+            {
+                auto n = std::min (len - m_carry.size(), size_ - used);
+                m_carry.append (data_ + used, n);
+                used += n;
+                if (used == size_ && m_carry.size() < len) {
+                    return used;
+                }
+            }
+
+            auto n = std::min (len - m_carry.size(), size_ - used);
+            m_carry.append (data_ + used, n);
+            used += n;
+
+            if (m_carry.size() < len) {
+                return used;
+            }
+
+            std::string atomBytes;
+            std::swap (atomBytes, m_carry);
+            atom (reinterpret_cast<const uint8_t *>(atomBytes.data()), len);
+            continue;
+        }
+
+        if (!measure (p + used, size_ - used, len) || len > size_ - used) {
+            m_carry.assign (data_ + used, size_ - used);
+            return size_;
+        }
+
+        atom (p + used, len);
+        used += len;
+    }
+
+    return used;
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+Tokeniser::complete() const {
+    return m_stack.empty() && m_carry.empty() && !m_skip;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+Tokeniser::values() const {
+    return m_values;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+Tokeniser::offset() const {
+    return m_offset;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+Tokeniser::depth() const {
+    return m_stack.size();
+}
+
+/******************************************************************************/
+
+bool
+amqp::internal::stream::
+Tokeniser::stopped() const {
+    return m_stopped;
+}
+
+/******************************************************************************/
+
+size_t
+amqp::internal::stream::
+Tokeniser::skipping() const {
+    return m_skip;
+}
+
+/******************************************************************************/
+
+void
+amqp::internal::stream::
+Tokeniser::skipped (size_t bytes_) {
+    if (bytes_ > m_skip) {
+        throw std::runtime_error ("Skipped past the end of the element");
+    }
+
+    m_skip -= bytes_;
+    m_offset += bytes_;
+
+    if (!m_skip) {
+        finishValue();
+    }
+}
+
+/******************************************************************************/
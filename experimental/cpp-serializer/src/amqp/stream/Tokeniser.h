@@ -0,0 +1,256 @@
+#pragma once
+
+/******************************************************************************/
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <proton/codec.h>
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Token
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * One element of an AMQP encoded stream. Scalars are delivered
+     * whole, compound types (described, list, map and array) are
+     * delivered as an opening token followed by the tokens of their
+     * contents and then a closing token with [end] set.
+     *
+     * We reuse proton's type enumeration rather than invent our own,
+     * it's what the rest of the code already talks in.
+     */
+    struct Token {
+        pn_type_t type;
+
+        /**
+         * set on the token closing a compound type
+         */
+        bool end;
+
+        /**
+         * Where the constructor of this element sits, counted from the
+         * start of whatever was fed to the [Tokeniser]
+         */
+        size_t offset;
+
+        /**
+         * For compound types the number of encoded bytes following the
+         * header, for strings, symbols and binary the number of bytes
+         * in the payload
+         */
+        size_t size;
+
+        /**
+         * Element count for compound types. A map of n entries has 2n
+         * elements, described types always have 2.
+         */
+        size_t count;
+
+        union {
+            bool     b;
+            int64_t  l;
+            uint64_t ul;
+            double   d;
+        } value;
+
+        /**
+         * Payload of strings, symbols, binary and the wider fixed width
+         * types we don't interpret (decimal128, uuid). Only valid for
+         * the duration of the callback it was passed to.
+         */
+        const char * bytes;
+
+        /**
+         * For arrays, the constructor every element shares
+         */
+        uint8_t element;
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::ITokenHandler
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    class ITokenHandler {
+        public :
+            enum Action {
+                /** carry on as normal */
+                next_a,
+
+                /**
+                 * Don't tokenise the contents of the compound just opened,
+                 * no further tokens, including its closing one, will be
+                 * delivered for it. Lists, maps and arrays are stepped over
+                 * using their encoded size without looking at the bytes.
+                 * Meaningless on anything but an opening token.
+                 */
+                skip_a,
+
+                /**
+                 * Stop consuming input once the current element has been
+                 * dealt with, [Tokeniser::feed] returns early
+                 */
+                stop_a
+            };
+
+            virtual ~ITokenHandler() = default;
+
+            virtual Action token (const Token &) = 0;
+    };
+
+}
+
+/******************************************************************************
+ *
+ * amqp::internal::stream::Tokeniser
+ *
+ ******************************************************************************/
+
+namespace amqp::internal::stream {
+
+    /**
+     * An incremental decoder for the AMQP 1.0 type system that can be fed a
+     * stream in arbitrarily sized pieces. Everything it needs to resume is
+     * kept in an explicit stack of open compound types so when it runs out
+     * of bytes part way through an element it simply remembers the part it
+     * has and picks up where it left off on the next call to [feed].
+     *
+     * The only bytes ever copied are those of an element that straddles two
+     * calls, so memory use is bounded by the nesting depth of the data and
+     * the size of the largest single scalar rather than the whole stream.
+     */
+    class Tokeniser {
+        private :
+            struct Frame {
+                pn_type_t type;
+                size_t    remaining;
+
+                /**
+                 * Arrays only encode the constructor once, every
+                 * element then shares it
+                 */
+                uint8_t   element;
+            };
+
+            ITokenHandler & m_handler;
+
+            std::vector<Frame> m_stack;
+
+            /**
+             * bytes of an element we've only partially seen
+             */
+            std::string m_carry;
+
+            /**
+             * offset of the next element we will tokenise
+             */
+            size_t m_offset;
+
+            /**
+             * bytes still to be stepped over due to a skip
+             */
+            size_t m_skip;
+
+            /**
+             * when skipping a described type we have no size to jump
+             * over so instead tokenise it without telling anyone until
+             * the frame at this depth closes
+             */
+            size_t m_silentAt;
+
+            size_t m_values;
+
+            bool m_stopped;
+
+            /**
+             * the constructor top level values share should they be the
+             * elements of an array, 0xff if they each have their own
+             */
+            uint8_t m_element;
+
+            bool measure (const uint8_t *, size_t, size_t &) const;
+            void atom (const uint8_t *, size_t);
+            void finishValue();
+            ITokenHandler::Action emit (const Token &);
+            void skip (size_t);
+
+            uint8_t implicit() const;
+            bool silent() const;
+
+        public :
+            explicit Tokeniser (ITokenHandler &, size_t offset_ = 0);
+
+            /**
+             * Start again as if newly made, keeping the memory used so far
+             */
+            void reset (size_t offset_ = 0);
+
+            /**
+             * What's fed from here on is a run of an array's elements, every
+             * one without the [constructor_] the array gave them all
+             */
+            void elements (uint8_t constructor_);
+
+            /**
+             * How many bytes the whole of the element at the start of the
+             * buffer occupies, contents and all, found from the sizes it
+             * was encoded with rather than by reading it. [constructor_]
+             * is that of the array it's an element of, if it is one.
+             * Throws if the buffer ends before the element does.
+             */
+            static size_t span (const char *, size_t, uint8_t constructor_ = 0xff);
+
+            /**
+             * Consume as much of the buffer as we can. Returns the number of
+             * bytes consumed which will only be less than what was passed in
+             * when the handler asked us to stop.
+             */
+            size_t feed (const char *, size_t);
+
+            /**
+             * True when we're between top level values
+             */
+            bool complete() const;
+
+            /**
+             * How many top level values have been fully read
+             */
+            size_t values() const;
+
+            /**
+             * The offset of the next byte we expect to see
+             */
+            size_t offset() const;
+
+            size_t depth() const;
+
+            /**
+             * Did the handler ask us to stop during the last call to [feed]
+             */
+            bool stopped() const;
+
+            /**
+             * When stepping over a skipped element this is how many
+             * more bytes we're going to throw away. Callers reading
+             * from something seekable can jump over them and then
+             * tell us via [skipped]
+             */
+            size_t skipping() const;
+            void skipped (size_t);
+    };
+
+}
+
+/******************************************************************************/
@@ -0,0 +1,288 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "stream/ColumnWriter.h"
+
+/******************************************************************************/
+
+using namespace amqp::internal::stream;
+
+/******************************************************************************/
+
+namespace {
+
+    struct Column {
+        int type;
+        size_t children;
+        uint64_t length;
+        uint64_t nulls;
+        std::vector<std::string> buffers;
+    };
+
+    /**
+     * The columns of a group by their path, "" being the root and the
+     * rest dot separated from there
+     */
+    using Group = std::map<std::string, Column>;
+
+    template<typename T>
+    T
+    get (const std::string & in_, size_t & at_) {
+        T rtn;
+        std::memcpy (&rtn, in_.data() + at_, sizeof (rtn));
+        at_ += sizeof (rtn);
+        return rtn;
+    }
+
+    /**
+     * Just enough of a reader for the file format to check what was
+     * written against what we expected
+     */
+    std::vector<Group>
+    read (const std::string & file_) {
+        EXPECT_EQ ("CORDACOL", file_.substr (0, 8));
+
+        std::vector<Group> rtn;
+        size_t at { 8 };
+
+        for ( ; ; ) {
+            EXPECT_EQ (0xffffffff, get<uint32_t> (file_, at));
+            auto size = get<uint32_t> (file_, at);
+
+            if (!size) {
+                EXPECT_EQ (file_.size(), at);
+                return rtn;
+            }
+
+            EXPECT_EQ (0U, size % 8);
+
+            auto body = at + size;
+            auto bodySize = get<uint64_t> (file_, at);
+            get<uint64_t> (file_, at);
+            auto columns = get<uint32_t> (file_, at);
+
+            Group group;
+            std::vector<std::pair<std::string, size_t>> parents;
+
+            for (uint32_t i { 0 } ; i < columns ; ++i) {
+                auto nameSize = get<uint16_t> (file_, at);
+                auto name = file_.substr (at, nameSize);
+                at += nameSize;
+
+                Column column;
+                column.type = get<uint8_t> (file_, at);
+                column.children = get<uint32_t> (file_, at);
+                column.length = get<uint64_t> (file_, at);
+                column.nulls = get<uint64_t> (file_, at);
+
+                for (auto n = get<uint8_t> (file_, at) ; n ; --n) {
+                    auto offset = get<uint64_t> (file_, at);
+                    auto bytes = get<uint64_t> (file_, at);
+
+                    EXPECT_EQ (0U, offset % 8);
+                    EXPECT_LE (offset + bytes, bodySize);
+
+                    column.buffers.push_back (file_.substr (body + offset, bytes));
+                }
+
+                std::string path;
+
+                if (!parents.empty()) {
+                    path = parents.back().first.empty()
+                        ? name
+                        : parents.back().first + "." + name;
+
+                    if (!--parents.back().second) {
+                        parents.pop_back();
+                    }
+                }
+
+                if (column.children) {
+                    parents.emplace_back (path, column.children);
+                }
+
+                group[path] = column;
+            }
+
+            at = body + bodySize;
+            rtn.push_back (std::move (group));
+        }
+    }
+
+    template<typename T>
+    std::vector<T>
+    values (const std::string & buffer_) {
+        std::vector<T> rtn (buffer_.size() / sizeof (T));
+        std::memcpy (rtn.data(), buffer_.data(), buffer_.size());
+        return rtn;
+    }
+
+}
+
+/******************************************************************************/
+
+TEST (ColumnWriter, composites) { // NOLINT
+    std::stringstream ss;
+    ColumnWriter writer (ss);
+
+    writer.beginComposite ("t", 3);
+    writer.property ("a"); writer.value (int32_t { 1 });
+    writer.property ("b"); writer.value (std::string_view ("xy"));
+    writer.property ("c"); writer.value (true);
+    writer.endComposite();
+
+    writer.beginComposite ("t", 3);
+    writer.property ("a"); writer.value (int32_t { 2 });
+    writer.property ("b"); writer.null();
+    writer.property ("c"); writer.value (false);
+    writer.endComposite();
+
+    writer.beginComposite ("t", 3);
+    writer.property ("a"); writer.value (int32_t { 3 });
+    writer.property ("b"); writer.value (std::string_view ("z"));
+    writer.property ("c"); writer.value (true);
+    writer.endComposite();
+
+    writer.close();
+
+    auto groups = read (ss.str());
+    ASSERT_EQ (1U, groups.size());
+    auto & g = groups[0];
+
+    EXPECT_EQ (ColumnWriter::struct_t, g[""].type);
+    EXPECT_EQ (3U, g[""].length);
+    EXPECT_EQ (3U, g[""].children);
+
+    EXPECT_EQ (ColumnWriter::int_t, g["a"].type);
+    EXPECT_EQ ((std::vector<int32_t> { 1, 2, 3 }), values<int32_t> (g["a"].buffers[1]));
+
+    EXPECT_EQ (ColumnWriter::string_t, g["b"].type);
+    EXPECT_EQ (1U, g["b"].nulls);
+    EXPECT_EQ (0x5, g["b"].buffers[0][0]);
+    EXPECT_EQ ((std::vector<int32_t> { 0, 2, 2, 3 }), values<int32_t> (g["b"].buffers[1]));
+    EXPECT_EQ ("xyz", g["b"].buffers[2]);
+
+    EXPECT_EQ (ColumnWriter::bool_t, g["c"].type);
+    EXPECT_EQ (0x5, g["c"].buffers[1][0]);
+}
+
+/******************************************************************************/
+
+/**
+ * Lists and maps are offsets into their children, and a property that
+ * doesn't turn up until later is null in the rows before it did
+ */
+TEST (ColumnWriter, nested) { // NOLINT
+    std::stringstream ss;
+    ColumnWriter writer (ss);
+
+    writer.beginComposite ("t", 1);
+    writer.property ("l");
+    writer.beginList (2);
+    writer.value (int64_t { 1 });
+    writer.value (int64_t { 2 });
+    writer.endList();
+    writer.endComposite();
+
+    writer.beginComposite ("t", 2);
+    writer.property ("l");
+    writer.beginList (0);
+    writer.endList();
+    writer.property ("m");
+    writer.beginMap (1);
+    writer.value (std::string_view ("k"));
+    writer.value (1.5);
+    writer.endMap();
+    writer.endComposite();
+
+    writer.close();
+
+    auto groups = read (ss.str());
+    ASSERT_EQ (1U, groups.size());
+    auto & g = groups[0];
+
+    EXPECT_EQ (ColumnWriter::list_t, g["l"].type);
+    EXPECT_EQ ((std::vector<int32_t> { 0, 2, 2 }), values<int32_t> (g["l"].buffers[1]));
+    EXPECT_EQ ((std::vector<int64_t> { 1, 2 }), values<int64_t> (g["l.item"].buffers[1]));
+
+    EXPECT_EQ (ColumnWriter::map_t, g["m"].type);
+    EXPECT_EQ (2U, g["m"].length);
+    EXPECT_EQ (1U, g["m"].nulls);
+    EXPECT_EQ ((std::vector<int32_t> { 0, 0, 1 }), values<int32_t> (g["m"].buffers[1]));
+    EXPECT_EQ ("k", g["m.key"].buffers[2]);
+    EXPECT_EQ ((std::vector<double> { 1.5 }), values<double> (g["m.value"].buffers[1]));
+}
+
+/******************************************************************************/
+
+/**
+ * A row abandoned part way through leaves no trace, and rows are written
+ * out a group at a time
+ */
+TEST (ColumnWriter, groups) { // NOLINT
+    std::stringstream ss;
+    ColumnWriter writer (ss, 2);
+
+    auto row = [&writer](int32_t i_) {
+        writer.beginComposite ("t", 1);
+        writer.property ("i");
+        writer.value (i_);
+        writer.endComposite();
+    };
+
+    row (1);
+
+    writer.beginComposite ("t", 2);
+    writer.property ("i");
+    writer.value (int32_t { 99 });
+    writer.property ("j");
+    writer.beginList (1);
+    writer.discard();
+
+    row (2);
+    row (3);
+
+    writer.close();
+
+    EXPECT_EQ (3U, writer.rows());
+
+    auto groups = read (ss.str());
+    ASSERT_EQ (2U, groups.size());
+
+    EXPECT_EQ (2U, groups[0][""].length);
+    EXPECT_EQ ((std::vector<int32_t> { 1, 2 }), values<int32_t> (groups[0]["i"].buffers[1]));
+
+    // the list was begun but as nothing was ever written to it it was
+    // only ever null
+    EXPECT_EQ (2U, groups[0]["j"].nulls);
+
+    EXPECT_EQ (1U, groups[1][""].length);
+    EXPECT_EQ ((std::vector<int32_t> { 3 }), values<int32_t> (groups[1]["i"].buffers[1]));
+}
+
+/******************************************************************************/
+
+TEST (ColumnWriter, conflicts) { // NOLINT
+    std::stringstream ss;
+    ColumnWriter writer (ss);
+
+    writer.beginComposite ("t", 1);
+    writer.property ("a");
+    writer.value (int32_t { 1 });
+    writer.endComposite();
+
+    writer.beginComposite ("t", 1);
+    writer.property ("a");
+    EXPECT_THROW (writer.value (std::string_view ("one")), std::runtime_error);
+
+    writer.discard();
+    EXPECT_THROW (writer.reference (0), std::runtime_error);
+}
+
+/******************************************************************************/
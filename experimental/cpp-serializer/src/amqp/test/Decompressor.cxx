@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <sstream>
+
+#include "stream/Decompressor.h"
+
+/******************************************************************************/
+
+using namespace amqp::internal::stream;
+
+/******************************************************************************/
+
+namespace {
+
+    const std::string expected { "hello hello hello hello" }; // NOLINT
+
+    /**
+     * zlib.compress (expected)
+     */
+    const std::string deflated { // NOLINT
+        "\x78\x9c\xcb\x48\xcd\xc9\xc9\x57\xc8\x40\x27\x01\x68\x03\x08\xb1", 16
+    };
+
+    /**
+     * Snappy framed: stream identifier then one compressed chunk holding
+     * a literal "hello " and a copy of 17 bytes from 6 back
+     */
+    const std::string snapped { // NOLINT
+        "\xff\x06\x00\x00" "sNaPpY"
+        "\x00\x0f\x00\x00" "\x8a\x1f\xb1\x54"
+            "\x17" "\x14" "hello " "\x42\x06\x00", 29
+    };
+
+    std::string
+    drain (Decompressor & d_, const std::string & in_, size_t chunk_) {
+        std::string out;
+        char buffer[5];
+
+        for (size_t i { 0 } ; i < in_.size() ; i += chunk_) {
+            d_.input (in_.data() + i, std::min (chunk_, in_.size() - i));
+
+            while (auto n = d_.output (buffer, sizeof (buffer))) {
+                out.append (buffer, n);
+            }
+        }
+
+        return out;
+    }
+
+}
+
+/******************************************************************************/
+
+TEST (Decompressor, deflate) { // NOLINT
+    for (size_t chunk : { 1, 3, 100 }) {
+        auto d = Decompressor::make (amqp::DEFLATE);
+        EXPECT_EQ (expected, drain (*d, deflated, chunk));
+        EXPECT_TRUE (d->finished());
+    }
+}
+
+/******************************************************************************/
+
+TEST (Decompressor, snappy) { // NOLINT
+    for (size_t chunk : { 1, 3, 100 }) {
+        auto d = Decompressor::make (amqp::SNAPPY);
+        EXPECT_EQ (expected, drain (*d, snapped, chunk));
+    }
+}
+
+/******************************************************************************/
+
+TEST (Decompressor, inflate) { // NOLINT
+    std::stringstream ss (deflated);
+    auto v = Decompressor::inflate (ss, amqp::DEFLATE);
+
+    EXPECT_EQ (expected, std::string (v.begin(), v.end()));
+}
+
+/******************************************************************************/
+
+TEST (Decompressor, corrupt) { // NOLINT
+    auto bad { snapped };
+    bad[14] ^= 1; // NOLINT
+
+    auto d = Decompressor::make (amqp::SNAPPY);
+    EXPECT_THROW (drain (*d, bad, bad.size()), std::runtime_error);
+
+    EXPECT_THROW (Decompressor::make (7), std::runtime_error);
+}
+
+/******************************************************************************/
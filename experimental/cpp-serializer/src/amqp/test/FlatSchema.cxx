@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include "types.h"
+
+#include "CompositeFactory.h"
+
+#include "schema/FlatSchema.h"
+#include "schema/described-types/Schema.h"
+#include "schema/described-types/Composite.h"
+#include "schema/described-types/Choice.h"
+#include "schema/described-types/Descriptor.h"
+#include "schema/restricted-types/Restricted.h"
+
+/******************************************************************************/
+
+using namespace amqp::internal::schema;
+
+/******************************************************************************/
+
+namespace {
+
+    uPtr<Schema>
+    schema() {
+        OrderedTypeNotations<AMQPTypeNotation> types;
+
+        std::vector<uPtr<Field>> fields;
+        fields.emplace_back (Field::make ("a", "int", { }, "", "", true, false));
+        fields.emplace_back (Field::make ("b", "string", { }, "0", "bee", false, false));
+        fields.emplace_back (Field::make (
+                "c", "*", { "java.util.List<net.corda.E>" }, "", "", true, false));
+        fields.emplace_back (Field::make (
+                "d", "*", { "java.util.Map<string, net.corda.E>" }, "", "", true, false));
+
+        types.insert (std::make_unique<Composite> (
+                "net.corda.C", "", std::list<std::string> { "net.corda.I" },
+                std::make_unique<Descriptor> ("net.corda:C"),
+                std::move (fields)));
+
+        types.insert (Restricted::make (
+                std::make_unique<Descriptor> ("net.corda:L"),
+                "java.util.List<net.corda.E>", "", { }, "list", { }));
+
+        types.insert (Restricted::make (
+                std::make_unique<Descriptor> ("net.corda:M"),
+                "java.util.Map<string, net.corda.E>", "", { }, "map", { }));
+
+        std::vector<uPtr<Choice>> choices;
+        choices.emplace_back (std::make_unique<Choice> ("X"));
+        choices.emplace_back (std::make_unique<Choice> ("Y"));
+
+        types.insert (Restricted::make (
+                std::make_unique<Descriptor> ("net.corda:E"),
+                "net.corda.E", "", { }, "list", std::move (choices)));
+
+        return std::make_unique<Schema> (std::move (types));
+    }
+
+    std::vector<std::string>
+    strings (const FlatSchema & flat_, const FlatSchema::Range & range_) {
+        std::vector<std::string> rtn;
+
+        for (auto id : flat_.ids (range_)) {
+            rtn.emplace_back (flat_.string (id));
+        }
+
+        return rtn;
+    }
+
+}
+
+/******************************************************************************/
+
+TEST (FlatSchema, types) { // NOLINT
+    FlatSchema flat (*schema());
+
+    ASSERT_EQ (4U, flat.types().size());
+
+    // dependencies first, the composite last
+    EXPECT_EQ ("net.corda.E", flat.string (flat.types().front().name));
+    EXPECT_EQ ("net.corda.C", flat.string (flat.types().back().name));
+
+    const auto * c = flat.byName ("net.corda.C");
+    ASSERT_NE (nullptr, c);
+    EXPECT_EQ (c, flat.byDescriptor ("net.corda:C"));
+    EXPECT_EQ (FlatSchema::composite_k, c->kind);
+    EXPECT_EQ (std::vector<std::string> { "net.corda.I" }, strings (flat, c->provides));
+
+    auto fields = flat.fields (*c);
+    ASSERT_EQ (4U, fields.size());
+
+    EXPECT_EQ ("a", flat.string (fields[0].name));
+    EXPECT_EQ (FlatSchema::primitive_f, fields[0].kind);
+    EXPECT_TRUE (fields[0].mandatory);
+
+    EXPECT_EQ ("0", flat.string (fields[1].defaultValue));
+    EXPECT_EQ ("bee", flat.string (fields[1].label));
+    EXPECT_FALSE (fields[1].mandatory);
+
+    EXPECT_EQ ("*", flat.string (fields[2].type));
+    EXPECT_EQ (FlatSchema::restricted_f, fields[2].kind);
+    EXPECT_EQ ("java.util.List<net.corda.E>", flat.string (fields[2].resolved));
+
+    const auto * l = flat.byDescriptor ("net.corda:L");
+    ASSERT_NE (nullptr, l);
+    EXPECT_EQ (FlatSchema::list_k, l->kind);
+    EXPECT_EQ (std::vector<std::string> { "net.corda.E" }, strings (flat, l->of));
+
+    const auto * m = flat.byDescriptor ("net.corda:M");
+    ASSERT_NE (nullptr, m);
+    EXPECT_EQ (FlatSchema::map_k, m->kind);
+    EXPECT_EQ ((std::vector<std::string> { "string", "net.corda.E" }), strings (flat, m->of));
+
+    const auto * e = flat.byName ("net.corda.E");
+    ASSERT_NE (nullptr, e);
+    EXPECT_EQ (FlatSchema::enum_k, e->kind);
+    EXPECT_EQ ((std::vector<std::string> { "X", "Y" }), strings (flat, e->of));
+
+    EXPECT_EQ (nullptr, flat.byName ("net.corda.D"));
+    EXPECT_EQ (nullptr, flat.byDescriptor ("net.corda:D"));
+}
+
+/******************************************************************************/
+
+/**
+ * Each string is held once however many times it appears, the empty one
+ * being ID 0
+ */
+TEST (FlatSchema, interned) { // NOLINT
+    FlatSchema flat (*schema());
+
+    const auto * e = flat.byName ("net.corda.E");
+    const auto * l = flat.byName ("java.util.List<net.corda.E>");
+    const auto * m = flat.byName ("java.util.Map<string, net.corda.E>");
+
+    EXPECT_EQ (e->name, flat.ids (l->of)[0]);
+    EXPECT_EQ (e->name, flat.ids (m->of)[1]);
+
+    EXPECT_EQ (0U, e->label);
+    EXPECT_EQ ("", flat.string (0));
+}
+
+/******************************************************************************/
+
+TEST (FlatSchema, readers) { // NOLINT
+    auto s = schema();
+
+    amqp::internal::CompositeFactory factory;
+    factory.process (*s);
+
+    for (const auto & d : { "net.corda:C", "net.corda:L", "net.corda:M", "net.corda:E" }) {
+        auto reader = factory.byDescriptor (d);
+        ASSERT_NE (nullptr, reader) << d;
+        EXPECT_EQ (s->fromDescriptor (d)->second.get()->name(), reader->type());
+    }
+
+    EXPECT_EQ (nullptr, factory.byDescriptor ("net.corda:D"));
+}
+
+/******************************************************************************/
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+#include "Format.h"
+
+/******************************************************************************/
+
+using namespace amqp::internal::reader;
+
+/******************************************************************************/
+
+TEST (Format, integers) { // NOLINT
+    EXPECT_EQ ("0", toString (int32_t { 0 }));
+    EXPECT_EQ ("-1", toString (int32_t { -1 }));
+    EXPECT_EQ ("2147483647", toString (std::numeric_limits<int32_t>::max()));
+    EXPECT_EQ ("-2147483648", toString (std::numeric_limits<int32_t>::min()));
+    EXPECT_EQ ("-9223372036854775808", toString (std::numeric_limits<int64_t>::min()));
+
+    EXPECT_EQ ("1", toString (true));
+    EXPECT_EQ ("0", toString (false));
+}
+
+/******************************************************************************/
+
+TEST (Format, doubles) { // NOLINT
+    EXPECT_EQ ("10.1", toString (10.1));
+    EXPECT_EQ ("10.0", toString (10.0));
+    EXPECT_EQ ("-3.0", toString (-3.0));
+    EXPECT_EQ ("0.0", toString (0.0));
+    EXPECT_EQ ("0.1", toString (0.1));
+    EXPECT_EQ ("1e+300", toString (1e300));
+    EXPECT_EQ ("5e-324", toString (std::numeric_limits<double>::denorm_min()));
+    EXPECT_EQ ("inf", toString (std::numeric_limits<double>::infinity()));
+}
+
+/******************************************************************************/
+
+/**
+ * Whatever we write has to read back as exactly the same value
+ */
+TEST (Format, roundTrip) { // NOLINT
+    std::mt19937_64 gen (42);
+
+    for (int i { 0 } ; i < 100000 ; ++i) {
+        auto bits = gen();
+        double d;
+        std::memcpy (&d, &bits, sizeof (d));
+
+        if (d != d) {
+            continue;
+        }
+
+        auto s = toString (d);
+        EXPECT_EQ (d, std::strtod (s.c_str(), nullptr)) << s;
+    }
+}
+
+/******************************************************************************/
+
+TEST (Format, quote) { // NOLINT
+    EXPECT_EQ (R"("")", quote (""));
+    EXPECT_EQ (R"("plain")", quote ("plain"));
+    EXPECT_EQ (R"("say \"hi\"")", quote (R"(say "hi")"));
+    EXPECT_EQ (R"("C:\\temp")", quote (R"(C:\temp)"));
+    EXPECT_EQ (R"("a\tb\nc\r\b\f")", quote ("a\tb\nc\r\b\f"));
+    EXPECT_EQ (R"("\u0000\u001f")", quote (std::string ("\0\x1f", 2)));
+
+    // DEL is printable as far as JSON cares
+    EXPECT_EQ ("\"\x7f\"", quote ("\x7f"));
+}
+
+/******************************************************************************/
+
+TEST (Format, utf8) { // NOLINT
+    // 2, 3 and 4 byte sequences pass straight through
+    EXPECT_EQ ("\"caf\xc3\xa9\"", quote ("caf\xc3\xa9"));
+    EXPECT_EQ ("\"\xe2\x82\xac 5\"", quote ("\xe2\x82\xac 5"));
+    EXPECT_EQ ("\"\xf0\x9f\x98\x80\"", quote ("\xf0\x9f\x98\x80"));
+
+    const std::string r { "\xef\xbf\xbd" };
+
+    // a stray continuation byte, and a lead byte that can never appear
+    EXPECT_EQ ("\"a" + r + "b\"", quote ("a\x80" "b"));
+    EXPECT_EQ ("\"" + r + "\"", quote ("\xff"));
+
+    // overlong, a surrogate, beyond U+10FFFF and cut short
+    EXPECT_EQ ("\"" + r + r + "\"", quote ("\xc0\xaf"));
+    EXPECT_EQ ("\"" + r + r + r + "\"", quote ("\xed\xa0\x80"));
+    EXPECT_EQ ("\"" + r + r + r + r + "\"", quote ("\xf4\x90\x80\x80"));
+    EXPECT_EQ ("\"" + r + r + "\"", quote ("\xe2\x82"));
+}
+
+/******************************************************************************/
+
+/**
+ * Wherever in a string the character needing escaping falls, relative
+ * to the blocks it's scanned in, it should be found
+ */
+TEST (Format, quoteBlocks) { // NOLINT
+    for (size_t size { 1 } ; size < 100 ; ++size) {
+        for (size_t i { 0 } ; i < size ; ++i) {
+            std::string in (size, 'x');
+            in[i] = '"';
+
+            std::string expected { "\"" + in.substr (0, i) + "\\\""
+                + in.substr (i + 1) + "\"" };
+
+            EXPECT_EQ (expected, quote (in)) << size << " " << i;
+
+            in[i] = '\xc3';
+            EXPECT_EQ ("\"" + in.substr (0, i) + "\xef\xbf\xbd"
+                + in.substr (i + 1) + "\"", quote (in)) << size << " " << i;
+        }
+    }
+}
+
+/******************************************************************************/
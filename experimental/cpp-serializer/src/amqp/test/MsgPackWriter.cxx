@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <sstream>
+
+#include "stream/MsgPackWriter.h"
+
+/******************************************************************************/
+
+using namespace amqp::internal::stream;
+
+/******************************************************************************/
+
+namespace {
+
+    template<typename T>
+    std::string
+    packed (T value_) {
+        std::stringstream ss;
+        MsgPackWriter writer (ss);
+
+        writer.value (value_);
+
+        return ss.str();
+    }
+
+    std::string
+    bytes (const char * bytes_, size_t size_) {
+        return std::string (bytes_, size_);
+    }
+
+}
+
+/******************************************************************************/
+
+/**
+ * Every integer in the smallest form that holds it
+ */
+TEST (MsgPackWriter, integers) { // NOLINT
+    EXPECT_EQ (bytes ("\x00", 1), packed (int32_t { 0 }));
+    EXPECT_EQ ("\x7f", packed (int32_t { 127 }));
+    EXPECT_EQ ("\xcc\x80", packed (int32_t { 128 }));
+    EXPECT_EQ ("\xcc\xff", packed (int32_t { 255 }));
+    EXPECT_EQ (bytes ("\xcd\x01\x00", 3), packed (int32_t { 256 }));
+    EXPECT_EQ (bytes ("\xce\x00\x01\x00\x00", 5), packed (int32_t { 65536 }));
+    EXPECT_EQ (bytes ("\xcf\x00\x00\x00\x01\x00\x00\x00\x00", 9), packed (int64_t { 1LL << 32 }));
+
+    EXPECT_EQ ("\xff", packed (int32_t { -1 }));
+    EXPECT_EQ ("\xe0", packed (int32_t { -32 }));
+    EXPECT_EQ ("\xd0\xdf", packed (int32_t { -33 }));
+    EXPECT_EQ ("\xd0\x80", packed (int32_t { -128 }));
+    EXPECT_EQ ("\xd1\xff\x7f", packed (int32_t { -129 }));
+    EXPECT_EQ (bytes ("\xd2\xff\xff\x7f\xff", 5), packed (int32_t { -32769 }));
+    EXPECT_EQ (bytes ("\xd3\x80\x00\x00\x00\x00\x00\x00\x00", 9),
+        packed (std::numeric_limits<int64_t>::min()));
+}
+
+/******************************************************************************/
+
+TEST (MsgPackWriter, primitives) { // NOLINT
+    EXPECT_EQ ("\xc3", packed (true));
+    EXPECT_EQ ("\xc2", packed (false));
+    EXPECT_EQ (bytes ("\xcb\x3f\xf8\x00\x00\x00\x00\x00\x00", 9), packed (1.5));
+
+    EXPECT_EQ ("\xa3" "abc", packed (std::string_view ("abc")));
+
+    std::string s31 (31, 'x'), s32 (32, 'x'), s256 (256, 'x');
+
+    EXPECT_EQ ("\xbf" + s31, packed (std::string_view (s31)));
+    EXPECT_EQ ("\xd9\x20" + s32, packed (std::string_view (s32)));
+    EXPECT_EQ (bytes ("\xda\x01\x00", 3) + s256, packed (std::string_view (s256)));
+}
+
+/******************************************************************************/
+
+TEST (MsgPackWriter, containers) { // NOLINT
+    std::stringstream ss;
+    MsgPackWriter writer (ss);
+
+    writer.beginComposite ("t", 2);
+    writer.property ("a");
+    writer.beginList (16);
+    for (int i { 0 } ; i < 16 ; ++i) {
+        writer.null();
+    }
+    writer.endList();
+    writer.property ("m");
+    writer.beginMap (1);
+    writer.value (int32_t { 1 });
+    writer.enumeration ("E");
+    writer.endMap();
+    writer.endComposite();
+
+    EXPECT_EQ (
+        bytes ("\x82" "\xa1" "a" "\xdc\x00\x10", 6) + std::string (16, '\xc0')
+            + "\xa1" "m" "\x81" "\x01" "\xa1" "E",
+        ss.str());
+}
+
+/******************************************************************************/
+
+/**
+ * Nothing is written until a value is complete, so one abandoned part way
+ * through leaves no trace
+ */
+TEST (MsgPackWriter, discard) { // NOLINT
+    std::stringstream ss;
+    MsgPackWriter writer (ss);
+
+    writer.beginList (2);
+    writer.value (int32_t { 1 });
+    EXPECT_EQ ("", ss.str());
+
+    writer.discard();
+
+    writer.reference (3);
+    EXPECT_EQ (bytes ("\xd6\x01\x00\x00\x00\x03", 6), ss.str());
+}
+
+/******************************************************************************/
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+
+#include "stream/Tokeniser.h"
+#include "stream/Predicate.h"
+
+/******************************************************************************/
+
+using namespace amqp::internal::stream;
+
+/******************************************************************************/
+
+namespace {
+
+    Token
+    integer (pn_type_t type_, int64_t value_) {
+        Token token { };
+        token.type = type_;
+        token.value.l = value_;
+
+        return token;
+    }
+
+    Token
+    unsignedInteger (uint64_t value_) {
+        Token token { };
+        token.type = PN_ULONG;
+        token.value.ul = value_;
+
+        return token;
+    }
+
+    Token
+    real (double value_) {
+        Token token { };
+        token.type = PN_DOUBLE;
+        token.value.d = value_;
+
+        return token;
+    }
+
+    Token
+    string (const std::string & value_) {
+        Token token { };
+        token.type = PN_STRING;
+        token.size = value_.size();
+        token.bytes = value_.data();
+
+        return token;
+    }
+
+    Token
+    boolean (bool value_) {
+        Token token { };
+        token.type = PN_BOOL;
+        token.value.b = value_;
+
+        return token;
+    }
+
+}
+
+/******************************************************************************/
+
+TEST (Predicate, numbers) { // NOLINT
+    EXPECT_TRUE (Predicate ("a == 10").test (integer (PN_INT, 10)));
+    EXPECT_FALSE (Predicate ("a == 10").test (integer (PN_INT, 11)));
+    EXPECT_TRUE (Predicate ("a != 10").test (integer (PN_LONG, 11)));
+    EXPECT_TRUE (Predicate ("a<10").test (integer (PN_INT, -3)));
+    EXPECT_FALSE (Predicate ("a < 10").test (integer (PN_INT, 10)));
+    EXPECT_TRUE (Predicate ("a <= 10").test (integer (PN_INT, 10)));
+    EXPECT_TRUE (Predicate ("a > -1").test (integer (PN_SHORT, 0)));
+    EXPECT_TRUE (Predicate ("a >= 2.5").test (integer (PN_INT, 3)));
+    EXPECT_FALSE (Predicate ("a >= 2.5").test (integer (PN_INT, 2)));
+
+    EXPECT_TRUE (Predicate ("a == 1.5").test (real (1.5)));
+    EXPECT_TRUE (Predicate ("a < 2").test (real (1.5)));
+    EXPECT_TRUE (Predicate ("a > 1e10").test (real (2e10)));
+
+    /*
+     * Every int64 compared exactly, without a trip through double
+     */
+    EXPECT_FALSE (Predicate ("a == 9007199254740993").test (
+            integer (PN_LONG, 9007199254740992)));
+
+    EXPECT_TRUE (Predicate ("a > -1").test (
+            unsignedInteger (std::numeric_limits<uint64_t>::max())));
+    EXPECT_TRUE (Predicate ("a == 7").test (unsignedInteger (7)));
+
+    EXPECT_FALSE (Predicate ("a == 1").test (boolean (true)));
+
+    /*
+     * Too large for an int64 is compared as a double, too large for
+     * that is an error
+     */
+    EXPECT_FALSE (Predicate ("a > 99999999999999999999").test (integer (PN_LONG, 1000000)));
+    EXPECT_TRUE (Predicate ("a < 99999999999999999999").test (integer (PN_LONG, 1000000)));
+    EXPECT_TRUE (Predicate ("a > -99999999999999999999").test (integer (PN_INT, -1)));
+    EXPECT_THROW (Predicate ("a > 1e999"), std::runtime_error);
+}
+
+/******************************************************************************/
+
+TEST (Predicate, strings) { // NOLINT
+    EXPECT_TRUE (Predicate ("a == abc").test (string ("abc")));
+    EXPECT_TRUE (Predicate ("a == \"a b\"").test (string ("a b")));
+    EXPECT_TRUE (Predicate ("a == 'x == y'").test (string ("x == y")));
+    EXPECT_TRUE (Predicate ("a == 10").test (string ("10")));
+    EXPECT_FALSE (Predicate ("a == abc").test (string ("abcd")));
+    EXPECT_TRUE (Predicate ("a != abc").test (string ("abcd")));
+
+    EXPECT_TRUE (Predicate ("a ^= ab").test (string ("abcd")));
+    EXPECT_TRUE (Predicate ("a ^= ''").test (string ("")));
+    EXPECT_FALSE (Predicate ("a ^= abcde").test (string ("abcd")));
+    EXPECT_FALSE (Predicate ("a ^= 1").test (integer (PN_INT, 10)));
+
+    EXPECT_TRUE (Predicate ("a == true").test (boolean (true)));
+    EXPECT_TRUE (Predicate ("a != true").test (boolean (false)));
+    EXPECT_FALSE (Predicate ("a == false").test (boolean (true)));
+
+    Token null { };
+    null.type = PN_NULL;
+
+    EXPECT_FALSE (Predicate ("a == abc").test (null));
+    EXPECT_FALSE (Predicate ("a != abc").test (null));
+}
+
+/******************************************************************************/
+
+TEST (Predicate, syntax) { // NOLINT
+    EXPECT_ANY_THROW (Predicate ("a"));
+    EXPECT_ANY_THROW (Predicate ("a =="));
+    EXPECT_ANY_THROW (Predicate ("== 1"));
+    EXPECT_ANY_THROW (Predicate ("a. == 1"));
+    EXPECT_ANY_THROW (Predicate ("a ! 1"));
+    EXPECT_ANY_THROW (Predicate ("a ^ 1"));
+    EXPECT_ANY_THROW (Predicate ("a < abc"));
+    EXPECT_ANY_THROW (Predicate ("a >= true"));
+
+    EXPECT_NO_THROW (Predicate ("a.b.c = 1"));
+}
+
+/******************************************************************************/
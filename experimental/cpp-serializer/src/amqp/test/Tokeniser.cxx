@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <sstream>
+
+#include "stream/Tokeniser.h"
+
+/******************************************************************************/
+
+using namespace amqp::internal::stream;
+
+/******************************************************************************/
+
+namespace {
+
+    /**
+     * described (ulong 1) [
+     *     int 5,
+     *     string "abc",
+     *     [ ],
+     *     { true : int 7 },
+     *     array of int [ 1, 2, 3 ]
+     * ]
+     */
+    const std::string encoded { // NOLINT
+        "\x00\x53\x01"
+        "\xc0\x16\x05"
+            "\x54\x05"
+            "\xa1\x03" "abc"
+            "\x45"
+            "\xc1\x04\x02" "\x41" "\x54\x07"
+            "\xe0\x05\x03\x54" "\x01\x02\x03",
+        27
+    };
+
+    const std::string expected { // NOLINT
+        "D2 ul:1 L5 i:5 s:abc L0 /L M2 b:1 i:7 /M A3 i:1 i:2 i:3 /A /L /D "
+    };
+
+    /**
+     * Write each token out in a compact form so we can easily compare
+     * what we were handed
+     */
+    class Recorder : public ITokenHandler {
+        private :
+            pn_type_t m_skip;
+            pn_type_t m_stop;
+
+        public :
+            std::stringstream ss;
+
+            explicit Recorder (
+                pn_type_t skip_ = PN_INVALID,
+                pn_type_t stop_ = PN_INVALID
+            ) : m_skip (skip_)
+              , m_stop (stop_)
+            { }
+
+            Action token (const Token & token_) override {
+                const char * c = "";
+                switch (token_.type) {
+                    case PN_DESCRIBED : c = "D"; break;
+                    case PN_LIST : c = "L"; break;
+                    case PN_MAP : c = "M"; break;
+                    case PN_ARRAY : c = "A"; break;
+                    case PN_ULONG : ss << "ul:" << token_.value.ul; break;
+                    case PN_INT : ss << "i:" << token_.value.l; break;
+                    case PN_BOOL : ss << "b:" << token_.value.b; break;
+                    case PN_STRING :
+                        ss << "s:" << std::string (token_.bytes, token_.size);
+                        break;
+                    default : ss << "?"; break;
+                }
+
+                if (token_.end) {
+                    ss << "/" << c;
+                } else if (*c) {
+                    ss << c << token_.count;
+                }
+
+                ss << " ";
+
+                if (token_.type == m_stop) {
+                    return stop_a;
+                }
+
+                return (!token_.end && token_.type == m_skip) ? skip_a : next_a;
+            }
+    };
+
+}
+
+/******************************************************************************/
+
+TEST (Tokeniser, whole) { // NOLINT
+    Recorder r;
+    Tokeniser t (r);
+
+    EXPECT_EQ(encoded.size(), t.feed (encoded.data(), encoded.size()));
+    EXPECT_EQ(expected, r.ss.str());
+    EXPECT_TRUE(t.complete());
+    EXPECT_EQ(1, t.values());
+    EXPECT_EQ(encoded.size(), t.offset());
+}
+
+/******************************************************************************/
+
+/**
+ * However we carve the input up we should be handed the same thing
+ */
+TEST (Tokeniser, chunked) { // NOLINT
+    for (size_t chunk { 1 } ; chunk < encoded.size() ; ++chunk) {
+        Recorder r;
+        Tokeniser t (r);
+
+        for (size_t i { 0 } ; i < encoded.size() ; i += chunk) {
+            auto n = std::min (chunk, encoded.size() - i);
+            EXPECT_EQ(n, t.feed (encoded.data() + i, n));
+            EXPECT_EQ(i + n == encoded.size(), t.complete());
+        }
+
+        EXPECT_EQ(expected, r.ss.str()) << "chunk size " << chunk;
+    }
+}
+
+/******************************************************************************/
+
+TEST (Tokeniser, skipList) { // NOLINT
+    Recorder r (PN_LIST);
+    Tokeniser t (r);
+
+    t.feed (encoded.data(), encoded.size());
+
+    EXPECT_EQ("D2 ul:1 L5 /D ", r.ss.str());
+    EXPECT_TRUE(t.complete());
+}
+
+/******************************************************************************/
+
+TEST (Tokeniser, skipDescribed) { // NOLINT
+    Recorder r (PN_DESCRIBED);
+    Tokeniser t (r);
+
+    t.feed (encoded.data(), encoded.size());
+
+    EXPECT_EQ("D2 ", r.ss.str());
+    EXPECT_TRUE(t.complete());
+    EXPECT_EQ(1, t.values());
+}
+
+/******************************************************************************/
+
+/**
+ * When skipping we're told how much is left so a caller can seek past it
+ */
+TEST (Tokeniser, skipped) { // NOLINT
+    Recorder r (PN_LIST);
+    Tokeniser t (r);
+
+    EXPECT_EQ(6, t.feed (encoded.data(), 6));
+    EXPECT_EQ(encoded.size() - 6, t.skipping());
+
+    t.skipped (t.skipping());
+
+    EXPECT_EQ("D2 ul:1 L5 /D ", r.ss.str());
+    EXPECT_TRUE(t.complete());
+}
+
+/******************************************************************************/
+
+TEST (Tokeniser, stop) { // NOLINT
+    Recorder r (PN_INVALID, PN_STRING);
+    Tokeniser t (r);
+
+    auto used = t.feed (encoded.data(), encoded.size());
+
+    EXPECT_EQ(13, used);
+    EXPECT_TRUE(t.stopped());
+    EXPECT_EQ("D2 ul:1 L5 i:5 s:abc ", r.ss.str());
+
+    EXPECT_EQ(encoded.size() - used, t.feed (
+            encoded.data() + used, encoded.size() - used));
+
+    EXPECT_EQ(expected, r.ss.str());
+}
+
+/******************************************************************************/
+
+/**
+ * Stepping over each element of the list by its encoded size alone
+ */
+TEST (Tokeniser, span) { // NOLINT
+    EXPECT_EQ(encoded.size(), Tokeniser::span (encoded.data(), encoded.size()));
+
+    size_t offset { 6 };
+
+    for (size_t size : { 2, 5, 1, 6, 7 }) {
+        EXPECT_EQ(size, Tokeniser::span (
+                encoded.data() + offset, encoded.size() - offset));
+        offset += size;
+    }
+
+    EXPECT_EQ(encoded.size(), offset);
+
+    /*
+     * The array's elements share its constructor
+     */
+    for (size_t i { 0 } ; i < 3 ; ++i) {
+        EXPECT_EQ(1, Tokeniser::span (encoded.data() + 24 + i, 3 - i, 0x54));
+    }
+
+    EXPECT_THROW(Tokeniser::span (encoded.data() + 6, 1), std::runtime_error);
+    EXPECT_THROW(Tokeniser::span (encoded.data() + 8, 3), std::runtime_error);
+    EXPECT_THROW(Tokeniser::span ("\x99", 1), std::runtime_error);
+}
+
+/******************************************************************************/
+
+/**
+ * A run of an array's elements read without the array around them
+ */
+TEST (Tokeniser, elements) { // NOLINT
+    Recorder r;
+    Tokeniser t (r);
+
+    t.elements (0x54);
+
+    EXPECT_EQ(3, t.feed (encoded.data() + 24, 3));
+    EXPECT_EQ("i:1 i:2 i:3 ", r.ss.str());
+    EXPECT_TRUE(t.complete());
+
+    EXPECT_THROW(t.elements (0x99), std::runtime_error);
+}
+
+/******************************************************************************/
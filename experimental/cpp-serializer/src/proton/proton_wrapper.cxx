@@ -125,25 +125,38 @@ proton::is_string (pn_data_t * data_, bool allowNull) {
 
 /******************************************************************************/
 
-std::string
-proton::get_string (pn_data_t * data_, bool allowNull) {
+std::string_view
+proton::get_string_view (pn_data_t * data_, bool allowNull) {
     if (pn_data_type(data_) == PN_STRING) {
         auto str = pn_data_get_string (data_);
-        return std::string (str.start, str.size);
+        return { str.start, str.size };
     } else  if (allowNull && pn_data_type(data_) == PN_NULL) {
-        return "";
+        return { };
     }
     throw std::runtime_error ("Expected a String");
 }
 
 /******************************************************************************/
 
-template<>
 std::string
-proton::get_symbol<std::string> (pn_data_t * data_) {
+proton::get_string (pn_data_t * data_, bool allowNull) {
+    return std::string (get_string_view (data_, allowNull));
+}
+
+/******************************************************************************/
+
+template<>
+std::string_view
+proton::get_symbol<std::string_view> (pn_data_t * data_) {
     is_symbol (data_);
     auto symbol = pn_data_get_symbol(data_);
-    return std::string (symbol.start, symbol.size);
+    return { symbol.start, symbol.size };
+}
+
+template<>
+std::string
+proton::get_symbol<std::string> (pn_data_t * data_) {
+    return std::string (get_symbol<std::string_view> (data_));
 }
 
 template<>
@@ -288,9 +301,9 @@ readAndNext<int32_t> (
 /******************************************************************************/
 
 template<>
-std::string
+std::string_view
 proton::
-readAndNext<std::string> (
+readAndNext<std::string_view> (
     pn_data_t * data_,
     bool tolerateDeviance_
 ) {
@@ -298,12 +311,12 @@ readAndNext<std::string> (
 
     if (pn_data_type(data_) == PN_STRING) {
         auto str = pn_data_get_string(data_);
-        return std::string(str.start, str.size);
+        return { str.start, str.size };
     } else if (pn_data_type(data_) == PN_SYMBOL) {
         auto symbol = pn_data_get_symbol(data_);
-        return std::string(symbol.start, symbol.size);
+        return { symbol.start, symbol.size };
     } else  if (tolerateDeviance_ && pn_data_type(data_) == PN_NULL) {
-        return "";
+        return { };
     }
     std::stringstream ss;
     ss << "Expected a String but found [" << data_ << "]";
@@ -312,6 +325,18 @@ readAndNext<std::string> (
 
 /******************************************************************************/
 
+template<>
+std::string
+proton::
+readAndNext<std::string> (
+    pn_data_t * data_,
+    bool tolerateDeviance_
+) {
+    return std::string (readAndNext<std::string_view> (data_, tolerateDeviance_));
+}
+
+/******************************************************************************/
+
 template<>
 bool
 proton::
@@ -4,6 +4,7 @@
 
 #include <iosfwd>
 #include <string>
+#include <string_view>
 
 #include <proton/types.h>
 #include <proton/codec.h>
@@ -39,11 +40,23 @@ namespace proton {
         return T {};
     }
 
+    template<> std::string get_symbol<std::string> (pn_data_t *);
+    template<> std::string_view get_symbol<std::string_view> (pn_data_t *);
+    template<> pn_bytes_t get_symbol<pn_bytes_t> (pn_data_t *);
+
     std::string get_symbol (pn_data_t *);
 
     bool get_boolean (pn_data_t *);
     std::string get_string (pn_data_t *, bool allowNull = false);
 
+    /**
+     * Strings and symbols as views rather than copies. These point into
+     * the pn_data_t they were read from so are only valid for as long as
+     * it is, anything needing to outlive that should ask for a
+     * std::string instead.
+     */
+    std::string_view get_string_view (pn_data_t *, bool allowNull = false);
+
     class auto_enter {
         private :
             pn_data_t * m_data;
@@ -104,6 +117,18 @@ namespace proton {
         return T{};
     }
 
+    /**
+     * Specialised in the CXX file. Declared here so translation units
+     * calling them don't instantiate the default above instead
+     */
+    template<> int32_t readAndNext<int32_t> (pn_data_t *, bool);
+    template<> std::string readAndNext<std::string> (pn_data_t *, bool);
+    template<> std::string_view readAndNext<std::string_view> (pn_data_t *, bool);
+    template<> bool readAndNext<bool> (pn_data_t *, bool);
+    template<> double readAndNext<double> (pn_data_t *, bool);
+    template<> long readAndNext<long> (pn_data_t *, bool);
+    template<> u_long readAndNext<u_long> (pn_data_t *, bool);
+
 }
 
 /******************************************************************************/